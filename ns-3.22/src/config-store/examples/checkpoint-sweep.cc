@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "ns3/core-module.h"
+#include "ns3/config-store-module.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+// A single server queue: customers arrive at random and are served at
+// the rate given by the ServiceRate attribute.
+class SweepExample : public Object
+{
+public:
+  static TypeId GetTypeId (void) {
+    static TypeId tid = TypeId ("ns3::SweepExample")
+      .SetParent<Object> ()
+      .AddAttribute ("ServiceRate", "Customers served per second",
+                     DoubleValue (1.2),
+                     MakeDoubleAccessor (&SweepExample::m_serviceRate),
+                     MakeDoubleChecker<double> (0.0))
+      ;
+      return tid;
+    }
+  SweepExample ()
+    : m_backlog (0),
+      m_served (0)
+  {
+    m_arrivals = CreateObject<ExponentialRandomVariable> ();
+    m_arrivals->SetAttribute ("Mean", DoubleValue (1.0));
+  }
+  void Arrive (void) {
+    m_backlog++;
+    Simulator::Schedule (Seconds (m_arrivals->GetValue ()), &SweepExample::Arrive, this);
+  }
+  void Serve (void) {
+    if (m_backlog > 0)
+      {
+        m_backlog--;
+        m_served++;
+      }
+    Simulator::Schedule (Seconds (1.0 / m_serviceRate), &SweepExample::Serve, this);
+  }
+  double m_serviceRate;
+  uint64_t m_backlog;
+  uint64_t m_served;
+  Ptr<ExponentialRandomVariable> m_arrivals;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (SweepExample);
+
+// Run the warm-up phase once, then every service rate from the state
+// reached at the end of the warm-up, in parallel copies of the process.
+int main (int argc, char *argv[])
+{
+  double warmup = 1000.0;
+  double duration = 10000.0;
+  uint32_t processes = 4;
+
+  CommandLine cmd;
+  cmd.AddValue ("warmup", "Duration of the warm-up phase, in seconds", warmup);
+  cmd.AddValue ("duration", "Duration of each variant, in seconds", duration);
+  cmd.AddValue ("processes", "Number of variants run at the same time", processes);
+  cmd.Parse (argc, argv);
+
+  Ptr<SweepExample> queue = CreateObject<SweepExample> ();
+  Config::RegisterRootNamespaceObject (queue);
+  Simulator::ScheduleNow (&SweepExample::Arrive, queue);
+  Simulator::ScheduleNow (&SweepExample::Serve, queue);
+
+  Simulator::Stop (Seconds (warmup));
+  Simulator::Run ();
+  std::cout << "warm-up: backlog=" << queue->m_backlog << std::endl;
+
+  Checkpoint checkpoint;
+  checkpoint.SetMaxProcesses (processes);
+  checkpoint.Save ("checkpoint-sweep.txt");
+
+  double rates[] = { 1.1, 1.2, 1.5, 2.0 };
+  for (uint32_t i = 0; i < sizeof (rates) / sizeof (rates[0]); i++)
+    {
+      if (checkpoint.Restore ())
+        {
+          queue->SetAttribute ("ServiceRate", DoubleValue (rates[i]));
+          uint64_t served = queue->m_served;
+          Simulator::Stop (Seconds (duration));
+          Simulator::Run ();
+          std::cout << "rate=" << rates[i]
+                    << " served=" << queue->m_served - served
+                    << " backlog=" << queue->m_backlog << std::endl;
+          Simulator::Destroy ();
+          return 0;
+        }
+    }
+  uint32_t failed = checkpoint.Wait ();
+
+  Simulator::Destroy ();
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+#include "checkpoint.h"
+#include "attribute-iterator.h"
+#include "ns3/simulator.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/global-value.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/fatal-error.h"
+#include "ns3/log.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Checkpoint");
+
+namespace {
+
+class CheckpointAttributeIterator : public AttributeIterator
+{
+public:
+  CheckpointAttributeIterator (std::ostream *os)
+    : m_os (os) {}
+private:
+  virtual void DoVisitAttribute (Ptr<Object> object, std::string name) {
+    StringValue str;
+    object->GetAttribute (name, str);
+    *m_os << "value " << GetCurrentPath () << " \"" << str.Get () << "\"" << std::endl;
+  }
+  std::ostream *m_os;
+};
+
+} // anonymous namespace
+
+Checkpoint::Checkpoint ()
+  : m_maxProcesses (0),
+    m_restores (0),
+    m_failed (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Checkpoint::~Checkpoint ()
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_running.empty ())
+    {
+      NS_LOG_WARN ("Checkpoint destroyed before its copies exited");
+    }
+}
+
+void
+Checkpoint::SetMaxProcesses (uint32_t maxProcesses)
+{
+  NS_LOG_FUNCTION (this << maxProcesses);
+  m_maxProcesses = maxProcesses;
+}
+
+void
+Checkpoint::Save (std::string filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+  std::ofstream os (filename.c_str ());
+  if (!os.good ())
+    {
+      NS_FATAL_ERROR ("Could not open " << filename);
+    }
+  os << "time now \"" << Simulator::Now ().GetTimeStep () << "\"" << std::endl;
+  os << "rng seed \"" << RngSeedManager::GetSeed () << "\"" << std::endl;
+  os << "rng run \"" << RngSeedManager::GetRun () << "\"" << std::endl;
+  os << "rng next-stream \"" << RngSeedManager::PeekNextStreamIndex () << "\"" << std::endl;
+  for (GlobalValue::Iterator i = GlobalValue::Begin (); i != GlobalValue::End (); ++i)
+    {
+      StringValue value;
+      (*i)->GetValue (value);
+      os << "global " << (*i)->GetName () << " \"" << value.Get () << "\"" << std::endl;
+    }
+  CheckpointAttributeIterator iterator (&os);
+  iterator.Iterate ();
+}
+
+void
+Checkpoint::Load (std::string filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+  std::ifstream is (filename.c_str ());
+  if (!is.good ())
+    {
+      NS_FATAL_ERROR ("Could not open " << filename);
+    }
+  std::string line;
+  while (std::getline (is, line))
+    {
+      // type name "value", where the value may hold spaces
+      std::string::size_type first = line.find (' ');
+      std::string::size_type second = line.find (' ', first + 1);
+      if (first == std::string::npos || second == std::string::npos
+          || line.size () < second + 3
+          || line[second + 1] != '"' || line[line.size () - 1] != '"')
+        {
+          NS_FATAL_ERROR ("Malformed line in " << filename << ": " << line);
+        }
+      std::string type = line.substr (0, first);
+      std::string name = line.substr (first + 1, second - first - 1);
+      std::string value = line.substr (second + 2, line.size () - second - 3);
+      NS_LOG_DEBUG ("type=" << type << ", name=" << name << ", value=" << value);
+      if (type == "value")
+        {
+          Config::Set (name, StringValue (value));
+        }
+      else if (type == "global")
+        {
+          Config::SetGlobal (name, StringValue (value));
+        }
+      else if (type == "rng")
+        {
+          std::istringstream iss (value);
+          uint64_t v;
+          iss >> v;
+          if (name == "seed")
+            {
+              RngSeedManager::SetSeed (v);
+            }
+          else if (name == "run")
+            {
+              RngSeedManager::SetRun (v);
+            }
+          else if (name == "next-stream")
+            {
+              RngSeedManager::SetNextStreamIndex (v);
+            }
+        }
+      else if (type == "time")
+        {
+          std::istringstream iss (value);
+          int64_t ts;
+          iss >> ts;
+          if (ts != Simulator::Now ().GetTimeStep ())
+            {
+              // the events which were pending at that time are lost
+              NS_FATAL_ERROR ("Can't load a checkpoint saved at " << TimeStep (ts)
+                              << " at " << Simulator::Now () << ": use Checkpoint::Restore");
+            }
+        }
+    }
+}
+
+bool
+Checkpoint::Restore (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_maxProcesses != 0 && m_running.size () >= m_maxProcesses)
+    {
+      WaitOne ();
+    }
+  // do not let the copy print what is still buffered
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::fflush (0);
+  pid_t pid = fork ();
+  if (pid < 0)
+    {
+      NS_FATAL_ERROR ("Could not fork: " << std::strerror (errno));
+    }
+  if (pid == 0)
+    {
+      // the copies started by the parent are not ours to wait for
+      m_running.clear ();
+      m_failed = 0;
+      m_restores = 0;
+      return true;
+    }
+  NS_LOG_LOGIC ("started copy " << pid);
+  m_restores++;
+  m_running.push_back (pid);
+  return false;
+}
+
+void
+Checkpoint::WaitOne (void)
+{
+  NS_LOG_FUNCTION (this);
+  // Only wait for our own copies: the other modules may have started
+  // processes of their own.
+  pid_t pid = m_running.front ();
+  int status = 0;
+  pid_t ret;
+  do
+    {
+      ret = waitpid (pid, &status, 0);
+    }
+  while (ret < 0 && errno == EINTR);
+  if (ret < 0)
+    {
+      NS_FATAL_ERROR ("Could not wait for copy " << pid << ": " << std::strerror (errno));
+    }
+  NS_LOG_LOGIC ("copy " << pid << " exited with status " << status);
+  m_running.pop_front ();
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    {
+      m_failed++;
+    }
+}
+
+uint32_t
+Checkpoint::Wait (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_running.empty ())
+    {
+      WaitOne ();
+    }
+  uint32_t failed = m_failed;
+  m_failed = 0;
+  return failed;
+}
+
+uint32_t
+Checkpoint::GetRestoreCount (void) const
+{
+  return m_restores;
+}
+
+} // namespace ns3
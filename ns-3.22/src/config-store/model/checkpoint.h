@@ -0,0 +1,126 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include <string>
+#include <list>
+#include <sys/types.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup configstore
+ *
+ * \brief Restart a simulation many times from the same point.
+ *
+ * A parameter sweep often repeats an identical warm-up phase for every
+ * parameter value. A Checkpoint lets such a program run the warm-up
+ * once, and then start every variant from the state reached at the end
+ * of the warm-up:
+ *
+ * \code
+ *   Simulator::Stop (Seconds (warmup));
+ *   Simulator::Run ();
+ *   Checkpoint checkpoint;
+ *   checkpoint.Save ("warm.txt");
+ *   for (uint32_t v = 0; v < variants; v++)
+ *     {
+ *       if (checkpoint.Restore ())
+ *         {
+ *           // in a copy of the simulation, as it was at the checkpoint
+ *           Config::Set ("/NodeList/0/...", ...);
+ *           Simulator::Stop (Seconds (duration));
+ *           Simulator::Run ();
+ *           Simulator::Destroy ();
+ *           return 0;
+ *         }
+ *     }
+ *   checkpoint.Wait ();
+ * \endcode
+ *
+ * The pending events hold arbitrary callbacks and the objects hold state
+ * which is not described by their attributes (queues, protocol state
+ * machines, random number generator streams...), so neither can be
+ * written to a file. Instead, Restore forks the process: the copy
+ * resumes the simulation with the event list, the object graph and the
+ * state of every RngStream exactly as they were when Restore was
+ * called, while the calling process keeps the checkpoint intact for the
+ * next variant. Unless a variant reseeds its random variables, all the
+ * variants therefore share the same random numbers from the checkpoint
+ * on, which reduces the variance of their differences.
+ *
+ * Save writes the part of the state which can be described in a file:
+ * the simulation time, the state of the RngSeedManager, the global
+ * values and the value of the attributes of every object reachable
+ * from the root namespace objects, in the format of the RAW_TEXT
+ * ConfigStore. Load applies such a file to a simulation, for example to
+ * check that a variant starts from the same configuration as the one
+ * saved with the checkpoint, or to reproduce it in a new process. Since
+ * the pending events cannot be read back, Load refuses a file saved at
+ * another simulation time than the current one: a simulation saved
+ * after a warm-up can only be resumed with Restore.
+ *
+ * Restore must be called while the simulator is not running, and only
+ * with simulator implementations which do not use threads, since the
+ * copy contains only the calling thread.
+ */
+class Checkpoint
+{
+public:
+  Checkpoint ();
+  ~Checkpoint ();
+
+  /**
+   * \param maxProcesses the largest number of copies which may run at
+   *        the same time. Restore waits for one of them to exit before
+   *        it starts a new one. Zero means no limit.
+   */
+  void SetMaxProcesses (uint32_t maxProcesses);
+
+  /**
+   * \param filename the file to write the state of the simulation to.
+   */
+  void Save (std::string filename) const;
+  /**
+   * \param filename a file written by Save.
+   *
+   * Set the global values and the attribute values saved in the file,
+   * and restore the state of the RngSeedManager. It is a fatal error
+   * if the file was saved at another time than Simulator::Now.
+   */
+  void Load (std::string filename) const;
+
+  /**
+   * Start a copy of the process which resumes from the current state of
+   * the simulation.
+   *
+   * \returns true in the copy, and false in the calling process.
+   */
+  bool Restore (void);
+  /**
+   * Wait until all the copies started by Restore have exited.
+   *
+   * \returns the number of copies which failed, that is, which exited
+   *          with a non-zero status or were killed by a signal.
+   */
+  uint32_t Wait (void);
+  /**
+   * \returns the number of copies started by Restore so far, not
+   *          counting the copy this is called from.
+   */
+  uint32_t GetRestoreCount (void) const;
+
+private:
+  /* Wait for the oldest copy to exit, and count it if it failed. */
+  void WaitOne (void);
+
+  uint32_t m_maxProcesses;
+  uint32_t m_restores;
+  // the copies which have not exited yet, oldest first
+  std::list<pid_t> m_running;
+  uint32_t m_failed;
+};
+
+} // namespace ns3
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,175 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/checkpoint.h"
+#include "ns3/simulator.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+namespace {
+
+void
+Nothing (void)
+{
+}
+
+} // anonymous namespace
+
+/**
+ * Save the attributes and the state of the random number generators,
+ * change them, and check that Load sets them back.
+ */
+class CheckpointSaveLoadTestCase : public TestCase
+{
+public:
+  CheckpointSaveLoadTestCase ();
+  virtual void DoRun (void);
+};
+
+CheckpointSaveLoadTestCase::CheckpointSaveLoadTestCase ()
+  : TestCase ("Check that Checkpoint::Load restores what Checkpoint::Save wrote")
+{
+}
+
+void
+CheckpointSaveLoadTestCase::DoRun (void)
+{
+  uint32_t seed = RngSeedManager::GetSeed ();
+  uint64_t run = RngSeedManager::GetRun ();
+  uint64_t nextStream = RngSeedManager::PeekNextStreamIndex ();
+
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  node->AddDevice (device);
+  device->SetAttribute ("DataRate", DataRateValue (DataRate ("7Mbps")));
+  RngSeedManager::SetSeed (7);
+  RngSeedManager::SetRun (3);
+  RngSeedManager::SetNextStreamIndex (11);
+
+  Checkpoint checkpoint;
+  std::string filename = CreateTempDirFilename ("checkpoint.txt");
+  checkpoint.Save (filename);
+
+  device->SetAttribute ("DataRate", DataRateValue (DataRate ("1Mbps")));
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  RngSeedManager::SetNextStreamIndex (12);
+
+  checkpoint.Load (filename);
+  DataRateValue rate;
+  device->GetAttribute ("DataRate", rate);
+  NS_TEST_EXPECT_MSG_EQ (rate.Get (), DataRate ("7Mbps"), "The attribute was not restored");
+  NS_TEST_EXPECT_MSG_EQ (RngSeedManager::GetSeed (), 7, "The seed was not restored");
+  NS_TEST_EXPECT_MSG_EQ (RngSeedManager::GetRun (), 3, "The run number was not restored");
+  NS_TEST_EXPECT_MSG_EQ (RngSeedManager::PeekNextStreamIndex (), 11, "The next stream was not restored");
+
+  RngSeedManager::SetSeed (seed);
+  RngSeedManager::SetRun (run);
+  RngSeedManager::SetNextStreamIndex (nextStream);
+  Simulator::Destroy ();
+}
+
+/**
+ * Restore the simulation in copies of the process, check the state they
+ * see, and that Wait only waits for these copies.
+ */
+class CheckpointRestoreTestCase : public TestCase
+{
+public:
+  CheckpointRestoreTestCase ();
+  virtual void DoRun (void);
+};
+
+CheckpointRestoreTestCase::CheckpointRestoreTestCase ()
+  : TestCase ("Check that Checkpoint::Restore resumes the simulation in its copies")
+{
+}
+
+void
+CheckpointRestoreTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  node->AddDevice (device);
+  device->SetAttribute ("DataRate", DataRateValue (DataRate ("7Mbps")));
+  Simulator::Schedule (Seconds (1), &Nothing);
+  Simulator::Schedule (Seconds (3), &Nothing);
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  // a process which is not a copy, and which Wait must leave alone
+  pid_t other = fork ();
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (other, 0, "Could not fork");
+  if (other == 0)
+    {
+      usleep (100000);
+      _exit (7);
+    }
+
+  Checkpoint checkpoint;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      if (checkpoint.Restore ())
+        {
+          // The copies see the simulation as it was, and resume it.
+          DataRateValue rate;
+          device->GetAttribute ("DataRate", rate);
+          bool ok = Simulator::Now () == Seconds (2) && rate.Get () == DataRate ("7Mbps");
+          Simulator::Run ();
+          ok = ok && Simulator::Now () == Seconds (3);
+          // The second copy fails on purpose.
+          _exit (ok && i == 0 ? 0 : 1);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (checkpoint.GetRestoreCount (), 2, "Wrong number of copies");
+  NS_TEST_EXPECT_MSG_EQ (checkpoint.Wait (), 1, "Only the second copy should have failed");
+
+  int status = 0;
+  pid_t pid;
+  do
+    {
+      pid = waitpid (other, &status, 0);
+    }
+  while (pid < 0 && errno == EINTR);
+  NS_TEST_EXPECT_MSG_EQ (pid, other, "Wait reaped a process which was not a copy");
+  NS_TEST_EXPECT_MSG_EQ (WIFEXITED (status) && WEXITSTATUS (status) == 7, true, "Wrong exit status");
+
+  // The simulation of the calling process is left untouched.
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (2), "The checkpoint was modified");
+  Simulator::Destroy ();
+}
+
+class CheckpointTestSuite : public TestSuite
+{
+public:
+  CheckpointTestSuite ()
+    : TestSuite ("checkpoint", UNIT)
+  {
+    AddTestCase (new CheckpointSaveLoadTestCase (), TestCase::QUICK);
+    AddTestCase (new CheckpointRestoreTestCase (), TestCase::QUICK);
+  }
+} g_checkpointTestSuite;
@@ -24,9 +24,12 @@
 #include "object-ptr-container.h"
 #include "names.h"
 #include "pointer.h"
+#include "trace-source-accessor.h"
 #include "log.h"
 
 #include <sstream>
+#include <map>
+#include <algorithm>
 
 namespace ns3 {
 
@@ -142,200 +145,291 @@ MatchContainer::DisconnectWithoutContext (std::string name, const CallbackBase &
 
 } // namespace Config
 
-class ArrayMatcher
+/**
+ * Resolves one or more compiled paths.  The paths are merged into a tree
+ * of their segments, so that the segments which start several paths are
+ * resolved once for all of them.
+ */
+class Resolver
 {
 public:
-  ArrayMatcher (std::string element);
-  bool Matches (uint32_t i) const;
+  Resolver ();
+  virtual ~Resolver ();
+
+  void Resolve (Ptr<Object> root);
+protected:
+  /**
+   * \param path the compiled path, which must outlive this resolver
+   * \param whole resolve all the segments of the path, rather than the
+   *        segments before its last '/'
+   * \returns the index of the path, given to DoOne
+   */
+  uint32_t AddPath (const Config::CompiledPath &path, bool whole);
+  /**
+   * \param path a compiled path
+   * \returns the text after the last '/' of the path
+   */
+  static std::string GetLeaf (const Config::CompiledPath &path);
+  /**
+   * \param tid the TypeId of an object
+   * \param name the name of a trace source
+   * \returns the trace source of this name, or zero, as found by
+   *          ObjectBase::TraceConnect
+   */
+  static Ptr<const TraceSourceAccessor> LookupTraceSource (TypeId tid, std::string name);
 private:
-  bool StringToUint32 (std::string str, uint32_t *value) const;
-  std::string m_element;
-};
+  /** An attribute which holds the objects of a segment. */
+  struct AttributeMatch
+  {
+    std::string name;                                //!< name of the attribute
+    bool pointer;                                    //!< a PointerValue, else an ObjectPtrContainerValue
+    bool gettable;                                   //!< can be read with the accessor
+    Ptr<const AttributeAccessor> accessor;           //!< the accessor used by ObjectBase::GetAttribute
+    const ObjectPtrContainerAccessor *container;     //!< the container accessor, if any and gettable
+  };
+  typedef std::vector<AttributeMatch> AttributeMatches;
+
+  /**
+   * \param tid the TypeId of an object
+   * \param item a segment
+   * \returns the pointer and container attributes of the objects of this
+   *          TypeId matched by the segment, in the order of the old
+   *          resolver: derived types first.
+   */
+  static const AttributeMatches &LookupAttributes (TypeId tid, std::string item);
+  /** A segment shared by the paths which start with the same segments. */
+  struct Node
+  {
+    const Config::CompiledPath::Segment *segment;  //!< the segment, zero for the root
+    std::vector<uint32_t> children;                //!< the nodes of the next segments
+    std::vector<uint32_t> paths;                   //!< the paths which end with this segment
+  };
 
+  static bool Matches (const Config::CompiledPath::Segment &segment, uint32_t index);
+  void DoResolve (uint32_t node, Ptr<Object> root);
+  void DoResolveSegment (uint32_t node, Ptr<Object> root);
+  void DoArrayResolve (uint32_t node, Ptr<Object> root, const AttributeMatch &attribute);
+  void DoArrayResolveIndex (uint32_t node, Ptr<Object> root, const AttributeMatch &attribute);
+  void DoResolveOne (Ptr<Object> object, uint32_t path);
+  void Push (std::string item);
+  void Pop (void);
+  std::string GetResolvedPath (void) const;
+  virtual void DoOne (Ptr<Object> object, std::string path, uint32_t index) = 0;
+  std::vector<Node> m_nodes;
+  /** the child of a node for the text of a segment */
+  std::map<std::pair<uint32_t, std::string>, uint32_t> m_children;
+  uint32_t m_nPaths;
+  std::string m_resolvedPath;
+  std::vector<std::string::size_type> m_pushed;
+};
 
-ArrayMatcher::ArrayMatcher (std::string element)
-  : m_element (element)
+Resolver::Resolver ()
+  : m_nodes (1),
+    m_nPaths (0)
 {
-  NS_LOG_FUNCTION (this << element);
+  NS_LOG_FUNCTION (this);
+  m_nodes[0].segment = 0;
 }
-bool
-ArrayMatcher::Matches (uint32_t i) const
+Resolver::~Resolver ()
 {
-  NS_LOG_FUNCTION (this << i);
-  if (m_element == "*")
-    {
-      NS_LOG_DEBUG ("Array "<<i<<" matches *");
-      return true;
-    }
-  std::string::size_type tmp;
-  tmp = m_element.find ("|");
-  if (tmp != std::string::npos)
-    {
-      std::string left = m_element.substr (0, tmp-0);
-      std::string right = m_element.substr (tmp+1, m_element.size () - (tmp + 1));
-      ArrayMatcher matcher = ArrayMatcher (left);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<left);
-          return true;
-        }
-      matcher = ArrayMatcher (right);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<right);
-          return true;
-        }
-      NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
-      return false;
-    }
-  std::string::size_type leftBracket = m_element.find ("[");
-  std::string::size_type rightBracket = m_element.find ("]");
-  std::string::size_type dash = m_element.find ("-");
-  if (leftBracket == 0 && rightBracket == m_element.size () - 1 &&
-      dash > leftBracket && dash < rightBracket)
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+Resolver::AddPath (const Config::CompiledPath &path, bool whole)
+{
+  NS_LOG_FUNCTION (this << &path << whole);
+  const Config::CompiledPath::Segments &segments = whole ? path.m_segments : path.m_rootSegments;
+  uint32_t node = 0;
+  for (Config::CompiledPath::Segments::const_iterator i = segments.begin (); i != segments.end (); ++i)
     {
-      std::string lowerBound = m_element.substr (leftBracket + 1, dash - (leftBracket + 1));
-      std::string upperBound = m_element.substr (dash + 1, rightBracket - (dash + 1));
-      uint32_t min;
-      uint32_t max;
-      if (StringToUint32 (lowerBound, &min) && 
-          StringToUint32 (upperBound, &max) &&
-          i >= min && i <= max)
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-          return true;
-        }
-      else
+      std::pair<uint32_t, std::string> key (node, i->item);
+      std::map<std::pair<uint32_t, std::string>, uint32_t>::const_iterator child = m_children.find (key);
+      if (child != m_children.end ())
         {
-          NS_LOG_DEBUG ("Array "<<i<<" does not "<<m_element);
-          return false;
+          node = child->second;
+          continue;
         }
+      uint32_t next = m_nodes.size ();
+      m_nodes.push_back (Node ());
+      m_nodes[next].segment = &*i;
+      m_nodes[node].children.push_back (next);
+      m_children.insert (std::make_pair (key, next));
+      node = next;
     }
-  uint32_t value;
-  if (StringToUint32 (m_element, &value) &&
-      i == value)
-    {
-      NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-      return true;
-    }
-  NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
-  return false;
+  m_nodes[node].paths.push_back (m_nPaths);
+  return m_nPaths++;
 }
 
-bool
-ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
+std::string
+Resolver::GetLeaf (const Config::CompiledPath &path)
 {
-  NS_LOG_FUNCTION (this << str << value);
-  std::istringstream iss;
-  iss.str (str);
-  iss >> (*value);
-  return !iss.bad () && !iss.fail ();
+  return path.m_leaf;
 }
 
-
-class Resolver
+void 
+Resolver::Resolve (Ptr<Object> root)
 {
-public:
-  Resolver (std::string path);
-  virtual ~Resolver ();
+  NS_LOG_FUNCTION (this << root);
 
-  void Resolve (Ptr<Object> root);
-private:
-  void Canonicalize (void);
-  void DoResolve (std::string path, Ptr<Object> root);
-  void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
-  void DoResolveOne (Ptr<Object> object);
-  std::string GetResolvedPath (void) const;
-  virtual void DoOne (Ptr<Object> object, std::string path) = 0;
-  std::vector<std::string> m_workStack;
-  std::string m_path;
-};
+  m_resolvedPath = "/";
+  m_pushed.clear ();
+  DoResolve (0, root);
+}
 
-Resolver::Resolver (std::string path)
-  : m_path (path)
+const Resolver::AttributeMatches &
+Resolver::LookupAttributes (TypeId tid, std::string item)
 {
-  NS_LOG_FUNCTION (this << path);
-  Canonicalize ();
+  NS_LOG_FUNCTION (tid << item);
+  typedef std::map<std::pair<uint16_t, std::string>, AttributeMatches> Cache;
+  static Cache cache;
+  std::pair<uint16_t, std::string> key (tid.GetUid (), item);
+  Cache::const_iterator cached = cache.find (key);
+  if (cached != cache.end ())
+    {
+      return cached->second;
+    }
+
+  AttributeMatches matches;
+  TypeId current;
+  TypeId next = tid;
+  do
+    {
+      current = next;
+      for (uint32_t i = 0; i < current.GetAttributeN (); i++)
+        {
+          struct TypeId::AttributeInformation info = current.GetAttribute (i);
+          if (info.name != item && item != "*")
+            {
+              continue;
+            }
+          bool pointer = dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0;
+          bool container = dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0;
+          if (!pointer && !container)
+            {
+              // this could be anything else and we don't know what to do with it.
+              // So, we just ignore it.
+              continue;
+            }
+          // ObjectBase::GetAttribute reads the first attribute of this name.
+          struct TypeId::AttributeInformation found;
+          tid.LookupAttributeByName (info.name, &found);
+          AttributeMatch match;
+          match.name = info.name;
+          match.pointer = pointer;
+          match.gettable = (found.flags & TypeId::ATTR_GET) && found.accessor->HasGetter ();
+          match.accessor = found.accessor;
+          match.container = 0;
+          if (container && match.gettable)
+            {
+              match.container = dynamic_cast<const ObjectPtrContainerAccessor *> (PeekPointer (found.accessor));
+            }
+          matches.push_back (match);
+        }
+      next = current.GetParent ();
+    } while (next != current);
+  return cache.insert (std::make_pair (key, matches)).first->second;
 }
-Resolver::~Resolver ()
+
+Ptr<const TraceSourceAccessor>
+Resolver::LookupTraceSource (TypeId tid, std::string name)
 {
-  NS_LOG_FUNCTION (this);
+  NS_LOG_FUNCTION (tid << name);
+  typedef std::map<std::pair<uint16_t, std::string>, Ptr<const TraceSourceAccessor> > Cache;
+  static Cache cache;
+  std::pair<uint16_t, std::string> key (tid.GetUid (), name);
+  Cache::const_iterator cached = cache.find (key);
+  if (cached != cache.end ())
+    {
+      return cached->second;
+    }
+  Ptr<const TraceSourceAccessor> accessor = tid.LookupTraceSourceByName (name);
+  cache.insert (std::make_pair (key, accessor));
+  return accessor;
 }
-void
-Resolver::Canonicalize (void)
-{
-  NS_LOG_FUNCTION (this);
 
-  // ensure that we start and end with a '/'
-  std::string::size_type tmp = m_path.find ("/");
-  if (tmp != 0)
+bool
+Resolver::Matches (const Config::CompiledPath::Segment &segment, uint32_t index)
+{
+  NS_LOG_FUNCTION (&segment << index);
+  if (segment.all)
     {
-      // no slash at start
-      m_path = "/" + m_path;
+      return true;
     }
-  tmp = m_path.find_last_of ("/");
-  if (tmp != (m_path.size () - 1))
+  for (std::vector<Config::CompiledPath::Range>::const_iterator i = segment.ranges.begin ();
+       i != segment.ranges.end (); ++i)
     {
-      // no slash at end
-      m_path = m_path + "/";
+      if (index >= i->min && index <= i->max)
+        {
+          return true;
+        }
     }
+  return false;
 }
 
-void 
-Resolver::Resolve (Ptr<Object> root)
+void
+Resolver::Push (std::string item)
 {
-  NS_LOG_FUNCTION (this << root);
+  m_pushed.push_back (m_resolvedPath.size ());
+  m_resolvedPath += item;
+  m_resolvedPath += "/";
+}
 
-  DoResolve (m_path, root);
+void
+Resolver::Pop (void)
+{
+  m_resolvedPath.resize (m_pushed.back ());
+  m_pushed.pop_back ();
 }
 
 std::string
 Resolver::GetResolvedPath (void) const
 {
   NS_LOG_FUNCTION (this);
-
-  std::string fullPath = "/";
-  for (std::vector<std::string>::const_iterator i = m_workStack.begin (); i != m_workStack.end (); i++)
-    {
-      fullPath += *i + "/";
-    }
-  return fullPath;
+  return m_resolvedPath;
 }
 
 void 
-Resolver::DoResolveOne (Ptr<Object> object)
+Resolver::DoResolveOne (Ptr<Object> object, uint32_t path)
 {
-  NS_LOG_FUNCTION (this << object);
+  NS_LOG_FUNCTION (this << object << path);
 
   NS_LOG_DEBUG ("resolved="<<GetResolvedPath ());
-  DoOne (object, GetResolvedPath ());
+  DoOne (object, GetResolvedPath (), path);
 }
 
 void
-Resolver::DoResolve (std::string path, Ptr<Object> root)
-{
-  NS_LOG_FUNCTION (this << path << root);
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-
-  if (next == std::string::npos)
-    {
-      //
-      // If root is zero, we're beginning to see if we can use the object name 
-      // service to resolve this path.  It is impossible to have a object name 
-      // associated with the root of the object name service since that root
-      // is not an object.  This path must be referring to something in another
-      // namespace and it will have been found already since the name service
-      // is always consulted last.
-      // 
-      if (root)
+Resolver::DoResolve (uint32_t node, Ptr<Object> root)
+{
+  NS_LOG_FUNCTION (this << node << root);
+
+  //
+  // If root is zero, we're beginning to see if we can use the object name 
+  // service to resolve this path.  It is impossible to have a object name 
+  // associated with the root of the object name service since that root
+  // is not an object.  This path must be referring to something in another
+  // namespace and it will have been found already since the name service
+  // is always consulted last.
+  // 
+  if (root)
+    {
+      for (std::vector<uint32_t>::const_iterator i = m_nodes[node].paths.begin (); i != m_nodes[node].paths.end (); ++i)
         {
-          DoResolveOne (root);
+          DoResolveOne (root, *i);
         }
-      return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+  for (std::vector<uint32_t>::const_iterator i = m_nodes[node].children.begin (); i != m_nodes[node].children.end (); ++i)
+    {
+      DoResolveSegment (*i, root);
+    }
+}
+
+void
+Resolver::DoResolveSegment (uint32_t node, Ptr<Object> root)
+{
+  NS_LOG_FUNCTION (this << node << root);
+
+  const Config::CompiledPath::Segment &item = *m_nodes[node].segment;
 
   //
   // If root is zero, we're beginning to see if we can use the object name 
@@ -344,16 +438,12 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   // the root of the "/Names" namespace, so we just ignore it and move on to 
   // the next segment.
   //
-  if (root == 0)
+  if (root == 0 && item.item.compare (0, 5, "Names") == 0)
     {
-      std::string::size_type offset = path.find ("/Names");
-      if (offset == 0)
-        {
-          m_workStack.push_back (item);
-          DoResolve (pathLeft, root);
-          m_workStack.pop_back ();
-          return;
-        }
+      Push (item.item);
+      DoResolve (node, root);
+      Pop ();
+      return;
     }
 
   //
@@ -362,13 +452,13 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   // zero, this means to look in the root of the "/Names" name space, otherwise
   // it refers to a name space context (level).
   //
-  Ptr<Object> namedObject = Names::Find<Object> (root, item);
+  Ptr<Object> namedObject = Names::Find<Object> (root, item.item);
   if (namedObject)
     {
-      NS_LOG_DEBUG ("Name system resolved item = " << item << " to " << namedObject);
-      m_workStack.push_back (item);
-      DoResolve (pathLeft, namedObject);
-      m_workStack.pop_back ();
+      NS_LOG_DEBUG ("Name system resolved item = " << item.item << " to " << namedObject);
+      Push (item.item);
+      DoResolve (node, namedObject);
+      Pop ();
       return;
     }
 
@@ -383,119 +473,219 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       return;
     }
-  std::string::size_type dollarPos = item.find ("$");
-  if (dollarPos == 0)
+  if (item.getObject)
     {
       // This is a call to GetObject
-      std::string tidString = item.substr (1, item.size () - 1);
-      NS_LOG_DEBUG ("GetObject="<<tidString<<" on path="<<GetResolvedPath ());
-      TypeId tid = TypeId::LookupByName (tidString);
-      Ptr<Object> object = root->GetObject<Object> (tid);
+      NS_LOG_DEBUG ("GetObject="<<item.item<<" on path="<<GetResolvedPath ());
+      if (!item.tidFound)
+        {
+          // fails as the path names no TypeId
+          TypeId::LookupByName (item.item.substr (1));
+        }
+      Ptr<Object> object = root->GetObject<Object> (item.tid);
       if (object == 0)
         {
-          NS_LOG_DEBUG ("GetObject ("<<tidString<<") failed on path="<<GetResolvedPath ());
+          NS_LOG_DEBUG ("GetObject ("<<item.item<<") failed on path="<<GetResolvedPath ());
           return;
         }
-      m_workStack.push_back (item);
-      DoResolve (pathLeft, object);
-      m_workStack.pop_back ();
+      Push (item.item);
+      DoResolve (node, object);
+      Pop ();
     }
   else 
     {
       // this is a normal attribute.
-      TypeId tid;
-      TypeId nextTid = root->GetInstanceTypeId ();
+      const AttributeMatches &attributes = LookupAttributes (root->GetInstanceTypeId (), item.item);
       bool foundMatch = false;
-      
-      do
+      for (AttributeMatches::const_iterator i = attributes.begin (); i != attributes.end (); ++i)
         {
-          tid = nextTid;
-          
-          for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+          if (i->pointer)
             {
-              struct TypeId::AttributeInformation info;
-              info = tid.GetAttribute(i);
-              if (info.name != item && item != "*")
+              NS_LOG_DEBUG ("GetAttribute(ptr)="<<i->name<<" on path="<<GetResolvedPath ());
+              PointerValue ptr;
+              if (!i->gettable || !i->accessor->Get (PeekPointer (root), ptr))
                 {
-                  continue;
-                }
-              // attempt to cast to a pointer checker.
-              const PointerChecker *ptr = dynamic_cast<const PointerChecker *> (PeekPointer (info.checker));
-              if (ptr != 0)
-                {
-                  NS_LOG_DEBUG ("GetAttribute(ptr)="<<info.name<<" on path="<<GetResolvedPath ());
-                  PointerValue ptr;
-                  root->GetAttribute (info.name, ptr);
-                  Ptr<Object> object = ptr.Get<Object> ();
-                  if (object == 0)
-                    {
-                      NS_LOG_ERROR ("Requested object name=\""<<item<<
-                                    "\" exists on path=\""<<GetResolvedPath ()<<"\""
-                                    " but is null.");
-                      continue;
-                    }
-                  foundMatch = true;
-                  m_workStack.push_back (info.name);
-                  DoResolve (pathLeft, object);
-                  m_workStack.pop_back ();
+                  root->GetAttribute (i->name, ptr);
                 }
-              // attempt to cast to an object vector.
-              const ObjectPtrContainerChecker *vectorChecker = 
-                dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
-              if (vectorChecker != 0)
+              Ptr<Object> object = ptr.Get<Object> ();
+              if (object == 0)
                 {
-                  NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
-                  foundMatch = true;
-                  ObjectPtrContainerValue vector;
-                  root->GetAttribute (info.name, vector);
-                  m_workStack.push_back (info.name);
-                  DoArrayResolve (pathLeft, vector);
-                  m_workStack.pop_back ();
+                  NS_LOG_ERROR ("Requested object name=\""<<item.item<<
+                                "\" exists on path=\""<<GetResolvedPath ()<<"\""
+                                " but is null.");
+                  continue;
                 }
-              // this could be anything else and we don't know what to do with it.
-              // So, we just ignore it.
+              foundMatch = true;
+              Push (i->name);
+              DoResolve (node, object);
+              Pop ();
             }
-
-          nextTid = tid.GetParent ();
-        } while (nextTid != tid);
-      
+          else
+            {
+              NS_LOG_DEBUG ("GetAttribute(vector)="<<i->name<<" on path="<<GetResolvedPath ());
+              foundMatch = true;
+              Push (i->name);
+              DoArrayResolve (node, root, *i);
+              Pop ();
+            }
+        }
       if (!foundMatch)
         {
-          NS_LOG_DEBUG ("Requested item="<<item<<" does not exist on path="<<GetResolvedPath ());
+          NS_LOG_DEBUG ("Requested item="<<item.item<<" does not exist on path="<<GetResolvedPath ());
           return;
         }
     }
 }
 
 void 
-Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &container)
+Resolver::DoArrayResolve (uint32_t node, Ptr<Object> root, const AttributeMatch &attribute)
 {
-  NS_LOG_FUNCTION(this << path << &container);
-  NS_ASSERT (path != "");
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-  if (next == std::string::npos)
+  NS_LOG_FUNCTION (this << node << root << attribute.name);
+  for (std::vector<uint32_t>::const_iterator child = m_nodes[node].children.begin ();
+       child != m_nodes[node].children.end (); ++child)
     {
-      return;
+      DoArrayResolveIndex (*child, root, attribute);
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+}
+
+void 
+Resolver::DoArrayResolveIndex (uint32_t node, Ptr<Object> root, const AttributeMatch &attribute)
+{
+  NS_LOG_FUNCTION (this << node << root << attribute.name);
+  const Config::CompiledPath::Segment &item = *m_nodes[node].segment;
 
-  ArrayMatcher matcher = ArrayMatcher (item);
-  ObjectPtrContainerValue::Iterator it;
-  for (it = container.Begin (); it != container.End (); ++it)
+  // The indexes increase with the position in the container: if the last
+  // index is the last position, each index is its position and the
+  // matching objects are fetched directly rather than by testing each of
+  // them.
+  std::vector<std::pair<uint32_t, Ptr<Object> > > matches;
+  bool positional = false;
+  uint32_t n;
+  if (attribute.container != 0 && attribute.container->GetN (PeekPointer (root), &n))
+    {
+      uint32_t last = 0;
+      if (n > 0)
+        {
+          attribute.container->GetItem (PeekPointer (root), n - 1, &last);
+        }
+      positional = (n == 0 || last == n - 1);
+    }
+  if (positional)
+    {
+      uint32_t index;
+      if (item.all)
+        {
+          for (uint32_t i = 0; i < n; i++)
+            {
+              matches.push_back (std::make_pair (i, attribute.container->GetItem (PeekPointer (root), i, &index)));
+            }
+        }
+      else
+        {
+          for (std::vector<Config::CompiledPath::Range>::const_iterator r = item.ranges.begin ();
+               r != item.ranges.end () && r->min < n; ++r)
+            {
+              for (uint64_t i = r->min; i <= r->max && i < n; i++)
+                {
+                  matches.push_back (std::make_pair (i, attribute.container->GetItem (PeekPointer (root), i, &index)));
+                }
+            }
+        }
+    }
+  else
     {
-      if (matcher.Matches ((*it).first))
+      ObjectPtrContainerValue container;
+      root->GetAttribute (attribute.name, container);
+      for (ObjectPtrContainerValue::Iterator it = container.Begin (); it != container.End (); ++it)
         {
-          std::ostringstream oss;
-          oss << (*it).first;
-          m_workStack.push_back (oss.str ());
-          DoResolve (pathLeft, (*it).second);
-          m_workStack.pop_back ();
+          if (Matches (item, (*it).first))
+            {
+              matches.push_back (*it);
+            }
         }
     }
+
+  for (uint32_t i = 0; i < matches.size (); i++)
+    {
+      NS_LOG_DEBUG ("Array "<<matches[i].first<<" matches "<<item.item);
+      std::ostringstream oss;
+      oss << matches[i].first;
+      Push (oss.str ());
+      DoResolve (node, matches[i].second);
+      Pop ();
+    }
 }
 
+/** Collects the objects matched by a path. */
+class LookupMatchesResolver : public Resolver
+{
+public:
+  LookupMatchesResolver (const Config::CompiledPath &path, bool whole)
+  {
+    AddPath (path, whole);
+  }
+  virtual void DoOne (Ptr<Object> object, std::string path, uint32_t index) {
+    m_objects.push_back (object);
+    m_contexts.push_back (path);
+  }
+  std::vector<Ptr<Object> > m_objects;
+  std::vector<std::string> m_contexts;
+};
+
+/** Connects callbacks to the trace sources matched by their paths. */
+class TraceResolver : public Resolver
+{
+public:
+  enum Operation
+  {
+    CONNECT,
+    CONNECT_WITHOUT_CONTEXT,
+    DISCONNECT,
+    DISCONNECT_WITHOUT_CONTEXT
+  };
+  TraceResolver (enum Operation operation)
+    : m_operation (operation)
+  {}
+  /**
+   * \param path the compiled path, which must outlive this resolver
+   * \param cb the callback, which must outlive this resolver
+   */
+  void AddTrace (const Config::CompiledPath &path, const CallbackBase &cb)
+  {
+    AddPath (path, false);
+    m_names.push_back (GetLeaf (path));
+    m_cbs.push_back (&cb);
+  }
+  virtual void DoOne (Ptr<Object> object, std::string path, uint32_t index) {
+    const std::string &name = m_names[index];
+    const CallbackBase &cb = *m_cbs[index];
+    Ptr<const TraceSourceAccessor> accessor = LookupTraceSource (object->GetInstanceTypeId (), name);
+    if (accessor == 0)
+      {
+        return;
+      }
+    switch (m_operation)
+      {
+      case CONNECT:
+        accessor->Connect (PeekPointer (object), path + name, cb);
+        break;
+      case CONNECT_WITHOUT_CONTEXT:
+        accessor->ConnectWithoutContext (PeekPointer (object), cb);
+        break;
+      case DISCONNECT:
+        accessor->Disconnect (PeekPointer (object), path + name, cb);
+        break;
+      case DISCONNECT_WITHOUT_CONTEXT:
+        accessor->DisconnectWithoutContext (PeekPointer (object), cb);
+        break;
+      }
+  }
+private:
+  std::vector<std::string> m_names;
+  std::vector<const CallbackBase *> m_cbs;
+  enum Operation m_operation;
+};
+
 
 class ConfigImpl 
 {
@@ -507,6 +697,12 @@ public:
   void Disconnect (std::string path, const CallbackBase &cb);
   Config::MatchContainer LookupMatches (std::string path);
 
+  /**
+   * \param resolver a resolver to run from each root namespace object,
+   *        then from the root of the "/Names" namespace
+   */
+  void Resolve (Resolver &resolver) const;
+
   void RegisterRootNamespaceObject (Ptr<Object> obj);
   void UnregisterRootNamespaceObject (Ptr<Object> obj);
 
@@ -514,89 +710,52 @@ public:
   Ptr<Object> GetRootNamespaceObject (uint32_t i) const;
 
 private:
-  void ParsePath (std::string path, std::string *root, std::string *leaf) const;
   typedef std::vector<Ptr<Object> > Roots;
   Roots m_roots;
 };
 
-void 
-ConfigImpl::ParsePath (std::string path, std::string *root, std::string *leaf) const
-{
-  NS_LOG_FUNCTION (this << path << root << leaf);
-
-  std::string::size_type slash = path.find_last_of ("/");
-  NS_ASSERT (slash != std::string::npos);
-  *root = path.substr (0, slash);
-  *leaf = path.substr (slash+1, path.size ()-(slash+1));
-  NS_LOG_FUNCTION (path << *root << *leaf);
-}
-
 void 
 ConfigImpl::Set (std::string path, const AttributeValue &value)
 {
   NS_LOG_FUNCTION (this << path << &value);
-
-  std::string root, leaf;
-  ParsePath (path, &root, &leaf);
-  Config::MatchContainer container = LookupMatches (root);
-  container.Set (leaf, value);
+  Config::CompiledPath (path).Set (value);
 }
 void 
 ConfigImpl::ConnectWithoutContext (std::string path, const CallbackBase &cb)
 {
   NS_LOG_FUNCTION (this << path << &cb);
-  std::string root, leaf;
-  ParsePath (path, &root, &leaf);
-  Config::MatchContainer container = LookupMatches (root);
-  container.ConnectWithoutContext (leaf, cb);
+  Config::CompiledPath (path).ConnectWithoutContext (cb);
 }
 void 
 ConfigImpl::DisconnectWithoutContext (std::string path, const CallbackBase &cb)
 {
   NS_LOG_FUNCTION (this << path << &cb);
-  std::string root, leaf;
-  ParsePath (path, &root, &leaf);
-  Config::MatchContainer container = LookupMatches (root);
-  container.DisconnectWithoutContext (leaf, cb);
+  Config::CompiledPath (path).DisconnectWithoutContext (cb);
 }
 void 
 ConfigImpl::Connect (std::string path, const CallbackBase &cb)
 {
   NS_LOG_FUNCTION (this << path << &cb);
-
-  std::string root, leaf;
-  ParsePath (path, &root, &leaf);
-  Config::MatchContainer container = LookupMatches (root);
-  container.Connect (leaf, cb);
+  Config::CompiledPath (path).Connect (cb);
 }
 void 
 ConfigImpl::Disconnect (std::string path, const CallbackBase &cb)
 {
   NS_LOG_FUNCTION (this << path << &cb);
-
-  std::string root, leaf;
-  ParsePath (path, &root, &leaf);
-  Config::MatchContainer container = LookupMatches (root);
-  container.Disconnect (leaf, cb);
+  Config::CompiledPath (path).Disconnect (cb);
 }
 
 Config::MatchContainer 
 ConfigImpl::LookupMatches (std::string path)
 {
   NS_LOG_FUNCTION (this << path);
-  class LookupMatchesResolver : public Resolver 
-  {
-  public:
-    LookupMatchesResolver (std::string path)
-      : Resolver (path)
-    {}
-    virtual void DoOne (Ptr<Object> object, std::string path) {
-      m_objects.push_back (object);
-      m_contexts.push_back (path);
-    }
-    std::vector<Ptr<Object> > m_objects;
-    std::vector<std::string> m_contexts;
-  } resolver = LookupMatchesResolver (path);
+  return Config::CompiledPath (path).LookupMatches ();
+}
+
+void
+ConfigImpl::Resolve (Resolver &resolver) const
+{
+  NS_LOG_FUNCTION (this << &resolver);
   for (Roots::const_iterator i = m_roots.begin (); i != m_roots.end (); i++)
     {
       resolver.Resolve (*i);
@@ -608,8 +767,6 @@ ConfigImpl::LookupMatches (std::string path)
   // looking at the root of the "/Names" namespace during this go.
   //
   resolver.Resolve (0);
-
-  return Config::MatchContainer (resolver.m_objects, resolver.m_contexts, path);
 }
 
 void 
@@ -649,6 +806,187 @@ ConfigImpl::GetRootNamespaceObject (uint32_t i) const
 
 namespace Config {
 
+CompiledPath::CompiledPath ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CompiledPath::CompiledPath (std::string path)
+  : m_path (path)
+{
+  NS_LOG_FUNCTION (this << path);
+  Compile (path, &m_segments);
+  std::string::size_type slash = path.find_last_of ("/");
+  if (slash != std::string::npos)
+    {
+      Compile (path.substr (0, slash), &m_rootSegments);
+      m_leaf = path.substr (slash + 1, path.size () - (slash + 1));
+    }
+}
+
+void
+CompiledPath::Compile (std::string path, Segments *segments)
+{
+  NS_LOG_FUNCTION (path << segments);
+  // ensure that we start and end with a '/'
+  if (path.find ("/") != 0)
+    {
+      path = "/" + path;
+    }
+  if (path.find_last_of ("/") != path.size () - 1)
+    {
+      path = path + "/";
+    }
+
+  std::string::size_type start = 1;
+  std::string::size_type next;
+  while ((next = path.find ("/", start)) != std::string::npos)
+    {
+      Segment segment;
+      segment.item = path.substr (start, next - start);
+      segment.getObject = segment.item.find ("$") == 0;
+      segment.tidFound = segment.getObject && TypeId::LookupByNameFailSafe (segment.item.substr (1), &segment.tid);
+      segment.all = CompileIndex (segment.item, &segment.ranges);
+      // sort and merge the ranges, so that the matching indexes are found in order
+      std::sort (segment.ranges.begin (), segment.ranges.end ());
+      std::vector<Range> merged;
+      for (std::vector<Range>::const_iterator i = segment.ranges.begin (); i != segment.ranges.end (); ++i)
+        {
+          if (!merged.empty () && i->min <= merged.back ().max)
+            {
+              merged.back ().max = std::max (merged.back ().max, i->max);
+            }
+          else
+            {
+              merged.push_back (*i);
+            }
+        }
+      segment.ranges = merged;
+      segments->push_back (segment);
+      start = next + 1;
+    }
+}
+
+bool
+CompiledPath::CompileIndex (std::string item, std::vector<Range> *ranges)
+{
+  NS_LOG_FUNCTION (item << ranges);
+  if (item == "*")
+    {
+      return true;
+    }
+  std::string::size_type tmp = item.find ("|");
+  if (tmp != std::string::npos)
+    {
+      std::string left = item.substr (0, tmp);
+      std::string right = item.substr (tmp + 1, item.size () - (tmp + 1));
+      bool leftAll = CompileIndex (left, ranges);
+      bool rightAll = CompileIndex (right, ranges);
+      return leftAll || rightAll;
+    }
+  std::string::size_type leftBracket = item.find ("[");
+  std::string::size_type rightBracket = item.find ("]");
+  std::string::size_type dash = item.find ("-");
+  Range range;
+  if (leftBracket == 0 && rightBracket == item.size () - 1 &&
+      dash > leftBracket && dash < rightBracket)
+    {
+      std::string lowerBound = item.substr (leftBracket + 1, dash - (leftBracket + 1));
+      std::string upperBound = item.substr (dash + 1, rightBracket - (dash + 1));
+      if (StringToUint32 (lowerBound, &range.min) &&
+          StringToUint32 (upperBound, &range.max) &&
+          range.min <= range.max)
+        {
+          ranges->push_back (range);
+        }
+      return false;
+    }
+  if (StringToUint32 (item, &range.min))
+    {
+      range.max = range.min;
+      ranges->push_back (range);
+    }
+  return false;
+}
+
+bool
+CompiledPath::StringToUint32 (std::string str, uint32_t *value)
+{
+  NS_LOG_FUNCTION (str << value);
+  std::istringstream iss;
+  iss.str (str);
+  iss >> (*value);
+  return !iss.bad () && !iss.fail ();
+}
+
+std::string
+CompiledPath::GetPath (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_path;
+}
+
+MatchContainer
+CompiledPath::LookupMatches (void) const
+{
+  NS_LOG_FUNCTION (this);
+  LookupMatchesResolver resolver (*this, true);
+  Singleton<ConfigImpl>::Get ()->Resolve (resolver);
+  return MatchContainer (resolver.m_objects, resolver.m_contexts, m_path);
+}
+
+void
+CompiledPath::Set (const AttributeValue &value) const
+{
+  NS_LOG_FUNCTION (this << &value);
+  NS_ASSERT (m_path.find ("/") != std::string::npos);
+  // the objects are all found before any of them is changed
+  LookupMatchesResolver resolver (*this, false);
+  Singleton<ConfigImpl>::Get ()->Resolve (resolver);
+  MatchContainer container (resolver.m_objects, resolver.m_contexts, m_path);
+  container.Set (m_leaf, value);
+}
+
+void
+CompiledPath::Connect (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  NS_ASSERT (m_path.find ("/") != std::string::npos);
+  TraceResolver resolver (TraceResolver::CONNECT);
+  resolver.AddTrace (*this, cb);
+  Singleton<ConfigImpl>::Get ()->Resolve (resolver);
+}
+
+void
+CompiledPath::ConnectWithoutContext (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  NS_ASSERT (m_path.find ("/") != std::string::npos);
+  TraceResolver resolver (TraceResolver::CONNECT_WITHOUT_CONTEXT);
+  resolver.AddTrace (*this, cb);
+  Singleton<ConfigImpl>::Get ()->Resolve (resolver);
+}
+
+void
+CompiledPath::Disconnect (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  NS_ASSERT (m_path.find ("/") != std::string::npos);
+  TraceResolver resolver (TraceResolver::DISCONNECT);
+  resolver.AddTrace (*this, cb);
+  Singleton<ConfigImpl>::Get ()->Resolve (resolver);
+}
+
+void
+CompiledPath::DisconnectWithoutContext (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  NS_ASSERT (m_path.find ("/") != std::string::npos);
+  TraceResolver resolver (TraceResolver::DISCONNECT_WITHOUT_CONTEXT);
+  resolver.AddTrace (*this, cb);
+  Singleton<ConfigImpl>::Get ()->Resolve (resolver);
+}
+
 void Reset (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -746,6 +1084,44 @@ Disconnect (std::string path, const CallbackBase &cb)
   NS_LOG_FUNCTION (path << &cb);
   Singleton<ConfigImpl>::Get ()->Disconnect (path, cb);
 }
+void
+ConnectMany (const std::vector<std::string> &paths, const std::vector<CallbackBase> &cbs)
+{
+  NS_LOG_FUNCTION (&paths << &cbs);
+  NS_ASSERT (paths.size () == cbs.size ());
+  std::vector<CompiledPath> compiled;
+  compiled.reserve (paths.size ());
+  for (uint32_t i = 0; i < paths.size (); i++)
+    {
+      NS_ASSERT (paths[i].find ("/") != std::string::npos);
+      compiled.push_back (CompiledPath (paths[i]));
+    }
+  TraceResolver resolver (TraceResolver::CONNECT);
+  for (uint32_t i = 0; i < compiled.size (); i++)
+    {
+      resolver.AddTrace (compiled[i], cbs[i]);
+    }
+  Singleton<ConfigImpl>::Get ()->Resolve (resolver);
+}
+void
+ConnectWithoutContextMany (const std::vector<std::string> &paths, const std::vector<CallbackBase> &cbs)
+{
+  NS_LOG_FUNCTION (&paths << &cbs);
+  NS_ASSERT (paths.size () == cbs.size ());
+  std::vector<CompiledPath> compiled;
+  compiled.reserve (paths.size ());
+  for (uint32_t i = 0; i < paths.size (); i++)
+    {
+      NS_ASSERT (paths[i].find ("/") != std::string::npos);
+      compiled.push_back (CompiledPath (paths[i]));
+    }
+  TraceResolver resolver (TraceResolver::CONNECT_WITHOUT_CONTEXT);
+  for (uint32_t i = 0; i < compiled.size (); i++)
+    {
+      resolver.AddTrace (compiled[i], cbs[i]);
+    }
+  Singleton<ConfigImpl>::Get ()->Resolve (resolver);
+}
 Config::MatchContainer LookupMatches (std::string path)
 {
   NS_LOG_FUNCTION (path);
@@ -21,6 +21,7 @@
 #define CONFIG_H
 
 #include "ptr.h"
+#include "type-id.h"
 #include <string>
 #include <vector>
 
@@ -29,6 +30,7 @@ namespace ns3 {
 class AttributeValue;
 class Object;
 class CallbackBase;
+class Resolver;
 
 /**
  * \brief Configuration of simulation parameters and tracing
@@ -222,6 +224,137 @@ private:
  */
 MatchContainer LookupMatches (std::string path);
 
+/**
+ * \brief a path parsed once, to be resolved many times.
+ *
+ * Config::Set and Config::Connect parse their path each time they are
+ * called.  A CompiledPath splits the path into its segments, looks up
+ * the TypeId of its $TypeId segments and turns its index segments into
+ * ranges of indexes once, so that the elements of a container which
+ * match a path such as "/NodeList/3/DeviceList/0/Mac/MacRx" are
+ * fetched from the container by position rather than by testing each
+ * of its elements.  The attributes of a segment and the trace source of
+ * the last segment are looked up once per TypeId.
+ *
+ * The objects matched are the same, in the same order, as with the
+ * functions of namespace Config, which use a CompiledPath too.
+ */
+class CompiledPath
+{
+public:
+  CompiledPath ();
+  /**
+   * \param path a path to match attributes, trace sources or objects.
+   */
+  CompiledPath (std::string path);
+
+  /**
+   * \returns the path this object was built from.
+   */
+  std::string GetPath (void) const;
+  /**
+   * \returns a container which contains all the objects which match
+   *          the whole path.
+   * \sa ns3::Config::LookupMatches
+   */
+  MatchContainer LookupMatches (void) const;
+  /**
+   * \param value the value to set in all matching attributes.
+   * \sa ns3::Config::Set
+   */
+  void Set (const AttributeValue &value) const;
+  /**
+   * \param cb the callback to connect to the matching trace sources.
+   * \sa ns3::Config::Connect
+   */
+  void Connect (const CallbackBase &cb) const;
+  /**
+   * \param cb the callback to connect to the matching trace sources.
+   * \sa ns3::Config::ConnectWithoutContext
+   */
+  void ConnectWithoutContext (const CallbackBase &cb) const;
+  /**
+   * \param cb the callback to disconnect from the matching trace sources.
+   * \sa ns3::Config::Disconnect
+   */
+  void Disconnect (const CallbackBase &cb) const;
+  /**
+   * \param cb the callback to disconnect from the matching trace sources.
+   * \sa ns3::Config::DisconnectWithoutContext
+   */
+  void DisconnectWithoutContext (const CallbackBase &cb) const;
+
+private:
+  friend class ns3::Resolver;
+
+  /** A range of indexes, bounds included. */
+  struct Range
+  {
+    uint32_t min;  //!< the first index
+    uint32_t max;  //!< the last index
+    /**
+     * \param o another range
+     * \returns true if this range starts before o
+     */
+    bool operator < (const Range &o) const { return min < o.min; }
+  };
+  /** A segment of the path, between two '/'. */
+  struct Segment
+  {
+    std::string item;           //!< the text of the segment
+    bool getObject;             //!< the segment is a $TypeId
+    bool tidFound;              //!< the TypeId of a $TypeId segment exists
+    TypeId tid;                 //!< the TypeId of a $TypeId segment
+    bool all;                   //!< as an index, the segment matches any index
+    std::vector<Range> ranges;  //!< as an index, the ranges it matches, sorted
+  };
+  typedef std::vector<Segment> Segments;
+
+  /**
+   * \param path a path
+   * \param segments the segments of the path
+   */
+  static void Compile (std::string path, Segments *segments);
+  /**
+   * \param item a segment
+   * \param ranges the ranges of indexes matched by the segment
+   * \returns true if the segment matches any index
+   */
+  static bool CompileIndex (std::string item, std::vector<Range> *ranges);
+  /**
+   * \param str a decimal number
+   * \param value the number
+   * \returns true if the number could be read
+   */
+  static bool StringToUint32 (std::string str, uint32_t *value);
+
+  std::string m_path;         //!< the path
+  Segments m_segments;        //!< the segments of the whole path
+  Segments m_rootSegments;    //!< the segments before the last '/'
+  std::string m_leaf;         //!< the text after the last '/'
+};
+
+/**
+ * \param paths paths to match trace sources.
+ * \param cbs the callbacks to connect, one per path.
+ *
+ * Connect each callback to the trace sources matched by its path, as
+ * Config::Connect does.  This is the usual way to connect a sink bound
+ * to its node or device to each of many nodes or devices: the paths are
+ * resolved together, so that the segments which start several of them
+ * are resolved once, and share the lookups of their attributes and
+ * trace sources.
+ */
+void ConnectMany (const std::vector<std::string> &paths, const std::vector<CallbackBase> &cbs);
+/**
+ * \param paths paths to match trace sources.
+ * \param cbs the callbacks to connect, one per path.
+ *
+ * Connect each callback to the trace sources matched by its path, as
+ * Config::ConnectWithoutContext does.
+ */
+void ConnectWithoutContextMany (const std::vector<std::string> &paths, const std::vector<CallbackBase> &cbs);
+
 /**
  * \param obj a new root object
  *
@@ -0,0 +1,287 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "dary-heap-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DaryHeapScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (DaryHeapScheduler);
+
+namespace {
+/* Number of children of each node of the heap. */
+const uint32_t ARITY = 4;
+/* Size of the cache line the sibling groups are aligned on. */
+const uintptr_t CACHE_LINE = 64;
+/* Smallest number of events the arrays are sized for. */
+const uint32_t MIN_CAPACITY = 64;
+} // anonymous namespace
+
+TypeId
+DaryHeapScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DaryHeapScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<DaryHeapScheduler> ()
+  ;
+  return tid;
+}
+
+DaryHeapScheduler::DaryHeapScheduler ()
+  : m_buffer (0),
+    m_keys (0),
+    m_impls (0),
+    m_size (0),
+    m_capacity (0)
+{
+  NS_LOG_FUNCTION (this);
+  Reallocate (MIN_CAPACITY);
+}
+
+DaryHeapScheduler::~DaryHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+  delete [] m_buffer;
+  delete [] m_impls;
+}
+
+void
+DaryHeapScheduler::Reallocate (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+  NS_ASSERT (capacity >= m_size);
+  // The children of node i are stored at indexes ARITY*i+1 to ARITY*i+ARITY
+  // so we align the address of m_keys[1] on a cache line boundary: each
+  // group of siblings then fills exactly one cache line.
+  uint8_t *buffer = new uint8_t [(capacity + 1) * sizeof (EventKey) + CACHE_LINE];
+  uintptr_t first = reinterpret_cast<uintptr_t> (buffer) + sizeof (EventKey);
+  first = (first + CACHE_LINE - 1) & ~(CACHE_LINE - 1);
+  EventKey *keys = reinterpret_cast<EventKey *> (first) - 1;
+  EventImpl **impls = new EventImpl * [capacity];
+  if (m_size > 0)
+    {
+      std::memcpy (keys, m_keys, m_size * sizeof (EventKey));
+      std::memcpy (impls, m_impls, m_size * sizeof (EventImpl *));
+    }
+  delete [] m_buffer;
+  delete [] m_impls;
+  m_buffer = buffer;
+  m_keys = keys;
+  m_impls = impls;
+  m_capacity = capacity;
+}
+
+uint32_t
+DaryHeapScheduler::Parent (uint32_t id) const
+{
+  return (id - 1) / ARITY;
+}
+
+uint32_t
+DaryHeapScheduler::FirstChild (uint32_t id) const
+{
+  return id * ARITY + 1;
+}
+
+void
+DaryHeapScheduler::Move (uint32_t to, uint32_t from)
+{
+  m_keys[to] = m_keys[from];
+  m_impls[to] = m_impls[from];
+}
+
+void
+DaryHeapScheduler::SiftUp (uint32_t index, EventKey key, EventImpl *impl)
+{
+  NS_LOG_FUNCTION (this << index);
+  // Move the parents down until we find the hole where the event belongs.
+  while (index > 0)
+    {
+      uint32_t parent = Parent (index);
+      if (!(key < m_keys[parent]))
+        {
+          break;
+        }
+      Move (index, parent);
+      index = parent;
+    }
+  m_keys[index] = key;
+  m_impls[index] = impl;
+}
+
+void
+DaryHeapScheduler::SiftDown (uint32_t index, EventKey key, EventImpl *impl)
+{
+  NS_LOG_FUNCTION (this << index);
+  while (true)
+    {
+      uint32_t first = FirstChild (index);
+      if (first >= m_size)
+        {
+          break;
+        }
+      uint32_t last = first + ARITY;
+      if (last > m_size)
+        {
+          last = m_size;
+        }
+      uint32_t smallest = first;
+      for (uint32_t child = first + 1; child < last; child++)
+        {
+          if (m_keys[child] < m_keys[smallest])
+            {
+              smallest = child;
+            }
+        }
+      if (!(m_keys[smallest] < key))
+        {
+          break;
+        }
+      Move (index, smallest);
+      index = smallest;
+    }
+  m_keys[index] = key;
+  m_impls[index] = impl;
+}
+
+void
+DaryHeapScheduler::RemoveAt (uint32_t index)
+{
+  NS_LOG_FUNCTION (this << index);
+  NS_ASSERT (index < m_size);
+  m_size--;
+  if (index == m_size)
+    {
+      return;
+    }
+  // fill the hole with the last event of the array
+  EventKey key = m_keys[m_size];
+  EventImpl *impl = m_impls[m_size];
+  if (index > 0 && key < m_keys[Parent (index)])
+    {
+      SiftUp (index, key, impl);
+    }
+  else
+    {
+      SiftDown (index, key, impl);
+    }
+}
+
+void
+DaryHeapScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  if (m_size == m_capacity)
+    {
+      Reallocate (2 * m_capacity);
+    }
+  m_size++;
+  SiftUp (m_size - 1, ev.key, ev.impl);
+}
+
+bool
+DaryHeapScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+DaryHeapScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event next;
+  next.impl = m_impls[0];
+  next.key = m_keys[0];
+  return next;
+}
+
+Scheduler::Event
+DaryHeapScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  Event next = PeekNext ();
+  RemoveAt (0);
+  return next;
+}
+
+void
+DaryHeapScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  uint32_t uid = ev.key.m_uid;
+  for (uint32_t i = 0; i < m_size; i++)
+    {
+      if (uid == m_keys[i].m_uid)
+        {
+          NS_ASSERT (m_impls[i] == ev.impl);
+          RemoveAt (i);
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+uint32_t
+DaryHeapScheduler::RemoveCancelled (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < m_size; i++)
+    {
+      if (m_impls[i]->IsCancelled ())
+        {
+          m_impls[i]->Unref ();
+        }
+      else
+        {
+          Move (kept, i);
+          kept++;
+        }
+    }
+  uint32_t removed = m_size - kept;
+  m_size = kept;
+  if (removed == 0)
+    {
+      return 0;
+    }
+  // rebuild the heap bottom-up, starting from the last internal node
+  if (m_size > 1)
+    {
+      for (uint32_t i = Parent (m_size - 1) + 1; i > 0; i--)
+        {
+          SiftDown (i - 1, m_keys[i - 1], m_impls[i - 1]);
+        }
+    }
+  // give back the memory used by the dead events
+  if (m_capacity > MIN_CAPACITY && m_capacity > 4 * m_size)
+    {
+      uint32_t capacity = 2 * m_size;
+      Reallocate (capacity > MIN_CAPACITY ? capacity : MIN_CAPACITY);
+    }
+  NS_LOG_DEBUG ("removed " << removed << " cancelled events, " << m_size << " left");
+  return removed;
+}
+
+} // namespace ns3
@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DARY_HEAP_SCHEDULER_H
+#define DARY_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a cache-friendly 4-ary heap event scheduler
+ *
+ * This scheduler is an implicit heap like HeapScheduler but it differs
+ * from it in two ways:
+ *  - every node has four children instead of two. The tree is thus half
+ *    as deep, which halves the number of levels visited by Insert and
+ *    RemoveNext at the cost of more comparisons per level.
+ *  - the EventKey of each event is stored in an array separate from
+ *    the EventImpl pointers, and that array is aligned such that the
+ *    four 16-byte keys of any group of siblings share a single 64-byte
+ *    cache line. Sifting events up and down the heap only touches the
+ *    key array, that is, one cache line per level.
+ *
+ * This scheduler also implements Scheduler::RemoveCancelled: the
+ * simulator can thus periodically purge the cancelled events in linear
+ * time instead of leaving them in the heap until they expire, and the
+ * storage shrinks back when most of the pending events were cancelled.
+ */
+class DaryHeapScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  DaryHeapScheduler ();
+  virtual ~DaryHeapScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+  virtual uint32_t RemoveCancelled (void);
+
+private:
+  inline uint32_t Parent (uint32_t id) const;
+  inline uint32_t FirstChild (uint32_t id) const;
+  inline void Move (uint32_t to, uint32_t from);
+  void SiftUp (uint32_t index, EventKey key, EventImpl *impl);
+  void SiftDown (uint32_t index, EventKey key, EventImpl *impl);
+  void RemoveAt (uint32_t index);
+  /* Reallocate the key and payload arrays to hold capacity events. */
+  void Reallocate (uint32_t capacity);
+
+  uint8_t *m_buffer;    // raw storage for the aligned key array
+  EventKey *m_keys;     // m_keys[i] is the key of the event at index i
+  EventImpl **m_impls;  // m_impls[i] is the payload of the event at index i
+  uint32_t m_size;
+  uint32_t m_capacity;
+};
+
+} // namespace ns3
+
+#endif /* DARY_HEAP_SCHEDULER_H */
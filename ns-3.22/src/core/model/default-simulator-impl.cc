@@ -25,10 +25,13 @@
 
 #include "ptr.h"
 #include "pointer.h"
+#include "uinteger.h"
+#include "boolean.h"
 #include "assert.h"
 #include "log.h"
 
 #include <cmath>
+#include <algorithm>
 
 
 namespace ns3 {
@@ -40,12 +43,45 @@ NS_LOG_COMPONENT_DEFINE ("DefaultSimulatorImpl");
 
 NS_OBJECT_ENSURE_REGISTERED (DefaultSimulatorImpl);
 
+/**
+ * Minimum number of cancelled events left in the scheduler before
+ * we ask it to remove them.
+ */
+static const int MIN_CANCELLED_EVENTS_THRESHOLD = 1024;
+
 TypeId
 DefaultSimulatorImpl::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::DefaultSimulatorImpl")
     .SetParent<SimulatorImpl> ()
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("EventImplPool",
+                   "The pool the memory of the events is allocated from.",
+                   TypeId::ATTR_GET,
+                   PointerValue (),
+                   MakePointerAccessor (&DefaultSimulatorImpl::m_eventPool),
+                   MakePointerChecker<EventImplPool> ())
+    .AddAttribute ("InjectedEvents",
+                   "The number of events scheduled by other threads "
+                   "than the main one.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::GetInjectedEvents),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("InjectedEventsProcessed",
+                   "The number of events scheduled by other threads "
+                   "than the main one which were moved into the event list.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::GetInjectedEventsProcessed),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("Profile",
+                   "Measure the wall clock time spent in each type of event, "
+                   "and print it when the simulator is destroyed. This is "
+                   "ignored unless ns-3 is configured with --enable-event-profiler.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DefaultSimulatorImpl::m_profile),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -64,8 +100,15 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
-  m_eventsWithContextEmpty = true;
+  m_cancelledEvents = 0;
+  m_cancelledEventsThreshold = MIN_CANCELLED_EVENTS_THRESHOLD;
+  m_eventsWithContext = 0;
+  m_eventsWithContextInjected = 0;
+  m_eventsWithContextProcessed = 0;
+  m_profile = false;
   m_main = SystemThread::Self();
+  m_eventPool = CreateObject<EventImplPool> ();
+  EventImplPool::SetCurrent (m_eventPool);
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl ()
@@ -83,6 +126,20 @@ DefaultSimulatorImpl::DoDispose (void)
       next.impl->Unref ();
     }
   m_events = 0;
+  EventWithContext *ev = __sync_lock_test_and_set (&m_eventsWithContext, (EventWithContext *)0);
+  while (ev != 0)
+    {
+      EventWithContext *next = ev->next;
+      ev->event->Unref ();
+      delete ev;
+      ev = next;
+    }
+  // The pool is deleted when the last event allocated from it is.
+  m_eventPool->Dispose ();
+  m_eventPool = 0;
+#ifdef NS3_EVENT_PROFILER
+  m_profiler = 0;
+#endif
   SimulatorImpl::DoDispose ();
 }
 void
@@ -99,6 +156,12 @@ DefaultSimulatorImpl::Destroy ()
           ev->Invoke ();
         }
     }
+#ifdef NS3_EVENT_PROFILER
+  if (m_profiler != 0)
+    {
+      m_profiler->Report ();
+    }
+#endif
 }
 
 void
@@ -137,7 +200,23 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
-  next.impl->Invoke ();
+  if (next.impl->IsCancelled ())
+    {
+      m_cancelledEvents--;
+    }
+#ifdef NS3_EVENT_PROFILER
+  if (m_profiler != 0)
+    {
+      uint32_t uid = m_uid;
+      m_profiler->Start (next.impl, next.key.m_context);
+      next.impl->Invoke ();
+      m_profiler->Stop (m_uid - uid);
+    }
+  else
+#endif
+    {
+      next.impl->Invoke ();
+    }
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
@@ -152,30 +231,36 @@ DefaultSimulatorImpl::IsFinished (void) const
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  if (m_eventsWithContext == 0)
     {
       return;
     }
 
-  // swap queues
-  EventsWithContext eventsWithContext;
-  {
-    CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
-  }
-  while (!eventsWithContext.empty ())
+  // take the whole stack, and reverse it to insert the events in the
+  // order they were scheduled
+  EventWithContext *stack = __sync_lock_test_and_set (&m_eventsWithContext, (EventWithContext *)0);
+  EventWithContext *eventsWithContext = 0;
+  while (stack != 0)
     {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
+      EventWithContext *next = stack->next;
+      stack->next = eventsWithContext;
+      eventsWithContext = stack;
+      stack = next;
+    }
+  while (eventsWithContext != 0)
+    {
+       EventWithContext *event = eventsWithContext;
+       eventsWithContext = event->next;
        Scheduler::Event ev;
-       ev.impl = event.event;
-       ev.key.m_ts = m_currentTs + event.timestamp;
-       ev.key.m_context = event.context;
+       ev.impl = event->event;
+       ev.key.m_ts = m_currentTs + event->timestamp;
+       ev.key.m_context = event->context;
        ev.key.m_uid = m_uid;
        m_uid++;
        m_unscheduledEvents++;
        m_events->Insert (ev);
+       m_eventsWithContextProcessed++;
+       delete event;
     }
 }
 
@@ -185,6 +270,13 @@ DefaultSimulatorImpl::Run (void)
   NS_LOG_FUNCTION (this);
   // Set the current threadId as the main threadId
   m_main = SystemThread::Self();
+  m_eventPool->SetOwner (m_main);
+#ifdef NS3_EVENT_PROFILER
+  if (m_profile && m_profiler == 0)
+    {
+      m_profiler = CreateObject<EventProfiler> ();
+    }
+#endif
   ProcessEventsWithContext ();
   m_stop = false;
 
@@ -255,15 +347,20 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, E
     }
   else
     {
-      EventWithContext ev;
-      ev.context = context;
-      ev.timestamp = time.GetTimeStep ();
-      ev.event = event;
-      {
-        CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
-      }
+      EventWithContext *ev = new EventWithContext;
+      ev->context = context;
+      ev->timestamp = time.GetTimeStep ();
+      ev->event = event;
+      // counted first so that the number of injected events is never
+      // lower than the number of processed ones
+      __sync_fetch_and_add (&m_eventsWithContextInjected, 1);
+      EventWithContext *head;
+      do
+        {
+          head = m_eventsWithContext;
+          ev->next = head;
+        }
+      while (!__sync_bool_compare_and_swap (&m_eventsWithContext, head, ev));
     }
 }
 
@@ -353,9 +450,37 @@ DefaultSimulatorImpl::Cancel (const EventId &id)
   if (!IsExpired (id))
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () == 2)
+        {
+          // destroy events are not stored in the scheduler.
+          return;
+        }
+      m_cancelledEvents++;
+      // Only purge when the cancelled events make up most of the event
+      // list so that the cost of the purge is amortized over the calls
+      // to Cancel which made it necessary.
+      if (m_cancelledEvents >= m_cancelledEventsThreshold
+          && 2 * m_cancelledEvents > m_unscheduledEvents)
+        {
+          RemoveCancelledEvents ();
+        }
     }
 }
 
+void
+DefaultSimulatorImpl::RemoveCancelledEvents (void)
+{
+  NS_LOG_FUNCTION (this);
+  int removed = m_events->RemoveCancelled ();
+  NS_ASSERT (removed <= m_cancelledEvents);
+  m_unscheduledEvents -= removed;
+  m_cancelledEvents -= removed;
+  // If the scheduler does not support RemoveCancelled, back off
+  // exponentially to keep the cost of trying negligible.
+  m_cancelledEventsThreshold = std::max (MIN_CANCELLED_EVENTS_THRESHOLD,
+                                         2 * m_cancelledEvents);
+}
+
 bool
 DefaultSimulatorImpl::IsExpired (const EventId &id) const
 {
@@ -404,4 +529,16 @@ DefaultSimulatorImpl::GetContext (void) const
   return m_currentContext;
 }
 
+uint64_t
+DefaultSimulatorImpl::GetInjectedEvents (void) const
+{
+  return __sync_fetch_and_add (const_cast<uint64_t *> (&m_eventsWithContextInjected), 0);
+}
+
+uint64_t
+DefaultSimulatorImpl::GetInjectedEventsProcessed (void) const
+{
+  return m_eventsWithContextProcessed;
+}
+
 } // namespace ns3
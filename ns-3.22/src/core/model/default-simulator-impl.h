@@ -24,8 +24,12 @@
 #include "simulator-impl.h"
 #include "scheduler.h"
 #include "event-impl.h"
+#include "event-impl-pool.h"
+#include "ns3/core-config.h"
+#ifdef NS3_EVENT_PROFILER
+#include "event-profiler.h"
+#endif
 #include "system-thread.h"
-#include "ns3/system-mutex.h"
 
 #include "ptr.h"
 
@@ -37,6 +41,21 @@ namespace ns3 {
  * \ingroup simulator
  *
  * The default single process simulator implementation.
+ *
+ * The memory of the events created while this simulator is the current
+ * one is allocated from an EventImplPool owned by the simulator, which
+ * can be inspected through the EventImplPool attribute.
+ *
+ * The events scheduled by other threads than the main one, for example
+ * the reader threads of the emulated net devices, are pushed onto a
+ * lock-free stack which the main thread empties in one go after each
+ * event, so that these threads never wait for the main event loop nor
+ * the other way around.
+ *
+ * When ns-3 is configured with --enable-event-profiler, setting the
+ * Profile attribute makes the simulator profile the execution of the
+ * events with an EventProfiler, and print its report when the simulator
+ * is destroyed.
  */
 class DefaultSimulatorImpl : public SimulatorImpl
 {
@@ -65,20 +84,40 @@ public:
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
 
+  /**
+   * \returns the number of events scheduled by other threads than the
+   *          main one so far.
+   */
+  uint64_t GetInjectedEvents (void) const;
+  /**
+   * \returns the number of events scheduled by other threads than the
+   *          main one which were moved into the event list so far.
+   */
+  uint64_t GetInjectedEventsProcessed (void) const;
+
 private:
   virtual void DoDispose (void);
   void ProcessOneEvent (void);
   void ProcessEventsWithContext (void);
+  /**
+   * Ask the scheduler to drop the cancelled events it holds, and
+   * update the event counters accordingly.
+   */
+  void RemoveCancelledEvents (void);
  
   struct EventWithContext {
     uint32_t context;
     uint64_t timestamp;
     EventImpl *event;
+    // the event scheduled right before this one
+    struct EventWithContext *next;
   };
-  typedef std::list<struct EventWithContext> EventsWithContext;
-  EventsWithContext m_eventsWithContext;
-  bool m_eventsWithContextEmpty;
-  SystemMutex m_eventsWithContextMutex;
+  // Most recent first. Other threads push with a compare-and-swap and
+  // the main thread takes the whole stack with an atomic exchange.
+  struct EventWithContext * volatile m_eventsWithContext;
+  // incremented atomically by the other threads
+  uint64_t m_eventsWithContextInjected;
+  uint64_t m_eventsWithContextProcessed;
 
   typedef std::list<EventId> DestroyEvents;
   DestroyEvents m_destroyEvents;
@@ -92,8 +131,18 @@ private:
   // number of events that have been inserted but not yet scheduled,
   // not counting the "destroy" events; this is used for validation
   int m_unscheduledEvents;
+  // number of events still in the scheduler which have been cancelled
+  int m_cancelledEvents;
+  // value of m_cancelledEvents above which we try to purge them
+  int m_cancelledEventsThreshold;
 
   SystemThread::ThreadId m_main;
+  Ptr<EventImplPool> m_eventPool;
+
+  bool m_profile;
+#ifdef NS3_EVENT_PROFILER
+  Ptr<EventProfiler> m_profiler;
+#endif
 };
 
 } // namespace ns3
@@ -0,0 +1,373 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-impl-pool.h"
+#include "uinteger.h"
+#include "assert.h"
+#include "log.h"
+#include <new>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventImplPool implementation.
+ */
+
+namespace ns3 {
+
+// Note: the allocation functions are called for every event: they only
+// log when a new chunk is reserved.
+NS_LOG_COMPONENT_DEFINE ("EventImplPool");
+
+NS_OBJECT_ENSURE_REGISTERED (EventImplPool);
+
+namespace {
+/* Alignment of the objects, and granularity of the size classes. */
+const std::size_t ALIGNMENT = 16;
+/* Space reserved for the header in front of each object. */
+const std::size_t HEADER_SIZE = 16;
+/* Size of the largest blocks served by the pool, header included. */
+const std::size_t MAX_BLOCK_SIZE = 256;
+/* Size of the chunks of memory the blocks are carved out of. */
+const std::size_t CHUNK_SIZE = 64 * 1024;
+/* Value of Header::sizeClass for the blocks allocated on the heap. */
+const uint32_t HEAP_CLASS = 0xffffffff;
+
+uint8_t **
+NextFree (uint8_t *block)
+{
+  return reinterpret_cast<uint8_t **> (block + HEADER_SIZE);
+}
+} // anonymous namespace
+
+EventImplPool *EventImplPool::m_current = 0;
+
+TypeId
+EventImplPool::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::EventImplPool")
+    .SetParent<Object> ()
+    .AddConstructor<EventImplPool> ()
+    .AddAttribute ("Allocations",
+                   "The number of events allocated from the pool so far.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&EventImplPool::GetAllocations),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("HeapAllocations",
+                   "The number of events allocated on the heap because "
+                   "they were too large for the pool.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&EventImplPool::GetHeapAllocations),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("BlocksInUse",
+                   "The number of blocks of the pool currently in use.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&EventImplPool::GetBlocksInUse),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("PeakBlocksInUse",
+                   "The largest number of blocks in use at the same time.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&EventImplPool::GetPeakBlocksInUse),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("ReservedBytes",
+                   "The number of bytes reserved from the heap by the pool.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&EventImplPool::GetReservedBytes),
+                   MakeUintegerChecker<uint64_t> ())
+  ;
+  return tid;
+}
+
+EventImplPool::EventImplPool ()
+  : m_owner (SystemThread::Self ()),
+    m_freeLists (MAX_BLOCK_SIZE / ALIGNMENT, 0),
+    m_arena (0),
+    m_arenaEnd (0),
+    m_remote (0),
+    m_remoteBlocks (0),
+    m_disposed (false),
+    m_allocations (0),
+    m_heapAllocations (0),
+    m_blocksInUse (0),
+    m_peakBlocksInUse (0),
+    m_reservedBytes (0)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (sizeof (Header) <= HEADER_SIZE);
+}
+
+EventImplPool::~EventImplPool ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_blocksInUse == 0);
+  for (std::vector<uint8_t *>::iterator i = m_chunks.begin (); i != m_chunks.end (); i++)
+    {
+      delete [] *i;
+    }
+  m_chunks.clear ();
+}
+
+void
+EventImplPool::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_current == this)
+    {
+      m_current = 0;
+    }
+  bool unused;
+  {
+    CriticalSection cs (m_remoteMutex);
+    m_disposed = true;
+    uint8_t *block = m_remote;
+    m_remote = 0;
+    __sync_lock_test_and_set (&m_remoteBlocks, 0);
+    unused = (block != 0);
+    while (block != 0)
+      {
+        uint8_t *next = *NextFree (block);
+        Release (block);
+        m_blocksInUse--;
+        block = next;
+      }
+    unused = unused && m_blocksInUse == 0;
+  }
+  Object::DoDispose ();
+  if (unused)
+    {
+      // the caller of Dispose still holds a reference to this pool
+      Unref ();
+    }
+}
+
+void
+EventImplPool::SetCurrent (Ptr<EventImplPool> pool)
+{
+  NS_LOG_FUNCTION (pool);
+  m_current = PeekPointer (pool);
+}
+
+Ptr<EventImplPool>
+EventImplPool::GetCurrent (void)
+{
+  return m_current;
+}
+
+void
+EventImplPool::SetOwner (SystemThread::ThreadId owner)
+{
+  NS_LOG_FUNCTION (this);
+  m_owner = owner;
+}
+
+void *
+EventImplPool::Allocate (std::size_t size)
+{
+  EventImplPool *pool = m_current;
+  uint8_t *block;
+  if (pool != 0 && SystemThread::Equals (pool->m_owner))
+    {
+      block = pool->DoAllocate (size);
+    }
+  else
+    {
+      block = static_cast<uint8_t *> (::operator new (HEADER_SIZE + size));
+      Header *header = reinterpret_cast<Header *> (block);
+      header->pool = 0;
+      header->sizeClass = HEAP_CLASS;
+    }
+  return block + HEADER_SIZE;
+}
+
+void
+EventImplPool::Deallocate (void *object, std::size_t size)
+{
+  if (object == 0)
+    {
+      return;
+    }
+  uint8_t *block = static_cast<uint8_t *> (object) - HEADER_SIZE;
+  Header *header = reinterpret_cast<Header *> (block);
+  if (header->pool == 0)
+    {
+      ::operator delete (block);
+      return;
+    }
+  NS_ASSERT (header->sizeClass == (HEADER_SIZE + size - 1) / ALIGNMENT);
+  header->pool->DoDeallocate (block);
+}
+
+uint8_t *
+EventImplPool::DoAllocate (std::size_t size)
+{
+  if (__sync_fetch_and_add (&m_remoteBlocks, 0) != 0)
+    {
+      DrainRemote ();
+    }
+  uint32_t sizeClass = (HEADER_SIZE + size - 1) / ALIGNMENT;
+  if (sizeClass >= m_freeLists.size ())
+    {
+      m_heapAllocations++;
+      uint8_t *block = static_cast<uint8_t *> (::operator new (HEADER_SIZE + size));
+      Header *header = reinterpret_cast<Header *> (block);
+      header->pool = 0;
+      header->sizeClass = HEAP_CLASS;
+      return block;
+    }
+  uint8_t *block = m_freeLists[sizeClass];
+  if (block != 0)
+    {
+      m_freeLists[sizeClass] = *NextFree (block);
+    }
+  else
+    {
+      std::size_t blockSize = (sizeClass + 1) * ALIGNMENT;
+      if (static_cast<std::size_t> (m_arenaEnd - m_arena) < blockSize)
+        {
+          // The tail of the previous chunk is lost, which wastes less
+          // than MAX_BLOCK_SIZE bytes per chunk.
+          NS_LOG_LOGIC ("new chunk for pool " << this);
+          m_arena = new uint8_t [CHUNK_SIZE];
+          m_arenaEnd = m_arena + CHUNK_SIZE;
+          m_chunks.push_back (m_arena);
+          m_reservedBytes += CHUNK_SIZE;
+        }
+      block = m_arena;
+      m_arena += blockSize;
+      Header *header = reinterpret_cast<Header *> (block);
+      header->pool = this;
+      header->sizeClass = sizeClass;
+    }
+  m_allocations++;
+  m_blocksInUse++;
+  if (m_blocksInUse > m_peakBlocksInUse)
+    {
+      m_peakBlocksInUse = m_blocksInUse;
+    }
+  if (m_blocksInUse == 1)
+    {
+      // keep the chunks alive until the last block is released
+      Ref ();
+    }
+  return block;
+}
+
+void
+EventImplPool::DoDeallocate (uint8_t *block)
+{
+  if (!SystemThread::Equals (m_owner) || m_disposed)
+    {
+      bool unused;
+      {
+        CriticalSection cs (m_remoteMutex);
+        if (!m_disposed)
+          {
+            *NextFree (block) = m_remote;
+            m_remote = block;
+            __sync_fetch_and_add (&m_remoteBlocks, 1);
+            return;
+          }
+        Release (block);
+        m_blocksInUse--;
+        unused = (m_blocksInUse == 0);
+      }
+      if (unused)
+        {
+          Unref ();
+        }
+      return;
+    }
+  Release (block);
+  m_blocksInUse--;
+  if (m_blocksInUse == 0)
+    {
+      Unref ();
+    }
+}
+
+void
+EventImplPool::Release (uint8_t *block)
+{
+  Header *header = reinterpret_cast<Header *> (block);
+  NS_ASSERT (header->pool == this);
+  *NextFree (block) = m_freeLists[header->sizeClass];
+  m_freeLists[header->sizeClass] = block;
+}
+
+void
+EventImplPool::DrainRemote (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint8_t *block;
+  {
+    CriticalSection cs (m_remoteMutex);
+    block = m_remote;
+    m_remote = 0;
+    __sync_lock_test_and_set (&m_remoteBlocks, 0);
+  }
+  while (block != 0)
+    {
+      uint8_t *next = *NextFree (block);
+      Release (block);
+      m_blocksInUse--;
+      block = next;
+    }
+  if (m_blocksInUse == 0)
+    {
+      // DoAllocate is only reached through m_current, which is set while
+      // the simulator owning this pool holds a reference to it.
+      Unref ();
+    }
+}
+
+uint64_t
+EventImplPool::GetAllocations (void) const
+{
+  return m_allocations;
+}
+
+uint64_t
+EventImplPool::GetHeapAllocations (void) const
+{
+  return m_heapAllocations;
+}
+
+uint64_t
+EventImplPool::GetBlocksInUse (void) const
+{
+  return m_blocksInUse;
+}
+
+uint64_t
+EventImplPool::GetPeakBlocksInUse (void) const
+{
+  return m_peakBlocksInUse;
+}
+
+uint64_t
+EventImplPool::GetReservedBytes (void) const
+{
+  return m_reservedBytes;
+}
+
+} // namespace ns3
@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_IMPL_POOL_H
+#define EVENT_IMPL_POOL_H
+
+#include "object.h"
+#include "system-thread.h"
+#include "system-mutex.h"
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventImplPool declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup events
+ * \brief A size-class allocator for the memory of EventImpl objects.
+ *
+ * EventImpl overrides its operator new and operator delete to forward
+ * to Allocate and Deallocate, so that every event created by one of the
+ * MakeEvent functions is served by the pool of the current simulator
+ * instead of by the global allocator. The pool carves blocks out of
+ * large chunks of memory, rounds their size up to one of a small set of
+ * size classes, and keeps one free list per size class: once the
+ * number of pending events has reached its steady state, scheduling an
+ * event and releasing it after it expired only pushes and pops blocks
+ * from these free lists.
+ *
+ * A pool is owned by a simulator implementation, which installs it with
+ * SetCurrent and declares its main thread with SetOwner. The free lists
+ * are touched without any locking by the owner thread only:
+ *  - events allocated by another thread, for example through
+ *    Simulator::ScheduleWithContext, and events too large for the
+ *    biggest size class, are allocated on the heap as usual.
+ *  - blocks released by another thread are queued under a mutex and
+ *    moved back to their free list by the owner thread.
+ *
+ * Every block records the pool it belongs to, and each pool keeps
+ * itself alive while some of its blocks are in use, so events may
+ * safely outlive the simulator which created them. Once the pool is
+ * disposed, its owner no longer allocates from it: the queued blocks
+ * are released by Dispose, and the blocks released later, by any
+ * thread, go back to the free lists under the mutex, so that the pool
+ * is deleted with the last of them.
+ */
+class EventImplPool : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  EventImplPool ();
+  virtual ~EventImplPool ();
+
+  /**
+   * \param size the size of the object to allocate
+   * \returns memory for an object of this size, taken from the current
+   *          pool if it is called from the owner thread of that pool.
+   */
+  static void *Allocate (std::size_t size);
+  /**
+   * \param object memory returned by Allocate
+   * \param size the size which was given to Allocate
+   */
+  static void Deallocate (void *object, std::size_t size);
+  /**
+   * \param pool the pool used by the following calls to Allocate, or
+   *        zero to use the heap.
+   */
+  static void SetCurrent (Ptr<EventImplPool> pool);
+  /**
+   * \returns the pool used by Allocate, if any.
+   */
+  static Ptr<EventImplPool> GetCurrent (void);
+
+  /**
+   * \param owner the only thread which may use the free lists.
+   */
+  void SetOwner (SystemThread::ThreadId owner);
+
+  /** \returns the number of blocks allocated from the pool so far. */
+  uint64_t GetAllocations (void) const;
+  /** \returns the number of events the owner thread allocated on
+   *  the heap because they were too large for the pool. */
+  uint64_t GetHeapAllocations (void) const;
+  /** \returns the number of blocks currently in use. */
+  uint64_t GetBlocksInUse (void) const;
+  /** \returns the largest number of blocks in use at the same time. */
+  uint64_t GetPeakBlocksInUse (void) const;
+  /** \returns the number of bytes reserved from the heap by the pool. */
+  uint64_t GetReservedBytes (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /**
+   * Prefix of every block, located right before the object.
+   */
+  struct Header
+  {
+    EventImplPool *pool; // zero for the blocks allocated on the heap
+    uint32_t sizeClass;
+  };
+
+  uint8_t *DoAllocate (std::size_t size);
+  void DoDeallocate (uint8_t *block);
+  /* Give back to the free lists the blocks released by other threads. */
+  void DrainRemote (void);
+  /* Push the block onto the free list of its size class. */
+  void Release (uint8_t *block);
+
+  static EventImplPool *m_current;
+
+  SystemThread::ThreadId m_owner;
+  // m_freeLists[i] is the first free block of size (i + 1) * ALIGNMENT.
+  // Free blocks are chained through their first word after the header.
+  std::vector<uint8_t *> m_freeLists;
+  std::vector<uint8_t *> m_chunks;
+  // unused part of the last chunk
+  uint8_t *m_arena;
+  uint8_t *m_arenaEnd;
+
+  // blocks released by other threads than the owner
+  SystemMutex m_remoteMutex;
+  uint8_t *m_remote;
+  // number of blocks in m_remote, read by the owner without the lock
+  uint32_t m_remoteBlocks;
+  // set by DoDispose: m_blocksInUse is then protected by m_remoteMutex
+  bool m_disposed;
+
+  uint64_t m_allocations;
+  uint64_t m_heapAllocations;
+  uint64_t m_blocksInUse;
+  uint64_t m_peakBlocksInUse;
+  uint64_t m_reservedBytes;
+};
+
+} // namespace ns3
+
+#endif /* EVENT_IMPL_POOL_H */
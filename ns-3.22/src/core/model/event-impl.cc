@@ -19,6 +19,7 @@
  */
 
 #include "event-impl.h"
+#include "event-impl-pool.h"
 #include "log.h"
 
 /**
@@ -31,6 +32,18 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+void *
+EventImpl::operator new (std::size_t size)
+{
+  return EventImplPool::Allocate (size);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  EventImplPool::Deallocate (p, size);
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -40,10 +41,27 @@ namespace ns3 {
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * The memory of all the subclasses is managed by the EventImplPool of
+ * the current simulator, if it has one.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
 public:
+  /**
+   * Allocate memory for an event from the current EventImplPool.
+   *
+   * \param size the size of the event.
+   * \returns the memory for the event.
+   */
+  static void *operator new (std::size_t size);
+  /**
+   * Give back the memory of an event to its EventImplPool.
+   *
+   * \param p the memory of the event.
+   * \param size the size of the event.
+   */
+  static void operator delete (void *p, std::size_t size);
   /** Default constructor. */
   EventImpl ();
   /** Destructor. */
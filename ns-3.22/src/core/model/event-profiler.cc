@@ -0,0 +1,349 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-profiler.h"
+#include "string.h"
+#include "uinteger.h"
+#include "fatal-error.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if (__GNUC__ >= 3)
+#include <cxxabi.h>
+#endif
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventProfiler implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EventProfiler");
+
+NS_OBJECT_ENSURE_REGISTERED (EventProfiler);
+
+namespace {
+
+std::string
+Demangle (const char *mangled)
+{
+#if (__GNUC__ >= 3)
+  int status;
+  char *demangled = abi::__cxa_demangle (mangled, NULL, NULL, &status);
+  if (status == 0 && demangled != 0)
+    {
+      std::string ret = demangled;
+      std::free (demangled);
+      return ret;
+    }
+  std::free (demangled);
+#endif
+  return mangled;
+}
+
+/* Sort by decreasing wall clock time. */
+template <typename T>
+bool
+SlowerFirst (const std::pair<T, uint64_t> &a, const std::pair<T, uint64_t> &b)
+{
+  return a.second > b.second;
+}
+
+} // anonymous namespace
+
+bool
+EventProfiler::Key::operator < (const Key &o) const
+{
+  return type < o.type || (type == o.type && context < o.context);
+}
+
+TypeId
+EventProfiler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::EventProfiler")
+    .SetParent<Object> ()
+    .AddConstructor<EventProfiler> ()
+    .AddAttribute ("TextFile",
+                   "The file the text report is written to, or the empty "
+                   "string for none.",
+                   StringValue ("event-profile.txt"),
+                   MakeStringAccessor (&EventProfiler::m_textFile),
+                   MakeStringChecker ())
+    .AddAttribute ("CsvFile",
+                   "The file the CSV report is written to, or the empty "
+                   "string for none.",
+                   StringValue ("event-profile.csv"),
+                   MakeStringAccessor (&EventProfiler::m_csvFile),
+                   MakeStringChecker ())
+    .AddAttribute ("SamplingPeriod",
+                   "The mean number of events per timed event, or 1 to "
+                   "time all the events.",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&EventProfiler::m_samplingPeriod),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+EventProfiler::EventProfiler ()
+{
+  NS_LOG_FUNCTION (this);
+  m_start.tv_sec = 0;
+  m_start.tv_nsec = 0;
+  m_lastKey.type = 0;
+  m_lastKey.context = 0;
+  m_last = 0;
+  m_timing = false;
+  m_countdown = 1;
+  m_jitter = 1;
+  m_samplingPeriod = 16;
+}
+
+EventProfiler::~EventProfiler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+EventProfiler::Start (const EventImpl *event, uint32_t context)
+{
+  Key key;
+  key.type = typeid (*event).name ();
+  key.context = context;
+  if (m_last == 0 || key.type != m_lastKey.type || key.context != m_lastKey.context)
+    {
+      Records::iterator i = m_records.lower_bound (key);
+      if (i == m_records.end () || key < i->first)
+        {
+          Record record;
+          record.count = 0;
+          record.timed = 0;
+          record.nanoseconds = 0;
+          record.fanOut = 0;
+          i = m_records.insert (i, std::make_pair (key, record));
+        }
+      m_lastKey = key;
+      m_last = &i->second;
+    }
+  m_timing = --m_countdown == 0 || m_last->timed == 0;
+  if (m_countdown == 0)
+    {
+      // uniform in [1, 2 * period - 1]
+      m_jitter = m_jitter * 1103515245 + 12345;
+      m_countdown = 1 + (m_jitter >> 8) % (2 * m_samplingPeriod - 1);
+    }
+  if (m_timing)
+    {
+      clock_gettime (CLOCK_MONOTONIC, &m_start);
+    }
+}
+
+void
+EventProfiler::Stop (uint32_t fanOut)
+{
+  if (m_timing)
+    {
+      struct timespec end;
+      clock_gettime (CLOCK_MONOTONIC, &end);
+      m_last->nanoseconds += (int64_t)(end.tv_sec - m_start.tv_sec) * 1000000000 + (end.tv_nsec - m_start.tv_nsec);
+      m_last->timed++;
+    }
+  m_last->count++;
+  m_last->fanOut += fanOut;
+}
+
+void
+EventProfiler::Merge (Record &to, const Record &record)
+{
+  to.count += record.count;
+  to.timed += record.timed;
+  to.nanoseconds += record.nanoseconds;
+  to.fanOut += record.fanOut;
+}
+
+uint64_t
+EventProfiler::GetNanoSeconds (const Record &record)
+{
+  if (record.timed == 0)
+    {
+      return 0;
+    }
+  return (uint64_t)((double)record.nanoseconds * record.count / record.timed + 0.5);
+}
+
+uint64_t
+EventProfiler::GetEventCount (void) const
+{
+  uint64_t count = 0;
+  for (Records::const_iterator i = m_records.begin (); i != m_records.end (); i++)
+    {
+      count += i->second.count;
+    }
+  return count;
+}
+
+void
+EventProfiler::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_records.clear ();
+  m_last = 0;
+}
+
+void
+EventProfiler::Print (std::ostream &os) const
+{
+  // The same type may show up under several names if it is defined in
+  // several libraries, so merge the records by demangled name.
+  std::map<std::string, Record> types;
+  for (Records::const_iterator i = m_records.begin (); i != m_records.end (); i++)
+    {
+      std::map<std::string, Record>::iterator type = types.find (Demangle (i->first.type));
+      if (type == types.end ())
+        {
+          types.insert (std::make_pair (Demangle (i->first.type), i->second));
+        }
+      else
+        {
+          Merge (type->second, i->second);
+        }
+    }
+  uint64_t count = 0;
+  uint64_t nanoseconds = 0;
+  std::vector<std::pair<std::string, uint64_t> > sorted;
+  for (std::map<std::string, Record>::const_iterator i = types.begin (); i != types.end (); i++)
+    {
+      count += i->second.count;
+      nanoseconds += GetNanoSeconds (i->second);
+      sorted.push_back (std::make_pair (i->first, GetNanoSeconds (i->second)));
+    }
+  std::stable_sort (sorted.begin (), sorted.end (), &SlowerFirst<std::string>);
+
+  std::ios::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  os << "Event profile: " << count << " events, "
+     << std::fixed << std::setprecision (6) << nanoseconds / 1e9 << " s" << std::endl;
+  os << std::setw (12) << "time (s)"
+     << std::setw (8) << "%"
+     << std::setw (12) << "count"
+     << std::setw (12) << "mean (ns)"
+     << std::setw (10) << "fan-out"
+     << "  event" << std::endl;
+  for (std::vector<std::pair<std::string, uint64_t> >::const_iterator i = sorted.begin (); i != sorted.end (); i++)
+    {
+      const Record &record = types[i->first];
+      os << std::setw (12) << std::setprecision (6) << i->second / 1e9
+         << std::setw (8) << std::setprecision (2)
+         << (nanoseconds == 0 ? 0.0 : 100.0 * i->second / nanoseconds)
+         << std::setw (12) << record.count
+         << std::setw (12) << std::setprecision (0) << (double)i->second / record.count
+         << std::setw (10) << std::setprecision (2) << (double)record.fanOut / record.count
+         << "  " << i->first << std::endl;
+    }
+  os.flags (flags);
+  os.precision (precision);
+}
+
+void
+EventProfiler::PrintCsv (std::ostream &os) const
+{
+  // merge by demangled name, as Print does, but per context
+  typedef std::map<std::pair<std::string, uint32_t>, Record> Names;
+  Names names;
+  for (Records::const_iterator i = m_records.begin (); i != m_records.end (); i++)
+    {
+      std::pair<std::string, uint32_t> name = std::make_pair (Demangle (i->first.type), i->first.context);
+      Names::iterator found = names.find (name);
+      if (found == names.end ())
+        {
+          names.insert (std::make_pair (name, i->second));
+        }
+      else
+        {
+          Merge (found->second, i->second);
+        }
+    }
+  std::vector<std::pair<Names::const_iterator, uint64_t> > sorted;
+  for (Names::const_iterator i = names.begin (); i != names.end (); i++)
+    {
+      sorted.push_back (std::make_pair (i, GetNanoSeconds (i->second)));
+    }
+  std::stable_sort (sorted.begin (), sorted.end (), &SlowerFirst<Names::const_iterator>);
+
+  os << "event,context,count,timed,nanoseconds,fanout" << std::endl;
+  for (std::vector<std::pair<Names::const_iterator, uint64_t> >::const_iterator i = sorted.begin (); i != sorted.end (); i++)
+    {
+      const Record &record = i->first->second;
+      // the demangled names hold commas, so always quote them
+      std::string name = i->first->first.first;
+      std::string::size_type quote = 0;
+      while ((quote = name.find ('"', quote)) != std::string::npos)
+        {
+          name.insert (quote, 1, '"');
+          quote += 2;
+        }
+      os << '"' << name << "\",";
+      if (i->first->first.second == 0xffffffff)
+        {
+          os << "-1";
+        }
+      else
+        {
+          os << i->first->first.second;
+        }
+      os << "," << record.count
+         << "," << record.timed
+         << "," << i->second
+         << "," << record.fanOut << std::endl;
+    }
+}
+
+void
+EventProfiler::Report (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_textFile.empty ())
+    {
+      std::ofstream os (m_textFile.c_str ());
+      if (!os.good ())
+        {
+          NS_FATAL_ERROR ("Could not open " << m_textFile);
+        }
+      Print (os);
+    }
+  if (!m_csvFile.empty ())
+    {
+      std::ofstream os (m_csvFile.c_str ());
+      if (!os.good ())
+        {
+          NS_FATAL_ERROR ("Could not open " << m_csvFile);
+        }
+      PrintCsv (os);
+    }
+}
+
+} // namespace ns3
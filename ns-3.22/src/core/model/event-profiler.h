@@ -0,0 +1,173 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include "object.h"
+#include "event-impl.h"
+#include <stdint.h>
+#include <ctime>
+#include <map>
+#include <ostream>
+#include <string>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventProfiler declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup events
+ * \brief Measure where the wall clock time of a simulation goes.
+ *
+ * The profiler records, for every event executed by the simulator, the
+ * wall clock time spent in EventImpl::Invoke and the number of events
+ * which were scheduled during that call (the fan-out of the event). The
+ * records are keyed by the concrete type of the event and by its
+ * context, that is, the node it runs on. The type of an event created
+ * by MakeEvent names the signature of the function it calls, or the
+ * class and the signature of the method, and the type of the bound
+ * arguments, but not the function or method itself: the events of the
+ * functions, or of the methods of a class, which have the same
+ * signature share their records.
+ *
+ * Reading the clock costs about as much as a small event, so only one
+ * event out of SamplingPeriod on average is timed, at jittered intervals
+ * so that periodic workloads are not aliased, as well as the first event
+ * of each record. The time of a record is the mean time of its timed
+ * events times its number of events. The event counts and fan-outs are
+ * exact.
+ *
+ * The DefaultSimulatorImpl uses a profiler when ns-3 is configured with
+ * --enable-event-profiler and its Profile attribute is set, for example
+ * with:
+ * \code
+ *   NS_ATTRIBUTE_DEFAULT='ns3::DefaultSimulatorImpl::Profile=true' ./waf --run ...
+ * \endcode
+ * It then writes the report of the profiler when Simulator::Destroy is
+ * called: the text report, which sums the records of each event type
+ * over all the contexts, goes to the file named by the TextFile
+ * attribute and all the records go to the file named by the CsvFile
+ * attribute, both sorted by decreasing wall clock time. Print and
+ * PrintCsv write the same reports to any stream.
+ */
+class EventProfiler : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  EventProfiler ();
+  virtual ~EventProfiler ();
+
+  /**
+   * Start to measure the execution of an event.
+   *
+   * \param event the event about to be executed.
+   * \param context the context of the event.
+   */
+  void Start (const EventImpl *event, uint32_t context);
+  /**
+   * Stop to measure the execution of the event given to Start.
+   *
+   * \param fanOut the number of events scheduled by the event.
+   */
+  void Stop (uint32_t fanOut);
+
+  /**
+   * \returns the number of events recorded so far.
+   */
+  uint64_t GetEventCount (void) const;
+  /**
+   * Forget about all the events recorded so far.
+   */
+  void Clear (void);
+
+  /**
+   * \param os the stream to print to.
+   *
+   * Print the records of each event type, summed over all the contexts.
+   */
+  void Print (std::ostream &os) const;
+  /**
+   * \param os the stream to print to.
+   *
+   * Print one line of comma-separated values per event type and
+   * context, preceded by a header line.
+   */
+  void PrintCsv (std::ostream &os) const;
+  /**
+   * Write the text report and the CSV report to the files named by the
+   * TextFile and CsvFile attributes, unless they are empty.
+   */
+  void Report (void) const;
+
+private:
+  struct Key
+  {
+    // typeid (*event).name (), which is unique per type: the events of
+    // functions or methods with the same signature have the same type
+    const char *type;
+    uint32_t context;
+    bool operator < (const Key &o) const;
+  };
+  struct Record
+  {
+    uint64_t count;
+    // the number of timed events, and their total time
+    uint64_t timed;
+    uint64_t nanoseconds;
+    uint64_t fanOut;
+  };
+  typedef std::map<Key, Record> Records;
+
+  /**
+   * \param to the record to add to.
+   * \param record the record to add.
+   */
+  static void Merge (Record &to, const Record &record);
+  /**
+   * \param record a record.
+   * \returns the estimated time of all the events of the record.
+   */
+  static uint64_t GetNanoSeconds (const Record &record);
+
+  Records m_records;
+  // the record of the last call to Start: events of the same type often
+  // run one after the other
+  Key m_lastKey;
+  Record *m_last;
+  // whether the event given to Start is timed
+  bool m_timing;
+  // the number of events until the next timed one
+  uint32_t m_countdown;
+  // the state of the generator of the sampling intervals, which must
+  // not draw from the random number streams of the simulation
+  uint32_t m_jitter;
+  uint32_t m_samplingPeriod;
+  struct timespec m_start;
+  std::string m_textFile;
+  std::string m_csvFile;
+};
+
+} // namespace ns3
+
+#endif /* EVENT_PROFILER_H */
@@ -0,0 +1,292 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+namespace {
+/* Largest number of events sorted at once into Bottom: larger groups of
+ * events are spread over a new rung instead. */
+const uint32_t THRESHOLD = 50;
+/* Maximum number of rungs in the ladder. */
+const uint32_t MAX_RUNGS = 8;
+
+bool
+EventGreater (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return b < a;
+}
+} // anonymous namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topStart (0),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Rung *>::iterator i = m_rungs.begin (); i != m_rungs.end (); i++)
+    {
+      delete *i;
+    }
+  m_rungs.clear ();
+}
+
+LadderScheduler::Bucket *
+LadderScheduler::GetBucket (Rung *rung, uint64_t ts)
+{
+  uint64_t index = (ts - rung->m_start) / rung->m_width;
+  if (index >= rung->m_buckets.size ())
+    {
+      index = rung->m_buckets.size () - 1;
+    }
+  NS_ASSERT (index >= rung->m_current);
+  return &rung->m_buckets[index];
+}
+
+LadderScheduler::Bucket *
+LadderScheduler::Locate (uint64_t ts)
+{
+  if (ts >= m_topStart)
+    {
+      return &m_top;
+    }
+  // Each rung covers the time range of the current bucket of the rung
+  // above it: look for the coarsest rung which still holds ts.
+  for (std::vector<Rung *>::iterator i = m_rungs.begin (); i != m_rungs.end (); i++)
+    {
+      Rung *rung = *i;
+      if (ts >= rung->m_start + rung->m_current * rung->m_width)
+        {
+          return GetBucket (rung, ts);
+        }
+    }
+  return &m_bottom;
+}
+
+void
+LadderScheduler::SetBottom (Bucket &events)
+{
+  NS_LOG_FUNCTION (this << events.size ());
+  NS_ASSERT (m_bottom.empty ());
+  std::sort (events.begin (), events.end (), EventGreater);
+  m_bottom.swap (events);
+}
+
+void
+LadderScheduler::InsertBottom (const Event &ev)
+{
+  Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, EventGreater);
+  m_bottom.insert (i, ev);
+}
+
+void
+LadderScheduler::Spread (Bucket &events)
+{
+  NS_LOG_FUNCTION (this << events.size ());
+  NS_ASSERT (!events.empty ());
+  uint64_t min = events.front ().key.m_ts;
+  uint64_t max = min;
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); i++)
+    {
+      min = std::min (min, i->key.m_ts);
+      max = std::max (max, i->key.m_ts);
+    }
+  if (events.size () <= THRESHOLD
+      || m_rungs.size () >= MAX_RUNGS
+      || min == max)
+    {
+      SetBottom (events);
+      return;
+    }
+  Rung *rung = new Rung ();
+  rung->m_start = min;
+  // One bucket per event on average, and the width is rounded up such
+  // that max falls in the last bucket.
+  rung->m_width = (max - min) / events.size () + 1;
+  rung->m_current = 0;
+  rung->m_buckets.resize (events.size ());
+  m_rungs.push_back (rung);
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); i++)
+    {
+      GetBucket (rung, i->key.m_ts)->push_back (*i);
+    }
+}
+
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_size > 0);
+  while (m_bottom.empty ())
+    {
+      Bucket events;
+      if (m_rungs.empty ())
+        {
+          // Move the whole content of Top down the ladder.
+          NS_ASSERT (!m_top.empty ());
+          uint64_t max = 0;
+          for (Bucket::const_iterator i = m_top.begin (); i != m_top.end (); i++)
+            {
+              max = std::max (max, i->key.m_ts);
+            }
+          m_topStart = max + 1;
+          events.swap (m_top);
+        }
+      else
+        {
+          // Move the first non-empty bucket of the last rung down the ladder.
+          Rung *rung = m_rungs.back ();
+          while (rung->m_current < rung->m_buckets.size ()
+                 && rung->m_buckets[rung->m_current].empty ())
+            {
+              rung->m_current++;
+            }
+          if (rung->m_current < rung->m_buckets.size ())
+            {
+              events.swap (rung->m_buckets[rung->m_current]);
+              rung->m_current++;
+            }
+          if (rung->m_current == rung->m_buckets.size ())
+            {
+              delete rung;
+              m_rungs.pop_back ();
+            }
+          if (events.empty ())
+            {
+              continue;
+            }
+        }
+      Spread (events);
+    }
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  m_size++;
+  Bucket *bucket = Locate (ev.key.m_ts);
+  if (bucket != &m_bottom)
+    {
+      bucket->push_back (ev);
+      if (m_bottom.empty ())
+        {
+          Refill ();
+        }
+      return;
+    }
+  InsertBottom (ev);
+  // Bottom is sorted: keep it small by spreading it over a new rung when
+  // too many events are scheduled close to the current time.
+  if (m_bottom.size () > THRESHOLD
+      && m_rungs.size () < MAX_RUNGS
+      && m_bottom.front ().key.m_ts != m_bottom.back ().key.m_ts)
+    {
+      Bucket events;
+      events.swap (m_bottom);
+      Spread (events);
+      Refill ();
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!m_bottom.empty ());
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!m_bottom.empty ());
+  Event next = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_size--;
+  if (m_bottom.empty () && m_size > 0)
+    {
+      Refill ();
+    }
+  return next;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  Bucket *bucket = Locate (ev.key.m_ts);
+  Bucket::iterator i;
+  for (i = bucket->begin (); i != bucket->end (); i++)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          break;
+        }
+    }
+  NS_ASSERT (i != bucket->end ());
+  NS_ASSERT (i->impl == ev.impl);
+  if (bucket == &m_bottom)
+    {
+      // keep Bottom sorted
+      m_bottom.erase (i);
+    }
+  else
+    {
+      *i = bucket->back ();
+      bucket->pop_back ();
+    }
+  m_size--;
+  if (m_bottom.empty () && m_size > 0)
+    {
+      Refill ();
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue described in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh and
+ * Ian Li-Jin Thng (ACM TOMACS, 2005). Events are stored in three tiers:
+ *  - Top: an unsorted array which receives all the events scheduled
+ *    beyond the time range covered by the other tiers.
+ *  - Rungs: a stack of calendar-like bucket arrays. The first rung is
+ *    built from the content of Top when it is needed, and each following
+ *    rung spreads a single bucket of the rung above it over buckets of
+ *    finer width. Buckets are not sorted.
+ *  - Bottom: a small sorted array which holds the earliest events.
+ *
+ * Unlike the CalendarScheduler, the ladder queue never needs to resize
+ * its buckets as a whole: the width of each rung is derived from the
+ * events it receives, and a bucket which holds too many events is
+ * simply spread over a new rung. This keeps the amortized cost of
+ * Insert and RemoveNext constant even with very skewed distributions of
+ * event timestamps.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LadderScheduler ();
+  virtual ~LadderScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+private:
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /**
+   * One rung of the ladder: m_buckets[i] holds the events whose timestamp
+   * is in [m_start + i * m_width, m_start + (i + 1) * m_width), except
+   * for the last bucket which holds all the events beyond its start.
+   */
+  struct Rung
+  {
+    uint64_t m_start;
+    uint64_t m_width;
+    // index of the first bucket which was not yet moved down the ladder
+    uint32_t m_current;
+    std::vector<Bucket> m_buckets;
+  };
+
+  /* Return the container the event with timestamp ts belongs to. */
+  Bucket *Locate (uint64_t ts);
+  /* Return the bucket of the rung which holds timestamp ts. */
+  Bucket *GetBucket (Rung *rung, uint64_t ts);
+  /* Spread the events over a new rung at the bottom of the ladder, or
+   * store them in Bottom if they are too few to be worth it. */
+  void Spread (Bucket &events);
+  /* Move events down the ladder until Bottom is not empty. */
+  void Refill (void);
+  /* Sort the events in decreasing order and store them in Bottom. */
+  void SetBottom (Bucket &events);
+  /* Insert the event in Bottom, which is sorted in decreasing order. */
+  void InsertBottom (const Event &ev);
+
+  Bucket m_top;
+  // all the events in Top have a timestamp greater or equal to m_topStart
+  uint64_t m_topStart;
+  // m_rungs[0] is the coarsest rung.
+  std::vector<Rung *> m_rungs;
+  // The earliest event is stored at the end of Bottom.
+  Bucket m_bottom;
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -220,6 +220,26 @@ public:
   virtual bool Get (const ObjectBase * object, AttributeValue &value) const;
   virtual bool HasGetter (void) const;
   virtual bool HasSetter (void) const;
+  /**
+   * Get the number of instances in the container, without copying them
+   * as Get does.
+   *
+   * \param [in] object The container object.
+   * \param [out] n The number of instances in the container.
+   * \returns true if the value could be obtained successfully.
+   */
+  bool GetN (const ObjectBase *object, uint32_t *n) const;
+  /**
+   * Get an instance from the container, by position.
+   *
+   * \param [in] object The container object.
+   * \param [in] i The position of the instance, in [0, GetN ()[.
+   * \param [out] index The index of the instance in the container:
+   *   i for the vectors and the getters, the key for the maps.  The
+   *   indexes increase with the position.
+   * \returns The instance.
+   */
+  Ptr<Object> GetItem (const ObjectBase *object, uint32_t i, uint32_t *index) const;
 private:
   /**
    * Get the number of instances in the container.
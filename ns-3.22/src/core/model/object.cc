@@ -96,11 +96,10 @@ Object::Object ()
   : m_tid (Object::GetTypeId ()),
     m_disposed (false),
     m_initialized (false),
-    m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
+    m_aggregates (AllocateAggregates (1)),
     m_getObjectCount (0)
 {
   NS_LOG_FUNCTION (this);
-  m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
 }
 Object::~Object () 
@@ -119,6 +118,11 @@ Object::~Object ()
           m_aggregates->n--;
         }
     }
+  // the cache may point to this object
+  for (uint32_t i = 0; i < GETOBJECT_CACHE_SIZE; i++)
+    {
+      m_aggregates->tids[i] = 0;
+    }
   // finally, if all objects have been removed from the list,
   // delete the aggregate list
   if (m_aggregates->n == 0)
@@ -131,10 +135,9 @@ Object::Object (const Object &o)
   : m_tid (o.m_tid),
     m_disposed (false),
     m_initialized (false),
-    m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
+    m_aggregates (AllocateAggregates (1)),
     m_getObjectCount (0)
 {
-  m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
 }
 void
@@ -150,17 +153,32 @@ Object::DoGetObject (TypeId tid) const
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (CheckLoose ());
 
-  uint32_t n = m_aggregates->n;
+  // the lookups of a TypeId are likely to be repeated, often per packet:
+  // the results are cached until the aggregates change.
+  uint16_t uid = tid.GetUid ();
+  if (uid == 0)
+    {
+      // a default TypeId names no Object, and would match the unused
+      // entries of the cache.
+      return 0;
+    }
+  for (uint32_t i = 0; i < GETOBJECT_CACHE_SIZE; i++)
+    {
+      if (m_aggregates->tids[i] == uid)
+        {
+          return m_aggregates->objects[i];
+        }
+    }
+
+  Object *found = 0;
   TypeId objectTid = Object::GetTypeId ();
+  // only the subclasses of Object can match
+  uint32_t n = (tid == objectTid || tid.IsChildOf (objectTid)) ? m_aggregates->n : 0;
   for (uint32_t i = 0; i < n; i++)
     {
       Object *current = m_aggregates->buffer[i];
       TypeId cur = current->GetInstanceTypeId ();
-      while (cur != tid && cur != objectTid)
-        {
-          cur = cur.GetParent ();
-        }
-      if (cur == tid)
+      if (cur == tid || cur.IsChildOf (tid))
         {
           // This is an attempt to 'cache' the result of this lookup.
           // the idea is that if we perform a lookup for a TypeId on this object,
@@ -172,11 +190,30 @@ Object::DoGetObject (TypeId tid) const
           current->m_getObjectCount++;
           // then, update the sort
           UpdateSortedArray (m_aggregates, i);
-          // finally, return the match
-          return const_cast<Object *> (current);
+          found = current;
+          break;
         }
     }
-  return 0;
+  uint32_t entry = m_aggregates->next;
+  m_aggregates->next = (entry + 1) % GETOBJECT_CACHE_SIZE;
+  m_aggregates->tids[entry] = uid;
+  m_aggregates->objects[entry] = found;
+  return found;
+}
+struct Object::Aggregates *
+Object::AllocateAggregates (uint32_t n)
+{
+  NS_LOG_FUNCTION (n);
+  struct Aggregates *aggregates = 
+    (struct Aggregates *)std::malloc (sizeof (struct Aggregates) + (n - 1) * sizeof (Object *));
+  aggregates->n = n;
+  aggregates->next = 0;
+  for (uint32_t i = 0; i < GETOBJECT_CACHE_SIZE; i++)
+    {
+      aggregates->tids[i] = 0;
+      aggregates->objects[i] = 0;
+    }
+  return aggregates;
 }
 void
 Object::Initialize (void)
@@ -260,9 +297,7 @@ Object::AggregateObject (Ptr<Object> o)
   Object *other = PeekPointer (o);
   // first create the new aggregate buffer.
   uint32_t total = m_aggregates->n + other->m_aggregates->n;
-  struct Aggregates *aggregates = 
-    (struct Aggregates *)std::malloc (sizeof(struct Aggregates)+(total-1)*sizeof(Object*));
-  aggregates->n = total;
+  struct Aggregates *aggregates = AllocateAggregates (total);
 
   // copy our buffer to the new buffer
   std::memcpy (&aggregates->buffer[0], 
@@ -332,6 +367,11 @@ Object::SetTypeId (TypeId tid)
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (Check ());
   m_tid = tid;
+  // the lookups done with the previous TypeId are stale
+  for (uint32_t i = 0; i < GETOBJECT_CACHE_SIZE; i++)
+    {
+      m_aggregates->tids[i] = 0;
+    }
 }
 
 void
@@ -316,6 +316,10 @@ private:
   friend class AggregateIterator;
   friend struct ObjectDeleter;
 
+  /**
+   * The number of TypeId lookups cached by each aggregate array.
+   */
+  enum { GETOBJECT_CACHE_SIZE = 8 };
   /**
    * The list of Objects aggregated to this one.
    *
@@ -327,13 +331,33 @@ private:
    * chunk of memory than the struct to allow space for a larger
    * variable sized buffer whose size is indicated by the element
    * \c n
+   *
+   * The array also caches the results of DoGetObject for all the
+   * aggregated Objects; a new array is allocated, with an empty cache,
+   * when an Object is aggregated.
    */
   struct Aggregates {
     /** The number of entries in \c buffer. */
     uint32_t n;
+    /** The next entry of the cache to replace. */
+    uint32_t next;
+    /**
+     * The uids of the TypeIds recently looked up by DoGetObject, zero
+     * for the unused entries.
+     */
+    uint16_t tids[GETOBJECT_CACHE_SIZE];
+    /** The Objects found for \c tids, zero if none was found. */
+    Object *objects[GETOBJECT_CACHE_SIZE];
     /** The array of Objects. */
     Object *buffer[1];
   };
+  /**
+   * Allocate an aggregate array with an empty cache.
+   *
+   * \param n The number of entries in the array.
+   * \return The array, whose entries are not set.
+   */
+  static struct Aggregates *AllocateAggregates (uint32_t n);
 
   /**
    * Find an Object of TypeId tid in the aggregates of this Object.
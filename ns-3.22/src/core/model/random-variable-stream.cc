@@ -33,8 +33,10 @@
 #include "log.h"
 #include "rng-stream.h"
 #include "rng-seed-manager.h"
+#include "system-mutex.h"
 #include <cmath>
 #include <iostream>
+#include <set>
 
 namespace ns3 {
 
@@ -42,6 +44,30 @@ NS_LOG_COMPONENT_DEFINE ("RandomVariableStream");
 
 NS_OBJECT_ENSURE_REGISTERED (RandomVariableStream);
 
+namespace {
+/**
+ * \returns the random variable streams which exist, so that
+ * RandomVariableStream::ReseedAll can find them.
+ */
+std::set<RandomVariableStream *> &
+GetStreams (void)
+{
+  static std::set<RandomVariableStream *> streams;
+  return streams;
+}
+
+/**
+ * \returns the mutex which protects the set of streams: the threads of
+ * the multithreaded simulator create and destroy streams concurrently.
+ */
+SystemMutex &
+GetStreamsMutex (void)
+{
+  static SystemMutex mutex;
+  return mutex;
+}
+} // anonymous namespace
+
 TypeId 
 RandomVariableStream::GetTypeId (void)
 {
@@ -65,16 +91,43 @@ RandomVariableStream::GetTypeId (void)
 }
 
 RandomVariableStream::RandomVariableStream()
-  : m_rng (0)
+  : m_rng (0),
+    m_rngStream (0)
 {
   NS_LOG_FUNCTION (this);
+  CriticalSection cs (GetStreamsMutex ());
+  GetStreams ().insert (this);
 }
 RandomVariableStream::~RandomVariableStream()
 {
   NS_LOG_FUNCTION (this);
+  {
+    CriticalSection cs (GetStreamsMutex ());
+    GetStreams ().erase (this);
+  }
   delete m_rng;
 }
 
+void
+RandomVariableStream::ReseedAll (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  CriticalSection cs (GetStreamsMutex ());
+  std::set<RandomVariableStream *> &streams = GetStreams ();
+  for (std::set<RandomVariableStream *>::iterator i = streams.begin (); i != streams.end (); i++)
+    {
+      RandomVariableStream *stream = *i;
+      if (stream->m_rng != 0)
+        {
+          delete stream->m_rng;
+          stream->m_rng = new RngStream (RngSeedManager::GetSeed (),
+                                         stream->m_rngStream,
+                                         RngSeedManager::GetRun ());
+          stream->DoReseed ();
+        }
+    }
+}
+
 void
 RandomVariableStream::SetAntithetic(bool isAntithetic)
 {
@@ -100,20 +153,18 @@ RandomVariableStream::SetStream (int64_t stream)
       // number assignment.
       uint64_t nextStream = RngSeedManager::GetNextStreamIndex ();
       NS_ASSERT(nextStream <= ((1ULL)<<63));
-      m_rng = new RngStream (RngSeedManager::GetSeed (),
-                             nextStream,
-                             RngSeedManager::GetRun ());
+      m_rngStream = nextStream;
     }
   else
     {
       // The last 2^63 streams are reserved for deterministic stream
       // number assignment.
       uint64_t base = ((1ULL)<<63);
-      uint64_t target = base + stream;
-      m_rng = new RngStream (RngSeedManager::GetSeed (),
-                             target,
-                             RngSeedManager::GetRun ());
+      m_rngStream = base + stream;
     }
+  m_rng = new RngStream (RngSeedManager::GetSeed (),
+                         m_rngStream,
+                         RngSeedManager::GetRun ());
   m_stream = stream;
 }
 int64_t
@@ -130,6 +181,12 @@ RandomVariableStream::Peek(void) const
   return m_rng;
 }
 
+void
+RandomVariableStream::DoReseed (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
 NS_OBJECT_ENSURE_REGISTERED(UniformRandomVariable);
 
 TypeId 
@@ -675,6 +732,13 @@ NormalRandomVariable::GetBound (void) const
   return m_bound;
 }
 
+void
+NormalRandomVariable::DoReseed (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_nextValid = false;
+}
+
 double 
 NormalRandomVariable::GetValue (double mean, double variance, double bound)
 {
@@ -989,6 +1053,13 @@ GammaRandomVariable::GetInteger (void)
   return (uint32_t)GetValue (m_alpha, m_beta);
 }
 
+void
+GammaRandomVariable::DoReseed (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_nextValid = false;
+}
+
 double 
 GammaRandomVariable::GetNormalValue (double mean, double variance, double bound)
 {
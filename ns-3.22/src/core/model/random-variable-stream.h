@@ -133,12 +133,32 @@ public:
    */
   virtual uint32_t GetInteger (void) = 0;
 
+  /**
+   * \brief Restart every random variable stream which exists from
+   * the current seed and run number.
+   *
+   * RngSeedManager::SetSeed and RngSeedManager::SetRun only affect the
+   * streams created after they are called. This gives the streams
+   * created before, for example while building the topology of a
+   * simulation, the state they would have had if they had been created
+   * with the current seed and run number, keeping their stream number.
+   */
+  static void ReseedAll (void);
+
 protected:
   /**
    * \brief Returns a pointer to the underlying RNG stream.
    */
   RngStream *Peek(void) const;
 
+  /**
+   * \brief Forget the values drawn in advance from the underlying RNG
+   * stream, which ReseedAll just restarted.
+   *
+   * The default implementation does nothing.
+   */
+  virtual void DoReseed (void);
+
 private:
   // you can't copy these objects.
   // Theoretically, it is possible to give them good copy semantics
@@ -154,6 +174,9 @@ private:
 
   /// The stream number for this RNG stream.
   int64_t m_stream;
+
+  /// The index of the stream in the RngStream generator.
+  uint64_t m_rngStream;
 };
 
 /**
@@ -1247,6 +1270,9 @@ private:
   /// The bound on values that can be returned by this RNG stream.
   double m_bound;
 
+  // Inherited from RandomVariableStream
+  virtual void DoReseed (void);
+
   /// True if the next value is valid.
   bool m_nextValid;
 
@@ -1629,6 +1655,9 @@ private:
   /// The beta value for the gamma distribution returned by this RNG stream.
   double m_beta;
 
+  // Inherited from RandomVariableStream
+  virtual void DoReseed (void);
+
   /// True if the next normal value is valid.
   bool m_nextValid;
 
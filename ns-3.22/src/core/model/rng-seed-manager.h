@@ -80,6 +80,19 @@ public:
   static uint64_t GetRun (void);
 
   static uint64_t GetNextStreamIndex(void);
+  /**
+   * \returns the stream index the next call to GetNextStreamIndex
+   *          will return.
+   */
+  static uint64_t PeekNextStreamIndex (void);
+  /**
+   * \param next the stream index the next call to GetNextStreamIndex
+   *        will return.
+   *
+   * This is used to restore the state of the seed manager saved with
+   * PeekNextStreamIndex.
+   */
+  static void SetNextStreamIndex (uint64_t next);
 
 };
 
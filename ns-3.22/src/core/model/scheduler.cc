@@ -48,4 +48,11 @@ Scheduler::GetTypeId (void)
   return tid;
 }
 
+uint32_t
+Scheduler::RemoveCancelled (void)
+{
+  NS_LOG_FUNCTION (this);
+  return 0;
+}
+
 } // namespace ns3
@@ -119,6 +119,18 @@ public:
    * This methods cannot be invoked if the list is empty.
    */
   virtual void Remove (const Event &ev) = 0;
+  /**
+   * Remove from the event list all the events which have been
+   * cancelled, that is, whose EventImpl::IsCancelled method returns
+   * true, and call SimpleRefCount::Unref on each of them.
+   *
+   * Supporting this operation is optional: the default implementation
+   * does nothing, in which case the cancelled events are discarded by
+   * the simulator when they reach the head of the event list.
+   *
+   * \returns the number of events removed from the event list.
+   */
+  virtual uint32_t RemoveCancelled (void);
 };
 
 /* Note the invariants which this function must provide:
@@ -22,6 +22,7 @@
 #ifndef SIMPLE_REF_COUNT_H
 #define SIMPLE_REF_COUNT_H
 
+#include "ns3/core-config.h"
 #include "empty.h"
 #include "default-deleter.h"
 #include "assert.h"
@@ -99,7 +100,12 @@ public:
   inline void Ref (void) const
   {
     NS_ASSERT (m_count < std::numeric_limits<uint32_t>::max());
+#ifdef NS3_MT_SIMULATOR
+    // objects may be shared by the threads of the multithreaded simulator
+    __sync_add_and_fetch (&m_count, 1);
+#else
     m_count++;
+#endif
   }
   /**
    * Decrement the reference count. This method should not be called
@@ -109,8 +115,12 @@ public:
    */
   inline void Unref (void) const
   {
-    m_count--;
-    if (m_count == 0)
+#ifdef NS3_MT_SIMULATOR
+    uint32_t count = __sync_sub_and_fetch (&m_count, 1);
+#else
+    uint32_t count = --m_count;
+#endif
+    if (count == 0)
       {
         DELETER::Delete (static_cast<T*> (const_cast<SimpleRefCount *> (this)));
       }
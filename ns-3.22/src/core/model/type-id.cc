@@ -82,6 +82,7 @@ public:
   std::string GetName (uint16_t uid) const;
   TypeId::hash_t GetHash (uint16_t uid) const;
   uint16_t GetParent (uint16_t uid) const;
+  bool IsChildOf (uint16_t uid, uint16_t ancestor) const;
   std::string GetGroupName (uint16_t uid) const;
   std::size_t GetSize (uint16_t uid) const;
   Callback<ObjectBase *> GetConstructor (uint16_t uid) const;
@@ -113,11 +114,16 @@ private:
   bool HasTraceSource (uint16_t uid, std::string name);
   bool HasAttribute (uint16_t uid, std::string name);
   static TypeId::hash_t Hasher (const std::string name);
+  void UpdateAncestors (uint16_t uid);
 
   struct IidInformation {
     std::string name;
     TypeId::hash_t hash;
     uint16_t parent;
+    // the types from the root of the hierarchy to this type, so that
+    // the ancestor of depth d of this type is ancestors[d].
+    std::vector<uint16_t> ancestors;
+    bool hasChildren;
     std::string groupName;
     std::size_t size;
     bool hasConstructor;
@@ -214,6 +220,7 @@ IidManager::AllocateUid (std::string name)
   information.name = name;
   information.hash = hash;
   information.parent = 0;
+  information.hasChildren = false;
   information.groupName = "";
   information.size = (std::size_t)(-1);
   information.hasConstructor = false;
@@ -221,6 +228,7 @@ IidManager::AllocateUid (std::string name)
   m_information.push_back (information);
   uint32_t uid = m_information.size ();
   NS_ASSERT (uid <= 0xffff);
+  m_information.back ().ancestors.push_back (uid);
 
   // Add to both maps:
   m_namemap.insert (std::make_pair (name, uid));
@@ -243,6 +251,37 @@ IidManager::SetParent (uint16_t uid, uint16_t parent)
   NS_ASSERT (parent <= m_information.size ());
   struct IidInformation *information = LookupInformation (uid);
   information->parent = parent;
+  UpdateAncestors (uid);
+}
+void
+IidManager::UpdateAncestors (uint16_t uid)
+{
+  NS_LOG_FUNCTION (this << uid);
+  struct IidInformation *information = LookupInformation (uid);
+  uint16_t parent = information->parent;
+  if (parent == 0 || parent == uid)
+    {
+      information->ancestors.clear ();
+    }
+  else
+    {
+      struct IidInformation *parentInformation = LookupInformation (parent);
+      parentInformation->hasChildren = true;
+      information->ancestors = parentInformation->ancestors;
+    }
+  information->ancestors.push_back (uid);
+  if (information->hasChildren)
+    {
+      // the parent of a registered type changed: so did the ancestors
+      // of its children.
+      for (uint32_t i = 1; i <= m_information.size (); i++)
+        {
+          if (i != uid && LookupInformation (i)->parent == uid)
+            {
+              UpdateAncestors (i);
+            }
+        }
+    }
 }
 void 
 IidManager::SetGroupName (uint16_t uid, std::string groupName)
@@ -327,6 +366,14 @@ IidManager::GetParent (uint16_t uid) const
   struct IidInformation *information = LookupInformation (uid);
   return information->parent;
 }
+bool
+IidManager::IsChildOf (uint16_t uid, uint16_t ancestor) const
+{
+  NS_LOG_FUNCTION (this << uid << ancestor);
+  std::vector<uint16_t> const &ancestors = LookupInformation (uid)->ancestors;
+  std::size_t depth = LookupInformation (ancestor)->ancestors.size () - 1;
+  return depth + 1 < ancestors.size () && ancestors[depth] == ancestor;
+}
 std::string 
 IidManager::GetGroupName (uint16_t uid) const
 {
@@ -666,12 +713,7 @@ bool
 TypeId::IsChildOf (TypeId other) const
 {
   NS_LOG_FUNCTION (this << other);
-  TypeId tmp = *this;
-  while (tmp != other && tmp != tmp.GetParent ())
-    {
-      tmp = tmp.GetParent ();
-    }
-  return tmp == other && *this != other;
+  return Singleton<IidManager>::Get ()->IsChildOf (m_tid, other.m_tid);
 }
 std::string 
 TypeId::GetGroupName (void) const
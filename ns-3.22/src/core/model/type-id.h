@@ -151,7 +151,8 @@ public:
    *
    * Calling this method is roughly similar to calling dynamic_cast
    * except that you do not need object instances: you can do the check
-   * with TypeId instances instead.
+   * with TypeId instances instead.  It takes a constant time: each
+   * TypeId keeps the list of its ancestors, updated by SetParent.
    */
   bool IsChildOf (TypeId other) const;
 
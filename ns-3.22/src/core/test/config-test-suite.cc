@@ -27,12 +27,14 @@
 #include "ns3/singleton.h"
 #include "ns3/object.h"
 #include "ns3/object-vector.h"
+#include "ns3/object-map.h"
 #include "ns3/names.h"
 #include "ns3/pointer.h"
 #include "ns3/log.h"
 
 
 #include <sstream>
+#include <map>
 
 using namespace ns3;
 
@@ -159,6 +161,28 @@ DerivedConfigTestObject::GetTypeId (void)
   return tid;
 }
 
+class MapConfigTestObject : public ConfigTestObject
+{
+public:
+  static TypeId GetTypeId (void);
+  void AddNode (uint32_t key, Ptr<ConfigTestObject> node) { m_nodes[key] = node; }
+private:
+  std::map<uint32_t, Ptr<ConfigTestObject> > m_nodes;
+};
+
+TypeId
+MapConfigTestObject::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("MapConfigTestObject")
+    .SetParent<ConfigTestObject> ()
+    .AddAttribute ("NodesMap", "",
+                   ObjectMapValue (),
+                   MakeObjectMapAccessor (&MapConfigTestObject::m_nodes),
+                   MakeObjectMapChecker<ConfigTestObject> ())
+    ;
+  return tid;
+}
+
 class BaseConfigObject : public Object
 {
 public:
@@ -721,6 +745,124 @@ SearchAttributesOfParentObjectsTestCase::DoRun (void)
 
 }
 
+// ===========================================================================
+// Test that a compiled path matches the expected objects, in order, through
+// vectors and maps of objects, and that ConnectMany connects each path.
+// ===========================================================================
+class CompiledPathConfigTestCase : public TestCase
+{
+public:
+  CompiledPathConfigTestCase ();
+  virtual ~CompiledPathConfigTestCase () {}
+
+private:
+  virtual void DoRun (void);
+  void Trace (std::string context, int16_t oldValue, int16_t newValue);
+  /**
+   * \param path a path
+   * \param expected the matched paths expected, separated by spaces
+   */
+  void CheckMatches (std::string path, std::string expected);
+
+  std::vector<std::string> m_contexts;
+  /** the object expected for each matched path */
+  std::map<std::string, Ptr<Object> > m_objects;
+};
+
+CompiledPathConfigTestCase::CompiledPathConfigTestCase ()
+  : TestCase ("Check that a compiled path matches the expected objects")
+{
+}
+
+void
+CompiledPathConfigTestCase::Trace (std::string context, int16_t oldValue, int16_t newValue)
+{
+  m_contexts.push_back (context);
+}
+
+void
+CompiledPathConfigTestCase::CheckMatches (std::string path, std::string expected)
+{
+  Config::MatchContainer compiled = Config::CompiledPath (path).LookupMatches ();
+  std::ostringstream oss;
+  for (uint32_t i = 0; i < compiled.GetN (); i++)
+    {
+      std::string matched = compiled.GetMatchedPath (i);
+      oss << (i == 0 ? "" : " ") << matched;
+      NS_TEST_ASSERT_MSG_EQ (m_objects.count (matched), 1, "unknown match " << matched << " of " << path);
+      NS_TEST_EXPECT_MSG_EQ (compiled.Get (i), m_objects[matched], "wrong object for " << matched);
+    }
+  NS_TEST_EXPECT_MSG_EQ (oss.str (), expected, "unexpected matches of " << path);
+}
+
+void
+CompiledPathConfigTestCase::DoRun (void)
+{
+  Ptr<MapConfigTestObject> root = CreateObject<MapConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  Ptr<ConfigTestObject> nine = CreateObject<ConfigTestObject> ();
+  root->AddNode (9, nine);
+  m_objects["/NodesMap/9/"] = nine;
+  Ptr<ConfigTestObject> two = CreateObject<ConfigTestObject> ();
+  root->AddNode (2, two);
+  m_objects["/NodesMap/2/"] = two;
+  m_objects["/NodesMap/2/$ConfigTestObject/"] = two;
+  Ptr<ConfigTestObject> node = CreateObject<ConfigTestObject> ();
+  root->AddNode (5, node);
+  m_objects["/NodesMap/5/"] = node;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Ptr<ConfigTestObject> a = CreateObject<ConfigTestObject> ();
+      node->AddNodeA (a);
+      std::ostringstream oss;
+      oss << "/NodesMap/5/NodesA/" << i << "/";
+      m_objects[oss.str ()] = a;
+    }
+
+  // the keys of a map are not its positions
+  CheckMatches ("/NodesMap/*", "/NodesMap/2/ /NodesMap/5/ /NodesMap/9/");
+  CheckMatches ("/NodesMap/[3-9]", "/NodesMap/5/ /NodesMap/9/");
+  CheckMatches ("/NodesMap/1|2", "/NodesMap/2/");
+  CheckMatches ("/NodesMap/2/$ConfigTestObject", "/NodesMap/2/$ConfigTestObject/");
+
+  CheckMatches ("/NodesMap/5/NodesA/[1-2]|0|7", "/NodesMap/5/NodesA/0/ /NodesMap/5/NodesA/1/ /NodesMap/5/NodesA/2/");
+  CheckMatches ("/NodesMap/5/NodesA/3|[2-9]|2", "/NodesMap/5/NodesA/2/ /NodesMap/5/NodesA/3/");
+  CheckMatches ("/NodesMap/5/NodesA/x", "");
+  CheckMatches ("/NodesMap/5/NodesA/", "");
+
+  // a compiled path sees the objects added after it was built
+  Config::CompiledPath all ("/NodesMap/5/NodesA/*");
+  NS_TEST_EXPECT_MSG_EQ (all.LookupMatches ().GetN (), 4, "wrong number of matches");
+  node->AddNodeA (CreateObject<ConfigTestObject> ());
+  NS_TEST_EXPECT_MSG_EQ (all.LookupMatches ().GetN (), 5, "wrong number of matches");
+
+  std::vector<std::string> paths;
+  std::vector<CallbackBase> cbs;
+  // paths which share their first segments, and one which does not
+  paths.push_back ("/NodesMap/5/NodesA/3/Source");
+  paths.push_back ("/NodesMap/5/NodesA/1/Source");
+  paths.push_back ("/NodesMap/2/Source");
+  for (uint32_t i = 0; i < paths.size (); i++)
+    {
+      cbs.push_back (MakeCallback (&CompiledPathConfigTestCase::Trace, this));
+    }
+  Config::ConnectMany (paths, cbs);
+  Config::Set ("/NodesMap/5/NodesA/*/Source", IntegerValue (5));
+  NS_TEST_ASSERT_MSG_EQ (m_contexts.size (), 2, "wrong number of trace events");
+  NS_TEST_EXPECT_MSG_EQ (m_contexts[0], "/NodesMap/5/NodesA/1/Source", "wrong context");
+  NS_TEST_EXPECT_MSG_EQ (m_contexts[1], "/NodesMap/5/NodesA/3/Source", "wrong context");
+  Config::Set ("/NodesMap/2/Source", IntegerValue (5));
+  NS_TEST_ASSERT_MSG_EQ (m_contexts.size (), 3, "wrong number of trace events");
+  NS_TEST_EXPECT_MSG_EQ (m_contexts[2], "/NodesMap/2/Source", "wrong context");
+
+  Config::CompiledPath (paths[0]).Disconnect (MakeCallback (&CompiledPathConfigTestCase::Trace, this));
+  Config::CompiledPath ("/NodesMap/5/NodesA/[0-3]/Source").Set (IntegerValue (6));
+  NS_TEST_ASSERT_MSG_EQ (m_contexts.size (), 4, "wrong number of trace events");
+  NS_TEST_EXPECT_MSG_EQ (m_contexts[3], "/NodesMap/5/NodesA/1/Source", "wrong context");
+
+  Config::UnregisterRootNamespaceObject (root);
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -737,6 +879,7 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new UnderRootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new ObjectVectorConfigTestCase, TestCase::QUICK);
   AddTestCase (new SearchAttributesOfParentObjectsTestCase, TestCase::QUICK);
+  AddTestCase (new CompiledPathConfigTestCase, TestCase::QUICK);
 }
 
 static ConfigTestSuite configTestSuite;
@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/event-profiler.h"
+#include "ns3/config.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace ns3;
+
+class EventProfilerTestCase : public TestCase
+{
+public:
+  EventProfilerTestCase (uint32_t samplingPeriod);
+  virtual void DoRun (void);
+  void Parent (uint32_t children);
+  void Child (void);
+
+private:
+  uint32_t m_samplingPeriod;
+};
+
+EventProfilerTestCase::EventProfilerTestCase (uint32_t samplingPeriod)
+  : TestCase ("Check the event counts and fan-out reported by the profiler"),
+    m_samplingPeriod (samplingPeriod)
+{
+}
+
+void
+EventProfilerTestCase::Parent (uint32_t children)
+{
+  for (uint32_t i = 0; i < children; i++)
+    {
+      Simulator::Schedule (MicroSeconds (1), &EventProfilerTestCase::Child, this);
+    }
+}
+
+void
+EventProfilerTestCase::Child (void)
+{
+}
+
+void
+EventProfilerTestCase::DoRun (void)
+{
+  std::string text = CreateTempDirFilename ("event-profile.txt");
+  std::string csv = CreateTempDirFilename ("event-profile.csv");
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::Profile", BooleanValue (true));
+  Config::SetDefault ("ns3::EventProfiler::TextFile", StringValue (text));
+  Config::SetDefault ("ns3::EventProfiler::CsvFile", StringValue (csv));
+  Config::SetDefault ("ns3::EventProfiler::SamplingPeriod", UintegerValue (m_samplingPeriod));
+
+  // ten parents on node 3, each of which schedules four children
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::ScheduleWithContext (3, Seconds (i), &EventProfilerTestCase::Parent, this, 4);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::Profile", BooleanValue (false));
+  Config::SetDefault ("ns3::EventProfiler::TextFile", StringValue ("event-profile.txt"));
+  Config::SetDefault ("ns3::EventProfiler::CsvFile", StringValue ("event-profile.csv"));
+  Config::SetDefault ("ns3::EventProfiler::SamplingPeriod", UintegerValue (16));
+
+  std::ifstream is (csv.c_str ());
+  NS_TEST_ASSERT_MSG_EQ (is.good (), true, "No CSV report");
+  std::string line;
+  std::getline (is, line);
+  NS_TEST_EXPECT_MSG_EQ (line, "event,context,count,timed,nanoseconds,fanout", "Bad CSV header");
+  uint32_t records = 0;
+  uint64_t parents = 0;
+  uint64_t children = 0;
+  uint64_t fanOut = 0;
+  while (std::getline (is, line))
+    {
+      records++;
+      // the name is quoted and may hold commas: parse from the end
+      std::string::size_type end = line.rfind ('"');
+      NS_TEST_ASSERT_MSG_NE (end, std::string::npos, "Unquoted event name");
+      std::string name = line.substr (1, end - 1);
+      std::istringstream fields (line.substr (end + 2));
+      int64_t context;
+      uint64_t count, timed, nanoseconds, eventFanOut;
+      char comma;
+      fields >> context >> comma >> count >> comma >> timed >> comma >> nanoseconds >> comma >> eventFanOut;
+      NS_TEST_EXPECT_MSG_EQ (context, 3, "Bad context");
+      // the first event of each record is always timed
+      NS_TEST_EXPECT_MSG_GT_OR_EQ (timed, 1, "No timed event");
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (timed, count, "More timed events than events");
+      if (m_samplingPeriod == 1)
+        {
+          NS_TEST_EXPECT_MSG_EQ (timed, count, "Not all the events were timed");
+        }
+      if (name.find ("EventProfilerTestCase::*)(unsigned int)") != std::string::npos)
+        {
+          parents += count;
+          fanOut += eventFanOut;
+        }
+      else
+        {
+          children += count;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (records, 2, "Expected one record per event type");
+  NS_TEST_EXPECT_MSG_EQ (parents, 10, "Bad number of parent events");
+  NS_TEST_EXPECT_MSG_EQ (children, 40, "Bad number of child events");
+  NS_TEST_EXPECT_MSG_EQ (fanOut, 40, "Bad fan-out");
+
+  std::ifstream report (text.c_str ());
+  std::getline (report, line);
+  NS_TEST_EXPECT_MSG_EQ (line.find ("Event profile: 50 events"), 0, "Bad text report");
+}
+
+class EventProfilerTestSuite : public TestSuite
+{
+public:
+  EventProfilerTestSuite ()
+    : TestSuite ("event-profiler")
+  {
+    AddTestCase (new EventProfilerTestCase (1), TestCase::QUICK);
+    AddTestCase (new EventProfilerTestCase (16), TestCase::QUICK);
+  }
+} g_eventProfilerTestSuite;
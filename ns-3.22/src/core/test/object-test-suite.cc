@@ -335,6 +335,69 @@ AggregateObjectTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_NE (baseA, 0, "Unable to GetObject on released object");
 }
 
+// ===========================================================================
+// Test case to make sure that the lookups cached by GetObject follow the
+// changes of the aggregation.
+// ===========================================================================
+class GetObjectCacheTestCase : public TestCase
+{
+public:
+  GetObjectCacheTestCase ();
+  virtual ~GetObjectCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+GetObjectCacheTestCase::GetObjectCacheTestCase ()
+  : TestCase ("Check that GetObject finds the objects aggregated after a lookup")
+{
+}
+
+GetObjectCacheTestCase::~GetObjectCacheTestCase ()
+{
+}
+
+void
+GetObjectCacheTestCase::DoRun (void)
+{
+  Ptr<BaseA> baseA = CreateObject<BaseA> ();
+  Ptr<DerivedB> derivedB = CreateObject<DerivedB> ();
+
+  //
+  // The unused entries of the cache must not match a default TypeId.
+  //
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<Object> (TypeId ()), 0, "Unexpectedly found an object for TypeId ()");
+
+  //
+  // A failed lookup is cached too; it must not hide an object aggregated
+  // later.
+  //
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<BaseB> (), 0, "Unexpectedly found a BaseB");
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<BaseB> (BaseB::GetTypeId ()), 0, "Unexpectedly found a BaseB");
+  baseA->AggregateObject (derivedB);
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<BaseB> (), derivedB, "Cannot GetObject for BaseB after aggregation");
+  NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<BaseA> (), baseA, "Cannot GetObject for BaseA after aggregation");
+
+  //
+  // Look up more types than the cache holds, then the first ones again.
+  //
+  for (uint32_t round = 0; round < 2; round++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<BaseB> (), derivedB, "Cannot GetObject for BaseB");
+      NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<DerivedB> (), derivedB, "Cannot GetObject for DerivedB");
+      NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<BaseA> (), baseA, "Cannot GetObject for BaseA");
+      NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<DerivedA> (), 0, "Unexpectedly found a DerivedA");
+      for (uint32_t i = 0; i < 20 && i < TypeId::GetRegisteredN (); i++)
+        {
+          TypeId tid = TypeId::GetRegistered (i);
+          bool expected = tid == Object::GetTypeId () || tid == BaseA::GetTypeId ()
+            || tid == BaseB::GetTypeId () || tid == DerivedB::GetTypeId ();
+          NS_TEST_ASSERT_MSG_EQ ((baseA->GetObject<Object> (tid) != 0), expected, "Wrong lookup of " << tid.GetName ());
+        }
+    }
+}
+
 // ===========================================================================
 // Test case to make sure that an Object factory can create Objects
 // ===========================================================================
@@ -421,6 +484,7 @@ ObjectTestSuite::ObjectTestSuite ()
 {
   AddTestCase (new CreateObjectTestCase, TestCase::QUICK);
   AddTestCase (new AggregateObjectTestCase, TestCase::QUICK);
+  AddTestCase (new GetObjectCacheTestCase, TestCase::QUICK);
   AddTestCase (new ObjectFactoryTestCase, TestCase::QUICK);
 }
 
@@ -21,8 +21,16 @@
 #include "ns3/simulator.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
+#include "ns3/dary-heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/event-impl-pool.h"
+#include "ns3/pointer.h"
+#include "ns3/uinteger.h"
+#include "ns3/system-thread.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -168,6 +176,78 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_destroy, true, "Event should have run");
 }
 
+class SimulatorCancelledEventsTestCase : public TestCase
+{
+public:
+  SimulatorCancelledEventsTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  void CheckEvent (uint32_t index);
+  uint32_t m_count;
+  uint32_t m_lastIndex;
+  bool m_cancelledRun;
+  bool m_outOfOrder;
+  ObjectFactory m_schedulerFactory;
+};
+
+SimulatorCancelledEventsTestCase::SimulatorCancelledEventsTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that cancelling most of the pending events works with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SimulatorCancelledEventsTestCase::CheckEvent (uint32_t index)
+{
+  if (index % 5 != 0)
+    {
+      m_cancelledRun = true;
+    }
+  if (m_count > 0 && index < m_lastIndex)
+    {
+      m_outOfOrder = true;
+    }
+  m_lastIndex = index;
+  m_count++;
+}
+
+void
+SimulatorCancelledEventsTestCase::DoRun (void)
+{
+  m_count = 0;
+  m_lastIndex = 0;
+  m_cancelledRun = false;
+  m_outOfOrder = false;
+
+  Simulator::SetScheduler (m_schedulerFactory);
+
+  // Event i expires at time i but is inserted in a scrambled order, and
+  // four out of five events are cancelled: this is enough cancelled events
+  // to make the simulator purge them from the schedulers which support it.
+  const uint32_t n = 10000;
+  std::vector<EventId> ids (n);
+  for (uint32_t j = 0; j < n; j++)
+    {
+      uint32_t i = (j * 7919) % n;
+      ids[i] = Simulator::Schedule (MicroSeconds (i), &SimulatorCancelledEventsTestCase::CheckEvent, this, i);
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      if (i % 5 != 0)
+        {
+          Simulator::Cancel (ids[i]);
+          NS_TEST_EXPECT_MSG_EQ (ids[i].IsExpired (), true, "Event was cancelled: it is now expired");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (ids[5].IsExpired (), false, "Event should not have expired yet");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, n / 5, "Wrong number of events run");
+  NS_TEST_EXPECT_MSG_EQ (m_cancelledRun, false, "A cancelled event was run");
+  NS_TEST_EXPECT_MSG_EQ (m_outOfOrder, false, "Events were run out of order");
+  NS_TEST_EXPECT_MSG_EQ (ids[5].IsExpired (), true, "Event should have expired now");
+  Simulator::Destroy ();
+}
+
 class SimulatorTemplateTestCase : public TestCase
 {
 public:
@@ -458,6 +538,103 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Run ();
   Simulator::Destroy ();
 }
+class SimulatorEventPoolTestCase : public TestCase
+{
+public:
+  SimulatorEventPoolTestCase ();
+  virtual void DoRun (void);
+  void Reschedule (uint32_t left);
+  struct Large
+  {
+    uint8_t data[512];
+  };
+  void LargeEvent (Large large);
+  uint32_t m_count;
+};
+
+SimulatorEventPoolTestCase::SimulatorEventPoolTestCase ()
+  : TestCase ("Check that the events are allocated from the EventImplPool of the simulator")
+{
+}
+
+void
+SimulatorEventPoolTestCase::Reschedule (uint32_t left)
+{
+  m_count++;
+  if (left > 0)
+    {
+      Simulator::Schedule (MicroSeconds (1), &SimulatorEventPoolTestCase::Reschedule, this, left - 1);
+    }
+}
+
+void
+SimulatorEventPoolTestCase::LargeEvent (Large large)
+{
+  m_count++;
+}
+
+static void
+ReleaseEvent (EventId *id)
+{
+  *id = EventId ();
+}
+
+static uint64_t
+GetPoolCounter (Ptr<EventImplPool> pool, std::string name)
+{
+  UintegerValue value;
+  pool->GetAttribute (name, value);
+  return value.Get ();
+}
+
+void
+SimulatorEventPoolTestCase::DoRun (void)
+{
+  m_count = 0;
+  PointerValue value;
+  if (!Simulator::GetImplementation ()->GetAttributeFailSafe ("EventImplPool", value))
+    {
+      // this simulator implementation does not pool its events
+      Simulator::Destroy ();
+      return;
+    }
+  Ptr<EventImplPool> pool = value.Get<EventImplPool> ();
+  NS_TEST_ASSERT_MSG_NE (pool, 0, "The simulator should own an event pool");
+  NS_TEST_EXPECT_MSG_EQ (EventImplPool::GetCurrent (), pool, "The pool of the simulator should be the current one");
+
+  // A chain of events, each of which schedules the next one: the same
+  // block is recycled over and over.
+  const uint32_t n = 10000;
+  Simulator::Schedule (MicroSeconds (1), &SimulatorEventPoolTestCase::Reschedule, this, n - 1);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, n, "Wrong number of events run");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (GetPoolCounter (pool, "Allocations"), n, "Events were not allocated from the pool");
+  NS_TEST_EXPECT_MSG_EQ (GetPoolCounter (pool, "BlocksInUse"), 0, "All the events should have been released");
+  NS_TEST_EXPECT_MSG_LT (GetPoolCounter (pool, "PeakBlocksInUse"), 10, "Blocks were not recycled");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (GetPoolCounter (pool, "ReservedBytes"), 64 * 1024, "Blocks were not recycled");
+
+  // Events too large for the pool are allocated on the heap.
+  Large large;
+  Simulator::Schedule (MicroSeconds (1), &SimulatorEventPoolTestCase::LargeEvent, this, large);
+  NS_TEST_EXPECT_MSG_EQ (GetPoolCounter (pool, "HeapAllocations"), 1, "The event should have been allocated on the heap");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, n + 1, "Wrong number of events run");
+
+  // Events may outlive the simulator, and the pool they come from.
+  EventId id = Simulator::Schedule (MicroSeconds (1), &SimulatorEventPoolTestCase::Reschedule, this, 0);
+  NS_TEST_EXPECT_MSG_EQ (GetPoolCounter (pool, "BlocksInUse"), 1, "The event should have been allocated from the pool");
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (EventImplPool::GetCurrent (), 0, "The pool should not be used after the simulator is destroyed");
+  NS_TEST_EXPECT_MSG_EQ (GetPoolCounter (pool, "BlocksInUse"), 1, "The event should still be alive");
+
+  // Once the pool is disposed, a block released by another thread goes
+  // straight back to its free list.
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (&ReleaseEvent, &id));
+  thread->Start ();
+  thread->Join ();
+  NS_TEST_EXPECT_MSG_EQ (GetPoolCounter (pool, "BlocksInUse"), 0, "The event should have been released");
+  pool = 0;
+}
 
 class SimulatorTestSuite : public TestSuite
 {
@@ -475,5 +652,22 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorCancelledEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorCancelledEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorCancelledEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SimulatorCancelledEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorCancelledEventsTestCase (factory), TestCase::QUICK);
+
+    AddTestCase (new SimulatorEventPoolTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -19,12 +19,14 @@
  */
 #include "ns3/test.h"
 #include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
 #include "ns3/config.h"
 #include "ns3/string.h"
+#include "ns3/uinteger.h"
 #include "ns3/system-thread.h"
 
 #include <ctime>
@@ -225,6 +227,104 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+class ThreadedSimulatorInjectionTestCase : public TestCase
+{
+public:
+  ThreadedSimulatorInjectionTestCase (unsigned int threads);
+  void Receive (unsigned int threadno, uint32_t seq);
+  void Check (void);
+  static void InjectingThread (std::pair<ThreadedSimulatorInjectionTestCase *, unsigned int> context);
+
+  static const uint32_t EVENTS = 10000;
+  unsigned int m_threads;
+  uint32_t m_next[MAXTHREADS];
+  uint64_t m_received;
+  bool m_inOrder;
+  std::list<Ptr<SystemThread> > m_threadlist;
+
+private:
+  virtual void DoRun (void);
+};
+
+ThreadedSimulatorInjectionTestCase::ThreadedSimulatorInjectionTestCase (unsigned int threads)
+  : TestCase ("Check that the events scheduled by other threads are all executed, in order"),
+    m_threads (threads)
+{
+}
+
+void
+ThreadedSimulatorInjectionTestCase::InjectingThread (std::pair<ThreadedSimulatorInjectionTestCase *, unsigned int> context)
+{
+  ThreadedSimulatorInjectionTestCase *me = context.first;
+  unsigned int threadno = context.second;
+  for (uint32_t i = 0; i < EVENTS; i++)
+    {
+      Simulator::ScheduleWithContext (threadno, MicroSeconds (1),
+                                      &ThreadedSimulatorInjectionTestCase::Receive, me, threadno, i);
+    }
+}
+
+void
+ThreadedSimulatorInjectionTestCase::Receive (unsigned int threadno, uint32_t seq)
+{
+  if (seq != m_next[threadno])
+    {
+      m_inOrder = false;
+    }
+  m_next[threadno] = seq + 1;
+  m_received++;
+}
+
+void
+ThreadedSimulatorInjectionTestCase::Check (void)
+{
+  if (m_received == m_threads * EVENTS)
+    {
+      Simulator::Stop ();
+      return;
+    }
+  Simulator::Schedule (MicroSeconds (10), &ThreadedSimulatorInjectionTestCase::Check, this);
+}
+
+void
+ThreadedSimulatorInjectionTestCase::DoRun (void)
+{
+  m_received = 0;
+  m_inOrder = true;
+  for (unsigned int i = 0; i < m_threads; ++i)
+    {
+      m_next[i] = 0;
+      m_threadlist.push_back (
+        Create<SystemThread> (MakeBoundCallback (
+            &ThreadedSimulatorInjectionTestCase::InjectingThread,
+                std::pair<ThreadedSimulatorInjectionTestCase *, unsigned int> (this, i))));
+    }
+  Simulator::Schedule (MicroSeconds (10), &ThreadedSimulatorInjectionTestCase::Check, this);
+  for (std::list<Ptr<SystemThread> >::iterator it = m_threadlist.begin (); it != m_threadlist.end (); ++it)
+    {
+      (*it)->Start ();
+    }
+
+  Simulator::Run ();
+
+  for (std::list<Ptr<SystemThread> >::iterator it = m_threadlist.begin (); it != m_threadlist.end (); ++it)
+    {
+      (*it)->Join ();
+    }
+  m_threadlist.clear ();
+
+  UintegerValue injected;
+  UintegerValue processed;
+  Simulator::GetImplementation ()->GetAttribute ("InjectedEvents", injected);
+  Simulator::GetImplementation ()->GetAttribute ("InjectedEventsProcessed", processed);
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, m_threads * EVENTS, "Lost events");
+  NS_TEST_EXPECT_MSG_EQ (m_inOrder, true, "Events of a thread executed out of order");
+  NS_TEST_EXPECT_MSG_EQ (injected.Get (), m_threads * EVENTS, "Bad number of injected events");
+  NS_TEST_EXPECT_MSG_EQ (processed.Get (), m_threads * EVENTS, "Bad number of processed events");
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -240,8 +340,10 @@ public:
     std::string schedulerTypes[] = {
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
+      "ns3::DaryHeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler"
     };
     unsigned int threadcounts[] = {
       0,
@@ -262,5 +364,6 @@ public:
               }
           }
       }
+    AddTestCase (new ThreadedSimulatorInjectionTestCase (4), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
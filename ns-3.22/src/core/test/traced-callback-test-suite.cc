@@ -62,6 +62,7 @@ BasicTracedCallbackTestCase::DoRun (void)
   // these methods do is to set corresponding member variables m_one and m_two.
   //
   TracedCallback<uint8_t, double> trace;
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), true, "No callback should be connected");
 
   //
   // Connect both callbacks to their respective test methods.  If we hit the 
@@ -70,6 +71,7 @@ BasicTracedCallbackTestCase::DoRun (void)
   //
   trace.ConnectWithoutContext (MakeCallback (&BasicTracedCallbackTestCase::CbOne, this));
   trace.ConnectWithoutContext (MakeCallback (&BasicTracedCallbackTestCase::CbTwo, this));
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), false, "Callbacks should be connected");
   m_one = false;
   m_two = false;
   trace (1, 2);
@@ -80,6 +82,7 @@ BasicTracedCallbackTestCase::DoRun (void)
   // If we now disconnect callback one then only callback two should be called.
   //
   trace.DisconnectWithoutContext (MakeCallback (&BasicTracedCallbackTestCase::CbOne, this));
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), false, "Callback CbTwo should still be connected");
   m_one = false;
   m_two = false;
   trace (1, 2);
@@ -90,6 +93,7 @@ BasicTracedCallbackTestCase::DoRun (void)
   // If we now disconnect callback two then neither callback should be called.
   //
   trace.DisconnectWithoutContext (MakeCallback (&BasicTracedCallbackTestCase::CbTwo, this));
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), true, "All the callbacks should be disconnected");
   m_one = false;
   m_two = false;
   trace (1, 2);
@@ -23,6 +23,7 @@
 #include <ctime>
 
 #include "ns3/type-id.h"
+#include "ns3/object-base.h"
 #include "ns3/test.h"
 #include "ns3/log.h"
 
@@ -188,6 +189,85 @@ CollisionTestCase::DoRun (void)
 }
   
   
+//----------------------------
+//
+// Test of IsChildOf
+
+class IsChildOfTestCase : public TestCase
+{
+public:
+  IsChildOfTestCase ();
+  virtual ~IsChildOfTestCase ();
+private:
+  virtual void DoRun (void);
+  // the types which never called SetParent have the parent 0
+  static bool HasParent (TypeId tid);
+  // walk the parents, as IsChildOf did
+  static bool WalkParents (TypeId tid, TypeId other);
+};
+
+IsChildOfTestCase::IsChildOfTestCase ()
+  : TestCase ("Check IsChildOf against the parents of the TypeIds")
+{
+}
+
+IsChildOfTestCase::~IsChildOfTestCase ()
+{
+}
+
+bool
+IsChildOfTestCase::HasParent (TypeId tid)
+{
+  return tid.GetParent ().GetUid () != 0 && tid.HasParent ();
+}
+
+bool
+IsChildOfTestCase::WalkParents (TypeId tid, TypeId other)
+{
+  TypeId tmp = tid;
+  while (tmp != other && HasParent (tmp))
+    {
+      tmp = tmp.GetParent ();
+    }
+  return tmp == other && tid != other;
+}
+
+void
+IsChildOfTestCase::DoRun (void)
+{
+  uint32_t nids = TypeId::GetRegisteredN ();
+  for (uint32_t i = 0; i < nids; ++i)
+    {
+      TypeId tid = TypeId::GetRegistered (i);
+      // the ancestors, and a sample of the other types
+      for (TypeId parent = tid; HasParent (parent); parent = parent.GetParent ())
+        {
+          NS_TEST_ASSERT_MSG_EQ (tid.IsChildOf (parent.GetParent ()), true,
+                                 tid.GetName () << " is a child of " << parent.GetParent ().GetName ());
+        }
+      NS_TEST_ASSERT_MSG_EQ (tid.IsChildOf (tid), false, tid.GetName () << " is not its own child");
+      for (uint32_t j = i % 17; j < nids; j += 17)
+        {
+          TypeId other = TypeId::GetRegistered (j);
+          NS_TEST_ASSERT_MSG_EQ (tid.IsChildOf (other), WalkParents (tid, other),
+                                 "wrong IsChildOf of " << tid.GetName () << " and " << other.GetName ());
+        }
+    }
+
+  // a type whose parent is set after its children were registered
+  TypeId base = TypeId ("IsChildOfTestCase::Base");
+  TypeId child = TypeId ("IsChildOfTestCase::Child").SetParent (base);
+  TypeId grandChild = TypeId ("IsChildOfTestCase::GrandChild").SetParent (child);
+  base.SetParent (base);
+  NS_TEST_ASSERT_MSG_EQ (grandChild.IsChildOf (base), true, "wrong IsChildOf before reparenting");
+  NS_TEST_ASSERT_MSG_EQ (grandChild.IsChildOf (ObjectBase::GetTypeId ()), false, "wrong IsChildOf before reparenting");
+  base.SetParent (ObjectBase::GetTypeId ());
+  NS_TEST_ASSERT_MSG_EQ (grandChild.IsChildOf (base), true, "wrong IsChildOf after reparenting");
+  NS_TEST_ASSERT_MSG_EQ (grandChild.IsChildOf (ObjectBase::GetTypeId ()), true, "wrong IsChildOf after reparenting");
+  NS_TEST_ASSERT_MSG_EQ (child.IsChildOf (grandChild), false, "wrong IsChildOf after reparenting");
+}
+
+
 //----------------------------
 //
 // Performance test
@@ -245,6 +325,19 @@ LookupTimeTestCase::DoRun (void)
   }
   stop = clock ();
   Report ("hash", stop - start);
+
+  TypeId objectBase = ObjectBase::GetTypeId ();
+  start = clock ();
+  for (uint32_t j = 0; j < REPETITIONS; ++j)
+    {
+      for (uint32_t i = 0; i < nids; ++i)
+        {
+          const TypeId tid = TypeId::GetRegistered (i);
+          tid.IsChildOf (objectBase);
+        }
+  }
+  stop = clock ();
+  Report ("IsChildOf", stop - start);
   
 }
 
@@ -298,6 +391,7 @@ TypeIdTestSuite::TypeIdTestSuite ()
   // as chained.
   AddTestCase (new UniqueTypeIdTestCase, QUICK);
   AddTestCase (new CollisionTestCase, QUICK);
+  AddTestCase (new IsChildOfTestCase, QUICK);
 }
 
 static TypeIdTestSuite g_TypeIdTestSuite;  
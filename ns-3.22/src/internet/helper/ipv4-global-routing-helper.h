@@ -82,6 +82,18 @@ public:
    *
    */
   static void RecomputeRoutingTables (void);
+  /**
+   * \brief Update the routes installed by a prior call to
+   * PopulateRoutingTables(), RecomputeRoutingTables() or
+   * UpdateRoutingTables() after some links changed.
+   *
+   * The routes are the same as with RecomputeRoutingTables(), but only
+   * the nodes whose shortest paths may have changed compute them again,
+   * and the others only update the routes to the networks which
+   * changed, so that the routes may be in a different order.  The
+   * first call computes all the routes.
+   */
+  static void UpdateRoutingTables (void);
 private:
   /**
    * \brief Assignment operator declared private and not implemented to disallow
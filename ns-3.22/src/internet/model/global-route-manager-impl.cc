@@ -35,6 +35,13 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include <unistd.h>
+#endif /* HAVE_PTHREAD_H */
 #include "global-router-interface.h"
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
@@ -44,6 +51,14 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/// The number of threads which run the SPF calculations
+static GlobalValue g_globalRoutingThreadCount ("GlobalRoutingThreadCount",
+                                               "The number of threads which run the SPF calculations "
+                                               "of the global routing, or zero to use one thread per "
+                                               "online processor.",
+                                               UintegerValue (0),
+                                               MakeUintegerChecker<uint32_t> ());
+
 /**
  * \brief Stream insertion operator.
  *
@@ -495,13 +510,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -531,6 +543,17 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
   return 0;
 }
 
+void
+GlobalRouteManagerLSDB::GetLSAs (std::vector<GlobalRoutingLSA*> &lsas) const
+{
+  NS_LOG_FUNCTION (this);
+  lsas.clear ();
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      lsas.push_back (i->second);
+    }
+}
+
 // ---------------------------------------------------------------------------
 //
 // GlobalRouteManagerImpl Implementation
@@ -598,6 +621,8 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
       delete m_lsdb;
       m_lsdb = new GlobalRouteManagerLSDB ();
     }
+  m_spfGraph = SpfGraph ();
+  m_spfStates.clear ();
 }
 
 //
@@ -697,37 +722,98 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 {
   NS_LOG_FUNCTION (this);
 //
-// Walk the list of nodes in the system.
+// The SPF calculations run on a compact copy of the Link State DataBase,
+// from several threads.  They find the same routes as SPFCalculate (),
+// which the main thread then installs root after root.
 //
   NS_LOG_INFO ("About to start SPF calculation");
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+  SpfGraph graph;
+  BuildSpfGraph (graph, 0);
+  std::vector<SpfJob> jobs;
+  GetSpfJobs (graph, jobs);
+  RunSpfJobs (graph, 0, std::vector<uint32_t> (), jobs);
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+void
+GlobalRouteManagerImpl::UpdateRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_spfStates.empty ())
     {
-      Ptr<Node> node = *i;
+      NS_LOG_LOGIC ("No previous SPF calculation, computing all the routes");
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      BuildSpfGraph (m_spfGraph, 0);
+      std::vector<SpfJob> jobs;
+      GetSpfJobs (m_spfGraph, jobs);
+      for (std::vector<SpfJob>::iterator i = jobs.begin (); i != jobs.end (); i++)
+        {
+          i->state = &m_spfStates[i->root];
+          i->state->routing = i->routing;
+        }
+      RunSpfJobs (m_spfGraph, 0, std::vector<uint32_t> (), jobs);
+      return;
+    }
+
+  delete m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  SpfGraph graph;
+  BuildSpfGraph (graph, &m_spfGraph);
+
 //
-// Look for the GlobalRouter interface that indicates that the node is
-// participating in routing.
+// Find the vertices whose links, destinations or stub networks changed.
+// The vertices keep their index, the new ones come last.
 //
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      uint32_t systemId = MpiInterface::GetSystemId ();
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != systemId) 
+  std::vector<uint32_t> changed;
+  std::vector<bool> isChanged (graph.ids.size (), false);
+  for (uint32_t v = 0; v < graph.ids.size (); v++)
+    {
+      if (v >= m_spfGraph.ids.size () || !SameSpfVertex (graph, m_spfGraph, v))
         {
-          continue;
+          changed.push_back (v);
+          isChanged[v] = true;
         }
+    }
+  bool externalsChanged = graph.externals != m_spfGraph.externals;
+  NS_LOG_LOGIC (changed.size () << " of " << graph.ids.size () << " vertices changed");
 
+  std::vector<SpfJob> jobs;
+  GetSpfJobs (graph, jobs);
+  std::map<uint32_t, SpfState> states;
+  for (std::vector<SpfJob>::iterator i = jobs.begin (); i != jobs.end (); i++)
+    {
+      SpfState &state = states[i->root];
+      i->replace = true;
+      std::map<uint32_t, SpfState>::iterator old = m_spfStates.find (i->root);
+      if (old != m_spfStates.end () && old->second.routing == i->routing)
+        {
+          state.distances.swap (old->second.distances);
+          state.exitOffsets.swap (old->second.exitOffsets);
+          state.exits.swap (old->second.exits);
+          i->replace = externalsChanged || isChanged[i->root];
+          m_spfStates.erase (old);
+        }
+      state.routing = i->routing;
+      i->state = &state;
+    }
 //
-// if the node has a global router interface, then run the global routing
-// algorithms.
+// The routers which are no longer roots lose their routes, as they would
+// with DeleteGlobalRoutes ().
 //
-      if (rtr && rtr->GetNumLSAs () )
+  for (std::map<uint32_t, SpfState>::iterator i = m_spfStates.begin (); i != m_spfStates.end (); i++)
+    {
+      uint32_t nRoutes = i->second.routing->GetNRoutes ();
+      for (uint32_t j = 0; j < nRoutes; j++)
         {
-          SPFCalculate (rtr->GetRouterId ());
+          i->second.routing->RemoveRoute (0);
         }
     }
-  NS_LOG_INFO ("Finished SPF calculation");
+  m_spfStates.swap (states);
+
+  RunSpfJobs (graph, &m_spfGraph, changed, jobs);
+  m_spfGraph = graph;
 }
 
 //
@@ -2203,6 +2289,914 @@ GlobalRouteManagerImpl::SPFVertexAddParent (SPFVertex* v)
     }
 }
 
+// ---------------------------------------------------------------------------
+//
+// SPF calculation on a compact graph, for all the routers
+//
+// ---------------------------------------------------------------------------
+
+bool
+GlobalRouteManagerImpl::SpfEdge::operator== (SpfEdge const &o) const
+{
+  return to == o.to && cost == o.cost && outIf == o.outIf
+         && nextHop == o.nextHop && hasNextHop == o.hasNextHop;
+}
+
+bool
+GlobalRouteManagerImpl::SpfDestination::operator== (SpfDestination const &o) const
+{
+  return network == o.network && mask == o.mask;
+}
+
+bool
+GlobalRouteManagerImpl::SpfExternal::operator== (SpfExternal const &o) const
+{
+  return router == o.router && destination == o.destination;
+}
+
+namespace {
+
+/// Find the first link record of a LSA whose link ID is an address, as SPFGetNextLink
+GlobalRoutingLinkRecord *
+FindLinkTo (GlobalRoutingLSA *lsa, Ipv4Address id)
+{
+  for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+      if (l->GetLinkId () == id)
+        {
+          return l;
+        }
+    }
+  return 0;
+}
+
+/// Whether the ranges [aBegin, aEnd) of a and [bBegin, bEnd) of b are equal
+template <typename T>
+bool
+SameRange (std::vector<T> const &a, uint32_t aBegin, uint32_t aEnd,
+           std::vector<T> const &b, uint32_t bBegin, uint32_t bEnd)
+{
+  if (aEnd - aBegin != bEnd - bBegin)
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < aEnd - aBegin; i++)
+    {
+      if (!(a[aBegin + i] == b[bBegin + i]))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+/// Append to missing the elements of the range of a which are not in the range of b
+template <typename T>
+void
+MissingFromRange (std::vector<T> const &a, uint32_t aBegin, uint32_t aEnd,
+                  std::vector<T> const &b, uint32_t bBegin, uint32_t bEnd,
+                  std::vector<T> &missing)
+{
+  std::vector<bool> used (bEnd - bBegin, false);
+  for (uint32_t i = aBegin; i < aEnd; i++)
+    {
+      uint32_t j;
+      for (j = bBegin; j < bEnd; j++)
+        {
+          if (!used[j - bBegin] && a[i] == b[j])
+            {
+              used[j - bBegin] = true;
+              break;
+            }
+        }
+      if (j == bEnd)
+        {
+          missing.push_back (a[i]);
+        }
+    }
+}
+
+typedef SPFVertex::NodeExit_t SpfExit; //!< next hop and outgoing interface from the root
+
+/**
+ * The sets of exits of the vertices of a SPF calculation.  A set is never
+ * modified once created, so that the vertices which inherit the exits of
+ * their parent share the set of the parent.  The set 0 is empty.
+ */
+class SpfExitSets
+{
+public:
+  SpfExitSets ()
+    : m_sets (1, std::make_pair (0U, 0U))
+  {
+  }
+  uint32_t Single (SpfExit exit)
+  {
+    m_exits.push_back (exit);
+    m_sets.push_back (std::make_pair (m_exits.size () - 1, 1U));
+    return m_sets.size () - 1;
+  }
+  // The union of two sets, sorted as SPFVertex::MergeRootExitDirections
+  uint32_t Merge (uint32_t a, uint32_t b)
+  {
+    std::vector<SpfExit> exits (Begin (a), End (a));
+    exits.insert (exits.end (), Begin (b), End (b));
+    std::sort (exits.begin (), exits.end ());
+    exits.erase (std::unique (exits.begin (), exits.end ()), exits.end ());
+    m_sets.push_back (std::make_pair (m_exits.size (), exits.size ()));
+    m_exits.insert (m_exits.end (), exits.begin (), exits.end ());
+    return m_sets.size () - 1;
+  }
+  uint32_t Size (uint32_t set) const
+  {
+    return m_sets[set].second;
+  }
+  SpfExit const *Begin (uint32_t set) const
+  {
+    return Size (set) == 0 ? 0 : &m_exits[m_sets[set].first];
+  }
+  SpfExit const *End (uint32_t set) const
+  {
+    return Begin (set) + Size (set);
+  }
+private:
+  std::vector<SpfExit> m_exits;
+  std::vector<std::pair<uint32_t, uint32_t> > m_sets;
+};
+
+/**
+ * A vertex in the candidate queue of a SPF calculation.  The candidates
+ * are ordered as in CandidateQueue: by distance, then the networks before
+ * the routers, then in the order they were pushed or got a shorter path.
+ */
+struct SpfCandidate
+{
+  uint32_t distance;
+  uint32_t router; // 0 for a network, 1 for a router
+  uint32_t order;
+  uint32_t vertex;
+};
+
+/// Order the candidates for std::push_heap, which keeps the greatest first
+bool
+SpfCandidateAfter (SpfCandidate const &a, SpfCandidate const &b)
+{
+  if (a.distance != b.distance)
+    {
+      return a.distance > b.distance;
+    }
+  if (a.router != b.router)
+    {
+      return a.router > b.router;
+    }
+  return a.order > b.order;
+}
+
+} // anonymous namespace
+
+void
+GlobalRouteManagerImpl::AddSpfRoutes (std::vector<SpfRoute> &routes, uint8_t type,
+                                      Ipv4Address network, Ipv4Mask mask,
+                                      SPFVertex::NodeExit_t const *begin, SPFVertex::NodeExit_t const *end)
+{
+  for (SPFVertex::NodeExit_t const *i = begin; i != end; i++)
+    {
+      if (i->second >= 0)
+        {
+          SpfRoute route;
+          route.type = type;
+          route.network = network;
+          route.mask = mask;
+          route.nextHop = i->first;
+          route.interface = i->second;
+          routes.push_back (route);
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::BuildSpfGraph (SpfGraph &graph, SpfGraph const *previous) const
+{
+  NS_LOG_FUNCTION (this << previous);
+  graph = SpfGraph ();
+  if (previous != 0)
+    {
+      graph.ids = previous->ids;
+      graph.indexes = previous->indexes;
+    }
+  std::vector<GlobalRoutingLSA*> lsas;
+  m_lsdb->GetLSAs (lsas);
+  std::vector<GlobalRoutingLSA*> vertices (graph.ids.size (), 0);
+  for (std::vector<GlobalRoutingLSA*>::const_iterator i = lsas.begin (); i != lsas.end (); i++)
+    {
+      std::pair<std::map<Ipv4Address, uint32_t>::iterator, bool> inserted =
+        graph.indexes.insert (std::make_pair ((*i)->GetLinkStateId (), graph.ids.size ()));
+      if (inserted.second)
+        {
+          graph.ids.push_back ((*i)->GetLinkStateId ());
+          vertices.push_back (0);
+        }
+      vertices[inserted.first->second] = *i;
+    }
+//
+// The router which has a transit link with each address, as found by
+// GetLSAByLinkData (), and the Ipv4 of each router, as found by
+// FindOutgoingInterfaceId ().
+//
+  std::map<Ipv4Address, uint32_t> transitRouters;
+  for (std::vector<GlobalRoutingLSA*>::const_iterator i = lsas.begin (); i != lsas.end (); i++)
+    {
+      for (uint32_t j = 0; j < (*i)->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *l = (*i)->GetLinkRecord (j);
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              transitRouters.insert (std::make_pair (l->GetLinkData (), graph.indexes[(*i)->GetLinkStateId ()]));
+            }
+        }
+    }
+  std::map<Ipv4Address, Ptr<Ipv4> > ipv4s;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr != 0)
+        {
+          ipv4s.insert (std::make_pair (rtr->GetRouterId (), (*i)->GetObject<Ipv4> ()));
+        }
+    }
+
+  uint32_t n = graph.ids.size ();
+  graph.types.assign (n, SPFVertex::VertexUnknown);
+  graph.stubRouters.assign (n, SPF_NOT_STUB);
+  graph.defaultRoutes.assign (n, SPFVertex::NodeExit_t (Ipv4Address::GetZero (), -1));
+  for (uint32_t v = 0; v < n; v++)
+    {
+      graph.edgeOffsets.push_back (graph.edges.size ());
+      graph.destinationOffsets.push_back (graph.destinations.size ());
+      graph.stubOffsets.push_back (graph.stubs.size ());
+      GlobalRoutingLSA *lsa = vertices[v];
+      if (lsa == 0)
+        {
+          continue;
+        }
+      if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+        {
+          graph.types[v] = SPFVertex::VertexRouter;
+          Ptr<Ipv4> ipv4;
+          std::map<Ipv4Address, Ptr<Ipv4> >::const_iterator found = ipv4s.find (graph.ids[v]);
+          if (found != ipv4s.end ())
+            {
+              ipv4 = found->second;
+            }
+          uint32_t transits = 0;
+          GlobalRoutingLinkRecord *transitLink = 0;
+          SpfEdge transitEdge;
+          for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+            {
+              GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+              if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+                {
+                  SpfDestination stub;
+                  stub.mask = Ipv4Mask (l->GetLinkData ().Get ());
+                  stub.network = l->GetLinkId ().CombineMask (stub.mask);
+                  graph.stubs.push_back (stub);
+                  continue;
+                }
+              NS_ASSERT_MSG (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+                             || l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork,
+                             "illegal Link Type");
+              std::map<Ipv4Address, uint32_t>::const_iterator w = graph.indexes.find (l->GetLinkId ());
+              NS_ASSERT_MSG (w != graph.indexes.end () && vertices[w->second] != 0,
+                             "No LSA for link " << l->GetLinkId () << " of " << graph.ids[v]);
+              GlobalRoutingLSA *wLsa = vertices[w->second];
+              SpfEdge edge;
+              edge.to = w->second;
+              edge.cost = l->GetMetric ();
+              if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+                {
+                  SpfDestination host;
+                  host.network = l->GetLinkData ();
+                  host.mask = Ipv4Mask::GetOnes ();
+                  graph.destinations.push_back (host);
+                  edge.outIf = ipv4 != 0 ? ipv4->GetInterfaceForPrefix (l->GetLinkData (), Ipv4Mask::GetOnes ()) : -1;
+                  GlobalRoutingLinkRecord *remote = FindLinkTo (wLsa, graph.ids[v]);
+                  edge.hasNextHop = remote != 0;
+                  edge.nextHop = remote != 0 ? remote->GetLinkData () : Ipv4Address::GetZero ();
+                }
+              else
+                {
+                  NS_ASSERT (wLsa->GetLSType () == GlobalRoutingLSA::NetworkLSA);
+                  edge.outIf = ipv4 != 0 ? ipv4->GetInterfaceForPrefix (wLsa->GetLinkStateId (),
+                                                                        wLsa->GetNetworkLSANetworkMask ()) : -1;
+                  edge.hasNextHop = true;
+                  edge.nextHop = Ipv4Address::GetZero ();
+                }
+              graph.edges.push_back (edge);
+              transits++;
+              transitLink = l;
+              transitEdge = edge;
+            }
+//
+// The routers with a single link to another router only get a default
+// route, as in CheckForStubNode ().
+//
+          if (transits == 0)
+            {
+              NS_LOG_WARN ("all nodes should have at least one transit link:" << graph.ids[v]);
+              graph.stubRouters[v] = SPF_STUB_NO_ROUTE;
+            }
+          else if (transits == 1 && transitLink->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+            {
+              GlobalRoutingLSA *wLsa = vertices[transitEdge.to];
+              for (uint32_t j = 0; j < wLsa->GetNLinkRecords (); j++)
+                {
+                  GlobalRoutingLinkRecord *lr = wLsa->GetLinkRecord (j);
+                  if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+                      && lr->GetLinkId () == graph.ids[v])
+                    {
+                      graph.stubRouters[v] = SPF_STUB_DEFAULT_ROUTE;
+                      graph.defaultRoutes[v] = SPFVertex::NodeExit_t (lr->GetLinkData (), transitEdge.outIf);
+                      break;
+                    }
+                }
+            }
+        }
+      else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+        {
+          graph.types[v] = SPFVertex::VertexNetwork;
+          SpfDestination network;
+          network.mask = lsa->GetNetworkLSANetworkMask ();
+          network.network = lsa->GetLinkStateId ().CombineMask (network.mask);
+          graph.destinations.push_back (network);
+          for (uint32_t i = 0; i < lsa->GetNAttachedRouters (); i++)
+            {
+              std::map<Ipv4Address, uint32_t>::const_iterator w = transitRouters.find (lsa->GetAttachedRouter (i));
+              if (w == transitRouters.end ())
+                {
+                  continue;
+                }
+              SpfEdge edge;
+              edge.to = w->second;
+              edge.cost = 0;
+              edge.outIf = -1;
+              GlobalRoutingLinkRecord *remote = FindLinkTo (vertices[w->second], graph.ids[v]);
+              edge.hasNextHop = remote != 0;
+              edge.nextHop = remote != 0 ? remote->GetLinkData () : Ipv4Address::GetZero ();
+              graph.edges.push_back (edge);
+            }
+        }
+    }
+  graph.edgeOffsets.push_back (graph.edges.size ());
+  graph.destinationOffsets.push_back (graph.destinations.size ());
+  graph.stubOffsets.push_back (graph.stubs.size ());
+
+  for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
+    {
+      GlobalRoutingLSA *extlsa = m_lsdb->GetExtLSA (i);
+      SpfExternal external;
+      external.router = SPF_INFINITY;
+      std::map<Ipv4Address, uint32_t>::const_iterator router = graph.indexes.find (extlsa->GetAdvertisingRouter ());
+      if (router != graph.indexes.end () && graph.types[router->second] == SPFVertex::VertexRouter)
+        {
+          external.router = router->second;
+        }
+      external.destination.mask = extlsa->GetNetworkLSANetworkMask ();
+      external.destination.network = extlsa->GetLinkStateId ().CombineMask (external.destination.mask);
+      graph.externals.push_back (external);
+    }
+  NS_LOG_LOGIC ("SPF graph of " << n << " vertices and " << graph.edges.size () << " links");
+}
+
+void
+GlobalRouteManagerImpl::GetSpfJobs (SpfGraph const &graph, std::vector<SpfJob> &jobs) const
+{
+  NS_LOG_FUNCTION (this);
+  jobs.clear ();
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      Ptr<Node> node = *i;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      // Ignore nodes that are not assigned to our systemId (distributed sim)
+      if (node->GetSystemId () != systemId || rtr == 0 || rtr->GetNumLSAs () == 0)
+        {
+          continue;
+        }
+      std::map<Ipv4Address, uint32_t>::const_iterator root = graph.indexes.find (rtr->GetRouterId ());
+      NS_ASSERT_MSG (root != graph.indexes.end (), "No LSA for router " << rtr->GetRouterId ());
+      SpfJob job;
+      job.root = root->second;
+      job.routing = rtr->GetRoutingProtocol ();
+      job.state = 0;
+      job.replace = false;
+      jobs.push_back (job);
+    }
+}
+
+bool
+GlobalRouteManagerImpl::SameSpfVertex (SpfGraph const &a, SpfGraph const &b, uint32_t v)
+{
+  return a.types[v] == b.types[v]
+         && a.stubRouters[v] == b.stubRouters[v]
+         && a.defaultRoutes[v] == b.defaultRoutes[v]
+         && SameRange (a.edges, a.edgeOffsets[v], a.edgeOffsets[v + 1],
+                       b.edges, b.edgeOffsets[v], b.edgeOffsets[v + 1])
+         && SameRange (a.destinations, a.destinationOffsets[v], a.destinationOffsets[v + 1],
+                       b.destinations, b.destinationOffsets[v], b.destinationOffsets[v + 1])
+         && SameRange (a.stubs, a.stubOffsets[v], a.stubOffsets[v + 1],
+                       b.stubs, b.stubOffsets[v], b.stubOffsets[v + 1]);
+}
+
+void
+GlobalRouteManagerImpl::RunSpfJobs (SpfGraph const &graph, SpfGraph const *previous,
+                                    std::vector<uint32_t> const &changed, std::vector<SpfJob> &jobs)
+{
+  NS_LOG_FUNCTION (this << previous << changed.size () << jobs.size ());
+  UintegerValue threadCount;
+  g_globalRoutingThreadCount.GetValue (threadCount);
+  uint32_t threads = threadCount.Get ();
+#ifdef HAVE_PTHREAD_H
+  if (threads == 0)
+    {
+      long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+      threads = cpus > 0 ? cpus : 1;
+    }
+#else
+  threads = 1;
+#endif
+//
+// The jobs run in batches, so that the routes waiting to be installed
+// never take much more memory than the routing tables of a few routers.
+//
+  uint32_t batchSize = 64 * threads;
+  for (uint32_t begin = 0; begin < jobs.size (); begin += batchSize)
+    {
+      uint32_t end = std::min<uint32_t> (begin + batchSize, jobs.size ());
+      uint32_t workers = std::min<uint32_t> (threads, end - begin);
+      std::vector<SpfBatch> batches (workers);
+      for (uint32_t i = 0; i < workers; i++)
+        {
+          batches[i].graph = &graph;
+          batches[i].previous = previous;
+          batches[i].changed = &changed;
+          batches[i].jobs = &jobs;
+          batches[i].first = begin + i;
+          batches[i].end = end;
+          batches[i].stride = workers;
+        }
+#ifdef HAVE_PTHREAD_H
+      std::vector<Ptr<SystemThread> > running;
+      for (uint32_t i = 1; i < workers; i++)
+        {
+          Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (&GlobalRouteManagerImpl::RunSpfBatch, &batches[i]));
+          thread->Start ();
+          running.push_back (thread);
+        }
+#endif /* HAVE_PTHREAD_H */
+      RunSpfBatch (&batches[0]);
+#ifdef HAVE_PTHREAD_H
+      for (std::vector<Ptr<SystemThread> >::iterator i = running.begin (); i != running.end (); i++)
+        {
+          (*i)->Join ();
+        }
+#endif /* HAVE_PTHREAD_H */
+
+      for (uint32_t i = begin; i < end; i++)
+        {
+          SpfJob &job = jobs[i];
+          Ptr<Ipv4GlobalRouting> gr = job.routing;
+          if (job.replace)
+            {
+              uint32_t nRoutes = gr->GetNRoutes ();
+              for (uint32_t j = 0; j < nRoutes; j++)
+                {
+                  gr->RemoveRoute (0);
+                }
+            }
+          for (std::vector<SpfRoute>::const_iterator j = job.removed.begin (); j != job.removed.end (); j++)
+            {
+              switch (j->type)
+                {
+                case SPF_HOST_ROUTE:
+                  gr->RemoveHostRouteTo (j->network, j->nextHop, j->interface);
+                  break;
+                case SPF_NETWORK_ROUTE:
+                  gr->RemoveNetworkRouteTo (j->network, j->mask, j->nextHop, j->interface);
+                  break;
+                default:
+                  gr->RemoveASExternalRouteTo (j->network, j->mask, j->nextHop, j->interface);
+                  break;
+                }
+            }
+          for (std::vector<SpfRoute>::const_iterator j = job.routes.begin (); j != job.routes.end (); j++)
+            {
+              switch (j->type)
+                {
+                case SPF_HOST_ROUTE:
+                  gr->AddHostRouteTo (j->network, j->nextHop, j->interface);
+                  break;
+                case SPF_NETWORK_ROUTE:
+                  gr->AddNetworkRouteTo (j->network, j->mask, j->nextHop, j->interface);
+                  break;
+                default:
+                  gr->AddASExternalRouteTo (j->network, j->mask, j->nextHop, j->interface);
+                  break;
+                }
+            }
+          NS_LOG_LOGIC ("Router " << graph.ids[job.root] << (job.replace ? " replaced its routes, " : " ")
+                                  << "removed " << job.removed.size () << " and added " << job.routes.size () << " routes");
+          std::vector<SpfRoute> ().swap (job.removed);
+          std::vector<SpfRoute> ().swap (job.routes);
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::RunSpfBatch (SpfBatch *batch)
+{
+  for (uint32_t i = batch->first; i < batch->end; i += batch->stride)
+    {
+      SpfJob &job = (*batch->jobs)[i];
+      if (batch->previous != 0 && !job.replace)
+        {
+          SpfUpdate (*batch->graph, *batch->previous, *batch->changed, job);
+        }
+      else
+        {
+          SpfCalculate (*batch->graph, job.root, job.routes, job.state);
+        }
+    }
+}
+
+//
+// This is SPFCalculate () on the graph, without the SPFVertex objects, the
+// lookups in the LSDB and the nodes: the candidate queue is a binary heap,
+// the vertices are indexes in arrays, and the vertices which inherit the
+// exits of their parent share them.  The candidates, the exits and the
+// routes are handled in the same order, so that the routes are the same
+// and installed in the same order.
+//
+void
+GlobalRouteManagerImpl::SpfCalculate (SpfGraph const &graph, uint32_t root,
+                                      std::vector<SpfRoute> &routes, SpfState *state)
+{
+  routes.clear ();
+  if (state != 0)
+    {
+      state->distances.clear ();
+      state->exitOffsets.clear ();
+      state->exits.clear ();
+    }
+  if (graph.stubRouters[root] == SPF_STUB_NO_ROUTE)
+    {
+      return;
+    }
+  if (graph.stubRouters[root] == SPF_STUB_DEFAULT_ROUTE)
+    {
+      SpfRoute route;
+      route.type = SPF_NETWORK_ROUTE;
+      route.network = Ipv4Address ((uint32_t)0);
+      route.mask = Ipv4Mask ((uint32_t)0);
+      route.nextHop = graph.defaultRoutes[root].first;
+      route.interface = graph.defaultRoutes[root].second;
+      routes.push_back (route);
+      return;
+    }
+
+  const uint32_t none = SPF_INFINITY;
+  uint32_t n = graph.ids.size ();
+  std::vector<uint32_t> distances (n, SPF_INFINITY);
+  std::vector<uint8_t> status (n, GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED);
+  std::vector<uint32_t> orders (n, 0);
+  std::vector<uint32_t> exitSets (n, 0);
+  SpfExitSets sets;
+  // the parents of each vertex, as linked lists of (parent, next)
+  std::vector<uint32_t> parents (n, none);
+  std::vector<std::pair<uint32_t, uint32_t> > parentLinks;
+  std::vector<SpfCandidate> candidates;
+  std::vector<uint32_t> tree;
+  uint32_t order = 0;
+
+  distances[root] = 0;
+  status[root] = GlobalRoutingLSA::LSA_SPF_IN_SPFTREE;
+  uint32_t v = root;
+  for (;;)
+    {
+//
+// RFC2328 16.1. (2): examine the links of v, as SPFNext ().
+//
+      bool vIsNetwork = graph.types[v] == SPFVertex::VertexNetwork;
+      bool vParentIsRoot = false;
+      for (uint32_t p = parents[v]; p != none; p = parentLinks[p].second)
+        {
+          vParentIsRoot = vParentIsRoot || parentLinks[p].first == root;
+        }
+      for (uint32_t e = graph.edgeOffsets[v]; e < graph.edgeOffsets[v + 1]; e++)
+        {
+          SpfEdge const &edge = graph.edges[e];
+          uint32_t w = edge.to;
+          if (status[w] == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE)
+            {
+              continue;
+            }
+          uint32_t distance = distances[v] + edge.cost;
+//
+// The exits from the root to w through v, as SPFNexthopCalculation ();
+// none when it leaves them unchanged.
+//
+          uint32_t exits = none;
+          if (v == root)
+            {
+              NS_ASSERT_MSG (edge.hasNextHop, "No link back from " << graph.ids[w] << " to " << graph.ids[v]);
+              exits = sets.Single (SpfExit (edge.nextHop, edge.outIf));
+            }
+          else if (vIsNetwork)
+            {
+              if (sets.Size (exitSets[v]) != 0 && (!vParentIsRoot || edge.hasNextHop))
+                {
+                  SpfExit exit = *sets.Begin (exitSets[v]);
+                  if (vParentIsRoot)
+                    {
+                      exit.first = edge.nextHop;
+                    }
+                  exits = sets.Single (exit);
+                }
+            }
+          else
+            {
+              exits = exitSets[v];
+            }
+
+          if (status[w] == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED
+              || distance < distances[w])
+            {
+              if (status[w] == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
+                {
+                  exitSets[w] = exits != none ? exits : 0;
+                }
+              else if (exits != none)
+                {
+                  exitSets[w] = exits;
+                }
+              distances[w] = distance;
+              status[w] = GlobalRoutingLSA::LSA_SPF_CANDIDATE;
+              parentLinks.push_back (std::make_pair (v, none));
+              parents[w] = parentLinks.size () - 1;
+              orders[w] = order++;
+              SpfCandidate candidate;
+              candidate.distance = distance;
+              candidate.router = graph.types[w] == SPFVertex::VertexNetwork ? 0 : 1;
+              candidate.order = orders[w];
+              candidate.vertex = w;
+              candidates.push_back (candidate);
+              std::push_heap (candidates.begin (), candidates.end (), &SpfCandidateAfter);
+            }
+          else if (distance == distances[w])
+            {
+              // equal cost multiple paths: merge the exits and the parents
+              exitSets[w] = sets.Merge (exitSets[w], exits != none ? exits : 0);
+              bool found = false;
+              for (uint32_t p = parents[w]; p != none; p = parentLinks[p].second)
+                {
+                  found = found || parentLinks[p].first == v;
+                }
+              if (!found)
+                {
+                  parentLinks.push_back (std::make_pair (v, parents[w]));
+                  parents[w] = parentLinks.size () - 1;
+                }
+            }
+        }
+//
+// RFC2328 16.1. (3): move the closest candidate to the tree, skipping the
+// entries of the vertices which got a shorter path since they were pushed.
+//
+      bool found = false;
+      while (!candidates.empty ())
+        {
+          std::pop_heap (candidates.begin (), candidates.end (), &SpfCandidateAfter);
+          SpfCandidate candidate = candidates.back ();
+          candidates.pop_back ();
+          if (status[candidate.vertex] == GlobalRoutingLSA::LSA_SPF_CANDIDATE
+              && orders[candidate.vertex] == candidate.order)
+            {
+              v = candidate.vertex;
+              found = true;
+              break;
+            }
+        }
+      if (!found)
+        {
+          break;
+        }
+      status[v] = GlobalRoutingLSA::LSA_SPF_IN_SPFTREE;
+      tree.push_back (v);
+//
+// RFC2328 16.1. (4): add the routes to v, as SPFIntraAddRouter () and
+// SPFIntraAddTransit ().
+//
+      uint8_t type = graph.types[v] == SPFVertex::VertexRouter ? SPF_HOST_ROUTE : SPF_NETWORK_ROUTE;
+      for (uint32_t d = graph.destinationOffsets[v]; d < graph.destinationOffsets[v + 1]; d++)
+        {
+          AddSpfRoutes (routes, type, graph.destinations[d].network, graph.destinations[d].mask,
+                        sets.Begin (exitSets[v]), sets.End (exitSets[v]));
+        }
+    }
+
+//
+// Second stage: the stub networks and the external routes, in the order
+// in which SPFProcessStubs () and ProcessASExternals () walk the tree.  The
+// children of a vertex are the vertices it is a parent of, in the order
+// they entered the tree.
+//
+  std::vector<uint32_t> childOffsets (n + 1, 0);
+  for (std::vector<uint32_t>::const_iterator i = tree.begin (); i != tree.end (); i++)
+    {
+      for (uint32_t p = parents[*i]; p != none; p = parentLinks[p].second)
+        {
+          childOffsets[parentLinks[p].first + 1]++;
+        }
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      childOffsets[i + 1] += childOffsets[i];
+    }
+  std::vector<uint32_t> children (childOffsets[n]);
+  std::vector<uint32_t> childEnds (childOffsets.begin (), childOffsets.end () - 1);
+  for (std::vector<uint32_t>::const_iterator i = tree.begin (); i != tree.end (); i++)
+    {
+      for (uint32_t p = parents[*i]; p != none; p = parentLinks[p].second)
+        {
+          children[childEnds[parentLinks[p].first]++] = *i;
+        }
+    }
+  std::vector<uint32_t> walk;
+  std::vector<bool> processed (n, false);
+  std::vector<std::pair<uint32_t, uint32_t> > stack;
+  walk.push_back (root);
+  stack.push_back (std::make_pair (root, childOffsets[root]));
+  while (!stack.empty ())
+    {
+      std::pair<uint32_t, uint32_t> &top = stack.back ();
+      if (top.second == childOffsets[top.first + 1])
+        {
+          stack.pop_back ();
+          continue;
+        }
+      uint32_t child = children[top.second++];
+      if (!processed[child])
+        {
+          processed[child] = true;
+          walk.push_back (child);
+          stack.push_back (std::make_pair (child, childOffsets[child]));
+        }
+    }
+  for (std::vector<uint32_t>::const_iterator i = walk.begin (); i != walk.end (); i++)
+    {
+      if (*i == root || graph.types[*i] != SPFVertex::VertexRouter)
+        {
+          continue;
+        }
+      for (uint32_t s = graph.stubOffsets[*i]; s < graph.stubOffsets[*i + 1]; s++)
+        {
+          AddSpfRoutes (routes, SPF_NETWORK_ROUTE, graph.stubs[s].network, graph.stubs[s].mask,
+                        sets.Begin (exitSets[*i]), sets.End (exitSets[*i]));
+        }
+    }
+  for (std::vector<SpfExternal>::const_iterator i = graph.externals.begin (); i != graph.externals.end (); i++)
+    {
+      uint32_t router = i->router;
+      if (router != none && router != root && status[router] == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE)
+        {
+          AddSpfRoutes (routes, SPF_EXTERNAL_ROUTE, i->destination.network, i->destination.mask,
+                        sets.Begin (exitSets[router]), sets.End (exitSets[router]));
+        }
+    }
+
+  if (state != 0)
+    {
+      state->distances.swap (distances);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          state->exitOffsets.push_back (state->exits.size ());
+          state->exits.insert (state->exits.end (), sets.Begin (exitSets[i]), sets.End (exitSets[i]));
+        }
+      state->exitOffsets.push_back (state->exits.size ());
+    }
+}
+
+//
+// The shortest paths from the root can only change if a link which was
+// removed or changed was part of them, or if a link which was added or
+// changed gives a path at most as long as the previous ones.  Otherwise,
+// the routes through each vertex keep their exits, and only the routes
+// to the destinations which changed need to be replaced.
+//
+void
+GlobalRouteManagerImpl::SpfUpdate (SpfGraph const &graph, SpfGraph const &previous,
+                                   std::vector<uint32_t> const &changed, SpfJob &job)
+{
+  SpfState &state = *job.state;
+  job.removed.clear ();
+  job.routes.clear ();
+  if (state.distances.empty ())
+    {
+      // a stub router whose own links did not change
+      return;
+    }
+  std::vector<uint32_t> &distances = state.distances;
+  bool affected = false;
+  for (std::vector<uint32_t>::const_iterator i = changed.begin (); i != changed.end () && !affected; i++)
+    {
+      uint32_t x = *i;
+      if (x >= distances.size () || distances[x] == SPF_INFINITY)
+        {
+          continue;
+        }
+      if (graph.types[x] != previous.types[x])
+        {
+          affected = true;
+          break;
+        }
+      std::vector<SpfEdge> removed;
+      MissingFromRange (previous.edges, previous.edgeOffsets[x], previous.edgeOffsets[x + 1],
+                        graph.edges, graph.edgeOffsets[x], graph.edgeOffsets[x + 1], removed);
+      for (std::vector<SpfEdge>::const_iterator e = removed.begin (); e != removed.end (); e++)
+        {
+          if (distances[e->to] != SPF_INFINITY
+              && (uint64_t)distances[x] + e->cost == distances[e->to])
+            {
+              affected = true;
+            }
+        }
+      std::vector<SpfEdge> added;
+      MissingFromRange (graph.edges, graph.edgeOffsets[x], graph.edgeOffsets[x + 1],
+                        previous.edges, previous.edgeOffsets[x], previous.edgeOffsets[x + 1], added);
+      for (std::vector<SpfEdge>::const_iterator e = added.begin (); e != added.end (); e++)
+        {
+          uint64_t distance = e->to < distances.size () ? distances[e->to] : SPF_INFINITY;
+          if ((uint64_t)distances[x] + e->cost <= distance)
+            {
+              affected = true;
+            }
+        }
+    }
+  if (affected)
+    {
+      job.replace = true;
+      SpfCalculate (graph, job.root, job.routes, job.state);
+      return;
+    }
+
+  for (std::vector<uint32_t>::const_iterator i = changed.begin (); i != changed.end (); i++)
+    {
+      uint32_t x = *i;
+      if (x >= distances.size () || distances[x] == SPF_INFINITY || x == job.root)
+        {
+          continue;
+        }
+      SpfExit const *begin = state.exits.empty () ? 0 : &state.exits[0] + state.exitOffsets[x];
+      SpfExit const *end = state.exits.empty () ? 0 : &state.exits[0] + state.exitOffsets[x + 1];
+      uint8_t type = graph.types[x] == SPFVertex::VertexRouter ? SPF_HOST_ROUTE : SPF_NETWORK_ROUTE;
+      std::vector<SpfDestination> removed;
+      std::vector<SpfDestination> added;
+      MissingFromRange (previous.destinations, previous.destinationOffsets[x], previous.destinationOffsets[x + 1],
+                        graph.destinations, graph.destinationOffsets[x], graph.destinationOffsets[x + 1], removed);
+      MissingFromRange (graph.destinations, graph.destinationOffsets[x], graph.destinationOffsets[x + 1],
+                        previous.destinations, previous.destinationOffsets[x], previous.destinationOffsets[x + 1], added);
+      for (std::vector<SpfDestination>::const_iterator d = removed.begin (); d != removed.end (); d++)
+        {
+          AddSpfRoutes (job.removed, type, d->network, d->mask, begin, end);
+        }
+      for (std::vector<SpfDestination>::const_iterator d = added.begin (); d != added.end (); d++)
+        {
+          AddSpfRoutes (job.routes, type, d->network, d->mask, begin, end);
+        }
+      if (type != SPF_HOST_ROUTE)
+        {
+          continue;
+        }
+      removed.clear ();
+      added.clear ();
+      MissingFromRange (previous.stubs, previous.stubOffsets[x], previous.stubOffsets[x + 1],
+                        graph.stubs, graph.stubOffsets[x], graph.stubOffsets[x + 1], removed);
+      MissingFromRange (graph.stubs, graph.stubOffsets[x], graph.stubOffsets[x + 1],
+                        previous.stubs, previous.stubOffsets[x], previous.stubOffsets[x + 1], added);
+      for (std::vector<SpfDestination>::const_iterator d = removed.begin (); d != removed.end (); d++)
+        {
+          AddSpfRoutes (job.removed, SPF_NETWORK_ROUTE, d->network, d->mask, begin, end);
+        }
+      for (std::vector<SpfDestination>::const_iterator d = added.begin (); d != added.end (); d++)
+        {
+          AddSpfRoutes (job.routes, SPF_NETWORK_ROUTE, d->network, d->mask, begin, end);
+        }
+    }
+  // the new vertices are out of the tree
+  distances.resize (graph.ids.size (), SPF_INFINITY);
+  state.exitOffsets.resize (graph.ids.size () + 1, state.exits.size ());
+}
+
 } // namespace ns3
 
 
@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
 #include "global-router-interface.h"
+#include "ipv4-global-routing.h"
 
 namespace ns3 {
 
@@ -639,6 +640,14 @@ public:
  */
   GlobalRoutingLSA* GetLSAByLinkData (Ipv4Address addr) const;
 
+/**
+ * @brief Get all the Link State Advertisements, other than the external ones.
+ *
+ * @param lsas cleared, then filled with the Link State Advertisements in the
+ * order of their link state ID.
+ */
+  void GetLSAs (std::vector<GlobalRoutingLSA*> &lsas) const;
+
 /**
  * @brief Set all LSA flags to an initialized state, for SPF computation
  *
@@ -733,6 +742,22 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the Link State DataBase and update the per-node forwarding
+ * tables which depend on the Link State Advertisements that changed since
+ * the previous call
+ *
+ * The first call deletes the global routes and computes them all, as
+ * InitializeRoutes does, but it also keeps the distances and exits that
+ * the SPF calculation of each router found.  The following calls compare
+ * the new database with the previous one.  A router whose shortest paths
+ * may go through a link which changed is computed again.  The others
+ * only replace their routes to the destinations advertised by the
+ * routers and networks which changed; these routes then come after the
+ * other routes in their forwarding tables.
+ */
+  virtual void UpdateRoutes ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -944,6 +969,235 @@ private:
    */
   int32_t FindOutgoingInterfaceId (Ipv4Address a, 
                                    Ipv4Mask amask = Ipv4Mask ("255.255.255.255"));
+
+  /**
+   * \brief A link of the SPF graph, as seen from the vertex it leaves
+   */
+  struct SpfEdge
+  {
+    uint32_t to;         //!< the index of the vertex the link leads to
+    uint32_t cost;       //!< the metric of the link, zero from a network
+    int32_t outIf;       //!< from a router, its interface to the link
+    Ipv4Address nextHop; //!< the next hop, if the link leaves the root or a network of the root
+    bool hasNextHop;     //!< whether the next hop was found
+    /**
+     * \param o the other link
+     * \returns true if both links are the same
+     */
+    bool operator== (SpfEdge const &o) const;
+  };
+
+  /**
+   * \brief A destination advertised by a vertex of the SPF graph
+   */
+  struct SpfDestination
+  {
+    Ipv4Address network; //!< the network, or the host
+    Ipv4Mask mask;       //!< the network mask
+    /**
+     * \param o the other destination
+     * \returns true if both destinations are the same
+     */
+    bool operator== (SpfDestination const &o) const;
+  };
+
+  /**
+   * \brief An external destination, advertised by a router
+   */
+  struct SpfExternal
+  {
+    uint32_t router;            //!< the index of the router, SPF_INFINITY if unknown
+    SpfDestination destination; //!< the destination
+    /**
+     * \param o the other destination
+     * \returns true if both destinations are the same
+     */
+    bool operator== (SpfExternal const &o) const;
+  };
+
+  /// How a stub router is routed, see CheckForStubNode
+  enum SpfStubRouter
+  {
+    SPF_NOT_STUB = 0,      //!< not a stub router, run the SPF calculation
+    SPF_STUB_NO_ROUTE,     //!< a router without transit links
+    SPF_STUB_DEFAULT_ROUTE //!< a router with a single point-to-point link
+  };
+
+  /**
+   * \brief The Link State DataBase as a compact graph
+   *
+   * The vertices are the router and network LSAs.  The links leaving a
+   * vertex, the destinations it advertises and its stub networks are
+   * stored contiguously, from the offset of the vertex to the offset of
+   * the next one (compressed sparse rows).  Everything the SPF calculation
+   * needs is resolved when the graph is built, including the next hops and
+   * the interfaces of the links, so that the SPF calculations of several
+   * roots can run in parallel without touching the LSAs or the nodes.
+   *
+   * A vertex keeps its index as long as the graph is rebuilt from the
+   * previous one; the vertices whose LSA disappeared are left without
+   * links.
+   */
+  struct SpfGraph
+  {
+    std::vector<Ipv4Address> ids;   //!< the link state ID of each vertex
+    std::vector<uint8_t> types;     //!< the SPFVertex::VertexType of each vertex, VertexUnknown if removed
+    std::vector<uint32_t> edgeOffsets; //!< the first link of each vertex, then the number of links
+    std::vector<SpfEdge> edges;     //!< the links of the vertices
+    std::vector<uint32_t> destinationOffsets; //!< the first destination of each vertex, then the number of destinations
+    std::vector<SpfDestination> destinations; //!< the point-to-point addresses of the routers and the networks
+    std::vector<uint32_t> stubOffsets; //!< the first stub network of each vertex, then the number of stub networks
+    std::vector<SpfDestination> stubs; //!< the stub networks of the routers
+    std::vector<uint8_t> stubRouters;  //!< the SpfStubRouter kind of each vertex
+    std::vector<SPFVertex::NodeExit_t> defaultRoutes; //!< the default route of each SPF_STUB_DEFAULT_ROUTE router
+    std::vector<SpfExternal> externals; //!< the external destinations
+    std::map<Ipv4Address, uint32_t> indexes; //!< the index of each link state ID
+  };
+
+  /// The kind of a route found by the SPF calculation
+  enum SpfRouteType
+  {
+    SPF_HOST_ROUTE,    //!< Ipv4GlobalRouting::AddHostRouteTo
+    SPF_NETWORK_ROUTE, //!< Ipv4GlobalRouting::AddNetworkRouteTo
+    SPF_EXTERNAL_ROUTE //!< Ipv4GlobalRouting::AddASExternalRouteTo
+  };
+
+  /**
+   * \brief A route found by the SPF calculation of a root
+   */
+  struct SpfRoute
+  {
+    uint8_t type;        //!< the SpfRouteType of the route
+    Ipv4Address network; //!< the destination
+    Ipv4Mask mask;       //!< the network mask of the destination
+    Ipv4Address nextHop; //!< the next hop
+    uint32_t interface;  //!< the outgoing interface
+  };
+
+  /**
+   * \brief What the SPF calculation of a root found, kept by UpdateRoutes
+   */
+  struct SpfState
+  {
+    Ptr<Ipv4GlobalRouting> routing;   //!< the routing protocol of the root
+    std::vector<uint32_t> distances;  //!< the distance of each vertex, SPF_INFINITY out of the tree; empty for a stub router
+    std::vector<uint32_t> exitOffsets; //!< the first exit of each vertex, then the number of exits
+    std::vector<SPFVertex::NodeExit_t> exits; //!< the exits from the root towards each vertex
+  };
+
+  /**
+   * \brief The SPF calculation of a root, as run by the worker threads
+   */
+  struct SpfJob
+  {
+    uint32_t root;   //!< the index of the root vertex
+    Ptr<Ipv4GlobalRouting> routing; //!< the routing protocol of the root, only used by the main thread
+    SpfState *state; //!< where to keep the distances and exits, or 0
+    bool replace;    //!< whether all the routes of the root are computed again
+    std::vector<SpfRoute> removed; //!< the routes to remove, when not replaced
+    std::vector<SpfRoute> routes;  //!< the routes to add
+  };
+
+  /**
+   * \brief The jobs a worker thread runs
+   */
+  struct SpfBatch
+  {
+    SpfGraph const *graph;    //!< the graph
+    SpfGraph const *previous; //!< the graph of the previous update, or 0
+    std::vector<uint32_t> const *changed; //!< the vertices which changed since the previous update
+    std::vector<SpfJob> *jobs; //!< the jobs
+    uint32_t first;           //!< the first job of the worker
+    uint32_t end;             //!< the end of the jobs of the worker
+    uint32_t stride;          //!< the distance between the jobs of the worker
+  };
+
+  /**
+   * \brief Build the SPF graph of the Link State DataBase
+   * \param graph the graph to fill
+   * \param previous the graph whose vertex indexes are kept, or 0
+   */
+  void BuildSpfGraph (SpfGraph &graph, SpfGraph const *previous) const;
+
+  /**
+   * \brief Find the routers whose routes this system computes
+   * \param graph the graph
+   * \param jobs filled with a job for each router, without state
+   */
+  void GetSpfJobs (SpfGraph const &graph, std::vector<SpfJob> &jobs) const;
+
+  /**
+   * \brief Compare a vertex of two graphs
+   * \param a a graph
+   * \param b a graph, with the same vertex indexes as the first one
+   * \param v the index of the vertex, which must exist in both graphs
+   * \returns true if the vertex has the same type, links, destinations
+   * and stub networks in both graphs
+   */
+  static bool SameSpfVertex (SpfGraph const &a, SpfGraph const &b, uint32_t v);
+
+  /**
+   * \brief Run the SPF calculation of the jobs on the worker threads
+   * and install their routes
+   *
+   * \param graph the graph
+   * \param previous the graph of the previous update, or 0
+   * \param changed the vertices which changed since the previous update
+   * \param jobs the jobs, in the order in which their routes are installed
+   */
+  void RunSpfJobs (SpfGraph const &graph, SpfGraph const *previous,
+                   std::vector<uint32_t> const &changed, std::vector<SpfJob> &jobs);
+
+  /**
+   * \brief Run the jobs of a worker thread
+   * \param batch the jobs
+   */
+  static void RunSpfBatch (SpfBatch *batch);
+
+  /**
+   * \brief Find the routes of a root, as SPFCalculate would install them
+   *
+   * This method only reads the graph, so that it can run in parallel.
+   *
+   * \param graph the graph
+   * \param root the index of the root vertex
+   * \param routes filled with the routes, in the order of SPFCalculate
+   * \param state where to keep the distances and exits, or 0
+   */
+  static void SpfCalculate (SpfGraph const &graph, uint32_t root,
+                            std::vector<SpfRoute> &routes, SpfState *state);
+
+  /**
+   * \brief Find how the routes of a root change since the previous update
+   *
+   * If a changed link may be part of the shortest paths from the root,
+   * the job is replaced by a new SPF calculation.  Otherwise, the routes
+   * to the destinations which changed are removed and added again with
+   * the exits kept in the state.
+   *
+   * \param graph the graph
+   * \param previous the graph of the previous update
+   * \param changed the vertices which changed since the previous update
+   * \param job the job
+   */
+  static void SpfUpdate (SpfGraph const &graph, SpfGraph const &previous,
+                         std::vector<uint32_t> const &changed, SpfJob &job);
+  /**
+   * \brief Append the routes to a destination through each exit with a
+   * valid interface
+   * \param routes the routes
+   * \param type the SpfRouteType of the routes
+   * \param network the destination network
+   * \param mask the destination mask
+   * \param begin the first exit
+   * \param end past the last exit
+   */
+  static void AddSpfRoutes (std::vector<SpfRoute> &routes, uint8_t type,
+                            Ipv4Address network, Ipv4Mask mask,
+                            SPFVertex::NodeExit_t const *begin, SPFVertex::NodeExit_t const *end);
+
+  SpfGraph m_spfGraph; //!< the graph of the last update
+  std::map<uint32_t, SpfState> m_spfStates; //!< the result of the last update, by root
 };
 
 } // namespace ns3
@@ -62,6 +62,18 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Update the routes of the per-node forwarding tables after some
+ * links changed.
+ *
+ * The routing database is built again, and only the routers whose
+ * shortest paths may have changed compute them again; the others only
+ * update the routes to the networks which changed.  The first call
+ * computes all the routes, as DeleteGlobalRoutes (),
+ * BuildGlobalRoutingDatabase () and InitializeRoutes ().
+ */
+  static void UpdateRoutes ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
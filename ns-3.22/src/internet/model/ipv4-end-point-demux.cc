@@ -21,13 +21,14 @@
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ns3/log.h"
+#include <algorithm>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152), m_order (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -41,35 +42,115 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_tuples.clear ();
+  m_positions.clear ();
 }
 
 bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPointDemux::Key::operator< (Key const &o) const
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (localPort != o.localPort)
     {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
+      return localPort < o.localPort;
+    }
+  if (localAddress != o.localAddress)
+    {
+      return localAddress < o.localAddress;
+    }
+  if (peerPort != o.peerPort)
+    {
+      return peerPort < o.peerPort;
+    }
+  if (peerAddress != o.peerAddress)
+    {
+      return peerAddress < o.peerAddress;
+    }
+  return order < o.order;
+}
+
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Position position;
+  position.order = m_order++;
+  position.i = m_endPoints.insert (m_endPoints.end (), endPoint);
+  m_positions[endPoint] = position;
+  Key key;
+  key.localPort = endPoint->GetLocalPort ();
+  key.localAddress = endPoint->GetLocalAddress ();
+  key.peerPort = endPoint->GetPeerPort ();
+  key.peerAddress = endPoint->GetPeerAddress ();
+  key.order = position.order;
+  m_tuples[key] = endPoint;
+  endPoint->m_demux = this;
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+}
+
+void
+Ipv4EndPointDemux::Reindex (Ipv4EndPoint *endPoint, Ipv4Address localAddress, uint16_t localPort,
+                            Ipv4Address peerAddress, uint16_t peerPort)
+{
+  NS_LOG_FUNCTION (this << endPoint << localAddress << localPort << peerAddress << peerPort);
+  Key key;
+  key.localPort = localPort;
+  key.localAddress = localAddress;
+  key.peerPort = peerPort;
+  key.peerAddress = peerAddress;
+  key.order = m_positions[endPoint].order;
+  m_tuples.erase (key);
+  key.localPort = endPoint->GetLocalPort ();
+  key.localAddress = endPoint->GetLocalAddress ();
+  key.peerPort = endPoint->GetPeerPort ();
+  key.peerAddress = endPoint->GetPeerAddress ();
+  m_tuples[key] = endPoint;
+}
+
+void
+Ipv4EndPointDemux::FindTuple (Ipv4Address localAddress, uint16_t localPort,
+                              Ipv4Address peerAddress, uint16_t peerPort,
+                              std::vector<std::pair<uint64_t, Ipv4EndPoint *> > &endPoints) const
+{
+  Key key;
+  key.localPort = localPort;
+  key.localAddress = localAddress;
+  key.peerPort = peerPort;
+  key.peerAddress = peerAddress;
+  key.order = 0;
+  for (std::map<Key, Ipv4EndPoint *>::const_iterator i = m_tuples.lower_bound (key);
+       i != m_tuples.end () && i->first.localPort == localPort && i->first.localAddress == localAddress
+       && i->first.peerPort == peerPort && i->first.peerAddress == peerAddress; i++)
+    {
+      endPoints.push_back (std::make_pair (i->first.order, i->second));
     }
-  return false;
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  Key key;
+  key.localPort = port;
+  key.localAddress = Ipv4Address::GetZero ();
+  key.peerPort = 0;
+  key.peerAddress = Ipv4Address::GetZero ();
+  key.order = 0;
+  std::map<Key, Ipv4EndPoint *>::const_iterator i = m_tuples.lower_bound (key);
+  return i != m_tuples.end () && i->first.localPort == port;
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
-        {
-          return true;
-        }
-    }
-  return false;
+  Key key;
+  key.localPort = port;
+  key.localAddress = addr;
+  key.peerPort = 0;
+  key.peerAddress = Ipv4Address::GetZero ();
+  key.order = 0;
+  std::map<Key, Ipv4EndPoint *>::const_iterator i = m_tuples.lower_bound (key);
+  return i != m_tuples.end () && i->first.localPort == port && i->first.localAddress == addr;
 }
 
 Ipv4EndPoint *
@@ -83,8 +164,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -99,8 +179,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -122,8 +201,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -132,23 +210,17 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::vector<std::pair<uint64_t, Ipv4EndPoint *> > found;
+  FindTuple (localAddress, localPort, peerAddress, peerPort, found);
+  if (!found.empty ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
 
   return endPoint;
 }
@@ -157,15 +229,22 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::map<Ipv4EndPoint *, Position>::iterator position = m_positions.find (endPoint);
+  if (position == m_positions.end ())
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
     }
+  Key key;
+  key.localPort = endPoint->GetLocalPort ();
+  key.localAddress = endPoint->GetLocalAddress ();
+  key.peerPort = endPoint->GetPeerPort ();
+  key.peerAddress = endPoint->GetPeerAddress ();
+  key.order = position->second.order;
+  m_tuples.erase (key);
+  m_endPoints.erase (position->second.i);
+  m_positions.erase (position);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -204,9 +283,40 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (!LookupPortLocal (dport))
     {
-      Ipv4EndPoint* endP = *i;
+      return retval1;
+    }
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+    {
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+        {
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
+        }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+
+  // Only the endpoints whose local address is the destination or the
+  // wildcard, and whose peer is the source or the wildcard, can end up in
+  // one of the lists; look at them in the order they were allocated.
+  std::vector<std::pair<uint64_t, Ipv4EndPoint *> > candidates;
+  FindTuple (incomingInterfaceAddr, dport, saddr, sport, candidates);
+  FindTuple (Ipv4Address::GetAny (), dport, saddr, sport, candidates);
+  FindTuple (incomingInterfaceAddr, dport, Ipv4Address::GetAny (), 0, candidates);
+  FindTuple (Ipv4Address::GetAny (), dport, Ipv4Address::GetAny (), 0, candidates);
+  std::sort (candidates.begin (), candidates.end ());
+  candidates.erase (std::unique (candidates.begin (), candidates.end ()), candidates.end ());
+
+  for (std::vector<std::pair<uint64_t, Ipv4EndPoint *> >::const_iterator i = candidates.begin ();
+       i != candidates.end (); i++)
+    {
+      Ipv4EndPoint* endP = i->second;
       NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
                                                  << " daddr=" << endP->GetLocalAddress ()
                                                  << " sport=" << endP->GetPeerPort ()
@@ -230,20 +340,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
               continue;
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
-        }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
       bool localAddressMatchesWildCard = 
         endP->GetLocalAddress () == Ipv4Address::GetAny ();
       bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
@@ -317,34 +413,40 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
+  std::vector<std::pair<uint64_t, Ipv4EndPoint *> > exact;
+  FindTuple (daddr, dport, saddr, sport, exact);
+  if (!exact.empty ())
+    {
+      /* this is an exact match. */
+      return exact.front ().second;
+    }
   uint32_t genericity = 3;
+  uint64_t genericOrder = 0;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  Key key;
+  key.localPort = dport;
+  key.localAddress = Ipv4Address::GetZero ();
+  key.peerPort = 0;
+  key.peerAddress = Ipv4Address::GetZero ();
+  key.order = 0;
+  for (std::map<Key, Ipv4EndPoint *>::const_iterator i = m_tuples.lower_bound (key);
+       i != m_tuples.end () && i->first.localPort == dport; i++)
     {
-      if ((*i)->GetLocalPort () != dport) 
-        {
-          continue;
-        }
-      if ((*i)->GetLocalAddress () == daddr &&
-          (*i)->GetPeerPort () == sport &&
-          (*i)->GetPeerAddress () == saddr) 
-        {
-          /* this is an exact match. */
-          return *i;
-        }
       uint32_t tmp = 0;
-      if ((*i)->GetLocalAddress () == Ipv4Address::GetAny ()) 
+      if (i->first.localAddress == Ipv4Address::GetAny ()) 
         {
           tmp++;
         }
-      if ((*i)->GetPeerAddress () == Ipv4Address::GetAny ()) 
+      if (i->first.peerAddress == Ipv4Address::GetAny ()) 
         {
           tmp++;
         }
-      if (tmp < genericity) 
+      // the first of the least generic endpoints in allocation order
+      if (tmp < genericity || (tmp == genericity && i->first.order < genericOrder)) 
         {
-          generic = (*i);
+          generic = i->second;
           genericity = tmp;
+          genericOrder = i->first.order;
         }
     }
   return generic;
@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
 
@@ -38,6 +40,10 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are indexed by their four-tuple, so that the lookups only
+ * look at the endpoints whose tuple can match, whatever the number of
+ * endpoints.  The endpoints tell the demux when their tuple changes.
  */
 
 class Ipv4EndPointDemux {
@@ -152,6 +158,63 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief The four-tuple of an endpoint, followed by the order of the
+   * endpoint in m_endPoints
+   */
+  struct Key
+  {
+    uint16_t localPort;       //!< the local port
+    Ipv4Address localAddress; //!< the local address
+    uint16_t peerPort;        //!< the peer port
+    Ipv4Address peerAddress;  //!< the peer address
+    uint64_t order;           //!< the allocation order of the endpoint
+    /**
+     * \param o the other key
+     * \returns true if this key sorts before o
+     */
+    bool operator< (Key const &o) const;
+  };
+
+  /**
+   * \brief The position of an endpoint in m_endPoints.
+   */
+  struct Position
+  {
+    uint64_t order; //!< the allocation order of the endpoint
+    EndPointsI i;   //!< the endpoint in m_endPoints
+  };
+
+  /**
+   * \brief Add a new endpoint to the list and the index.
+   * \param endPoint the endpoint
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Move an endpoint in the index after its tuple changed.
+   * \param endPoint the endpoint
+   * \param localAddress the previous local address
+   * \param localPort the previous local port
+   * \param peerAddress the previous peer address
+   * \param peerPort the previous peer port
+   */
+  void Reindex (Ipv4EndPoint *endPoint, Ipv4Address localAddress, uint16_t localPort,
+                Ipv4Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Append the endpoints of a four-tuple.
+   * \param localAddress local address
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \param endPoints the endpoints found, with their order
+   */
+  void FindTuple (Ipv4Address localAddress, uint16_t localPort,
+                  Ipv4Address peerAddress, uint16_t peerPort,
+                  std::vector<std::pair<uint64_t, Ipv4EndPoint *> > &endPoints) const;
 
   /**
    * \brief Allocate an ephemeral port.
@@ -178,6 +241,21 @@ private:
    * \brief A list of IPv4 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The IPv4 end points, by four-tuple.
+   */
+  std::map<Key, Ipv4EndPoint *> m_tuples;
+
+  /**
+   * \brief The position of each IPv4 end point.
+   */
+  std::map<Ipv4EndPoint *, Position> m_positions;
+
+  /**
+   * \brief The allocation order of the next end point.
+   */
+  uint64_t m_order;
 };
 
 } // namespace ns3
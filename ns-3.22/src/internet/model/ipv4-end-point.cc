@@ -19,6 +19,7 @@
  */
 
 #include "ipv4-end-point.h"
+#include "ipv4-end-point-demux.h"
 #include "ns3/packet.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -31,7 +32,8 @@ Ipv4EndPoint::Ipv4EndPoint (Ipv4Address address, uint16_t port)
   : m_localAddr (address), 
     m_localPort (port),
     m_peerAddr (Ipv4Address::GetAny ()),
-    m_peerPort (0)
+    m_peerPort (0),
+    m_demux (0)
 {
   NS_LOG_FUNCTION (this << address << port);
 }
@@ -58,7 +60,12 @@ void
 Ipv4EndPoint::SetLocalAddress (Ipv4Address address)
 {
   NS_LOG_FUNCTION (this << address);
+  Ipv4Address oldAddress = m_localAddr;
   m_localAddr = address;
+  if (m_demux != 0)
+    {
+      m_demux->Reindex (this, oldAddress, m_localPort, m_peerAddr, m_peerPort);
+    }
 }
 
 uint16_t 
@@ -83,8 +90,14 @@ void
 Ipv4EndPoint::SetPeer (Ipv4Address address, uint16_t port)
 {
   NS_LOG_FUNCTION (this << address << port);
+  Ipv4Address oldAddress = m_peerAddr;
+  uint16_t oldPort = m_peerPort;
   m_peerAddr = address;
   m_peerPort = port;
+  if (m_demux != 0)
+    {
+      m_demux->Reindex (this, m_localAddr, m_localPort, oldAddress, oldPort);
+    }
 }
 
 void
@@ -32,6 +32,7 @@ namespace ns3 {
 
 class Header;
 class Packet;
+class Ipv4EndPointDemux;
 
 /**
  * \brief A representation of an internet endpoint/connection
@@ -169,6 +170,8 @@ public:
                     uint32_t icmpInfo);
 
 private:
+  friend class Ipv4EndPointDemux;
+
   /**
    * \brief ForwardUp wrapper.
    * \param p packet
@@ -229,6 +232,11 @@ private:
    * \brief The destroy callback.
    */
   Callback<void> m_destroyCallback;
+
+  /**
+   * \brief The demux which indexes this end point by its four-tuple (if any).
+   */
+  Ipv4EndPointDemux *m_demux;
 };
 
 } // namespace ns3
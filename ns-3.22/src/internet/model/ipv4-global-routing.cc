@@ -28,6 +28,7 @@
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/boolean.h"
 #include "ipv4-global-routing.h"
+#include <algorithm>
 #include "global-route-manager.h"
 
 namespace ns3 {
@@ -78,6 +79,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_hostRouteTrie.Insert (route);
 }
 
 void 
@@ -88,6 +90,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_hostRouteTrie.Insert (route);
 }
 
 void 
@@ -103,6 +106,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkRouteTrie.Insert (route);
 }
 
 void 
@@ -116,6 +120,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkRouteTrie.Insert (route);
 }
 
 void 
@@ -141,52 +146,17 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
   Ptr<Ipv4Route> rtentry = 0;
   // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
+  typedef std::vector<Ipv4RoutingTableTrie::Route> RouteVec_t;
   RouteVec_t allRoutes;
 
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
-       i++) 
-    {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
-        {
-          if (oif != 0)
-            {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
-            }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
-        }
-    }
+  m_hostRouteTrie.Lookup (dest, m_matches);
+  SelectRoutes (oif, allRoutes);
   if (allRoutes.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
-           j++) 
-        {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
-            {
-              if (oif != 0)
-                {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
-                }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
-            }
-        }
+      m_networkRouteTrie.Lookup (dest, m_matches);
+      SelectRoutes (oif, allRoutes);
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
     {
@@ -207,7 +177,11 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
                       continue;
                     }
                 }
-              allRoutes.push_back (*k);
+              Ipv4RoutingTableTrie::Route route;
+              route.entry = *k;
+              route.metric = 0;
+              route.order = 0;
+              allRoutes.push_back (route);
               break;
             }
         }
@@ -226,7 +200,7 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
         {
           selectIndex = 0;
         }
-      Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex); 
+      Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex).entry;
       // create a Ipv4Route object from the selected routing table entry
       rtentry = Create<Ipv4Route> ();
       rtentry->SetDestination (route->GetDest ());
@@ -243,6 +217,47 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 }
 
+namespace {
+
+bool
+CompareRouteOrder (const Ipv4RoutingTableTrie::Route &a, const Ipv4RoutingTableTrie::Route &b)
+{
+  return a.order < b.order;
+}
+
+} // anonymous namespace
+
+void
+Ipv4GlobalRouting::SelectRoutes (Ptr<NetDevice> oif, std::vector<Ipv4RoutingTableTrie::Route> &routes) const
+{
+  NS_LOG_FUNCTION (this << oif);
+  for (Ipv4RoutingTableTrie::Matches::const_iterator i = m_matches.begin ();
+       i != m_matches.end ();
+       i++)
+    {
+      for (Ipv4RoutingTableTrie::Routes::const_iterator j = i->routes->begin ();
+           j != i->routes->end ();
+           j++)
+        {
+          if (oif != 0)
+            {
+              if (oif != m_ipv4->GetNetDevice (j->entry->GetInterface ()))
+                {
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
+                }
+            }
+          routes.push_back (*j);
+          NS_LOG_LOGIC (routes.size () << "Found global route" << j->entry);
+        }
+    }
+  if (m_matches.size () > 1)
+    {
+      // the routes to several prefixes are used in the order they were added
+      std::sort (routes.begin (), routes.end (), &CompareRouteOrder);
+    }
+}
+
 uint32_t 
 Ipv4GlobalRouting::GetNRoutes (void) const
 {
@@ -317,6 +332,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           if (tmp  == index)
             {
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
+              m_hostRouteTrie.Remove (*i);
               delete *i;
               m_hostRoutes.erase (i);
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
@@ -334,6 +350,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
+          m_networkRouteTrie.Remove (*j);
           delete *j;
           m_networkRoutes.erase (j);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -360,6 +377,60 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
   NS_ASSERT (false);
 }
 
+bool
+Ipv4GlobalRouting::RemoveRouteTo (std::list<Ipv4RoutingTableEntry *> &routes, Ipv4RoutingTableTrie *trie,
+                                  Ipv4Address network, Ipv4Mask networkMask,
+                                  Ipv4Address nextHop, uint32_t interface)
+{
+  for (std::list<Ipv4RoutingTableEntry *>::iterator i = routes.begin (); i != routes.end (); i++)
+    {
+      Ipv4RoutingTableEntry *route = *i;
+      if (route->GetDestNetwork () == network
+          && route->GetDestNetworkMask () == networkMask
+          && route->GetGateway () == nextHop
+          && route->GetInterface () == interface)
+        {
+          if (trie != 0)
+            {
+              trie->Remove (route);
+            }
+          delete route;
+          routes.erase (i);
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+Ipv4GlobalRouting::RemoveHostRouteTo (Ipv4Address dest,
+                                      Ipv4Address nextHop,
+                                      uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << dest << nextHop << interface);
+  return RemoveRouteTo (m_hostRoutes, &m_hostRouteTrie, dest, Ipv4Mask::GetOnes (), nextHop, interface);
+}
+
+bool
+Ipv4GlobalRouting::RemoveNetworkRouteTo (Ipv4Address network,
+                                         Ipv4Mask networkMask,
+                                         Ipv4Address nextHop,
+                                         uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << network << networkMask << nextHop << interface);
+  return RemoveRouteTo (m_networkRoutes, &m_networkRouteTrie, network, networkMask, nextHop, interface);
+}
+
+bool
+Ipv4GlobalRouting::RemoveASExternalRouteTo (Ipv4Address network,
+                                            Ipv4Mask networkMask,
+                                            Ipv4Address nextHop,
+                                            uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << network << networkMask << nextHop << interface);
+  return RemoveRouteTo (m_ASexternalRoutes, 0, network, networkMask, nextHop, interface);
+}
+
 int64_t
 Ipv4GlobalRouting::AssignStreams (int64_t stream)
 {
@@ -390,6 +461,8 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_hostRouteTrie.Clear ();
+  m_networkRouteTrie.Clear ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -27,6 +27,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-routing-table-trie.h"
 #include "ns3/random-variable-stream.h"
 
 namespace ns3 {
@@ -216,6 +217,58 @@ public:
    */
   void RemoveRoute (uint32_t i);
 
+  /**
+   * \brief Remove a host route from the global unicast routing table.
+   *
+   * The first route to the host through the next hop and interface is
+   * removed, if any.  The other routes keep their order.
+   *
+   * \param dest The Ipv4Address of the destination host.
+   * \param nextHop The next hop of the route.
+   * \param interface The network interface index of the route.
+   * \returns true if a route was removed
+   *
+   * \see Ipv4GlobalRouting::AddHostRouteTo
+   */
+  bool RemoveHostRouteTo (Ipv4Address dest,
+                          Ipv4Address nextHop,
+                          uint32_t interface);
+
+  /**
+   * \brief Remove a network route from the global unicast routing table.
+   *
+   * The first route to the network through the next hop and interface is
+   * removed, if any.  The other routes keep their order.
+   *
+   * \param network The Ipv4Address network of the route.
+   * \param networkMask The Ipv4Mask of the network.
+   * \param nextHop The next hop of the route.
+   * \param interface The network interface index of the route.
+   * \returns true if a route was removed
+   *
+   * \see Ipv4GlobalRouting::AddNetworkRouteTo
+   */
+  bool RemoveNetworkRouteTo (Ipv4Address network,
+                             Ipv4Mask networkMask,
+                             Ipv4Address nextHop,
+                             uint32_t interface);
+
+  /**
+   * \brief Remove an external route from the global unicast routing table.
+   *
+   * \param network The Ipv4Address network of the route.
+   * \param networkMask The Ipv4Mask of the network.
+   * \param nextHop The next hop of the route.
+   * \param interface The network interface index of the route.
+   * \returns true if a route was removed
+   *
+   * \see Ipv4GlobalRouting::AddASExternalRouteTo
+   */
+  bool RemoveASExternalRouteTo (Ipv4Address network,
+                                Ipv4Mask networkMask,
+                                Ipv4Address nextHop,
+                                uint32_t interface);
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model.  Return the number of streams (possibly zero) that
@@ -260,8 +313,34 @@ private:
 
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /**
+   * \brief Remove the first route of a list to a network through a next hop
+   * and interface
+   * \param routes the routes
+   * \param trie the prefix index of the routes, if any
+   * \param network the network of the route
+   * \param networkMask the mask of the network
+   * \param nextHop the next hop of the route
+   * \param interface the interface of the route
+   * \returns true if a route was removed
+   */
+  bool RemoveRouteTo (std::list<Ipv4RoutingTableEntry *> &routes, Ipv4RoutingTableTrie *trie,
+                      Ipv4Address network, Ipv4Mask networkMask,
+                      Ipv4Address nextHop, uint32_t interface);
+
+  /**
+   * \brief Append the routes of the prefixes found by the last lookup
+   * which go through an output device, in the order they were added
+   * \param oif output interface if any (put 0 otherwise)
+   * \param routes the routes found
+   */
+  void SelectRoutes (Ptr<NetDevice> oif, std::vector<Ipv4RoutingTableTrie::Route> &routes) const;
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
+  Ipv4RoutingTableTrie m_hostRouteTrie;    //!< Prefix index of m_hostRoutes
+  Ipv4RoutingTableTrie m_networkRouteTrie; //!< Prefix index of m_networkRoutes
+  Ipv4RoutingTableTrie::Matches m_matches; //!< Prefixes found by the last lookup
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
@@ -230,6 +230,7 @@ Ipv4L3Protocol::DoDispose (void)
       *i = 0;
     }
   m_interfaces.clear ();
+  m_reverseInterfacesContainer.clear ();
   m_sockets.clear ();
   m_node = 0;
   m_routingProtocol = 0;
@@ -319,6 +320,8 @@ Ipv4L3Protocol::AddIpv4Interface (Ptr<Ipv4Interface>interface)
   NS_LOG_FUNCTION (this << interface);
   uint32_t index = m_interfaces.size ();
   m_interfaces.push_back (interface);
+  // the first interface of a device is the one which receives its packets
+  m_reverseInterfacesContainer.insert (std::make_pair (interface->GetDevice (), index));
   return index;
 }
 
@@ -390,17 +393,11 @@ Ipv4L3Protocol::GetInterfaceForDevice (
   Ptr<const NetDevice> device) const
 {
   NS_LOG_FUNCTION (this << device);
-  int32_t interface = 0;
-  for (Ipv4InterfaceList::const_iterator i = m_interfaces.begin (); 
-       i != m_interfaces.end (); 
-       i++, interface++)
+  Ipv4InterfaceReverseContainer::const_iterator i = m_reverseInterfacesContainer.find (device);
+  if (i != m_reverseInterfacesContainer.end ())
     {
-      if ((*i)->GetDevice () == device)
-        {
-          return interface;
-        }
+      return i->second;
     }
-
   return -1;
 }
 
@@ -476,31 +473,31 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
   NS_LOG_LOGIC ("Packet from " << from << " received on node " << 
                 m_node->GetId ());
 
-  uint32_t interface = 0;
-  Ptr<Packet> packet = p->Copy ();
+  Ipv4InterfaceReverseContainer::const_iterator found = m_reverseInterfacesContainer.find (device);
+  NS_ASSERT_MSG (found != m_reverseInterfacesContainer.end (), "No interface for device " << device);
+  uint32_t interface = found->second;
+  Ptr<Ipv4Interface> ipv4Interface = m_interfaces[interface];
 
-  Ptr<Ipv4Interface> ipv4Interface;
-  for (Ipv4InterfaceList::const_iterator i = m_interfaces.begin (); 
-       i != m_interfaces.end (); 
-       i++, interface++)
+  if (!ipv4Interface->IsUp ())
     {
-      ipv4Interface = *i;
-      if (ipv4Interface->GetDevice () == device)
+      NS_LOG_LOGIC ("Dropping received packet -- interface is down");
+      if (!m_dropTrace.IsEmpty ())
         {
-          if (ipv4Interface->IsUp ())
-            {
-              m_rxTrace (packet, m_node->GetObject<Ipv4> (), interface);
-              break;
-            }
-          else
-            {
-              NS_LOG_LOGIC ("Dropping received packet -- interface is down");
-              Ipv4Header ipHeader;
-              packet->RemoveHeader (ipHeader);
-              m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, m_node->GetObject<Ipv4> (), interface);
-              return;
-            }
+          Ptr<Packet> packet = p->Copy ();
+          Ipv4Header ipHeader;
+          packet->RemoveHeader (ipHeader);
+          m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, m_node->GetObject<Ipv4> (), interface);
         }
+      return;
+    }
+
+  // The node gives the same packet to all the handlers of the device, so
+  // the header is removed from a copy. The copy shares the buffer of the
+  // packet: removing the header only moves its start.
+  Ptr<Packet> packet = p->Copy ();
+  if (!m_rxTrace.IsEmpty ())
+    {
+      m_rxTrace (packet, m_node->GetObject<Ipv4> (), interface);
     }
 
   Ipv4Header ipHeader;
@@ -821,7 +818,10 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
             }
           else
             {
-              m_txTrace (packet, m_node->GetObject<Ipv4> (), interface);
+              if (!m_txTrace.IsEmpty ())
+                {
+                  m_txTrace (packet, m_node->GetObject<Ipv4> (), interface);
+                }
               outInterface->Send (packet, route->GetGateway ());
             }
         }
@@ -851,7 +851,10 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
             }
           else
             {
-              m_txTrace (packet, m_node->GetObject<Ipv4> (), interface);
+              if (!m_txTrace.IsEmpty ())
+                {
+                  m_txTrace (packet, m_node->GetObject<Ipv4> (), interface);
+                }
               outInterface->Send (packet, ipHeader.GetDestination ());
             }
         }
@@ -0,0 +1,254 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ipv4-routing-table-trie.h"
+#include "ipv4-routing-table-entry.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4RoutingTableTrie");
+
+Ipv4RoutingTableTrie::Ipv4RoutingTableTrie ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+void
+Ipv4RoutingTableTrie::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  struct Node root;
+  std::memset (&root, 0, sizeof (root));
+  m_nodes.assign (1, root);
+  m_freeNodes.clear ();
+  m_routes.assign (1, Routes ());
+  m_freeRoutes.clear ();
+  m_irregular.clear ();
+  m_nRoutes = 0;
+  m_order = 0;
+}
+
+uint32_t
+Ipv4RoutingTableTrie::GetNRoutes (void) const
+{
+  return m_nRoutes;
+}
+
+uint32_t
+Ipv4RoutingTableTrie::AllocateNode (void)
+{
+  struct Node node;
+  std::memset (&node, 0, sizeof (node));
+  if (!m_freeNodes.empty ())
+    {
+      uint32_t index = m_freeNodes.back ();
+      m_freeNodes.pop_back ();
+      m_nodes[index] = node;
+      return index;
+    }
+  m_nodes.push_back (node);
+  return m_nodes.size () - 1;
+}
+
+uint32_t
+Ipv4RoutingTableTrie::FindSlot (uint32_t address, uint16_t length, bool create, std::vector<uint32_t> &path)
+{
+  NS_ASSERT (length <= 32);
+  path.clear ();
+  uint32_t node = 0;
+  path.push_back (node);
+  uint32_t depth = length / 4;
+  for (uint32_t i = 0; i < depth; i++)
+    {
+      uint32_t nibble = (address >> (28 - 4 * i)) & 0xf;
+      uint32_t child = m_nodes[node].children[nibble];
+      if (child == 0)
+        {
+          if (!create)
+            {
+              return 0;
+            }
+          child = AllocateNode ();
+          m_nodes[node].children[nibble] = child;
+        }
+      node = child;
+      path.push_back (node);
+    }
+  uint32_t remainder = length % 4;
+  uint32_t bits = 0;
+  if (remainder != 0)
+    {
+      bits = (address >> (32 - 4 * depth - remainder)) & ((1 << remainder) - 1);
+    }
+  return (1 << remainder) | bits;
+}
+
+void
+Ipv4RoutingTableTrie::Insert (Ipv4RoutingTableEntry *entry, uint32_t metric)
+{
+  NS_LOG_FUNCTION (this << entry << metric);
+  uint32_t mask = entry->GetDestNetworkMask ().Get ();
+  uint32_t address = entry->GetDestNetwork ().Get () & mask;
+  struct Route route;
+  route.entry = entry;
+  route.metric = metric;
+  route.order = m_order++;
+  m_nRoutes++;
+
+  uint32_t inverse = ~mask;
+  if ((inverse & (inverse + 1)) != 0)
+    {
+      NS_LOG_LOGIC ("Non contiguous mask " << entry->GetDestNetworkMask ());
+      m_irregular[std::make_pair (mask, address)].push_back (route);
+      return;
+    }
+  std::vector<uint32_t> path;
+  uint32_t slot = FindSlot (address, entry->GetDestNetworkMask ().GetPrefixLength (), true, path);
+  uint32_t index = m_nodes[path.back ()].prefixes[slot];
+  if (index == 0)
+    {
+      if (!m_freeRoutes.empty ())
+        {
+          index = m_freeRoutes.back ();
+          m_freeRoutes.pop_back ();
+        }
+      else
+        {
+          index = m_routes.size ();
+          m_routes.push_back (Routes ());
+        }
+      m_nodes[path.back ()].prefixes[slot] = index;
+    }
+  m_routes[index].push_back (route);
+}
+
+void
+Ipv4RoutingTableTrie::Remove (Ipv4RoutingTableEntry *entry)
+{
+  NS_LOG_FUNCTION (this << entry);
+  uint32_t mask = entry->GetDestNetworkMask ().Get ();
+  uint32_t address = entry->GetDestNetwork ().Get () & mask;
+
+  Routes *routes;
+  uint32_t inverse = ~mask;
+  IrregularRoutes::iterator irregular = m_irregular.end ();
+  std::vector<uint32_t> path;
+  uint32_t slot = 0;
+  if ((inverse & (inverse + 1)) != 0)
+    {
+      irregular = m_irregular.find (std::make_pair (mask, address));
+      NS_ASSERT_MSG (irregular != m_irregular.end (), "Route " << entry << " not found");
+      routes = &irregular->second;
+    }
+  else
+    {
+      slot = FindSlot (address, entry->GetDestNetworkMask ().GetPrefixLength (), false, path);
+      NS_ASSERT_MSG (slot != 0 && m_nodes[path.back ()].prefixes[slot] != 0, "Route " << entry << " not found");
+      routes = &m_routes[m_nodes[path.back ()].prefixes[slot]];
+    }
+
+  Routes::iterator i;
+  for (i = routes->begin (); i != routes->end (); i++)
+    {
+      if (i->entry == entry)
+        {
+          break;
+        }
+    }
+  NS_ASSERT_MSG (i != routes->end (), "Route " << entry << " not found");
+  routes->erase (i);
+  m_nRoutes--;
+  if (!routes->empty ())
+    {
+      return;
+    }
+
+  if (irregular != m_irregular.end ())
+    {
+      m_irregular.erase (irregular);
+      return;
+    }
+  m_freeRoutes.push_back (m_nodes[path.back ()].prefixes[slot]);
+  m_nodes[path.back ()].prefixes[slot] = 0;
+  // remove the nodes left empty, but never the root
+  for (uint32_t depth = path.size () - 1; depth > 0; depth--)
+    {
+      const struct Node &node = m_nodes[path[depth]];
+      for (uint32_t j = 0; j < 16; j++)
+        {
+          if (node.children[j] != 0 || node.prefixes[j] != 0)
+            {
+              return;
+            }
+        }
+      m_freeNodes.push_back (path[depth]);
+      uint32_t nibble = (address >> (28 - 4 * (depth - 1))) & 0xf;
+      m_nodes[path[depth - 1]].children[nibble] = 0;
+    }
+}
+
+void
+Ipv4RoutingTableTrie::Lookup (Ipv4Address dest, Matches &matches) const
+{
+  NS_LOG_FUNCTION (this << dest);
+  matches.clear ();
+  uint32_t address = dest.Get ();
+  uint32_t node = 0;
+  for (uint32_t depth = 0; depth <= 8; depth++)
+    {
+      const struct Node &current = m_nodes[node];
+      uint32_t nibble = depth < 8 ? (address >> (28 - 4 * depth)) & 0xf : 0;
+      uint32_t maxRemainder = depth < 8 ? 3 : 0;
+      for (uint32_t remainder = 0; remainder <= maxRemainder; remainder++)
+        {
+          uint32_t index = current.prefixes[(1 << remainder) | (nibble >> (4 - remainder))];
+          if (index != 0)
+            {
+              struct Match match;
+              match.prefixLength = 4 * depth + remainder;
+              match.routes = &m_routes[index];
+              matches.push_back (match);
+            }
+        }
+      if (depth == 8)
+        {
+          break;
+        }
+      node = current.children[nibble];
+      if (node == 0)
+        {
+          break;
+        }
+    }
+  for (IrregularRoutes::const_iterator i = m_irregular.begin (); i != m_irregular.end (); i++)
+    {
+      if ((address & i->first.first) == i->first.second)
+        {
+          struct Match match;
+          match.prefixLength = Ipv4Mask (i->first.first).GetPrefixLength ();
+          match.routes = &i->second;
+          matches.push_back (match);
+        }
+    }
+}
+
+} // namespace ns3
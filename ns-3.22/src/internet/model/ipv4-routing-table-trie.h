@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef IPV4_ROUTING_TABLE_TRIE_H
+#define IPV4_ROUTING_TABLE_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include <utility>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Ipv4RoutingTableEntry;
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief Prefix index of the unicast routes of a routing table
+ *
+ * The routes are stored in a multibit trie with a stride of 4 bits.
+ * The node at depth k holds the routes whose prefix length is between
+ * 4k and 4k+3, indexed by the last bits of their prefix, so that a
+ * lookup visits at most 9 nodes whatever the number of routes. The
+ * nodes and the route sets are kept in vectors and refer to each other
+ * by index, which keeps the trie compact. The trie is updated as
+ * routes are added and removed.
+ *
+ * The trie does not own the routes: the routing protocols keep their
+ * own lists, which define the order of GetRoute, and add or remove each
+ * route both in the list and in the trie. Each route is stored with the
+ * metric and the insertion order which the routing protocols use to
+ * choose between the routes which match a destination.
+ *
+ * Routes whose mask is not contiguous are kept aside and tested one
+ * after the other.
+ */
+class Ipv4RoutingTableTrie
+{
+public:
+  /**
+   * \brief A route stored in the trie
+   */
+  struct Route
+  {
+    Ipv4RoutingTableEntry *entry; //!< the route
+    uint32_t metric;              //!< the metric of the route
+    uint64_t order;               //!< the insertion order of the route
+  };
+  /// The routes to a prefix, in insertion order
+  typedef std::vector<struct Route> Routes;
+  /**
+   * \brief The routes to a prefix which matches a destination
+   */
+  struct Match
+  {
+    uint16_t prefixLength; //!< the length of the prefix, as given by Ipv4Mask::GetPrefixLength
+    Routes const *routes;  //!< the routes to the prefix
+  };
+  /// The prefixes which match a destination
+  typedef std::vector<struct Match> Matches;
+
+  Ipv4RoutingTableTrie ();
+
+  /**
+   * \brief Add a route
+   * \param entry the route, whose destination network and mask are used
+   * \param metric the metric of the route
+   */
+  void Insert (Ipv4RoutingTableEntry *entry, uint32_t metric = 0);
+  /**
+   * \brief Remove a route
+   * \param entry the route, which must have been added with Insert
+   */
+  void Remove (Ipv4RoutingTableEntry *entry);
+  /**
+   * \brief Remove all the routes
+   */
+  void Clear (void);
+  /**
+   * \returns the number of routes in the trie
+   */
+  uint32_t GetNRoutes (void) const;
+  /**
+   * \brief Find the prefixes which contain a destination
+   *
+   * The prefixes with a contiguous mask are given from the shortest to
+   * the longest, followed by the others. The Routes they point to are
+   * valid until the trie is modified.
+   *
+   * \param dest the destination address
+   * \param matches cleared, then filled with the matching prefixes
+   */
+  void Lookup (Ipv4Address dest, Matches &matches) const;
+
+private:
+  /// A node of the trie
+  struct Node
+  {
+    /// the index of the child node for each value of the next 4 bits, 0 if none
+    uint32_t children[16];
+    /**
+     * the index of the routes to the prefixes which end in this node, 0
+     * if none: the routes to a prefix with r more bits than the node are
+     * at index (1 << r) | bits
+     */
+    uint32_t prefixes[16];
+  };
+  /// The routes with a non contiguous mask, by mask and masked network
+  typedef std::map<std::pair<uint32_t, uint32_t>, Routes> IrregularRoutes;
+
+  /**
+   * \brief Find the node and slot of a prefix
+   * \param address the masked network of the prefix
+   * \param length the length of the prefix
+   * \param create whether to create the missing nodes
+   * \param path filled with the nodes from the root to the node of the prefix
+   * \returns the slot of the prefix in the node, 0 if a node is missing
+   */
+  uint32_t FindSlot (uint32_t address, uint16_t length, bool create, std::vector<uint32_t> &path);
+  /**
+   * \returns the index of a new empty node
+   */
+  uint32_t AllocateNode (void);
+
+  std::vector<struct Node> m_nodes;  //!< the nodes, the root first
+  std::vector<uint32_t> m_freeNodes; //!< the indexes of the unused nodes
+  std::vector<Routes> m_routes;      //!< the routes of each prefix, the first one is unused
+  std::vector<uint32_t> m_freeRoutes; //!< the indexes of the unused route sets
+  IrregularRoutes m_irregular;       //!< the routes with a non contiguous mask
+  uint32_t m_nRoutes;                //!< the number of routes
+  uint64_t m_order;                  //!< the insertion order of the next route
+};
+
+} // namespace ns3
+
+#endif /* IPV4_ROUTING_TABLE_TRIE_H */
@@ -72,6 +72,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_networkRouteTrie.Insert (route, metric);
 }
 
 void 
@@ -86,6 +87,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_networkRouteTrie.Insert (route, metric);
 }
 
 void 
@@ -143,6 +145,7 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
                                                         networkMask,
                                                         outputInterface);
   m_networkRoutes.push_back (make_pair (route,0));
+  m_networkRouteTrie.Insert (route, 0);
 }
 
 uint32_t 
@@ -239,52 +242,59 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 
 
-  for (NetworkRoutesI i = m_networkRoutes.begin (); 
-       i != m_networkRoutes.end (); 
+  // among the routes which match, keep the longest prefix, then the
+  // smallest metric, then the route added last
+  Ipv4RoutingTableEntry *route = 0;
+  uint64_t order = 0;
+  m_networkRouteTrie.Lookup (dest, m_matches);
+  for (Ipv4RoutingTableTrie::Matches::const_iterator i = m_matches.begin (); 
+       i != m_matches.end (); 
        i++) 
     {
-      Ipv4RoutingTableEntry *j=i->first;
-      uint32_t metric =i->second;
-      Ipv4Mask mask = (j)->GetDestNetworkMask ();
-      uint16_t masklen = mask.GetPrefixLength ();
-      Ipv4Address entry = (j)->GetDestNetwork ();
-      NS_LOG_LOGIC ("Searching for route to " << dest << ", checking against route to " << entry << "/" << masklen);
-      if (mask.IsMatch (dest, entry)) 
+      uint16_t masklen = i->prefixLength;
+      for (Ipv4RoutingTableTrie::Routes::const_iterator j = i->routes->begin (); 
+           j != i->routes->end (); 
+           j++)
         {
-          NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << masklen << ", metric " << metric);
+          uint32_t metric = j->metric;
+          NS_LOG_LOGIC ("Found global network route " << j->entry << ", mask length " << masklen << ", metric " << metric);
           if (oif != 0)
             {
-              if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
+              if (oif != m_ipv4->GetNetDevice (j->entry->GetInterface ()))
                 {
                   NS_LOG_LOGIC ("Not on requested interface, skipping");
                   continue;
                 }
             }
-          if (masklen < longest_mask) // Not interested if got shorter mask
+          if (route != 0)
             {
-              NS_LOG_LOGIC ("Previous match longer, skipping");
-              continue;
-            }
-          if (masklen > longest_mask) // Reset metric if longer masklen
-            {
-              shortest_metric = 0xffffffff;
+              if (masklen < longest_mask) // Not interested if got shorter mask
+                {
+                  NS_LOG_LOGIC ("Previous match longer, skipping");
+                  continue;
+                }
+              if (masklen == longest_mask
+                  && (metric > shortest_metric || (metric == shortest_metric && j->order < order)))
+                {
+                  NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
+                  continue;
+                }
             }
           longest_mask = masklen;
-          if (metric > shortest_metric)
-            {
-              NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
-              continue;
-            }
           shortest_metric = metric;
-          Ipv4RoutingTableEntry* route = (j);
-          uint32_t interfaceIdx = route->GetInterface ();
-          rtentry = Create<Ipv4Route> ();
-          rtentry->SetDestination (route->GetDest ());
-          rtentry->SetSource (SourceAddressSelection (interfaceIdx, route->GetDest ()));
-          rtentry->SetGateway (route->GetGateway ());
-          rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+          order = j->order;
+          route = j->entry;
         }
     }
+  if (route != 0)
+    {
+      uint32_t interfaceIdx = route->GetInterface ();
+      rtentry = Create<Ipv4Route> ();
+      rtentry->SetDestination (route->GetDest ());
+      rtentry->SetSource (SourceAddressSelection (interfaceIdx, route->GetDest ()));
+      rtentry->SetGateway (route->GetGateway ());
+      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+    }
   if (rtentry != 0)
     {
       NS_LOG_LOGIC ("Matching route via " << rtentry->GetGateway () << " at the end");
@@ -442,6 +452,7 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
     {
       if (tmp == index)
         {
+          m_networkRouteTrie.Remove (j->first);
           delete j->first;
           m_networkRoutes.erase (j);
           return;
@@ -592,6 +603,7 @@ Ipv4StaticRouting::DoDispose (void)
     {
       delete (j->first);
     }
+  m_networkRouteTrie.Clear ();
   for (MulticastRoutesI i = m_multicastRoutes.begin (); 
        i != m_multicastRoutes.end (); 
        i = m_multicastRoutes.erase (i)) 
@@ -630,6 +642,7 @@ Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
     {
       if (it->first->GetInterface () == i)
         {
+          m_networkRouteTrie.Remove (it->first);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -677,6 +690,7 @@ Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
           && it->first->GetDestNetwork () == networkAddress
           && it->first->GetDestNetworkMask () == networkMask)
         {
+          m_networkRouteTrie.Remove (it->first);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-routing-table-trie.h"
 
 namespace ns3 {
 
@@ -430,6 +431,16 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief the prefix index of m_networkRoutes, used for the lookups.
+   */
+  Ipv4RoutingTableTrie m_networkRouteTrie;
+
+  /**
+   * \brief the prefixes found by the last lookup.
+   */
+  Ipv4RoutingTableTrie::Matches m_matches;
+
   /**
    * \brief the forwarding table for multicast.
    */
@@ -21,6 +21,7 @@
 #include "ipv6-end-point-demux.h"
 #include "ipv6-end-point.h"
 #include "ns3/log.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -29,7 +30,8 @@ NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_order (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -43,33 +45,109 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_tuples.clear ();
+  m_positions.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+bool Ipv6EndPointDemux::Key::operator< (Key const &o) const
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (localPort != o.localPort)
     {
-      if ((*i)->GetLocalPort  () == port)
-        {
-          return true;
-        }
+      return localPort < o.localPort;
+    }
+  if (localAddress != o.localAddress)
+    {
+      return localAddress < o.localAddress;
     }
-  return false;
+  if (peerPort != o.peerPort)
+    {
+      return peerPort < o.peerPort;
+    }
+  if (peerAddress != o.peerAddress)
+    {
+      return peerAddress < o.peerAddress;
+    }
+  return order < o.order;
 }
 
-bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
 {
-  NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  NS_LOG_FUNCTION (this << endPoint);
+  Position position;
+  position.order = m_order++;
+  position.i = m_endPoints.insert (m_endPoints.end (), endPoint);
+  m_positions[endPoint] = position;
+  Key key;
+  key.localPort = endPoint->GetLocalPort ();
+  key.localAddress = endPoint->GetLocalAddress ();
+  key.peerPort = endPoint->GetPeerPort ();
+  key.peerAddress = endPoint->GetPeerAddress ();
+  key.order = position.order;
+  m_tuples[key] = endPoint;
+  endPoint->m_demux = this;
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+}
+
+void Ipv6EndPointDemux::Reindex (Ipv6EndPoint *endPoint, Ipv6Address localAddress, uint16_t localPort,
+                                 Ipv6Address peerAddress, uint16_t peerPort)
+{
+  NS_LOG_FUNCTION (this << endPoint << localAddress << localPort << peerAddress << peerPort);
+  Key key;
+  key.localPort = localPort;
+  key.localAddress = localAddress;
+  key.peerPort = peerPort;
+  key.peerAddress = peerAddress;
+  key.order = m_positions[endPoint].order;
+  m_tuples.erase (key);
+  key.localPort = endPoint->GetLocalPort ();
+  key.localAddress = endPoint->GetLocalAddress ();
+  key.peerPort = endPoint->GetPeerPort ();
+  key.peerAddress = endPoint->GetPeerAddress ();
+  m_tuples[key] = endPoint;
+}
+
+void Ipv6EndPointDemux::FindTuple (Ipv6Address localAddress, uint16_t localPort,
+                                   Ipv6Address peerAddress, uint16_t peerPort,
+                                   std::vector<std::pair<uint64_t, Ipv6EndPoint *> > &endPoints) const
+{
+  Key key;
+  key.localPort = localPort;
+  key.localAddress = localAddress;
+  key.peerPort = peerPort;
+  key.peerAddress = peerAddress;
+  key.order = 0;
+  for (std::map<Key, Ipv6EndPoint *>::const_iterator i = m_tuples.lower_bound (key);
+       i != m_tuples.end () && i->first.localPort == localPort && i->first.localAddress == localAddress
+       && i->first.peerPort == peerPort && i->first.peerAddress == peerAddress; i++)
     {
-      if ((*i)->GetLocalPort () == port
-          && (*i)->GetLocalAddress () == addr)
-        {
-          return true;
-        }
+      endPoints.push_back (std::make_pair (i->first.order, i->second));
     }
-  return false;
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  Key key;
+  key.localPort = port;
+  key.localAddress = Ipv6Address::GetZero ();
+  key.peerPort = 0;
+  key.peerAddress = Ipv6Address::GetZero ();
+  key.order = 0;
+  std::map<Key, Ipv6EndPoint *>::const_iterator i = m_tuples.lower_bound (key);
+  return i != m_tuples.end () && i->first.localPort == port;
+}
+
+bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
+{
+  NS_LOG_FUNCTION (this << addr << port);
+  Key key;
+  key.localPort = port;
+  key.localAddress = addr;
+  key.peerPort = 0;
+  key.peerAddress = Ipv6Address::GetZero ();
+  key.order = 0;
+  std::map<Key, Ipv6EndPoint *>::const_iterator i = m_tuples.lower_bound (key);
+  return i != m_tuples.end () && i->first.localPort == port && i->first.localAddress == addr;
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
@@ -82,8 +160,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -97,8 +174,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -118,8 +194,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -127,23 +202,17 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::vector<std::pair<uint64_t, Ipv6EndPoint *> > found;
+  FindTuple (localAddress, localPort, peerAddress, peerPort, found);
+  if (!found.empty ())
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
 
   return endPoint;
 }
@@ -151,15 +220,22 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::map<Ipv6EndPoint *, Position>::iterator position = m_positions.find (endPoint);
+  if (position == m_positions.end ())
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
     }
+  Key key;
+  key.localPort = endPoint->GetLocalPort ();
+  key.localAddress = endPoint->GetLocalAddress ();
+  key.peerPort = endPoint->GetPeerPort ();
+  key.peerAddress = endPoint->GetPeerAddress ();
+  key.order = position->second.order;
+  m_tuples.erase (key);
+  m_endPoints.erase (position->second.i);
+  m_positions.erase (position);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -179,9 +255,22 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+
+  /* Only the endpoints whose local address is the destination or the
+     wildcard, and whose peer is the source or the wildcard, can end up in
+     one of the lists; look at them in the order they were allocated. */
+  std::vector<std::pair<uint64_t, Ipv6EndPoint *> > candidates;
+  FindTuple (daddr, dport, saddr, sport, candidates);
+  FindTuple (Ipv6Address::GetAny (), dport, saddr, sport, candidates);
+  FindTuple (daddr, dport, Ipv6Address::GetAny (), 0, candidates);
+  FindTuple (Ipv6Address::GetAny (), dport, Ipv6Address::GetAny (), 0, candidates);
+  std::sort (candidates.begin (), candidates.end ());
+  candidates.erase (std::unique (candidates.begin (), candidates.end ()), candidates.end ());
+
+  for (std::vector<std::pair<uint64_t, Ipv6EndPoint *> >::const_iterator i = candidates.begin ();
+       i != candidates.end (); i++)
     {
-      Ipv6EndPoint* endP = *i;
+      Ipv6EndPoint* endP = i->second;
       NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
                                                  << " daddr=" << endP->GetLocalAddress ()
                                                  << " sport=" << endP->GetPeerPort ()
@@ -284,39 +373,45 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
 {
+  std::vector<std::pair<uint64_t, Ipv6EndPoint *> > exact;
+  FindTuple (dst, dport, src, sport, exact);
+  if (!exact.empty ())
+    {
+      /* this is an exact match. */
+      return exact.front ().second;
+    }
+
   uint32_t genericity = 3;
+  uint64_t genericOrder = 0;
   Ipv6EndPoint *generic = 0;
-
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  Key key;
+  key.localPort = dport;
+  key.localAddress = Ipv6Address::GetZero ();
+  key.peerPort = 0;
+  key.peerAddress = Ipv6Address::GetZero ();
+  key.order = 0;
+
+  for (std::map<Key, Ipv6EndPoint *>::const_iterator i = m_tuples.lower_bound (key);
+       i != m_tuples.end () && i->first.localPort == dport; i++)
     {
       uint32_t tmp = 0;
 
-      if ((*i)->GetLocalPort () != dport)
-        {
-          continue;
-        }
-
-      if ((*i)->GetLocalAddress () == dst && (*i)->GetPeerPort () == sport
-          && (*i)->GetPeerAddress () == src)
-        {
-          /* this is an exact match. */
-          return *i;
-        }
-
-      if ((*i)->GetLocalAddress () == Ipv6Address::GetAny ())
+      if (i->first.localAddress == Ipv6Address::GetAny ())
         {
           tmp++;
         }
 
-      if ((*i)->GetPeerAddress () == Ipv6Address::GetAny ())
+      if (i->first.peerAddress == Ipv6Address::GetAny ())
         {
           tmp++;
         }
 
-      if (tmp < genericity)
+      /* the first of the least generic endpoints in allocation order */
+      if (tmp < genericity || (tmp == genericity && i->first.order < genericOrder))
         {
-          generic = (*i);
+          generic = i->second;
           genericity = tmp;
+          genericOrder = i->first.order;
         }
     }
   return generic;
@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -33,6 +35,10 @@ class Ipv6EndPoint;
 /**
  * \class Ipv6EndPointDemux
  * \brief Demultiplexor for end points.
+ *
+ * The endpoints are indexed by their four-tuple, so that the lookups only
+ * look at the endpoints whose tuple can match, whatever the number of
+ * endpoints.  The endpoints tell the demux when their tuple changes.
  */
 class Ipv6EndPointDemux
 {
@@ -137,6 +143,64 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief The four-tuple of an endpoint, followed by the order of the
+   * endpoint in m_endPoints
+   */
+  struct Key
+  {
+    uint16_t localPort;       //!< the local port
+    Ipv6Address localAddress; //!< the local address
+    uint16_t peerPort;        //!< the peer port
+    Ipv6Address peerAddress;  //!< the peer address
+    uint64_t order;           //!< the allocation order of the endpoint
+    /**
+     * \param o the other key
+     * \returns true if this key sorts before o
+     */
+    bool operator< (Key const &o) const;
+  };
+
+  /**
+   * \brief The position of an endpoint in m_endPoints.
+   */
+  struct Position
+  {
+    uint64_t order; //!< the allocation order of the endpoint
+    EndPointsI i;   //!< the endpoint in m_endPoints
+  };
+
+  /**
+   * \brief Add a new endpoint to the list and the index.
+   * \param endPoint the endpoint
+   */
+  void Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Move an endpoint in the index after its tuple changed.
+   * \param endPoint the endpoint
+   * \param localAddress the previous local address
+   * \param localPort the previous local port
+   * \param peerAddress the previous peer address
+   * \param peerPort the previous peer port
+   */
+  void Reindex (Ipv6EndPoint *endPoint, Ipv6Address localAddress, uint16_t localPort,
+                Ipv6Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Append the endpoints of a four-tuple.
+   * \param localAddress local address
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \param endPoints the endpoints found, with their order
+   */
+  void FindTuple (Ipv6Address localAddress, uint16_t localPort,
+                  Ipv6Address peerAddress, uint16_t peerPort,
+                  std::vector<std::pair<uint64_t, Ipv6EndPoint *> > &endPoints) const;
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -162,6 +226,21 @@ private:
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The IPv6 end points, by four-tuple.
+   */
+  std::map<Key, Ipv6EndPoint *> m_tuples;
+
+  /**
+   * \brief The position of each IPv6 end point.
+   */
+  std::map<Ipv6EndPoint *, Position> m_positions;
+
+  /**
+   * \brief The allocation order of the next end point.
+   */
+  uint64_t m_order;
 };
 
 } /* namespace ns3 */
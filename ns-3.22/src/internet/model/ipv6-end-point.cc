@@ -23,6 +23,7 @@
 #include "ns3/simulator.h"
 
 #include "ipv6-end-point.h"
+#include "ipv6-end-point-demux.h"
 
 namespace ns3
 {
@@ -33,7 +34,8 @@ Ipv6EndPoint::Ipv6EndPoint (Ipv6Address addr, uint16_t port)
   : m_localAddr (addr),
     m_localPort (port),
     m_peerAddr (Ipv6Address::GetAny ()),
-    m_peerPort (0)
+    m_peerPort (0),
+    m_demux (0)
 {
 }
 
@@ -55,7 +57,12 @@ Ipv6Address Ipv6EndPoint::GetLocalAddress ()
 
 void Ipv6EndPoint::SetLocalAddress (Ipv6Address addr)
 {
+  Ipv6Address oldAddr = m_localAddr;
   m_localAddr = addr;
+  if (m_demux != 0)
+    {
+      m_demux->Reindex (this, oldAddr, m_localPort, m_peerAddr, m_peerPort);
+    }
 }
 
 uint16_t Ipv6EndPoint::GetLocalPort ()
@@ -65,7 +72,12 @@ uint16_t Ipv6EndPoint::GetLocalPort ()
 
 void Ipv6EndPoint::SetLocalPort (uint16_t port)
 {
+  uint16_t oldPort = m_localPort;
   m_localPort = port;
+  if (m_demux != 0)
+    {
+      m_demux->Reindex (this, m_localAddr, oldPort, m_peerAddr, m_peerPort);
+    }
 }
 
 Ipv6Address Ipv6EndPoint::GetPeerAddress ()
@@ -91,8 +103,14 @@ Ptr<NetDevice> Ipv6EndPoint::GetBoundNetDevice (void)
 
 void Ipv6EndPoint::SetPeer (Ipv6Address addr, uint16_t port)
 {
+  Ipv6Address oldAddr = m_peerAddr;
+  uint16_t oldPort = m_peerPort;
   m_peerAddr = addr;
   m_peerPort = port;
+  if (m_demux != 0)
+    {
+      m_demux->Reindex (this, m_localAddr, m_localPort, oldAddr, oldPort);
+    }
 }
 
 void Ipv6EndPoint::SetRxCallback (Callback<void, Ptr<Packet>, Ipv6Header, uint16_t, Ptr<Ipv6Interface> > callback)
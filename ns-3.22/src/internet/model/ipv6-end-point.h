@@ -34,6 +34,7 @@ namespace ns3
 
 class Header;
 class Packet;
+class Ipv6EndPointDemux;
 
 /**
  * \brief A representation of an internet IPv6 endpoint/connection
@@ -178,6 +179,8 @@ public:
                     uint8_t code, uint32_t info);
 
 private:
+  friend class Ipv6EndPointDemux;
+
   /**
    * \brief ForwardUp wrapper.
    * \param p packet
@@ -237,6 +240,11 @@ private:
    * \brief The destroy callback.
    */
   Callback<void> m_destroyCallback;
+
+  /**
+   * \brief The demux which indexes this end point by its four-tuple (if any).
+   */
+  Ipv6EndPointDemux *m_demux;
 };
 
 } /* namespace ns3 */
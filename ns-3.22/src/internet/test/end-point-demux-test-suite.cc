@@ -0,0 +1,358 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-end-point-demux.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-end-point-demux.h"
+#include "ns3/ipv6-end-point.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simple-net-device.h"
+
+#include <vector>
+
+using namespace ns3;
+
+// The endpoints found by looking at all of them, as the demuxes did before
+// they indexed them.  A is the address type, E the endpoint type.
+template <typename A, typename E>
+static std::list<E *>
+ScanLookup (std::list<E *> const &endPoints, A daddr, uint16_t dport, A saddr, uint16_t sport,
+            Ptr<NetDevice> device, A incomingInterfaceAddr, bool isBroadcast)
+{
+  std::list<E *> retval[4];
+  for (typename std::list<E *>::const_iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      E *endP = *i;
+      if (endP->GetLocalPort () != dport
+          || (endP->GetBoundNetDevice () && endP->GetBoundNetDevice () != device))
+        {
+          continue;
+        }
+      bool localWildCard = endP->GetLocalAddress () == A::GetAny ();
+      bool localExact = endP->GetLocalAddress () == daddr;
+      if (isBroadcast && !localWildCard)
+        {
+          localExact = endP->GetLocalAddress () == incomingInterfaceAddr;
+        }
+      bool peerPortExact = endP->GetPeerPort () == sport;
+      bool peerPortWildCard = endP->GetPeerPort () == 0;
+      bool peerExact = endP->GetPeerAddress () == saddr;
+      bool peerWildCard = endP->GetPeerAddress () == A::GetAny ();
+      if (!(localExact || localWildCard) || !(peerPortExact || peerPortWildCard)
+          || !(peerExact || peerWildCard))
+        {
+          continue;
+        }
+      if (localWildCard && peerPortWildCard && peerWildCard)
+        {
+          retval[0].push_back (endP);
+        }
+      if ((localExact || (isBroadcast && localWildCard)) && peerPortWildCard && peerWildCard)
+        {
+          retval[1].push_back (endP);
+        }
+      if (localWildCard && peerPortExact && peerExact)
+        {
+          retval[2].push_back (endP);
+        }
+      if (localExact && peerPortExact && peerExact)
+        {
+          retval[3].push_back (endP);
+        }
+    }
+  for (uint32_t i = 3; i > 0; i--)
+    {
+      if (!retval[i].empty ())
+        {
+          return retval[i];
+        }
+    }
+  return retval[0];
+}
+
+template <typename A, typename E>
+static E *
+ScanSimpleLookup (std::list<E *> const &endPoints, A daddr, uint16_t dport, A saddr, uint16_t sport)
+{
+  uint32_t genericity = 3;
+  E *generic = 0;
+  for (typename std::list<E *>::const_iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      if ((*i)->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if ((*i)->GetLocalAddress () == daddr && (*i)->GetPeerPort () == sport
+          && (*i)->GetPeerAddress () == saddr)
+        {
+          return *i;
+        }
+      uint32_t tmp = ((*i)->GetLocalAddress () == A::GetAny ()) + ((*i)->GetPeerAddress () == A::GetAny ());
+      if (tmp < genericity)
+        {
+          generic = *i;
+          genericity = tmp;
+        }
+    }
+  return generic;
+}
+
+// Allocate, change and remove endpoints at random in a small space of
+// addresses and ports, and compare the lookups with those of a scan of
+// all the endpoints.
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Check the lookups of the IPv4 endpoints demux")
+{
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+  Ptr<SimpleNetDevice> devices[2] = { CreateObject<SimpleNetDevice> (), CreateObject<SimpleNetDevice> () };
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  interface->SetDevice (devices[0]);
+  interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.255.255.0")));
+
+  Ipv4Address locals[] = { Ipv4Address::GetAny (), Ipv4Address ("10.0.0.1"), Ipv4Address ("10.0.0.2") };
+  Ipv4Address destinations[] = { Ipv4Address ("10.0.0.1"), Ipv4Address ("10.0.0.2"),
+                                 Ipv4Address ("10.0.0.255"), Ipv4Address ("255.255.255.255") };
+  Ipv4Address peers[] = { Ipv4Address::GetAny (), Ipv4Address ("10.0.1.1"), Ipv4Address ("10.0.1.2") };
+  uint16_t localPorts[] = { 80, 81 };
+  uint16_t peerPorts[] = { 0, 1000, 1001 };
+
+  Ipv4EndPointDemux demux;
+  std::vector<Ipv4EndPoint *> endPoints;
+  for (uint32_t step = 0; step < 2000; step++)
+    {
+      uint32_t op = random->GetInteger (0, 9);
+      Ipv4EndPoint *endPoint = 0;
+      if (op <= 3 || endPoints.empty ())
+        {
+          Ipv4Address local = locals[random->GetInteger (0, 2)];
+          uint16_t localPort = localPorts[random->GetInteger (0, 1)];
+          switch (random->GetInteger (0, 2))
+            {
+            case 0:
+              endPoint = demux.Allocate (local);
+              break;
+            case 1:
+              endPoint = demux.Allocate (local, localPort);
+              break;
+            default:
+              endPoint = demux.Allocate (local, localPort, peers[random->GetInteger (0, 2)],
+                                         peerPorts[random->GetInteger (0, 2)]);
+              break;
+            }
+          if (endPoint != 0)
+            {
+              endPoints.push_back (endPoint);
+            }
+        }
+      else
+        {
+          uint32_t i = random->GetInteger (0, endPoints.size () - 1);
+          switch (op)
+            {
+            case 4:
+            case 5:
+              demux.DeAllocate (endPoints[i]);
+              endPoints.erase (endPoints.begin () + i);
+              break;
+            case 6:
+            case 7:
+              endPoints[i]->SetPeer (peers[random->GetInteger (0, 2)], peerPorts[random->GetInteger (0, 2)]);
+              break;
+            case 8:
+              endPoints[i]->SetLocalAddress (locals[random->GetInteger (0, 2)]);
+              break;
+            default:
+              endPoints[i]->BindToNetDevice (devices[random->GetInteger (0, 1)]);
+              break;
+            }
+        }
+
+      Ipv4EndPointDemux::EndPoints all = demux.GetAllEndPoints ();
+      NS_TEST_ASSERT_MSG_EQ (all.size (), endPoints.size (), "Bad number of endpoints");
+      for (uint32_t j = 0; j < 10; j++)
+        {
+          Ipv4Address daddr = destinations[random->GetInteger (0, 3)];
+          uint16_t dport = localPorts[random->GetInteger (0, 1)];
+          Ipv4Address saddr = peers[random->GetInteger (1, 2)];
+          uint16_t sport = peerPorts[random->GetInteger (0, 2)];
+          bool isBroadcast = daddr.IsBroadcast () || daddr == Ipv4Address ("10.0.0.255");
+          Ipv4Address incomingInterfaceAddr = daddr == Ipv4Address ("10.0.0.255") ? Ipv4Address ("10.0.0.1") : daddr;
+          Ipv4EndPointDemux::EndPoints expected =
+            ScanLookup<Ipv4Address, Ipv4EndPoint> (all, daddr, dport, saddr, sport, devices[0],
+                                                   incomingInterfaceAddr, isBroadcast);
+          Ipv4EndPointDemux::EndPoints found = demux.Lookup (daddr, dport, saddr, sport, interface);
+          NS_TEST_ASSERT_MSG_EQ ((found == expected), true, "Bad endpoints for " << daddr << ":" << dport
+                                 << " from " << saddr << ":" << sport << " at step " << step);
+          NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (daddr, dport, saddr, sport),
+                                 (ScanSimpleLookup<Ipv4Address, Ipv4EndPoint> (all, daddr, dport, saddr, sport)),
+                                 "Bad simple lookup at step " << step);
+          bool portUsed = false;
+          bool localUsed = false;
+          for (Ipv4EndPointDemux::EndPointsI k = all.begin (); k != all.end (); k++)
+            {
+              portUsed = portUsed || (*k)->GetLocalPort () == dport;
+              localUsed = localUsed || ((*k)->GetLocalPort () == dport && (*k)->GetLocalAddress () == daddr);
+            }
+          NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (dport), portUsed, "Bad local port lookup");
+          NS_TEST_ASSERT_MSG_EQ (demux.LookupLocal (daddr, dport), localUsed, "Bad local address lookup");
+        }
+    }
+}
+
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Check the lookups of the IPv6 endpoints demux")
+{
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (2);
+  Ptr<SimpleNetDevice> devices[2] = { CreateObject<SimpleNetDevice> (), CreateObject<SimpleNetDevice> () };
+  Ptr<Ipv6Interface> interface = CreateObject<Ipv6Interface> ();
+  interface->SetDevice (devices[0]);
+
+  Ipv6Address locals[] = { Ipv6Address::GetAny (), Ipv6Address ("2001:1::1"), Ipv6Address ("2001:1::2") };
+  Ipv6Address peers[] = { Ipv6Address::GetAny (), Ipv6Address ("2001:2::1"), Ipv6Address ("2001:2::2") };
+  uint16_t localPorts[] = { 80, 81 };
+  uint16_t peerPorts[] = { 0, 1000, 1001 };
+
+  Ipv6EndPointDemux demux;
+  std::vector<Ipv6EndPoint *> endPoints;
+  for (uint32_t step = 0; step < 2000; step++)
+    {
+      uint32_t op = random->GetInteger (0, 9);
+      if (op <= 3 || endPoints.empty ())
+        {
+          Ipv6Address local = locals[random->GetInteger (0, 2)];
+          uint16_t localPort = localPorts[random->GetInteger (0, 1)];
+          Ipv6EndPoint *endPoint;
+          switch (random->GetInteger (0, 2))
+            {
+            case 0:
+              endPoint = demux.Allocate (local);
+              break;
+            case 1:
+              endPoint = demux.Allocate (local, localPort);
+              break;
+            default:
+              endPoint = demux.Allocate (local, localPort, peers[random->GetInteger (0, 2)],
+                                         peerPorts[random->GetInteger (0, 2)]);
+              break;
+            }
+          if (endPoint != 0)
+            {
+              endPoints.push_back (endPoint);
+            }
+        }
+      else
+        {
+          uint32_t i = random->GetInteger (0, endPoints.size () - 1);
+          switch (op)
+            {
+            case 4:
+            case 5:
+              demux.DeAllocate (endPoints[i]);
+              endPoints.erase (endPoints.begin () + i);
+              break;
+            case 6:
+              endPoints[i]->SetPeer (peers[random->GetInteger (0, 2)], peerPorts[random->GetInteger (0, 2)]);
+              break;
+            case 7:
+              endPoints[i]->SetLocalPort (localPorts[random->GetInteger (0, 1)]);
+              break;
+            case 8:
+              endPoints[i]->SetLocalAddress (locals[random->GetInteger (0, 2)]);
+              break;
+            default:
+              endPoints[i]->BindToNetDevice (devices[random->GetInteger (0, 1)]);
+              break;
+            }
+        }
+
+      Ipv6EndPointDemux::EndPoints all = demux.GetEndPoints ();
+      NS_TEST_ASSERT_MSG_EQ (all.size (), endPoints.size (), "Bad number of endpoints");
+      for (uint32_t j = 0; j < 10; j++)
+        {
+          Ipv6Address daddr = locals[random->GetInteger (1, 2)];
+          uint16_t dport = localPorts[random->GetInteger (0, 1)];
+          Ipv6Address saddr = peers[random->GetInteger (1, 2)];
+          uint16_t sport = peerPorts[random->GetInteger (0, 2)];
+          Ipv6EndPointDemux::EndPoints expected =
+            ScanLookup<Ipv6Address, Ipv6EndPoint> (all, daddr, dport, saddr, sport, devices[0], daddr, false);
+          Ipv6EndPointDemux::EndPoints found = demux.Lookup (daddr, dport, saddr, sport, interface);
+          NS_TEST_ASSERT_MSG_EQ ((found == expected), true, "Bad endpoints for " << daddr << ":" << dport
+                                 << " from " << saddr << ":" << sport << " at step " << step);
+          NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (daddr, dport, saddr, sport),
+                                 (ScanSimpleLookup<Ipv6Address, Ipv6EndPoint> (all, daddr, dport, saddr, sport)),
+                                 "Bad simple lookup at step " << step);
+          bool portUsed = false;
+          bool localUsed = false;
+          for (Ipv6EndPointDemux::EndPointsI k = all.begin (); k != all.end (); k++)
+            {
+              portUsed = portUsed || (*k)->GetLocalPort () == dport;
+              localUsed = localUsed || ((*k)->GetLocalPort () == dport && (*k)->GetLocalAddress () == daddr);
+            }
+          NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (dport), portUsed, "Bad local port lookup");
+          NS_TEST_ASSERT_MSG_EQ (demux.LookupLocal (daddr, dport), localUsed, "Bad local address lookup");
+        }
+    }
+}
+
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ();
+};
+
+EndPointDemuxTestSuite::EndPointDemuxTestSuite ()
+  : TestSuite ("end-point-demux", UNIT)
+{
+  AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+}
+
+static EndPointDemuxTestSuite endPointDemuxTestSuite;
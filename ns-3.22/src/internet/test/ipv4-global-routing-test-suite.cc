@@ -14,9 +14,14 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+#include <sstream>
+#include <string>
 #include <vector>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/global-route-manager-impl.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
@@ -420,6 +425,148 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
 }
 
 
+// Compare the routes computed on the SPF graph from several threads with
+// those of the original SPF calculation, and the routes updated after a
+// change with those computed again from scratch.
+class Ipv4GlobalRoutingSpfTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingSpfTestCase ();
+
+private:
+  virtual void DoRun (void);
+  typedef std::vector<std::vector<std::string> > Tables;
+  Tables GetTables (bool sorted) const;
+  void CheckUpdate (std::string change);
+
+  NodeContainer m_nodes;
+};
+
+Ipv4GlobalRoutingSpfTestCase::Ipv4GlobalRoutingSpfTestCase ()
+  : TestCase ("Check the routes of the threaded and incremental SPF calculations")
+{
+}
+
+Ipv4GlobalRoutingSpfTestCase::Tables
+Ipv4GlobalRoutingSpfTestCase::GetTables (bool sorted) const
+{
+  Tables tables;
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> routing = m_nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      std::vector<std::string> table;
+      for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+        {
+          std::ostringstream route;
+          route << *routing->GetRoute (j);
+          table.push_back (route.str ());
+        }
+      if (sorted)
+        {
+          std::sort (table.begin (), table.end ());
+        }
+      tables.push_back (table);
+    }
+  return tables;
+}
+
+void
+Ipv4GlobalRoutingSpfTestCase::CheckUpdate (std::string change)
+{
+  Ipv4GlobalRoutingHelper::UpdateRoutingTables ();
+  Tables updated = GetTables (true);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  Tables recomputed = GetTables (true);
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((updated[i] == recomputed[i]), true,
+                             "Bad routes of node " << i << " updated after " << change);
+    }
+  // start again from the routes of the first update
+  Ipv4GlobalRoutingHelper::UpdateRoutingTables ();
+}
+
+// A ring of 8 routers linked two by two, with a shortcut between routers 0
+// and 4, a network shared by routers 2, 5 and 6, routers 8 and 9 attached
+// to routers 1 and 3 only, and networks without other routers on some of
+// them.
+void
+Ipv4GlobalRoutingSpfTestCase::DoRun (void)
+{
+  m_nodes.Create (10);
+  InternetStackHelper internet;
+  internet.Install (m_nodes);
+
+  SimpleNetDeviceHelper p2pHelper;
+  p2pHelper.SetNetDevicePointToPointMode (true);
+  SimpleNetDeviceHelper csmaHelper;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
+  std::vector<std::pair<uint32_t, uint32_t> > links;
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      links.push_back (std::make_pair (i, (i + 1) % 8));
+    }
+  links.push_back (std::make_pair (0, 4));
+  links.push_back (std::make_pair (1, 8));
+  links.push_back (std::make_pair (3, 9));
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      ipv4.Assign (p2pHelper.Install (NodeContainer (m_nodes.Get (links[i].first), m_nodes.Get (links[i].second))));
+      ipv4.NewNetwork ();
+    }
+  ipv4.SetBase ("10.1.0.0", "255.255.255.0");
+  ipv4.Assign (csmaHelper.Install (NodeContainer (m_nodes.Get (2), m_nodes.Get (5), m_nodes.Get (6))));
+  ipv4.SetBase ("10.2.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i < 8; i += 3)
+    {
+      ipv4.Assign (csmaHelper.Install (m_nodes.Get (i)));
+      ipv4.NewNetwork ();
+    }
+
+  // the routes of the SPF graph, from two threads
+  Config::SetGlobal ("GlobalRoutingThreadCount", UintegerValue (2));
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  Tables tables = GetTables (false);
+
+  // the routes of the original SPF calculation
+  GlobalRouteManagerImpl *impl = new GlobalRouteManagerImpl ();
+  impl->DeleteGlobalRoutes ();
+  impl->BuildGlobalRoutingDatabase ();
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      impl->DebugSPFCalculate (m_nodes.Get (i)->GetObject<GlobalRouter> ()->GetRouterId ());
+    }
+  delete impl;
+  Tables expected = GetTables (false);
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (tables[i].size (), expected[i].size (), "Bad number of routes for node " << i);
+      NS_TEST_EXPECT_MSG_EQ ((tables[i] == expected[i]), true, "Bad routes for node " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (tables[8].size (), 1, "Router 8 should only have a default route");
+
+  Ipv4GlobalRoutingHelper::UpdateRoutingTables ();
+  // a network added to a router, which changes no path
+  ipv4.SetBase ("10.3.0.0", "255.255.255.0");
+  ipv4.Assign (csmaHelper.Install (m_nodes.Get (7)));
+  CheckUpdate ("adding a network");
+  // a link of the ring down, then up again
+  Ptr<Ipv4> ipv4Of5 = m_nodes.Get (5)->GetObject<Ipv4> ();
+  ipv4Of5->SetDown (1);
+  CheckUpdate ("setting down a link");
+  ipv4Of5->SetUp (1);
+  CheckUpdate ("setting up a link");
+  // a longer shortcut from router 0 to router 4
+  Ptr<Ipv4> ipv4Of0 = m_nodes.Get (0)->GetObject<Ipv4> ();
+  ipv4Of0->SetMetric (3, 10);
+  CheckUpdate ("changing a metric");
+
+  Config::SetGlobal ("GlobalRoutingThreadCount", UintegerValue (0));
+  Simulator::Destroy ();
+}
+
+
 class Ipv4GlobalRoutingTestSuite : public TestSuite
 {
 public:
@@ -431,6 +578,7 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
 {
   AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
   AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingSpfTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
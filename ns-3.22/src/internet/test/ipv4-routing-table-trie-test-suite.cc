@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-routing-table-trie.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/random-variable-stream.h"
+
+#include <set>
+#include <vector>
+
+using namespace ns3;
+
+// Compare the prefixes found by the trie with those found by testing
+// every route, while routes are added and removed.
+class Ipv4RoutingTableTrieTestCase : public TestCase
+{
+public:
+  Ipv4RoutingTableTrieTestCase ();
+  virtual ~Ipv4RoutingTableTrieTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void AddRoute (Ipv4Address network, Ipv4Mask mask);
+  void RemoveRoute (uint32_t i);
+  void CheckLookup (Ipv4Address dest);
+
+  Ipv4RoutingTableTrie m_trie;
+  std::vector<Ipv4RoutingTableEntry *> m_routes;
+};
+
+Ipv4RoutingTableTrieTestCase::Ipv4RoutingTableTrieTestCase ()
+  : TestCase ("Check the prefixes found by the routing table trie")
+{
+}
+
+Ipv4RoutingTableTrieTestCase::~Ipv4RoutingTableTrieTestCase ()
+{
+  for (uint32_t i = 0; i < m_routes.size (); i++)
+    {
+      delete m_routes[i];
+    }
+}
+
+void
+Ipv4RoutingTableTrieTestCase::AddRoute (Ipv4Address network, Ipv4Mask mask)
+{
+  Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
+  *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network, mask, 0);
+  m_routes.push_back (route);
+  m_trie.Insert (route, m_routes.size ());
+}
+
+void
+Ipv4RoutingTableTrieTestCase::RemoveRoute (uint32_t i)
+{
+  m_trie.Remove (m_routes[i]);
+  delete m_routes[i];
+  m_routes.erase (m_routes.begin () + i);
+}
+
+void
+Ipv4RoutingTableTrieTestCase::CheckLookup (Ipv4Address dest)
+{
+  std::set<Ipv4RoutingTableEntry *> expected;
+  for (uint32_t i = 0; i < m_routes.size (); i++)
+    {
+      if (m_routes[i]->GetDestNetworkMask ().IsMatch (dest, m_routes[i]->GetDestNetwork ()))
+        {
+          expected.insert (m_routes[i]);
+        }
+    }
+
+  Ipv4RoutingTableTrie::Matches matches;
+  m_trie.Lookup (dest, matches);
+  std::set<Ipv4RoutingTableEntry *> found;
+  for (Ipv4RoutingTableTrie::Matches::const_iterator i = matches.begin (); i != matches.end (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (i->routes->empty (), false, "Empty prefix found for " << dest);
+      uint64_t order = 0;
+      for (Ipv4RoutingTableTrie::Routes::const_iterator j = i->routes->begin (); j != i->routes->end (); j++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (i->prefixLength, j->entry->GetDestNetworkMask ().GetPrefixLength (),
+                                 "Bad prefix length for " << dest);
+          NS_TEST_EXPECT_MSG_EQ ((j == i->routes->begin () || j->order > order), true,
+                                 "Routes not in insertion order for " << dest);
+          order = j->order;
+          found.insert (j->entry);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (found.size (), expected.size (), "Bad number of routes found for " << dest);
+  NS_TEST_EXPECT_MSG_EQ ((found == expected), true, "Bad routes found for " << dest);
+}
+
+void
+Ipv4RoutingTableTrieTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+
+  // a default route, some host routes, routes to the same prefix, and
+  // a non contiguous mask
+  AddRoute (Ipv4Address ("0.0.0.0"), Ipv4Mask::GetZero ());
+  AddRoute (Ipv4Address ("10.1.2.3"), Ipv4Mask::GetOnes ());
+  AddRoute (Ipv4Address ("10.1.2.0"), Ipv4Mask ("255.255.255.0"));
+  AddRoute (Ipv4Address ("10.1.2.0"), Ipv4Mask ("255.255.255.0"));
+  AddRoute (Ipv4Address ("10.1.2.77"), Ipv4Mask ("255.255.255.0"));
+  AddRoute (Ipv4Address ("10.0.0.0"), Ipv4Mask ("255.0.255.0"));
+  CheckLookup (Ipv4Address ("10.1.2.3"));
+  CheckLookup (Ipv4Address ("10.1.2.4"));
+  CheckLookup (Ipv4Address ("10.7.0.9"));
+  CheckLookup (Ipv4Address ("192.168.0.1"));
+
+  // random prefixes in a small part of the address space, so that they
+  // overlap
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      uint32_t length = random->GetInteger (0, 32);
+      uint32_t mask = length == 0 ? 0 : ~((1ULL << (32 - length)) - 1);
+      uint32_t address = 0x0a000000 | random->GetInteger (0, 0xffff) << 8 | random->GetInteger (0, 0xff);
+      AddRoute (Ipv4Address (address), Ipv4Mask (mask));
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_trie.GetNRoutes (), m_routes.size (), "Bad number of routes");
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      CheckLookup (Ipv4Address (0x0a000000 | random->GetInteger (0, 0xffff) << 8 | random->GetInteger (0, 0xff)));
+    }
+
+  // remove most of the routes, in random order
+  while (m_routes.size () > 100)
+    {
+      RemoveRoute (random->GetInteger (0, m_routes.size () - 1));
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_trie.GetNRoutes (), m_routes.size (), "Bad number of routes");
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      CheckLookup (Ipv4Address (0x0a000000 | random->GetInteger (0, 0xffff) << 8 | random->GetInteger (0, 0xff)));
+    }
+  for (uint32_t i = 0; i < m_routes.size (); i++)
+    {
+      CheckLookup (m_routes[i]->GetDestNetwork ());
+    }
+
+  while (!m_routes.empty ())
+    {
+      RemoveRoute (m_routes.size () - 1);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_trie.GetNRoutes (), 0, "Routes left in the trie");
+  CheckLookup (Ipv4Address ("10.1.2.3"));
+}
+
+class Ipv4RoutingTableTrieTestSuite : public TestSuite
+{
+public:
+  Ipv4RoutingTableTrieTestSuite ();
+};
+
+Ipv4RoutingTableTrieTestSuite::Ipv4RoutingTableTrieTestSuite ()
+  : TestSuite ("ipv4-routing-table-trie", UNIT)
+{
+  AddTestCase (new Ipv4RoutingTableTrieTestCase, TestCase::QUICK);
+}
+
+static Ipv4RoutingTableTrieTestSuite ipv4RoutingTableTrieTestSuite;
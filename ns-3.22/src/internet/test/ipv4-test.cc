@@ -29,6 +29,12 @@
 #include "ns3/arp-l3-protocol.h"
 #include "ns3/ipv4-interface.h"
 #include "ns3/loopback-net-device.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/mac48-address.h"
+#include <sstream>
+#include <vector>
 
 using namespace ns3;
 
@@ -140,7 +146,102 @@ Ipv4L3ProtocolTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
-  
+/**
+ * Check that the packets received from a device are handed to the
+ * interface of that device, and that the packet of the device is never
+ * modified.
+ */
+class Ipv4L3ProtocolReceiveTestCase : public TestCase
+{
+public:
+  Ipv4L3ProtocolReceiveTestCase ();
+  virtual void DoRun (void);
+
+private:
+  void Rx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  Ptr<const Packet> m_packet;
+  uint32_t m_interface;
+};
+
+Ipv4L3ProtocolReceiveTestCase::Ipv4L3ProtocolReceiveTestCase ()
+  : TestCase ("Verify the receive path of the IPv4 layer 3 protocol")
+{
+}
+
+void
+Ipv4L3ProtocolReceiveTestCase::Rx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_packet = packet;
+  m_interface = interface;
+}
+
+void
+Ipv4L3ProtocolReceiveTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<Ipv4L3Protocol> ipv4 = CreateObject<Ipv4L3Protocol> ();
+  node->AggregateObject (ipv4);
+  node->AggregateObject (CreateObject<ArpL3Protocol> ());
+  ipv4->SetRoutingProtocol (CreateObject<Ipv4StaticRouting> ());
+
+  std::vector<Ptr<SimpleNetDevice> > devices;
+  std::vector<uint32_t> interfaces;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (device);
+      uint32_t interface = ipv4->AddInterface (device);
+      std::ostringstream address;
+      address << "10.0." << i << ".1";
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address (address.str ().c_str ()), "255.255.255.0"));
+      ipv4->SetUp (interface);
+      devices.push_back (device);
+      interfaces.push_back (interface);
+    }
+  for (uint32_t i = 0; i < devices.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (ipv4->GetInterfaceForDevice (devices[i]), (int32_t)interfaces[i],
+                             "Wrong interface for device " << i);
+      NS_TEST_EXPECT_MSG_EQ (ipv4->GetNetDevice (interfaces[i]), devices[i], "Wrong device for interface " << i);
+    }
+  Ptr<SimpleNetDevice> other = CreateObject<SimpleNetDevice> ();
+  NS_TEST_EXPECT_MSG_EQ (ipv4->GetInterfaceForDevice (other), -1, "A device without interface has an interface");
+
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.0.2.2"));
+  header.SetDestination (Ipv4Address ("10.0.2.1"));
+  header.SetProtocol (253);
+  header.SetTtl (64);
+  header.SetPayloadSize (100);
+
+  // With a sink on the Rx trace, which may keep the packet it is given,
+  // the header is removed from a copy.
+  ipv4->TraceConnectWithoutContext ("Rx", MakeCallback (&Ipv4L3ProtocolReceiveTestCase::Rx, this));
+  Ptr<Packet> packet = Create<Packet> (100);
+  packet->AddHeader (header);
+  ipv4->Receive (devices[2], packet, Ipv4L3Protocol::PROT_NUMBER, Mac48Address::Allocate (),
+                 devices[2]->GetAddress (), NetDevice::PACKET_HOST);
+  NS_TEST_ASSERT_MSG_NE (m_packet, 0, "The Rx trace was not called");
+  NS_TEST_EXPECT_MSG_EQ (m_interface, interfaces[2], "The packet was received on the wrong interface");
+  NS_TEST_EXPECT_MSG_NE (m_packet, packet, "The trace sink was given the packet of the device");
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 120, "The packet of the device was modified");
+
+  // Without, the header is still removed from a copy: the node gives the
+  // same packet to all the handlers of the device.
+  ipv4->TraceDisconnectWithoutContext ("Rx", MakeCallback (&Ipv4L3ProtocolReceiveTestCase::Rx, this));
+  m_packet = 0;
+  packet = Create<Packet> (100);
+  packet->AddHeader (header);
+  ipv4->Receive (devices[2], packet, Ipv4L3Protocol::PROT_NUMBER, Mac48Address::Allocate (),
+                 devices[2]->GetAddress (), NetDevice::PACKET_HOST);
+  NS_TEST_EXPECT_MSG_EQ (m_packet, 0, "The Rx trace was called after its sink was disconnected");
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 120, "The packet of the device was modified");
+
+  Simulator::Destroy ();
+}
+
 static class IPv4L3ProtocolTestSuite : public TestSuite
 {
 public:
@@ -148,5 +249,6 @@ public:
     TestSuite ("ipv4-protocol", UNIT)
   {
     AddTestCase (new Ipv4L3ProtocolTestCase (), TestCase::QUICK);
+    AddTestCase (new Ipv4L3ProtocolReceiveTestCase (), TestCase::QUICK);
   }
 } g_ipv4protocolTestSuite;
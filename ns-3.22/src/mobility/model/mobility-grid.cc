@@ -0,0 +1,209 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <algorithm>
+#include <cmath>
+#include "mobility-grid.h"
+#include "mobility-model.h"
+#include "ns3/simulator.h"
+#include "ns3/callback.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MobilityGrid");
+
+MobilityGrid::MobilityGrid ()
+  : m_cellSize (100.0),
+    m_nItems (0),
+    m_maxSpeed (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MobilityGrid::~MobilityGrid ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+void
+MobilityGrid::SetCellSize (double cellSize)
+{
+  NS_LOG_FUNCTION (this << cellSize);
+  NS_ASSERT (cellSize > 0);
+  Clear ();
+  m_cellSize = cellSize;
+}
+
+double
+MobilityGrid::GetCellSize (void) const
+{
+  return m_cellSize;
+}
+
+void
+MobilityGrid::Add (uint32_t item, Ptr<MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this << item << mobility);
+  NS_ASSERT (mobility != 0);
+  m_nItems++;
+  std::map<const MobilityModel *, uint32_t>::const_iterator i = m_index.find (PeekPointer (mobility));
+  if (i != m_index.end ())
+    {
+      m_entries[i->second].items.push_back (item);
+      return;
+    }
+  Entry entry;
+  entry.mobility = mobility;
+  entry.items.push_back (item);
+  entry.speed = 0;
+  uint32_t e = m_entries.size ();
+  m_entries.push_back (entry);
+  m_index[PeekPointer (mobility)] = e;
+  mobility->TraceConnectWithoutContext ("CourseChange", MakeCallback (&MobilityGrid::CourseChanged, this));
+  Place (e);
+}
+
+void
+MobilityGrid::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Entry>::const_iterator i = m_entries.begin (); i != m_entries.end (); ++i)
+    {
+      i->mobility->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&MobilityGrid::CourseChanged, this));
+    }
+  m_entries.clear ();
+  m_index.clear ();
+  m_cells.clear ();
+  m_nItems = 0;
+  m_maxSpeed = 0;
+  m_placed = Seconds (0);
+}
+
+uint32_t
+MobilityGrid::GetNItems (void) const
+{
+  return m_nItems;
+}
+
+void
+MobilityGrid::CourseChanged (Ptr<const MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this << mobility);
+  std::map<const MobilityModel *, uint32_t>::const_iterator i = m_index.find (PeekPointer (mobility));
+  NS_ASSERT (i != m_index.end ());
+  Place (i->second);
+}
+
+void
+MobilityGrid::Place (uint32_t e)
+{
+  // GetPosition may notify a course change, and thus call Place, so
+  // it is called before the cells are changed.
+  Vector position = m_entries[e].mobility->GetPosition ();
+  Vector velocity = m_entries[e].mobility->GetVelocity ();
+  Entry &entry = m_entries[e];
+  std::map<Cell, std::vector<uint32_t> >::iterator i = m_cells.find (entry.cell);
+  if (i != m_cells.end ())
+    {
+      std::vector<uint32_t>::iterator j = std::find (i->second.begin (), i->second.end (), e);
+      if (j != i->second.end ())
+        {
+          i->second.erase (j);
+          if (i->second.empty ())
+            {
+              m_cells.erase (i);
+            }
+        }
+    }
+  entry.cell = GetCell (position);
+  m_cells[entry.cell].push_back (e);
+  entry.speed = std::sqrt (velocity.x * velocity.x + velocity.y * velocity.y);
+  m_maxSpeed = std::max (m_maxSpeed, entry.speed);
+}
+
+MobilityGrid::Cell
+MobilityGrid::GetCell (const Vector &position) const
+{
+  return Cell ((int64_t)std::floor (position.x / m_cellSize),
+               (int64_t)std::floor (position.y / m_cellSize));
+}
+
+double
+MobilityGrid::GetMargin (void) const
+{
+  return m_maxSpeed * (Simulator::Now () - m_placed).GetSeconds ();
+}
+
+void
+MobilityGrid::Lookup (const Vector &position, double distance, std::vector<uint32_t> &items)
+{
+  NS_LOG_FUNCTION (this << position << distance);
+  double margin = GetMargin ();
+  if (margin > m_cellSize / 2)
+    {
+      // put the models which move back in the cells of their position
+      m_maxSpeed = 0;
+      m_placed = Simulator::Now ();
+      for (uint32_t e = 0; e < m_entries.size (); e++)
+        {
+          if (m_entries[e].speed > 0)
+            {
+              Place (e);
+            }
+        }
+      margin = GetMargin ();
+    }
+  double range = distance + margin;
+  std::size_t start = items.size ();
+  double xMin = std::floor ((position.x - range) / m_cellSize);
+  double xMax = std::floor ((position.x + range) / m_cellSize);
+  double yMin = std::floor ((position.y - range) / m_cellSize);
+  double yMax = std::floor ((position.y + range) / m_cellSize);
+  double nCells = (xMax - xMin + 1) * (yMax - yMin + 1);
+  if (nCells <= m_cells.size ())
+    {
+      for (int64_t x = (int64_t)xMin; x <= (int64_t)xMax; x++)
+        {
+          for (int64_t y = (int64_t)yMin; y <= (int64_t)yMax; y++)
+            {
+              std::map<Cell, std::vector<uint32_t> >::const_iterator i = m_cells.find (Cell (x, y));
+              if (i == m_cells.end ())
+                {
+                  continue;
+                }
+              for (std::vector<uint32_t>::const_iterator j = i->second.begin (); j != i->second.end (); ++j)
+                {
+                  items.insert (items.end (), m_entries[*j].items.begin (), m_entries[*j].items.end ());
+                }
+            }
+        }
+    }
+  else
+    {
+      // more cells to look at than non-empty cells, possibly infinitely
+      // many: all the items are returned.
+      for (std::vector<Entry>::const_iterator i = m_entries.begin (); i != m_entries.end (); ++i)
+        {
+          items.insert (items.end (), i->items.begin (), i->items.end ());
+        }
+    }
+  std::sort (items.begin () + start, items.end ());
+}
+
+} // namespace ns3
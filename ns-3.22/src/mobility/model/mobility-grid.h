@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef MOBILITY_GRID_H
+#define MOBILITY_GRID_H
+
+#include <vector>
+#include <map>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+class MobilityModel;
+
+/**
+ * \ingroup mobility
+ * \brief An index of the positions of mobility models in a uniform grid.
+ *
+ * The channels use this index to find the receivers which may be near
+ * a transmitter without looking at all of them.  Each mobility model is
+ * stored in the square cell of the x-y plane which holds its position,
+ * and moved to another cell when it notifies a course change.
+ *
+ * The models which move are not moved between their course changes:
+ * the grid instead widens the lookups by the distance which they could
+ * have travelled at the highest speed seen since the last time all of
+ * them were put back in the cells of their current position, which is
+ * done when that distance reaches half a cell.  This assumes that the
+ * models notify a course change whenever their velocity changes, as all
+ * the models of this module do, except ConstantAccelerationMobilityModel
+ * and WaypointMobilityModel with LazyNotify set.
+ */
+class MobilityGrid
+{
+public:
+  MobilityGrid ();
+  ~MobilityGrid ();
+
+  /**
+   * \param cellSize the side of the cells, in meters
+   *
+   * The items already added are removed.
+   */
+  void SetCellSize (double cellSize);
+  /**
+   * \return the side of the cells, in meters
+   */
+  double GetCellSize (void) const;
+
+  /**
+   * \param item an index chosen by the caller
+   * \param mobility the mobility model which gives the position of the item
+   *
+   * Many items can share a mobility model.
+   */
+  void Add (uint32_t item, Ptr<MobilityModel> mobility);
+  /**
+   * Remove all the items.
+   */
+  void Clear (void);
+  /**
+   * \return the number of items added
+   */
+  uint32_t GetNItems (void) const;
+
+  /**
+   * \param position a position
+   * \param distance a distance, in meters, which can be infinite
+   * \param items the vector to which the items are appended
+   *
+   * Append to items, in increasing order, all the items whose position
+   * in the x-y plane is within distance of position.  The other items
+   * of the cells visited are appended too.
+   */
+  void Lookup (const Vector &position, double distance, std::vector<uint32_t> &items);
+
+private:
+  /// the coordinates of a cell
+  typedef std::pair<int64_t, int64_t> Cell;
+  /// a mobility model of the grid
+  struct Entry
+  {
+    Ptr<MobilityModel> mobility;  //!< the mobility model
+    std::vector<uint32_t> items;  //!< the items at its position
+    Cell cell;                    //!< the cell which holds it
+    double speed;                 //!< its speed when it was put in its cell
+  };
+
+  /**
+   * \param mobility a mobility model which changed course
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+  /**
+   * Put an entry in the cell of its current position.
+   * \param entry the index of the entry
+   */
+  void Place (uint32_t entry);
+  /**
+   * \param position a position
+   * \return the cell which holds the position
+   */
+  Cell GetCell (const Vector &position) const;
+  /**
+   * \return the distance which the models may have travelled since
+   * they were put in their cells
+   */
+  double GetMargin (void) const;
+
+  double m_cellSize;                                 //!< the side of the cells
+  uint32_t m_nItems;                                 //!< the number of items
+  std::vector<Entry> m_entries;                      //!< the mobility models
+  std::map<const MobilityModel *, uint32_t> m_index; //!< mobility model to entry
+  std::map<Cell, std::vector<uint32_t> > m_cells;    //!< the entries of the non-empty cells
+  double m_maxSpeed;                                 //!< highest speed since m_placed
+  Time m_placed;                                     //!< when all the entries were last placed
+};
+
+} // namespace ns3
+
+#endif /* MOBILITY_GRID_H */
@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/mobility-grid.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/random-walk-2d-mobility-model.h"
+#include "ns3/rectangle.h"
+
+using namespace ns3;
+
+/**
+ * The lookups of a grid return all the items within the distance,
+ * while some of the models move.
+ */
+class MobilityGridLookupTestCase : public TestCase
+{
+public:
+  MobilityGridLookupTestCase ();
+private:
+  virtual void DoRun (void);
+  void Check (void);
+
+  MobilityGrid m_grid;
+  std::vector<Ptr<MobilityModel> > m_models;
+  Ptr<UniformRandomVariable> m_random;
+  uint32_t m_found;
+};
+
+MobilityGridLookupTestCase::MobilityGridLookupTestCase ()
+  : TestCase ("Look up the models near a position"),
+    m_found (0)
+{
+}
+
+void
+MobilityGridLookupTestCase::Check (void)
+{
+  for (uint32_t k = 0; k < 20; k++)
+    {
+      Vector position (m_random->GetValue (-100, 1100), m_random->GetValue (-100, 1100), 0);
+      double distance = m_random->GetValue (0, 300);
+      std::vector<uint32_t> items;
+      items.push_back (12345);
+      m_grid.Lookup (position, distance, items);
+      NS_TEST_ASSERT_MSG_EQ (items[0], 12345, "the items were not appended");
+      bool sorted = std::adjacent_find (items.begin () + 1, items.end (), std::greater_equal<uint32_t> ()) == items.end ();
+      NS_TEST_ASSERT_MSG_EQ (sorted, true, "the items are not sorted");
+      for (uint32_t i = 0; i < m_models.size (); i++)
+        {
+          Vector p = m_models[i]->GetPosition ();
+          double dx = p.x - position.x;
+          double dy = p.y - position.y;
+          if (std::sqrt (dx * dx + dy * dy) <= distance)
+            {
+              m_found++;
+              // the models with an odd index hold two items
+              NS_TEST_ASSERT_MSG_EQ (std::binary_search (items.begin () + 1, items.end (), 2 * i), true,
+                                     "model " << i << " at " << p << " not found near " << position);
+              if (i % 2)
+                {
+                  NS_TEST_ASSERT_MSG_EQ (std::binary_search (items.begin () + 1, items.end (), 2 * i + 1), true,
+                                         "second item of model " << i << " not found");
+                }
+            }
+        }
+    }
+}
+
+void
+MobilityGridLookupTestCase::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+  m_grid.SetCellSize (50);
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      Ptr<MobilityModel> model;
+      switch (i % 3)
+        {
+        case 0:
+          model = CreateObject<ConstantPositionMobilityModel> ();
+          break;
+        case 1:
+          {
+            Ptr<ConstantVelocityMobilityModel> velocity = CreateObject<ConstantVelocityMobilityModel> ();
+            velocity->SetVelocity (Vector (m_random->GetValue (-20, 20), m_random->GetValue (-20, 20), 0));
+            model = velocity;
+          }
+          break;
+        case 2:
+          model = CreateObject<RandomWalk2dMobilityModel> ();
+          model->SetAttribute ("Bounds", RectangleValue (Rectangle (0, 1000, 0, 1000)));
+          model->SetAttribute ("Time", TimeValue (Seconds (2)));
+          break;
+        }
+      model->SetPosition (Vector (m_random->GetValue (0, 1000), m_random->GetValue (0, 1000), 0));
+      model->Initialize ();
+      m_models.push_back (model);
+      m_grid.Add (2 * i, model);
+      if (i % 2)
+        {
+          m_grid.Add (2 * i + 1, model);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_grid.GetNItems (), 450, "wrong number of items");
+
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      Simulator::Schedule (Seconds (0.37 * i), &MobilityGridLookupTestCase::Check, this);
+    }
+  // a model stops, and another one starts moving
+  Simulator::Schedule (Seconds (3.1), &MobilityModel::SetPosition, m_models[1], Vector (500, 500, 0));
+  Simulator::Schedule (Seconds (3.1), &ConstantVelocityMobilityModel::SetVelocity,
+                       DynamicCast<ConstantVelocityMobilityModel> (m_models[1]), Vector (0, 0, 0));
+  Simulator::Schedule (Seconds (5.3), &ConstantVelocityMobilityModel::SetVelocity,
+                       DynamicCast<ConstantVelocityMobilityModel> (m_models[4]), Vector (30, 30, 0));
+  Simulator::Stop (Seconds (20));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_GT (m_found, 1000, "too few models near the positions looked up");
+
+  std::vector<uint32_t> items;
+  m_grid.Lookup (Vector (0, 0, 0), std::numeric_limits<double>::infinity (), items);
+  NS_TEST_EXPECT_MSG_EQ (items.size (), 450, "an infinite distance does not return all the items");
+  m_grid.Clear ();
+  Simulator::Destroy ();
+  m_models.clear ();
+}
+
+static class MobilityGridTestSuite : public TestSuite
+{
+public:
+  MobilityGridTestSuite ()
+    : TestSuite ("mobility-grid", UNIT)
+  {
+    AddTestCase (new MobilityGridLookupTestCase (), TestCase::QUICK);
+  }
+} g_mobilityGridTestSuite;
@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * SimpleMultithreaded builds a ring of point-to-point links:
+ *
+ *   n0 --- n1 --- n2 --- ... --- n(N-1)
+ *    \_____________________________/
+ *
+ * Every node sends a few packets to its right neighbor at the start of
+ * the simulation, and every node forwards the packets it receives to
+ * its other neighbor, so the packets travel around the ring until the
+ * end of the simulation.
+ *
+ * With --threads, the ring is split into one segment per thread and run
+ * by the MultithreadedSimulatorImpl; with --threads=1 it runs on the
+ * DefaultSimulatorImpl. The program reports the wall clock time of the
+ * simulation, which should go down as the number of threads goes up:
+ *
+ *   ./waf --run "simple-multithreaded --nodes=10000 --threads=1"
+ *   ./waf --run "simple-multithreaded --nodes=10000 --threads=0"
+ *
+ * ns-3 must be configured with --enable-mt-simulator to use more than
+ * one thread.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/multithreaded-simulator-impl.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("SimpleMultithreaded");
+
+// Number of packets received by each node: each entry is only written by
+// the thread which executes the events of the node.
+static std::vector<uint64_t> g_received;
+
+static bool
+Forward (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  Ptr<Node> node = device->GetNode ();
+  g_received[node->GetId ()]++;
+  Ptr<NetDevice> other = node->GetDevice (0) == device ? node->GetDevice (1) : node->GetDevice (0);
+  other->Send (packet->Copy (), other->GetBroadcast (), protocol);
+  return true;
+}
+
+static void
+Start (Ptr<NetDevice> device, uint32_t packets, uint32_t size)
+{
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      device->Send (Create<Packet> (size), device->GetBroadcast (), 0x0800);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nodes = 10000;
+  uint32_t threads = 0;
+  uint32_t packets = 10;
+  uint32_t size = 1000;
+  double stop = 1.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Number of nodes in the ring", nodes);
+  cmd.AddValue ("threads", "Number of threads, or zero for one thread per processor", threads);
+  cmd.AddValue ("packets", "Number of packets sent by each node", packets);
+  cmd.AddValue ("size", "Size of the packets", size);
+  cmd.AddValue ("stop", "Simulation time, in seconds", stop);
+  cmd.Parse (argc, argv);
+
+  if (threads != 1)
+    {
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue ("ns3::MultithreadedSimulatorImpl"));
+      Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (threads));
+    }
+
+  NodeContainer ring;
+  ring.Create (nodes);
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      p2p.Install (ring.Get (i), ring.Get ((i + 1) % nodes));
+    }
+
+  g_received.resize (nodes, 0);
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      Ptr<Node> node = ring.Get (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); j++)
+        {
+          node->GetDevice (j)->SetReceiveCallback (MakeCallback (&Forward));
+        }
+      // the first device of each node is linked to its right neighbor
+      Simulator::ScheduleWithContext (i, Seconds (0), &Start, node->GetDevice (0), packets, size);
+    }
+
+  Simulator::Stop (Seconds (stop));
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t elapsed = clock.End ();
+
+  uint64_t received = 0;
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      received += g_received[i];
+    }
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  std::cout << "threads=" << (impl != 0 ? impl->GetThreadCount () : 1)
+            << " received=" << received
+            << " wallclock=" << elapsed << "ms";
+  if (impl != 0)
+    {
+      std::cout << " lookahead=" << impl->GetLookAhead ().GetSeconds () << "s";
+    }
+  std::cout << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,832 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/core-config.h"
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <set>
+#include <unistd.h>
+#include <sched.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+namespace {
+/* Timestamp of the events which never expire. */
+const uint64_t INFINITE_TS = 0x7fffffffffffffffULL;
+/* Context of the events which do not belong to any node. */
+const uint32_t NO_CONTEXT = 0xffffffff;
+/* Number of times a thread checks the barrier before it yields. */
+const uint32_t BARRIER_SPINS = 1000;
+
+uint32_t
+FindGroup (std::vector<uint32_t> &group, uint32_t id)
+{
+  while (group[id] != id)
+    {
+      group[id] = group[group[id]];
+      id = group[id];
+    }
+  return id;
+}
+} // anonymous namespace
+
+__thread MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::m_current = 0;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("ThreadCount",
+                   "The number of threads which execute the simulation, "
+                   "or zero to use one thread per online processor.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_threadCount),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+#ifndef NS3_MT_SIMULATOR
+  NS_FATAL_ERROR ("Can't use the multithreaded simulator without --enable-mt-simulator");
+#endif
+  m_global = new Partition ();
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  m_global->uid = 4;
+  m_global->currentUid = 0;
+  m_global->currentTs = 0;
+  m_global->currentContext = NO_CONTEXT;
+  m_global->nextTs = INFINITE_TS;
+  m_externalEmpty = true;
+  m_threadCount = 0;
+  m_lookAhead = INFINITE_TS;
+  m_windowEnd = 0;
+  m_running = false;
+  m_done = false;
+  m_stop = false;
+  m_nextWorker = 0;
+  m_barrierCount = 0;
+  m_barrierGeneration = 0;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_partitions.push_back (m_global);
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      Partition *partition = *i;
+      while (!partition->events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      for (uint32_t j = 0; j < partition->outbox.size (); j++)
+        {
+          for (uint32_t k = 0; k < partition->outbox[j].size (); k++)
+            {
+              partition->outbox[j][k].event->Unref ();
+            }
+        }
+      delete partition;
+    }
+  m_partitions.clear ();
+  m_global = 0;
+  for (std::list<Message>::iterator i = m_external.begin (); i != m_external.end (); i++)
+    {
+      i->event->Unref ();
+    }
+  m_external.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT (!m_running);
+  m_schedulerFactory = schedulerFactory;
+  std::vector<Partition *> partitions = m_partitions;
+  partitions.push_back (m_global);
+  for (std::vector<Partition *>::iterator i = partitions.begin (); i != partitions.end (); i++)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      Partition *partition = *i;
+      if (partition->events != 0)
+        {
+          while (!partition->events->IsEmpty ())
+            {
+              scheduler->Insert (partition->events->RemoveNext ());
+            }
+        }
+      partition->events = scheduler;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::CreatePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_partitions.empty ());
+  if (m_threadCount == 0)
+    {
+      long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+      m_threadCount = cpus > 0 ? cpus : 1;
+    }
+  for (uint32_t i = 0; i < m_threadCount; i++)
+    {
+      Partition *partition = new Partition ();
+      partition->index = i;
+      partition->events = m_schedulerFactory.Create<Scheduler> ();
+      partition->uid = m_global->uid;
+      partition->currentUid = 0;
+      partition->currentTs = m_global->currentTs;
+      partition->currentContext = NO_CONTEXT;
+      partition->nextTs = INFINITE_TS;
+      partition->outbox.resize (m_threadCount + 1);
+      m_partitions.push_back (partition);
+    }
+  m_global->index = m_threadCount;
+
+  // The nodes which share a channel other than a point-to-point channel
+  // can interact without delay: they belong to the same group.
+  NodeContainer nodes = NodeContainer::GetGlobal ();
+  uint32_t n = nodes.GetN ();
+  std::vector<uint32_t> group (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      group[i] = i;
+    }
+  std::set<uint32_t> channels;
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      for (uint32_t j = 0; j < (*i)->GetNDevices (); ++j)
+        {
+          Ptr<NetDevice> device = (*i)->GetDevice (j);
+          Ptr<Channel> channel = device->GetChannel ();
+          if (device->IsPointToPoint () || channel == 0
+              || !channels.insert (channel->GetId ()).second)
+            {
+              continue;
+            }
+          uint32_t first = FindGroup (group, (*i)->GetId ());
+          for (uint32_t k = 0; k < channel->GetNDevices (); k++)
+            {
+              uint32_t other = FindGroup (group, channel->GetDevice (k)->GetNode ()->GetId ());
+              group[other] = first;
+            }
+        }
+    }
+  std::vector<uint32_t> size (n, 0);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      size[FindGroup (group, i)]++;
+    }
+
+  // Assign the groups to partitions in the order of the node ids, such
+  // that the partitions hold about the same number of nodes: nodes
+  // created together are likely to be close to each other.
+  const uint32_t unassigned = 0xffffffff;
+  std::vector<uint32_t> partitionOfGroup (n, unassigned);
+  m_partitionOf.resize (n);
+  uint32_t current = 0;
+  uint32_t assigned = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t root = FindGroup (group, i);
+      if (partitionOfGroup[root] == unassigned)
+        {
+          while (current + 1 < m_threadCount
+                 && assigned >= static_cast<uint64_t> (current + 1) * n / m_threadCount)
+            {
+              current++;
+            }
+          partitionOfGroup[root] = current;
+          assigned += size[root];
+        }
+      m_partitionOf[i] = partitionOfGroup[root];
+    }
+
+  // Move the events scheduled so far to their partition.
+  Ptr<Scheduler> events = m_global->events;
+  m_global->events = m_schedulerFactory.Create<Scheduler> ();
+  while (!events->IsEmpty ())
+    {
+      Scheduler::Event ev = events->RemoveNext ();
+      GetEventPartition (ev.key.m_context)->events->Insert (ev);
+    }
+  NS_LOG_INFO (n << " nodes assigned to " << m_threadCount << " partitions");
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookAhead (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_lookAhead = INFINITE_TS;
+  NodeContainer nodes = NodeContainer::GetGlobal ();
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      uint32_t local = GetPartition ((*i)->GetId ());
+      for (uint32_t j = 0; j < (*i)->GetNDevices (); ++j)
+        {
+          Ptr<NetDevice> device = (*i)->GetDevice (j);
+          Ptr<Channel> channel = device->GetChannel ();
+          if (!device->IsPointToPoint () || channel == 0 || channel->GetNDevices () != 2)
+            {
+              continue;
+            }
+          Ptr<NetDevice> remote = channel->GetDevice (0) == device ? channel->GetDevice (1) : channel->GetDevice (0);
+          if (GetPartition (remote->GetNode ()->GetId ()) == local)
+            {
+              continue;
+            }
+          TimeValue delay;
+          if (!channel->GetAttributeFailSafe ("Delay", delay))
+            {
+              NS_FATAL_ERROR ("Channel " << channel->GetInstanceTypeId ().GetName ()
+                              << " between partitions has no Delay attribute");
+            }
+          uint64_t ts = delay.Get ().GetTimeStep ();
+          if (ts == 0)
+            {
+              NS_FATAL_ERROR ("Point-to-point channel between nodes " << (*i)->GetId ()
+                              << " and " << remote->GetNode ()->GetId ()
+                              << " crosses partitions but has no delay");
+            }
+          if (ts < m_lookAhead)
+            {
+              m_lookAhead = ts;
+            }
+        }
+    }
+  NS_LOG_INFO ("lookahead=" << TimeStep (m_lookAhead));
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetThreadCount (void) const
+{
+  return m_partitions.empty () ? m_threadCount : m_partitions.size ();
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  return GetEventPartition (context)->index;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  return TimeStep (m_lookAhead);
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrentPartition (void) const
+{
+  return m_current != 0 ? m_current : m_global;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetEventPartition (uint32_t context) const
+{
+  if (context == NO_CONTEXT || m_partitions.empty ())
+    {
+      return m_global;
+    }
+  if (context < m_partitionOf.size ())
+    {
+      return m_partitions[m_partitionOf[context]];
+    }
+  // nodes created after the first call to Run
+  return m_partitions[context % m_partitions.size ()];
+}
+
+bool
+MultithreadedSimulatorImpl::IsConcurrent (Partition *partition) const
+{
+  return m_running && m_current != 0 && m_current != m_global
+         && partition != m_current && partition != m_global;
+}
+
+void
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = partition->uid;
+  partition->uid++;
+  partition->events->Insert (ev);
+}
+
+void
+MultithreadedSimulatorImpl::Barrier (void)
+{
+  uint32_t generation = m_barrierGeneration;
+  if (__sync_add_and_fetch (&m_barrierCount, 1) == m_partitions.size ())
+    {
+      m_barrierCount = 0;
+      __sync_fetch_and_add (&m_barrierGeneration, 1);
+      return;
+    }
+  for (uint32_t spins = 0; m_barrierGeneration == generation; spins++)
+    {
+      if (spins >= BARRIER_SPINS)
+        {
+          sched_yield ();
+        }
+    }
+  __sync_synchronize ();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition *partition)
+{
+  Scheduler::Event next = partition->events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->currentTs);
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  partition->currentTs = next.key.m_ts;
+  partition->currentContext = next.key.m_context;
+  partition->currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow (Partition *partition, uint64_t end)
+{
+  while (!partition->events->IsEmpty () && !m_stop)
+    {
+      if (partition->events->PeekNext ().key.m_ts >= end)
+        {
+          break;
+        }
+      ProcessOneEvent (partition);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Deliver (uint32_t index)
+{
+  Partition *partition = index < m_partitions.size () ? m_partitions[index] : m_global;
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      std::vector<Message> &inbox = m_partitions[i]->outbox[index];
+      for (std::vector<Message>::const_iterator j = inbox.begin (); j != inbox.end (); j++)
+        {
+          if (j->cancel)
+            {
+              j->event->Cancel ();
+              j->event->Unref ();
+              continue;
+            }
+          Insert (partition, j->ts, j->context, j->event);
+        }
+      inbox.clear ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::ComputeWindow (void)
+{
+  Deliver (m_global->index);
+  if (!m_externalEmpty)
+    {
+      std::list<Message> external;
+      {
+        CriticalSection cs (m_externalMutex);
+        m_external.swap (external);
+        m_externalEmpty = true;
+      }
+      for (std::list<Message>::const_iterator i = external.begin (); i != external.end (); i++)
+        {
+          Partition *partition = GetEventPartition (i->context);
+          Insert (partition, m_windowEnd + i->ts, i->context, i->event);
+          partition->nextTs = std::min (partition->nextTs, m_windowEnd + i->ts);
+        }
+    }
+  while (!m_stop)
+    {
+      uint64_t lbts = INFINITE_TS;
+      for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+        {
+          lbts = std::min (lbts, (*i)->nextTs);
+        }
+      uint64_t next = INFINITE_TS;
+      if (!m_global->events->IsEmpty ())
+        {
+          next = m_global->events->PeekNext ().key.m_ts;
+        }
+      if (lbts == INFINITE_TS && next == INFINITE_TS)
+        {
+          return false;
+        }
+      if (next > lbts)
+        {
+          // Conservative window: no event executed before its end can
+          // schedule an event for another partition within it.
+          m_windowEnd = m_lookAhead >= INFINITE_TS - lbts ? INFINITE_TS : lbts + m_lookAhead;
+          m_windowEnd = std::min (m_windowEnd, next);
+          return true;
+        }
+      // All the partitions are done with the events before this one:
+      // run it alone, then refresh the partitions it may have modified.
+      m_windowEnd = next;
+      ProcessOneEvent (m_global);
+      for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+        {
+          Partition *partition = *i;
+          partition->nextTs = partition->events->IsEmpty () ? INFINITE_TS : partition->events->PeekNext ().key.m_ts;
+        }
+    }
+  return false;
+}
+
+void
+MultithreadedSimulatorImpl::Loop (uint32_t index)
+{
+  Partition *partition = m_partitions[index];
+  m_current = partition;
+  while (true)
+    {
+      Deliver (index);
+      partition->nextTs = partition->events->IsEmpty () ? INFINITE_TS : partition->events->PeekNext ().key.m_ts;
+      Barrier ();
+      if (index == 0)
+        {
+          // the other threads wait at the barrier while the main thread
+          // handles the events without context.
+          m_current = m_global;
+          m_done = !ComputeWindow ();
+          m_current = partition;
+        }
+      Barrier ();
+      if (m_done)
+        {
+          break;
+        }
+      ProcessWindow (partition, m_windowEnd);
+      Barrier ();
+    }
+  m_current = 0;
+}
+
+void
+MultithreadedSimulatorImpl::DoWorker (void)
+{
+  Loop (__sync_add_and_fetch (&m_nextWorker, 1));
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_partitions.empty ())
+    {
+      CreatePartitions ();
+    }
+  CalculateLookAhead ();
+  m_stop = false;
+  m_done = false;
+  m_windowEnd = m_global->currentTs;
+  m_nextWorker = 0;
+  m_running = true;
+  for (uint32_t i = 1; i < m_partitions.size (); i++)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::DoWorker, this));
+      thread->Start ();
+      m_threads.push_back (thread);
+    }
+  Loop (0);
+  for (std::vector<Ptr<SystemThread> >::iterator i = m_threads.begin (); i != m_threads.end (); i++)
+    {
+      (*i)->Join ();
+    }
+  m_threads.clear ();
+  m_running = false;
+  // the simulation time seen from the main program is the time of the
+  // last event executed by any partition.
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      m_global->currentTs = std::max (m_global->currentTs, (*i)->currentTs);
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      if (!(*i)->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return m_global->events->IsEmpty ();
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &time)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep ());
+  Simulator::Schedule (time, &Simulator::Stop);
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep () << event);
+  NS_ASSERT_MSG (!m_running || m_current != 0, "Simulator::Schedule Thread-unsafe invocation!");
+  NS_ASSERT (time.IsPositive ());
+  Partition *partition = GetCurrentPartition ();
+  uint64_t ts = partition->currentTs + time.GetTimeStep ();
+  Insert (partition, ts, partition->currentContext, event);
+  return EventId (event, ts, partition->currentContext, partition->uid - 1);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << time.GetTimeStep () << event);
+  NS_ASSERT (time.IsPositive ());
+  if (m_running && m_current == 0)
+    {
+      // called by a thread which does not execute events
+      Message message;
+      message.ts = time.GetTimeStep ();
+      message.context = context;
+      message.event = event;
+      message.cancel = false;
+      CriticalSection cs (m_externalMutex);
+      m_external.push_back (message);
+      m_externalEmpty = false;
+      return;
+    }
+  Partition *current = GetCurrentPartition ();
+  Partition *partition = GetEventPartition (context);
+  uint64_t ts = current->currentTs + time.GetTimeStep ();
+  if (partition == current || current == m_global)
+    {
+      // the other threads do not run when the events without context do
+      Insert (partition, ts, context, event);
+      return;
+    }
+  if (ts < m_windowEnd)
+    {
+      NS_FATAL_ERROR ("Event scheduled at " << TimeStep (ts) << " by node " << current->currentContext
+                      << " for node " << context << " in another partition before the end of the window at "
+                      << TimeStep (m_windowEnd) << ": only point-to-point channels may cross partitions");
+    }
+  Message message;
+  message.ts = ts;
+  message.context = context;
+  message.event = event;
+  message.cancel = false;
+  current->outbox[partition->index].push_back (message);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+  EventId id (Ptr<EventImpl> (event, false), GetCurrentPartition ()->currentTs, NO_CONTEXT, 2);
+  CriticalSection cs (m_destroyEventsMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  return TimeStep (GetCurrentPartition ()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrentPartition ()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = GetEventPartition (id.GetContext ());
+  NS_ASSERT_MSG (partition == GetCurrentPartition () || GetCurrentPartition () == m_global,
+                 "Events can only be removed by the thread which executes them");
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = GetEventPartition (id.GetContext ());
+  if (id.GetUid () != 2 && IsConcurrent (partition))
+    {
+      // IsExpired checked that the other partition does not execute
+      // the event before the next barrier.
+      Message message;
+      message.ts = id.GetTs ();
+      message.context = id.GetContext ();
+      message.event = id.PeekEventImpl ();
+      message.cancel = true;
+      message.event->Ref ();
+      m_current->outbox[partition->index].push_back (message);
+      return;
+    }
+  id.PeekEventImpl ()->Cancel ();
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0
+          || id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  // The partition of the event holds the time up to which its events
+  // were executed.
+  Partition *partition = GetEventPartition (id.GetContext ());
+  if (IsConcurrent (partition) && partition->nextTs < m_windowEnd
+      && id.PeekEventImpl () != 0)
+    {
+      // The other thread updates currentTs while it executes the window:
+      // only the events outside of the window have a known state.
+      if (id.GetTs () < partition->nextTs)
+        {
+          return true;
+        }
+      if (id.GetTs () < m_windowEnd)
+        {
+          NS_FATAL_ERROR ("Event of node " << id.GetContext () << " at " << TimeStep (id.GetTs ())
+                          << " inspected by node " << m_current->currentContext
+                          << " in another partition before the end of the window at "
+                          << TimeStep (m_windowEnd));
+        }
+      return id.PeekEventImpl ()->IsCancelled ();
+    }
+  if (id.PeekEventImpl () == 0
+      || id.GetTs () < partition->currentTs
+      || (id.GetTs () == partition->currentTs
+          && id.GetUid () <= partition->currentUid)
+      || id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (INFINITE_TS);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrentPartition ()->currentContext;
+}
+
+} // namespace ns3
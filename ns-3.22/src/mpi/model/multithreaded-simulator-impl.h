@@ -0,0 +1,209 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/ptr.h"
+
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \ingroup mpi
+ *
+ * \brief Conservative parallel simulator implementation running on
+ * the threads of a single process.
+ *
+ * The nodes are split into as many partitions as there are threads,
+ * and each thread executes the events of its partition, identified by
+ * the context of the events. Nodes linked by channels which are not
+ * point-to-point channels always share the same partition, and the
+ * smallest delay of the point-to-point channels which cross partitions
+ * is used as lookahead: the threads execute in parallel all the events
+ * in windows of simulation time which are that long, and synchronize
+ * with a barrier between two windows.
+ *
+ * The events scheduled for another partition during a window are
+ * appended to a vector of the sending partition, one per destination,
+ * which only the sending thread touches during the window and only the
+ * destination thread reads after the next barrier: they are handed over
+ * without any locking. Events and the packets they hold are not copied.
+ *
+ * A thread may not inspect or cancel during a window the events another
+ * partition may execute in that same window. IsExpired and Cancel only
+ * look at the time up to which the other partition had executed its
+ * events when the window started, and cancellations are delivered to the
+ * partition of the event at the next barrier.
+ *
+ * Events without context, that is, the events scheduled from the main
+ * program, are executed by the main thread alone while all the other
+ * threads wait.
+ *
+ * This implementation requires that ns-3 be configured with
+ * --enable-mt-simulator, which makes reference counting and the packet
+ * allocators safe to use from several threads.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &time);
+  virtual EventId Schedule (Time const &time, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \returns the number of threads which execute the simulation.
+   */
+  uint32_t GetThreadCount (void) const;
+  /**
+   * \param context the context of some events.
+   * \returns the index of the partition which executes these events.
+   */
+  uint32_t GetPartition (uint32_t context) const;
+  /**
+   * \returns the lookahead computed at the start of the last call to Run.
+   */
+  Time GetLookAhead (void) const;
+
+private:
+  /**
+   * An event scheduled for another partition during a window.
+   */
+  struct Message
+  {
+    uint64_t ts;
+    uint32_t context;
+    EventImpl *event;
+    // if true, the event is cancelled instead of inserted
+    bool cancel;
+  };
+
+  /**
+   * The events of a set of nodes, and the state of the thread which
+   * executes them.
+   */
+  struct Partition
+  {
+    uint32_t index;
+    Ptr<Scheduler> events;
+    uint32_t uid;
+    uint32_t currentUid;
+    uint64_t currentTs;
+    uint32_t currentContext;
+    // timestamp of the first event left after the last window: the
+    // other threads may read it during the window, unlike currentTs.
+    uint64_t nextTs;
+    // outbox[i] holds the events scheduled for partition i, and
+    // is only touched by the thread of partition i between windows.
+    std::vector<std::vector<Message> > outbox;
+  };
+
+  virtual void DoDispose (void);
+  /* Assign the nodes to partitions and move the events accordingly. */
+  void CreatePartitions (void);
+  void CalculateLookAhead (void);
+  /* Body of the worker threads. */
+  void DoWorker (void);
+  /* Main loop of the thread which executes partition index. */
+  void Loop (uint32_t index);
+  /* Compute the end of the next window, running the events without
+   * context which are due first. \returns false when the simulation
+   * is over. */
+  bool ComputeWindow (void);
+  /* Insert into partition index the events the other partitions
+   * scheduled for it during the last window. */
+  void Deliver (uint32_t index);
+  /* Execute the events of the partition which are due before the end
+   * of the window. */
+  void ProcessWindow (Partition *partition, uint64_t end);
+  void ProcessOneEvent (Partition *partition);
+  /* Wait until all the threads reach the barrier. */
+  void Barrier (void);
+  void Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event);
+  Partition *GetCurrentPartition (void) const;
+  Partition *GetEventPartition (uint32_t context) const;
+  /* \returns true if the calling thread executes a window and partition
+   * is executed by another thread at the same time. */
+  bool IsConcurrent (Partition *partition) const;
+
+  typedef std::list<EventId> DestroyEvents;
+  DestroyEvents m_destroyEvents;
+  mutable SystemMutex m_destroyEventsMutex;
+
+  // events scheduled by other threads during Run; Message::ts is
+  // the delay of the event.
+  std::list<Message> m_external;
+  SystemMutex m_externalMutex;
+  volatile bool m_externalEmpty;
+
+  ObjectFactory m_schedulerFactory;
+  // one partition per thread, created by the first call to Run
+  std::vector<Partition *> m_partitions;
+  // the events without context, and the events scheduled before the
+  // partitions are created
+  Partition *m_global;
+  std::vector<uint32_t> m_partitionOf;
+  uint32_t m_threadCount;
+  uint64_t m_lookAhead;
+  uint64_t m_windowEnd;
+  bool m_running;
+  bool m_done;
+  volatile bool m_stop;
+
+  std::vector<Ptr<SystemThread> > m_threads;
+  uint32_t m_nextWorker;
+  volatile uint32_t m_barrierCount;
+  volatile uint32_t m_barrierGeneration;
+
+  /* The partition of the calling thread, if it is executing events. */
+  static __thread Partition *m_current;
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
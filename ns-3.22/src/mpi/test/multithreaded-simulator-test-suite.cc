@@ -0,0 +1,210 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/core-config.h"
+#include "ns3/simulator.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/error-model.h"
+#include "ns3/nstime.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * A SimpleNetDevice which the MultithreadedSimulatorImpl may place in
+ * another partition than its peer, the delay of its SimpleChannel being
+ * the lookahead.
+ */
+class PointToPointSimpleNetDevice : public SimpleNetDevice
+{
+public:
+  virtual bool IsPointToPoint (void) const
+  {
+    return true;
+  }
+};
+
+} // anonymous namespace
+
+/**
+ * Run a ring of nodes which keep scheduling events for their neighbors
+ * on the DefaultSimulatorImpl and on the MultithreadedSimulatorImpl, and
+ * check that every node executes the same events at the same times.
+ */
+class MultithreadedSimulatorOrderTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorOrderTestCase (uint32_t threads);
+  virtual void DoRun (void);
+
+private:
+  // (timestamp, tag) of the events executed by each node
+  typedef std::vector<std::vector<std::pair<int64_t, uint32_t> > > Log;
+
+  void Run (Ptr<SimulatorImpl> impl, Log *log);
+  void Hop (uint32_t node, uint32_t hop);
+  void Local (uint32_t node, uint32_t hop);
+  void Global (void);
+
+  uint32_t m_threads;
+  uint32_t m_nodes;
+  uint32_t m_hops;
+  Log *m_log;
+  std::vector<int64_t> m_global;
+};
+
+MultithreadedSimulatorOrderTestCase::MultithreadedSimulatorOrderTestCase (uint32_t threads)
+  : TestCase ("Check that the MultithreadedSimulatorImpl executes the events of a cross-partition "
+              "workload like the DefaultSimulatorImpl"),
+    m_threads (threads),
+    m_nodes (8),
+    m_hops (40),
+    m_log (0)
+{
+}
+
+void
+MultithreadedSimulatorOrderTestCase::Hop (uint32_t node, uint32_t hop)
+{
+  NS_ASSERT (Simulator::GetContext () == node);
+  (*m_log)[node].push_back (std::make_pair (Simulator::Now ().GetTimeStep (), hop));
+  Simulator::Schedule (MicroSeconds (1 + (hop * 13) % 97), &MultithreadedSimulatorOrderTestCase::Local,
+                       this, node, hop);
+  if (hop < m_hops)
+    {
+      // Not shorter than the delay of the channels.
+      uint32_t next = (node + 1) % m_nodes;
+      Time delay = MilliSeconds (1) + MicroSeconds ((node * 37 + hop * 11) % 200);
+      Simulator::ScheduleWithContext (next, delay, &MultithreadedSimulatorOrderTestCase::Hop,
+                                      this, next, hop + 1);
+    }
+}
+
+void
+MultithreadedSimulatorOrderTestCase::Local (uint32_t node, uint32_t hop)
+{
+  (*m_log)[node].push_back (std::make_pair (Simulator::Now ().GetTimeStep (), 1000 + hop));
+}
+
+void
+MultithreadedSimulatorOrderTestCase::Global (void)
+{
+  m_global.push_back (Simulator::Now ().GetTimeStep ());
+  // a second chain, started from an event without context
+  Simulator::ScheduleWithContext (m_nodes / 2, MicroSeconds (3), &MultithreadedSimulatorOrderTestCase::Hop,
+                                  this, m_nodes / 2, m_hops / 2);
+}
+
+void
+MultithreadedSimulatorOrderTestCase::Run (Ptr<SimulatorImpl> impl, Log *log)
+{
+  Simulator::SetImplementation (impl);
+  m_log = log;
+  m_log->resize (m_nodes);
+  m_global.clear ();
+
+  NodeContainer nodes;
+  nodes.Create (m_nodes);
+  for (uint32_t i = 0; i < m_nodes; i++)
+    {
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MilliSeconds (1)));
+      for (uint32_t j = i; j <= i + 1; j++)
+        {
+          Ptr<PointToPointSimpleNetDevice> device = CreateObject<PointToPointSimpleNetDevice> ();
+          device->SetChannel (channel);
+          nodes.Get (j % m_nodes)->AddDevice (device);
+        }
+    }
+
+  for (uint32_t i = 0; i < m_nodes; i++)
+    {
+      Simulator::ScheduleWithContext (i, MicroSeconds (i * 3), &MultithreadedSimulatorOrderTestCase::Hop,
+                                      this, i, 0);
+    }
+  Simulator::Schedule (MicroSeconds (5500), &MultithreadedSimulatorOrderTestCase::Global, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+MultithreadedSimulatorOrderTestCase::DoRun (void)
+{
+  Simulator::Destroy ();
+
+  Log expected;
+  Run (CreateObject<DefaultSimulatorImpl> (), &expected);
+  std::vector<int64_t> expectedGlobal = m_global;
+
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  impl->SetAttribute ("ThreadCount", UintegerValue (m_threads));
+  Log log;
+  Run (impl, &log);
+  NS_TEST_EXPECT_MSG_EQ (impl->GetThreadCount (), m_threads, "Wrong number of partitions");
+
+  NS_TEST_ASSERT_MSG_EQ (m_global.size (), expectedGlobal.size (), "Wrong number of events without context");
+  for (uint32_t i = 0; i < m_global.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_global[i], expectedGlobal[i], "Event without context executed at the wrong time");
+    }
+  for (uint32_t node = 0; node < m_nodes; node++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (log[node].size (), expected[node].size (), "Wrong number of events for node " << node);
+      for (uint32_t i = 1; i < log[node].size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_GT_OR_EQ (log[node][i].first, log[node][i - 1].first,
+                                       "Events of node " << node << " executed out of order");
+        }
+      // The order of the events with the same timestamp may differ
+      // between the two implementations.
+      std::sort (log[node].begin (), log[node].end ());
+      std::sort (expected[node].begin (), expected[node].end ());
+      for (uint32_t i = 0; i < log[node].size (); i++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (log[node][i].first, expected[node][i].first,
+                                 "Event of node " << node << " executed at the wrong time");
+          NS_TEST_EXPECT_MSG_EQ (log[node][i].second, expected[node][i].second,
+                                 "Wrong event executed by node " << node);
+        }
+    }
+}
+
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ()
+    : TestSuite ("multithreaded-simulator", UNIT)
+  {
+#ifdef NS3_MT_SIMULATOR
+    AddTestCase (new MultithreadedSimulatorOrderTestCase (1), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorOrderTestCase (4), TestCase::QUICK);
+#endif
+  }
+} g_multithreadedSimulatorTestSuite;
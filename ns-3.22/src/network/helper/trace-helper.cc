@@ -28,6 +28,8 @@
 #include "ns3/names.h"
 #include "ns3/net-device.h"
 #include "ns3/pcap-file-wrapper.h"
+#include "ns3/pointer.h"
+#include "ns3/queue.h"
 
 #include "trace-helper.h"
 
@@ -390,6 +392,113 @@ AsciiTraceHelper::DefaultReceiveSinkWithContext (Ptr<OutputStreamWrapper> stream
   *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << std::endl;
 }
 
+BinaryTraceHelper::BinaryTraceHelper ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+BinaryTraceHelper::~BinaryTraceHelper ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+Ptr<BinaryTraceFile>
+BinaryTraceHelper::CreateFile (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+
+  Ptr<BinaryTraceFile> file = CreateObject<BinaryTraceFile> ();
+  file->Open (filename, std::ios::out);
+  NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename << " for binary trace output");
+  return file;
+}
+
+void
+BinaryTraceHelper::EnableBinary (Ptr<BinaryTraceFile> file, Ptr<NetDevice> nd)
+{
+  NS_LOG_FUNCTION (file << nd);
+
+  // the layout of the packets is recorded from their metadata
+  Packet::EnablePrinting ();
+
+  uint32_t node = nd->GetNode ()->GetId ();
+  uint32_t device = nd->GetIfIndex ();
+  nd->TraceConnectWithoutContext ("MacRx", MakeBoundCallback (&DefaultReceiveSink, file, node, device));
+  nd->TraceConnectWithoutContext ("PhyRxDrop", MakeBoundCallback (&DefaultDropSink, file, node, device));
+
+  struct TypeId::AttributeInformation info;
+  if (nd->GetInstanceTypeId ().LookupAttributeByName ("TxQueue", &info))
+    {
+      PointerValue ptr;
+      nd->GetAttribute ("TxQueue", ptr);
+      Ptr<Queue> queue = ptr.Get<Queue> ();
+      if (queue != 0)
+        {
+          queue->TraceConnectWithoutContext ("Enqueue", MakeBoundCallback (&DefaultEnqueueSink, file, node, device));
+          queue->TraceConnectWithoutContext ("Drop", MakeBoundCallback (&DefaultDropSink, file, node, device));
+          queue->TraceConnectWithoutContext ("Dequeue", MakeBoundCallback (&DefaultDequeueSink, file, node, device));
+        }
+    }
+}
+
+void
+BinaryTraceHelper::EnableBinary (Ptr<BinaryTraceFile> file, NetDeviceContainer d)
+{
+  for (NetDeviceContainer::Iterator i = d.Begin (); i != d.End (); ++i)
+    {
+      EnableBinary (file, *i);
+    }
+}
+
+void
+BinaryTraceHelper::EnableBinary (Ptr<BinaryTraceFile> file, NodeContainer n)
+{
+  NetDeviceContainer devs;
+  for (NodeContainer::Iterator i = n.Begin (); i != n.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          devs.Add (node->GetDevice (j));
+        }
+    }
+  EnableBinary (file, devs);
+}
+
+void
+BinaryTraceHelper::EnableBinaryAll (Ptr<BinaryTraceFile> file)
+{
+  EnableBinary (file, NodeContainer::GetGlobal ());
+}
+
+void
+BinaryTraceHelper::DefaultEnqueueSink (Ptr<BinaryTraceFile> file, uint32_t node, uint32_t device, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (file << node << device << p);
+  file->Write (BinaryTraceFile::ENQUEUE, node, device, p);
+}
+
+void
+BinaryTraceHelper::DefaultDropSink (Ptr<BinaryTraceFile> file, uint32_t node, uint32_t device, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (file << node << device << p);
+  file->Write (BinaryTraceFile::DROP, node, device, p);
+}
+
+void
+BinaryTraceHelper::DefaultDequeueSink (Ptr<BinaryTraceFile> file, uint32_t node, uint32_t device, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (file << node << device << p);
+  file->Write (BinaryTraceFile::DEQUEUE, node, device, p);
+}
+
+void
+BinaryTraceHelper::DefaultReceiveSink (Ptr<BinaryTraceFile> file, uint32_t node, uint32_t device, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (file << node << device << p);
+  file->Write (BinaryTraceFile::RECEIVE, node, device, p);
+}
+
 void 
 PcapHelperForDevice::EnablePcap (std::string prefix, Ptr<NetDevice> nd, bool promiscuous, bool explicitFilename)
 {
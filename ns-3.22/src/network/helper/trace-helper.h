@@ -25,6 +25,7 @@
 #include "ns3/simulator.h"
 #include "ns3/pcap-file-wrapper.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/binary-trace-file.h"
 
 namespace ns3 {
 
@@ -525,6 +526,110 @@ AsciiTraceHelper::HookDefaultReceiveSinkWithContext (
                  << tracename << "\"");
 }
 
+/**
+ * \brief Manage binary trace files for net devices
+ *
+ * The binary traces record the events of the ascii traces of the devices
+ * (the "MacRx" and "PhyRxDrop" trace sources of the devices, and the
+ * "Enqueue", "Dequeue" and "Drop" trace sources of their "TxQueue") in a
+ * BinaryTraceFile, which the utils/decode-binary-trace program turns
+ * into ascii traces after the simulation.  The trace sources that a
+ * device does not have are ignored, so that any device can be traced.
+ */
+class BinaryTraceHelper
+{
+public:
+  /**
+   * @brief Create a binary trace helper.
+   */
+  BinaryTraceHelper ();
+
+  /**
+   * @brief Destroy a binary trace helper.
+   */
+  ~BinaryTraceHelper ();
+
+  /**
+   * @brief Create and open a binary trace file.
+   *
+   * @param filename the name of the file
+   * @returns a pointer to the BinaryTraceFile
+   */
+  Ptr<BinaryTraceFile> CreateFile (std::string filename);
+
+  /**
+   * @brief Record the events of a device in a binary trace file.
+   *
+   * @param file the file
+   * @param nd the device
+   */
+  void EnableBinary (Ptr<BinaryTraceFile> file, Ptr<NetDevice> nd);
+
+  /**
+   * @brief Record the events of the devices of a container in a binary trace file.
+   *
+   * @param file the file
+   * @param d the devices
+   */
+  void EnableBinary (Ptr<BinaryTraceFile> file, NetDeviceContainer d);
+
+  /**
+   * @brief Record the events of all the devices of the nodes of a container
+   * in a binary trace file.
+   *
+   * @param file the file
+   * @param n the nodes
+   */
+  void EnableBinary (Ptr<BinaryTraceFile> file, NodeContainer n);
+
+  /**
+   * @brief Record the events of all the devices in a binary trace file.
+   *
+   * @param file the file
+   */
+  void EnableBinaryAll (Ptr<BinaryTraceFile> file);
+
+  /**
+   * @brief Basic Enqueue default trace sink.
+   *
+   * @param file the output file
+   * @param node the id of the node of the device
+   * @param device the index of the device in its node
+   * @param p the packet
+   */
+  static void DefaultEnqueueSink (Ptr<BinaryTraceFile> file, uint32_t node, uint32_t device, Ptr<const Packet> p);
+
+  /**
+   * @brief Basic Drop default trace sink.
+   *
+   * @param file the output file
+   * @param node the id of the node of the device
+   * @param device the index of the device in its node
+   * @param p the packet
+   */
+  static void DefaultDropSink (Ptr<BinaryTraceFile> file, uint32_t node, uint32_t device, Ptr<const Packet> p);
+
+  /**
+   * @brief Basic Dequeue default trace sink.
+   *
+   * @param file the output file
+   * @param node the id of the node of the device
+   * @param device the index of the device in its node
+   * @param p the packet
+   */
+  static void DefaultDequeueSink (Ptr<BinaryTraceFile> file, uint32_t node, uint32_t device, Ptr<const Packet> p);
+
+  /**
+   * @brief Basic Receive default trace sink.
+   *
+   * @param file the output file
+   * @param node the id of the node of the device
+   * @param device the index of the device in its node
+   * @param p the packet
+   */
+  static void DefaultReceiveSink (Ptr<BinaryTraceFile> file, uint32_t node, uint32_t device, Ptr<const Packet> p);
+};
+
 /**
  * \brief Base class providing common user-level pcap operations for helpers
  * representing net devices.
@@ -20,6 +20,11 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/core-config.h"
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -51,47 +56,160 @@ NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
 uint32_t Buffer::g_recommendedStart = 0;
+
+namespace {
+
+/* The storage of the buffers is served from a few size classes which
+ * match common packet sizes. The last class holds the storage too
+ * large for the others: it is allocated on and released to the heap.
+ */
+const uint32_t g_sizeClassSize[] = { 64, 576, 1500, 9000, 0 };
+const uint32_t N_SIZE_CLASSES = sizeof (g_sizeClassSize) / sizeof (g_sizeClassSize[0]);
+const uint32_t HEAP_CLASS = N_SIZE_CLASSES - 1;
+
+/* The counters are shared by all threads: they are updated atomically
+ * only when the multithreaded simulator is enabled to keep the cost of
+ * the default build.
+ */
+#ifdef NS3_MT_SIMULATOR
+#define BUFFER_STAT_INC(x) __sync_add_and_fetch (&(x), 1)
+#define BUFFER_STAT_DEC(x) __sync_sub_and_fetch (&(x), 1)
+#else
+#define BUFFER_STAT_INC(x) (++(x))
+#define BUFFER_STAT_DEC(x) (--(x))
+#endif
+
+/**
+ * \ingroup packet
+ * \brief Usage counters of a size class.
+ */
+struct SizeClassCounters
+{
+  uint64_t allocated; //!< storage blocks allocated from the heap
+  uint64_t inUse;     //!< storage blocks used by buffers
+  uint64_t cached;    //!< storage blocks held by the thread caches
+  uint64_t highWater; //!< largest value of inUse
+} g_counters[N_SIZE_CLASSES]; //!< Usage counters of each size class
+
+uint32_t
+GetSizeClass (uint32_t size)
+{
+  for (uint32_t i = 0; i < HEAP_CLASS; i++)
+    {
+      if (size <= g_sizeClassSize[i])
+        {
+          return i;
+        }
+    }
+  return HEAP_CLASS;
+}
+
+void
+CountInUse (uint32_t sizeClass)
+{
+  struct SizeClassCounters &counters = g_counters[sizeClass];
+  uint64_t inUse = BUFFER_STAT_INC (counters.inUse);
+#ifdef NS3_MT_SIMULATOR
+  uint64_t highWater = counters.highWater;
+  while (inUse > highWater)
+    {
+      uint64_t old = __sync_val_compare_and_swap (&counters.highWater, highWater, inUse);
+      if (old == highWater)
+        {
+          break;
+        }
+      highWater = old;
+    }
+#else
+  if (inUse > counters.highWater)
+    {
+      counters.highWater = inUse;
+    }
+#endif
+}
+
 #ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
+/* Each thread caches up to this number of bytes of released storage
+ * for each size class.
  */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
+const uint32_t CACHE_BYTES = 2 * 1024 * 1024;
+
+/**
+ * \ingroup packet
+ * \brief Released buffer storage kept by a thread, for each size class.
+ */
+struct ThreadCache
+{
+  std::vector<uint8_t *> blocks[HEAP_CLASS]; //!< released storage of each class
+};
+
+/* The cache of each thread is created on its first use, and deleted
+ * when the thread exits or, for the main thread, when the static
+ * destructors of this compilation unit run. The caches are not
+ * re-created afterwards: buffers released late go back to the heap.
+ */
+__thread struct ThreadCache *t_cache = 0;
+bool g_destroyed = false;
+
+void
+DeleteThreadCache (void *p)
+{
+  struct ThreadCache *cache = static_cast<struct ThreadCache *> (p);
+  for (uint32_t i = 0; i < HEAP_CLASS; i++)
+    {
+      for (std::vector<uint8_t *>::iterator j = cache->blocks[i].begin ();
+           j != cache->blocks[i].end (); j++)
+        {
+          BUFFER_STAT_DEC (g_counters[i].cached);
+          delete [] *j;
+        }
+    }
+  delete cache;
+}
+
+#ifdef HAVE_PTHREAD_H
+pthread_key_t g_cacheKey;
+pthread_once_t g_cacheKeyOnce = PTHREAD_ONCE_INIT;
+
+void
+CreateCacheKey (void)
+{
+  pthread_key_create (&g_cacheKey, &DeleteThreadCache);
+}
+#endif /* HAVE_PTHREAD_H */
+
+struct ThreadCache *
+GetThreadCache (void)
+{
+  if (t_cache == 0)
+    {
+      t_cache = new ThreadCache ();
+#ifdef HAVE_PTHREAD_H
+      pthread_once (&g_cacheKeyOnce, &CreateCacheKey);
+      pthread_setspecific (g_cacheKey, t_cache);
+#endif
+    }
+  return t_cache;
+}
+#endif /* BUFFER_FREE_LIST */
+
+} // anonymous namespace
+
+#ifdef BUFFER_FREE_LIST
 struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
   NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
+  if (t_cache != 0)
     {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
+#ifdef HAVE_PTHREAD_H
+      pthread_setspecific (g_cacheKey, 0);
+#endif
+      DeleteThreadCache (t_cache);
+      t_cache = 0;
     }
+  g_destroyed = true;
 }
 
 void
@@ -99,46 +217,47 @@ Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  uint32_t sizeClass = GetSizeClass (data->m_size);
+  BUFFER_STAT_DEC (g_counters[sizeClass].inUse);
+  /* feed into the cache of this thread */
+  if (sizeClass != HEAP_CLASS && !g_destroyed)
     {
-      Buffer::Deallocate (data);
-    }
-  else
-    {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      std::vector<uint8_t *> &blocks = GetThreadCache ()->blocks[sizeClass];
+      if (blocks.size () < CACHE_BYTES / g_sizeClassSize[sizeClass])
+        {
+          blocks.push_back (reinterpret_cast<uint8_t *> (data));
+          BUFFER_STAT_INC (g_counters[sizeClass].cached);
+          return;
+        }
     }
+  Buffer::Deallocate (data);
 }
 
 Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
+  uint32_t sizeClass = GetSizeClass (dataSize);
+  struct Buffer::Data *data;
+  if (sizeClass == HEAP_CLASS)
     {
-      g_freeList = new Buffer::FreeList ();
+      data = Buffer::Allocate (dataSize);
+      BUFFER_STAT_INC (g_counters[sizeClass].allocated);
     }
-  else if (IS_INITIALIZED (g_freeList))
+  else if (!g_destroyed && !GetThreadCache ()->blocks[sizeClass].empty ())
     {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
+      std::vector<uint8_t *> &blocks = t_cache->blocks[sizeClass];
+      data = reinterpret_cast<struct Buffer::Data *> (blocks.back ());
+      blocks.pop_back ();
+      BUFFER_STAT_DEC (g_counters[sizeClass].cached);
+      data->m_count = 1;
+    }
+  else
+    {
+      data = Buffer::Allocate (g_sizeClassSize[sizeClass]);
+      BUFFER_STAT_INC (g_counters[sizeClass].allocated);
     }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
+  CountInUse (sizeClass);
   NS_ASSERT (data->m_count == 1);
   return data;
 }
@@ -148,6 +267,7 @@ Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
+  BUFFER_STAT_DEC (g_counters[GetSizeClass (data->m_size)].inUse);
   Deallocate (data);
 }
 
@@ -155,10 +275,75 @@ Buffer::Data *
 Buffer::Create (uint32_t size)
 {
   NS_LOG_FUNCTION (size);
-  return Allocate (size);
+  struct Buffer::Data *data = Allocate (size);
+  uint32_t sizeClass = GetSizeClass (data->m_size);
+  BUFFER_STAT_INC (g_counters[sizeClass].allocated);
+  CountInUse (sizeClass);
+  return data;
 }
 #endif /* BUFFER_FREE_LIST */
 
+void
+Buffer::Unref (struct Buffer::Data *data)
+{
+#ifdef NS3_MT_SIMULATOR
+  uint32_t count = __sync_sub_and_fetch (&data->m_count, 1);
+#else
+  uint32_t count = --data->m_count;
+#endif
+  if (count == 0)
+    {
+      Recycle (data);
+    }
+}
+
+uint32_t
+Buffer::GetAllocatorSizeClasses (void)
+{
+  return N_SIZE_CLASSES;
+}
+
+struct Buffer::AllocatorStatistics
+Buffer::GetAllocatorStatistics (uint32_t sizeClass)
+{
+  NS_LOG_FUNCTION (sizeClass);
+  NS_ASSERT (sizeClass < N_SIZE_CLASSES);
+  struct AllocatorStatistics statistics;
+  statistics.size = g_sizeClassSize[sizeClass];
+  statistics.allocated = g_counters[sizeClass].allocated;
+  statistics.inUse = g_counters[sizeClass].inUse;
+  statistics.cached = g_counters[sizeClass].cached;
+  statistics.highWater = g_counters[sizeClass].highWater;
+  return statistics;
+}
+
+void
+Buffer::PrintAllocatorStatistics (std::ostream &os)
+{
+  NS_LOG_FUNCTION (&os);
+  for (uint32_t i = 0; i < N_SIZE_CLASSES; i++)
+    {
+      struct AllocatorStatistics statistics = GetAllocatorStatistics (i);
+      if (statistics.size == 0)
+        {
+          os << "heap:";
+        }
+      else
+        {
+          os << statistics.size << ":";
+        }
+      os << " allocated=" << statistics.allocated
+         << " in-use=" << statistics.inUse
+         << " cached=" << statistics.cached
+         << " high-water=" << statistics.highWater;
+      if (statistics.size != 0)
+        {
+          os << " (" << statistics.highWater * statistics.size << " bytes)";
+        }
+      os << std::endl;
+    }
+}
+
 struct Buffer::Data *
 Buffer::Allocate (uint32_t reqSize)
 {
@@ -244,7 +429,7 @@ void
 Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
-  m_data = Buffer::Create (0);
+  m_data = Buffer::Create (g_recommendedStart);
   m_start = std::min (m_data->m_size, g_recommendedStart);
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
@@ -262,13 +447,9 @@ Buffer::operator = (Buffer const&o)
   if (m_data != o.m_data) 
     {
       // not assignment to self.
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
-        {
-          Recycle (m_data);
-        }
+      Unref (m_data);
       m_data = o.m_data;
-      m_data->m_count++;
+      Ref (m_data);
     }
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
@@ -285,11 +466,7 @@ Buffer::~Buffer ()
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
-    {
-      Recycle (m_data);
-    }
+  Unref (m_data);
 }
 
 uint32_t
@@ -311,7 +488,12 @@ Buffer::AddAtStart (uint32_t start)
   NS_LOG_FUNCTION (this << start);
   bool dirty;
   NS_ASSERT (CheckInternalState ());
+#ifdef NS3_MT_SIMULATOR
+  // the buffers which share the data may be used by other threads
+  bool isDirty = m_data->m_count > 1;
+#else
   bool isDirty = m_data->m_count > 1 && m_start > m_data->m_dirtyStart;
+#endif
   if (m_start >= start && !isDirty)
     {
       /* enough space in the buffer and not dirty. 
@@ -330,11 +512,7 @@ Buffer::AddAtStart (uint32_t start)
       uint32_t newSize = GetInternalSize () + start;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data + start, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0)
-        {
-          Buffer::Recycle (m_data);
-        }
+      Buffer::Unref (m_data);
       m_data = newData;
 
       int32_t delta = start - m_start;
@@ -362,7 +540,12 @@ Buffer::AddAtEnd (uint32_t end)
   NS_LOG_FUNCTION (this << end);
   bool dirty;
   NS_ASSERT (CheckInternalState ());
+#ifdef NS3_MT_SIMULATOR
+  // the buffers which share the data may be used by other threads
+  bool isDirty = m_data->m_count > 1;
+#else
   bool isDirty = m_data->m_count > 1 && m_end < m_data->m_dirtyEnd;
+#endif
   if (GetInternalEnd () + end <= m_data->m_size && !isDirty)
     {
       /* enough space in buffer and not dirty
@@ -383,11 +566,7 @@ Buffer::AddAtEnd (uint32_t end)
       uint32_t newSize = GetInternalSize () + end;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
-        {
-          Buffer::Recycle (m_data);
-        }
+      Buffer::Unref (m_data);
       m_data = newData;
 
       int32_t delta = -m_start;
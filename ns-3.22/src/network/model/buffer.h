@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <vector>
 #include <ostream>
+#include "ns3/core-config.h"
 #include "ns3/assert.h"
 
 #define BUFFER_FREE_LIST 1
@@ -38,9 +39,14 @@ namespace ns3 {
  * automatically adjusted to hold any data prepended
  * or appended by the user. Its implementation is optimized
  * to ensure that the number of buffer resizes is minimized,
- * by creating new Buffers of the maximum size ever used.
- * The correct maximum size is learned at runtime during use by 
- * recording the maximum size of each packet.
+ * by creating new Buffers large enough to hold the headers
+ * of the largest packets seen so far.
+ *
+ * The storage of the buffers comes from a slab allocator whose
+ * size classes match common packet sizes (64, 576, 1500 and 9000
+ * bytes): each thread keeps a cache of released storage for each
+ * class, and larger storage is allocated on the heap. The usage of
+ * each class can be queried with GetAllocatorStatistics.
  *
  * \internal
  * The implementation of the Buffer class uses a COW (Copy On Write)
@@ -657,6 +663,39 @@ private:
    */
   Buffer (uint32_t dataSize, bool initialize);
   ~Buffer ();
+
+  /**
+   * \brief Usage of one size class of the buffer storage allocator.
+   */
+  struct AllocatorStatistics
+  {
+    uint32_t size;       //!< size of the storage of the class, zero for the heap class
+    uint64_t allocated;  //!< number of storage blocks allocated from the heap so far
+    uint64_t inUse;      //!< number of storage blocks currently used by buffers
+    uint64_t cached;     //!< number of released storage blocks held by the thread caches
+    uint64_t highWater;  //!< largest number of storage blocks used at the same time
+  };
+  /**
+   * \brief Get the number of size classes of the storage allocator
+   *
+   * The last class holds the storage too large for the other
+   * classes, which is allocated on the heap and never cached.
+   *
+   * \returns the number of size classes
+   */
+  static uint32_t GetAllocatorSizeClasses (void);
+  /**
+   * \brief Get the usage of a size class of the storage allocator
+   * \param sizeClass the index of the class, smaller than
+   *        GetAllocatorSizeClasses
+   * \returns the usage of the class
+   */
+  static struct AllocatorStatistics GetAllocatorStatistics (uint32_t sizeClass);
+  /**
+   * \brief Print the usage of every size class of the storage allocator
+   * \param os the output stream
+   */
+  static void PrintAllocatorStatistics (std::ostream &os);
 private:
   /**
    * This data structure is variable-sized through its last member whose size
@@ -671,6 +710,9 @@ private:
    * New user data can be safely written only outside of the "dirty
    * area" if the reference count is higher than 1 (that is, if
    * more than one Buffer instance references the same BufferData).
+   * With the multithreaded simulator, the Buffer instances may be used
+   * by several threads: the reference count is updated atomically, and
+   * the data is only written while a single instance references it.
    */
   struct Data
   {
@@ -733,13 +775,35 @@ private:
    */
   uint32_t GetInternalEnd (void) const;
 
+  /**
+   * \brief Add a reference to a buffer data storage
+   *
+   * \param data the buffer data storage
+   */
+  static inline void Ref (struct Buffer::Data *data);
+  /**
+   * \brief Remove a reference to a buffer data storage
+   *
+   * The storage is recycled when its last reference is removed.
+   *
+   * \param data the buffer data storage
+   */
+  static void Unref (struct Buffer::Data *data);
   /**
    * \brief Recycle the buffer memory
+   *
+   * The storage is kept in the cache of the calling thread for
+   * its size class, unless the cache is full.
+   *
    * \param data the buffer data storage
    */
   static void Recycle (struct Buffer::Data *data);
   /**
    * \brief Create a buffer data storage
+   *
+   * The storage is taken from the cache of the calling thread for
+   * the smallest size class which can hold it, if any.
+   *
    * \param size the storage size to create
    * \returns a pointer to the created buffer storage
    */
@@ -798,15 +862,11 @@ private:
   uint32_t m_end;
 
 #ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
   /// Local static destructor structure
   struct LocalStaticDestructor 
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
   static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
 };
@@ -1053,6 +1113,15 @@ Buffer::Iterator::Read (Buffer::Iterator start, uint32_t size)
   start.Write (*this, end);
 }
 
+void
+Buffer::Ref (struct Buffer::Data *data)
+{
+#ifdef NS3_MT_SIMULATOR
+  __sync_add_and_fetch (&data->m_count, 1);
+#else
+  data->m_count++;
+#endif
+}
 
 Buffer::Buffer (Buffer const&o)
   : m_data (o.m_data),
@@ -1062,7 +1131,7 @@ Buffer::Buffer (Buffer const&o)
     m_start (o.m_start),
     m_end (o.m_end)
 {
-  m_data->m_count++;
+  Ref (m_data);
   NS_ASSERT (CheckInternalState ());
 }
 
@@ -22,7 +22,9 @@
 #include <vector>
 #include <cstring>
 
+#ifndef NS3_MT_SIMULATOR
 #define USE_FREE_LIST 1
+#endif
 #define FREE_LIST_SIZE 1000
 #define OFFSET_MAX (2147483647)
 
@@ -147,10 +149,7 @@ ByteTagList::ByteTagList (const ByteTagList &o)
     m_data (o.m_data)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data != 0)
-    {
-      m_data->count++;
-    }
+  Ref (m_data);
 }
 ByteTagList &
 ByteTagList::operator = (const ByteTagList &o)
@@ -163,10 +162,7 @@ ByteTagList::operator = (const ByteTagList &o)
   Deallocate (m_data);
   m_data = o.m_data;
   m_used = o.m_used;
-  if (m_data != 0)
-    {
-      m_data->count++;
-    }
+  Ref (m_data);
   return *this;
 }
 ByteTagList::~ByteTagList ()
@@ -188,8 +184,13 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
       m_data = Allocate (spaceNeeded);
       m_used = 0;
     } 
+#ifdef NS3_MT_SIMULATOR
+  // the lists which share the data may be used by other threads
+  else if (m_data->size < spaceNeeded || m_data->count != 1)
+#else
   else if (m_data->size < spaceNeeded ||
            (m_data->count != 1 && m_data->dirty != m_used))
+#endif
     {
       struct ByteTagListData *newData = Allocate (spaceNeeded);
       std::memcpy (&newData->data, &m_data->data, m_used);
@@ -427,8 +428,8 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     {
       return;
     }
-  data->count--;
-  if (data->count == 0)
+  // without the free list, the lists may be used by several threads
+  if (__sync_sub_and_fetch (&data->count, 1) == 0)
     {
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
@@ -437,5 +438,20 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
 
 #endif /* USE_FREE_LIST */
 
+void
+ByteTagList::Ref (struct ByteTagListData *data)
+{
+  NS_LOG_FUNCTION (this << data);
+  if (data == 0)
+    {
+      return;
+    }
+#ifdef NS3_MT_SIMULATOR
+  __sync_add_and_fetch (&data->count, 1);
+#else
+  data->count++;
+#endif
+}
+
 
 } // namespace ns3
@@ -259,6 +259,12 @@ private:
    */
   void Deallocate (struct ByteTagListData *data);
 
+  /**
+   * \brief Adds a reference to a ByteTagListData
+   * \param data the ByteTagListData to reference, may be null
+   */
+  void Ref (struct ByteTagListData *data);
+
   uint16_t m_used; //!< the number of used bytes in the buffer
   struct ByteTagListData *m_data; //!< the ByteTagListData structure
 };
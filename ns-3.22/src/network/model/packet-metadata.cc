@@ -77,11 +77,7 @@ PacketMetadata::ReserveCopy (uint32_t size)
   struct PacketMetadata::Data *newData = PacketMetadata::Create (m_used + size);
   memcpy (newData->m_data, m_data->m_data, m_used);
   newData->m_dirtyEnd = m_used;
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
-    {
-      PacketMetadata::Recycle (m_data);
-    }
+  Unref (m_data);
   m_data = newData;
   if (m_head != 0xffff)
     {
@@ -95,15 +91,23 @@ PacketMetadata::ReserveCopy (uint32_t size)
       Append16 (0xffff, start);
     }
 }
+bool
+PacketMetadata::IsFreeAtEnd (void) const
+{
+#ifdef NS3_MT_SIMULATOR
+  return m_data->m_count == 1;
+#else
+  return m_head == 0xffff ||
+         m_data->m_count == 1 ||
+         m_data->m_dirtyEnd == m_used;
+#endif
+}
 void
 PacketMetadata::Reserve (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
   NS_ASSERT (m_data != 0);
-  if (m_data->m_size >= m_used + size &&
-      (m_head == 0xffff ||
-       m_data->m_count == 1 ||
-       m_data->m_dirtyEnd == m_used))
+  if (m_data->m_size >= m_used + size && IsFreeAtEnd ())
     {
       /* enough room, not dirty. */
     }
@@ -380,10 +384,7 @@ PacketMetadata::AddSmall (const struct PacketMetadata::SmallItem *item)
   uint32_t typeUidSize = GetUleb128Size (item->typeUid);
   uint32_t sizeSize = GetUleb128Size (item->size);
   uint32_t n =  2 + 2 + typeUidSize + sizeSize + 2;
-  if (m_used + n > m_data->m_size ||
-      (m_head != 0xffff &&
-       m_data->m_count != 1 &&
-       m_used != m_data->m_dirtyEnd))
+  if (m_used + n > m_data->m_size || !IsFreeAtEnd ())
     {
       ReserveCopy (n);
     }
@@ -418,10 +419,7 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   uint32_t fragEndSize = GetUleb128Size (extraItem->fragmentEnd);
   uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2 + fragStartSize + fragEndSize + 4;
 
-  if (m_used + n > m_data->m_size ||
-      (m_head != 0xffff &&
-       m_data->m_count != 1 &&
-       m_used != m_data->m_dirtyEnd))
+  if (m_used + n > m_data->m_size || !IsFreeAtEnd ())
     {
       ReserveCopy (n);
     }
@@ -604,6 +602,10 @@ PacketMetadata::Recycle (struct PacketMetadata::Data *data)
     } 
   NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
   NS_ASSERT (data->m_count == 0);
+#ifdef NS3_MT_SIMULATOR
+  // the free list is shared by all the threads
+  PacketMetadata::Deallocate (data);
+#else
   if (m_freeList.size () > 1000 ||
       data->m_size < m_maxSize) 
     {
@@ -613,6 +615,7 @@ PacketMetadata::Recycle (struct PacketMetadata::Data *data)
     {
       m_freeList.push_back (data);
     }
+#endif
 }
 
 struct PacketMetadata::Data *
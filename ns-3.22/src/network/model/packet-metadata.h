@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <vector>
 #include <limits>
+#include "ns3/core-config.h"
 #include "ns3/callback.h"
 #include "ns3/assert.h"
 #include "ns3/type-id.h"
@@ -588,6 +589,16 @@ public:
    * \param n space to reserve
    */
   inline void Reserve (uint32_t n);
+  /**
+   * \brief Check if new items may be written after m_used
+   *
+   * With the multithreaded simulator, the metadata which share their
+   * data may be used by other threads: the data is only written while
+   * it is not shared.
+   *
+   * \returns true if the bytes after m_used may be written in place
+   */
+  inline bool IsFreeAtEnd (void) const;
   /**
    * \brief Reserve space and make a metadata copy
    * \param n space to reserve
@@ -633,6 +644,17 @@ public:
    */
   bool IsSharedPointerOk (uint16_t pointer) const;
 
+  /**
+   * \brief Add a reference to a buffer data storage
+   * \param data the buffer data storage
+   */
+  static inline void Ref (struct PacketMetadata::Data *data);
+  /**
+   * \brief Remove a reference to a buffer data storage, and recycle
+   * it with the last one
+   * \param data the buffer data storage
+   */
+  static inline void Unref (struct PacketMetadata::Data *data);
   /**
    * \brief Recycle the buffer memory
    * \param data the buffer data storage
@@ -686,6 +708,29 @@ public:
 
 namespace ns3 {
 
+void
+PacketMetadata::Ref (struct PacketMetadata::Data *data)
+{
+  NS_ASSERT (data->m_count < std::numeric_limits<uint32_t>::max());
+#ifdef NS3_MT_SIMULATOR
+  __sync_add_and_fetch (&data->m_count, 1);
+#else
+  data->m_count++;
+#endif
+}
+void
+PacketMetadata::Unref (struct PacketMetadata::Data *data)
+{
+#ifdef NS3_MT_SIMULATOR
+  uint32_t count = __sync_sub_and_fetch (&data->m_count, 1);
+#else
+  uint32_t count = --data->m_count;
+#endif
+  if (count == 0)
+    {
+      PacketMetadata::Recycle (data);
+    }
+}
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
   : m_data (PacketMetadata::Create (10)),
     m_head (0xffff),
@@ -707,8 +752,7 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_packetUid (o.m_packetUid)
 {
   NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  Ref (m_data);
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -717,14 +761,10 @@ PacketMetadata::operator = (PacketMetadata const& o)
     {
       // not self assignment
       NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
-        {
-          PacketMetadata::Recycle (m_data);
-        }
+      Unref (m_data);
       m_data = o.m_data;
       NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      Ref (m_data);
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
@@ -735,11 +775,7 @@ PacketMetadata::operator = (PacketMetadata const& o)
 PacketMetadata::~PacketMetadata ()
 {
   NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
-    {
-      PacketMetadata::Recycle (m_data);
-    }
+  Unref (m_data);
 }
 
 } // namespace ns3
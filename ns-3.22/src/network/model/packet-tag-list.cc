@@ -30,6 +30,16 @@
 #include "ns3/log.h"
 #include <cstring>
 
+/* With the multithreaded simulator, the other branches of a merge may
+ * be released by other threads while it is copied: it is then deleted
+ * by Unref.
+ */
+#ifdef NS3_MT_SIMULATOR
+#define NS_ASSERT_MERGE(cur) NS_ASSERT ((cur)->count > 0)
+#else
+#define NS_ASSERT_MERGE(cur) NS_ASSERT ((cur)->count > 1)
+#endif
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
@@ -103,7 +113,7 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 
   // At this point cur is a merge, but untested for tid
   NS_ASSERT (cur != 0);
-  NS_ASSERT (cur->count > 1);
+  NS_ASSERT_MERGE (cur);
 
   /*
      Walk the remainder of the list, copying, until we find tid
@@ -131,14 +141,14 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
   while ( /* cur && */ cur->tid != tid)
     {
       NS_ASSERT (cur != 0);
-      NS_ASSERT (cur->count > 1);
-      cur->count--;                       // unmerge cur
+      NS_ASSERT_MERGE (cur);
       struct TagData * copy = new struct TagData ();
       copy->tid = cur->tid;
       copy->count = 1;
       memcpy (copy->data, cur->data, TagData::MAX_SIZE);
       copy->next = cur->next;             // merge into tail
-      copy->next->count++;                // mark new merge
+      Ref (copy->next);                   // mark new merge
+      Unref (cur);                        // unmerge cur
       *prevNext = copy;                   // point prior list at copy
       prevNext = &copy->next;             // advance
       cur      =  copy->next;
@@ -146,7 +156,7 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
   // Sanity check:
   NS_ASSERT (cur != 0);                 // cur should be non-zero
   NS_ASSERT (cur->tid == tid);          // cur->tid should be tid
-  NS_ASSERT (cur->count > 1);           // cur should be a merge
+  NS_ASSERT_MERGE (cur);           // cur should be a merge
 
   // link around tid, removing it from our list
   found = (this->*Writer)(tag, false, cur, prevNext);
@@ -182,13 +192,10 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
   else
     {
       // cur is always a merge at this point
+      // if there's a next, make it a merge
+      Ref (cur->next);
       // unmerge cur, since we linked around it already
-      cur->count--;
-      if (cur->next != 0)
-        {
-          // there's a next, so make it a merge
-          cur->next->count++;
-        }
+      Unref (cur);
     }
   return found;
 }
@@ -224,17 +231,14 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
     {
       // cur is always a merge at this point
       // need to copy, replace, and link past cur
-      cur->count--;                     // unmerge cur
       struct TagData * copy = new struct TagData ();
       copy->tid = tag.GetInstanceTypeId ();
       copy->count = 1;
       tag.Serialize (TagBuffer (copy->data,
                                 copy->data + tag.GetSerializedSize ()));
       copy->next = cur->next;           // merge into tail
-      if (copy->next != 0)
-        {
-          copy->next->count++;          // mark new merge
-        }
+      Ref (copy->next);                 // mark new merge
+      Unref (cur);                      // unmerge cur
       *prevNext = copy;                 // point prior list at copy
     }
   return found;
@@ -27,6 +27,7 @@
 
 #include <stdint.h>
 #include <ostream>
+#include "ns3/core-config.h"
 #include "ns3/type-id.h"
 
 namespace ns3 {
@@ -287,6 +288,23 @@ private:
    */
   bool ReplaceWriter (Tag & tag, bool preMerge, struct TagData * cur, struct TagData ** prevNext);
 
+  /**
+   * Add an incoming link to a tag.
+   *
+   * With the multithreaded simulator, the branches which share a tag
+   * may be used by several threads: its count is updated atomically.
+   *
+   * \param [in] data Pointer to the tag, may be null.
+   */
+  static inline void Ref (struct TagData *data);
+  /**
+   * Remove an incoming link to a tag, and delete the tags which have
+   * no incoming link anymore, up to the next merge.
+   *
+   * \param [in] data Pointer to the tag, may be null.
+   */
+  static inline void Unref (struct TagData *data);
+
   /**
    * Pointer to first \ref TagData on the list
    */
@@ -309,10 +327,7 @@ PacketTagList::PacketTagList ()
 PacketTagList::PacketTagList (PacketTagList const &o)
   : m_next (o.m_next)
 {
-  if (m_next != 0)
-    {
-      m_next->count++;
-    }
+  Ref (m_next);
 }
 
 PacketTagList &
@@ -325,10 +340,7 @@ PacketTagList::operator = (PacketTagList const &o)
     }
   RemoveAll ();
   m_next = o.m_next;
-  if (m_next != 0) 
-    {
-      m_next->count++;
-    }
+  Ref (m_next);
   return *this;
 }
 
@@ -338,13 +350,30 @@ PacketTagList::~PacketTagList ()
 }
 
 void
-PacketTagList::RemoveAll (void)
+PacketTagList::Ref (struct TagData *data)
+{
+  if (data != 0)
+    {
+#ifdef NS3_MT_SIMULATOR
+      __sync_add_and_fetch (&data->count, 1);
+#else
+      data->count++;
+#endif
+    }
+}
+
+void
+PacketTagList::Unref (struct TagData *data)
 {
   struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  for (struct TagData *cur = data; cur != 0; cur = cur->next)
     {
-      cur->count--;
-      if (cur->count > 0) 
+#ifdef NS3_MT_SIMULATOR
+      uint32_t count = __sync_sub_and_fetch (&cur->count, 1);
+#else
+      uint32_t count = --cur->count;
+#endif
+      if (count > 0) 
         {
           break;
         }
@@ -358,6 +387,12 @@ PacketTagList::RemoveAll (void)
     {
       delete prev;
     }
+}
+
+void
+PacketTagList::RemoveAll (void)
+{
+  Unref (m_next);
   m_next = 0;
 }
 
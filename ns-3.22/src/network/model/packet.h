@@ -701,6 +701,12 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
+  /**
+   * \brief Allocate the uid of a new packet.
+   * \returns the value of the global counter before its increment.
+   */
+  static uint32_t AllocateUid (void);
+
   static uint32_t m_globalUid; //!< Global counter of packets Uid
 };
 
@@ -0,0 +1,227 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sstream>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/binary-trace-file.h"
+#include "ns3/ethernet-header.h"
+#include "ns3/ethernet-trailer.h"
+#include "ns3/llc-snap-header.h"
+
+using namespace ns3;
+
+namespace {
+
+Ptr<Packet>
+MakePacket (uint32_t size)
+{
+  Ptr<Packet> p = Create<Packet> (size);
+  LlcSnapHeader llc;
+  llc.SetType (0x0800);
+  p->AddHeader (llc);
+  EthernetHeader ethernet;
+  ethernet.SetSource (Mac48Address ("00:00:00:00:00:01"));
+  ethernet.SetDestination (Mac48Address ("00:00:00:00:00:02"));
+  ethernet.SetLengthType (p->GetSize ());
+  p->AddHeader (ethernet);
+  EthernetTrailer trailer;
+  trailer.EnableFcs (true);
+  trailer.CalcFcs (p);
+  p->AddTrailer (trailer);
+  return p;
+}
+
+std::string
+PrintPacket (Ptr<const Packet> p)
+{
+  std::ostringstream oss;
+  p->Print (oss);
+  return oss.str ();
+}
+
+std::string
+PrintRecord (Ptr<BinaryTraceFile> file, BinaryTraceFile::Record const &record)
+{
+  std::ostringstream oss;
+  file->Print (record, oss);
+  return oss.str ();
+}
+
+/* Read the records of a file, without the type definitions. */
+std::vector<BinaryTraceFile::Record>
+ReadRecords (Ptr<BinaryTraceFile> file, std::string filename)
+{
+  std::vector<BinaryTraceFile::Record> records;
+  file->Open (filename, std::ios::in);
+  BinaryTraceFile::Record record;
+  while (file->Read (record))
+    {
+      if (record.event != BinaryTraceFile::TYPE)
+        {
+          records.push_back (record);
+        }
+    }
+  return records;
+}
+
+} // anonymous namespace
+
+/**
+ * The records read back hold the fields written and print the packets
+ * as Packet::Print does.
+ */
+class BinaryTraceFileRoundTripTestCase : public TestCase
+{
+public:
+  BinaryTraceFileRoundTripTestCase ();
+private:
+  virtual void DoRun (void);
+  void Write (Ptr<BinaryTraceFile> file, uint8_t event, uint32_t node, uint32_t device, Ptr<const Packet> p);
+};
+
+BinaryTraceFileRoundTripTestCase::BinaryTraceFileRoundTripTestCase ()
+  : TestCase ("Write and read back records")
+{
+}
+
+void
+BinaryTraceFileRoundTripTestCase::Write (Ptr<BinaryTraceFile> file, uint8_t event,
+                                         uint32_t node, uint32_t device, Ptr<const Packet> p)
+{
+  file->Write (event, node, device, p);
+}
+
+void
+BinaryTraceFileRoundTripTestCase::DoRun (void)
+{
+  Packet::EnablePrinting ();
+  std::string filename = CreateTempDirFilename ("binary-trace-file-test.btr");
+
+  std::vector<Ptr<Packet> > packets;
+  packets.push_back (MakePacket (100));
+  packets.push_back (MakePacket (0));
+  packets.push_back (MakePacket (1000)->CreateFragment (10, 50));
+  packets.push_back (Create<Packet> (20));
+
+  Ptr<BinaryTraceFile> file = CreateObject<BinaryTraceFile> ();
+  // a block of about two records, so that it is written many times
+  file->SetAttribute ("BlockSize", UintegerValue (600));
+  file->Open (filename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (file->Fail (), false, "could not open " << filename);
+  uint8_t events[] = { BinaryTraceFile::ENQUEUE, BinaryTraceFile::DEQUEUE,
+                       BinaryTraceFile::DROP, BinaryTraceFile::RECEIVE };
+  for (uint32_t i = 0; i < packets.size (); i++)
+    {
+      Simulator::Schedule (MilliSeconds (1500 + i), &BinaryTraceFileRoundTripTestCase::Write,
+                           this, file, events[i], i, i + 7, packets[i]);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  file->Close ();
+
+  std::vector<BinaryTraceFile::Record> records = ReadRecords (file, filename);
+  NS_TEST_ASSERT_MSG_EQ (records.size (), packets.size (), "wrong number of records");
+  for (uint32_t i = 0; i < packets.size (); i++)
+    {
+      BinaryTraceFile::Record const &record = records[i];
+      NS_TEST_EXPECT_MSG_EQ (record.time, MilliSeconds (1500 + i).GetTimeStep (), "wrong time");
+      NS_TEST_EXPECT_MSG_EQ (record.uid, packets[i]->GetUid (), "wrong uid");
+      NS_TEST_EXPECT_MSG_EQ (record.node, i, "wrong node");
+      NS_TEST_EXPECT_MSG_EQ (record.device, i + 7, "wrong device");
+      NS_TEST_EXPECT_MSG_EQ (record.size, packets[i]->GetSize (), "wrong size");
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t)record.event, (uint32_t)events[i], "wrong event");
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t)record.flags, 0, "unexpected truncation");
+      NS_TEST_EXPECT_MSG_EQ (PrintRecord (file, record), PrintPacket (packets[i]), "wrong packet");
+    }
+
+  EthernetHeader ethernet;
+  NS_TEST_EXPECT_MSG_EQ (file->PeekChunk (records[0], ethernet), true, "no ethernet header");
+  NS_TEST_EXPECT_MSG_EQ (ethernet.GetSource (), Mac48Address ("00:00:00:00:00:01"), "wrong ethernet source");
+  NS_TEST_EXPECT_MSG_EQ (file->PeekChunk (records[3], ethernet), false, "unexpected ethernet header");
+  file->Close ();
+}
+
+/**
+ * The headers which do not fit in the records are reported.
+ */
+class BinaryTraceFileTruncationTestCase : public TestCase
+{
+public:
+  BinaryTraceFileTruncationTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+BinaryTraceFileTruncationTestCase::BinaryTraceFileTruncationTestCase ()
+  : TestCase ("Truncate the headers and the items")
+{
+}
+
+void
+BinaryTraceFileTruncationTestCase::DoRun (void)
+{
+  Packet::EnablePrinting ();
+  std::string filename = CreateTempDirFilename ("binary-trace-file-truncation.btr");
+  Ptr<Packet> p = MakePacket (100);
+
+  // room for the ethernet header (14 bytes) but not for the llc header
+  Ptr<BinaryTraceFile> file = CreateObject<BinaryTraceFile> ();
+  file->SetAttribute ("CaptureSize", UintegerValue (20));
+  file->Open (filename, std::ios::out);
+  file->Write (BinaryTraceFile::ENQUEUE, 0, 0, p);
+  file->Close ();
+
+  std::vector<BinaryTraceFile::Record> records = ReadRecords (file, filename);
+  NS_TEST_ASSERT_MSG_EQ (records.size (), 1, "wrong number of records");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)records[0].flags, (uint32_t)BinaryTraceFile::BYTES_TRUNCATED, "wrong flags");
+  std::string printed = PrintRecord (file, records[0]);
+  NS_TEST_EXPECT_MSG_EQ ((printed.find ("ns3::LlcSnapHeader (...)") != std::string::npos), true,
+                         "the llc header should not be printed: " << printed);
+  NS_TEST_EXPECT_MSG_EQ ((printed.find ("ns3::EthernetTrailer (...)") != std::string::npos), true,
+                         "the trailer should not be printed: " << printed);
+  EthernetHeader ethernet;
+  NS_TEST_EXPECT_MSG_EQ (file->PeekChunk (records[0], ethernet), true, "no ethernet header");
+  file->Close ();
+
+  file = CreateObject<BinaryTraceFile> ();
+  file->SetAttribute ("MaxItems", UintegerValue (2));
+  file->Open (filename, std::ios::out);
+  file->Write (BinaryTraceFile::ENQUEUE, 0, 0, p);
+  file->Close ();
+
+  records = ReadRecords (file, filename);
+  NS_TEST_ASSERT_MSG_EQ (records.size (), 1, "wrong number of records");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)records[0].flags, (uint32_t)BinaryTraceFile::ITEMS_TRUNCATED, "wrong flags");
+  NS_TEST_EXPECT_MSG_EQ (records[0].items.size (), 2, "wrong number of items");
+  file->Close ();
+}
+
+static class BinaryTraceFileTestSuite : public TestSuite
+{
+public:
+  BinaryTraceFileTestSuite ()
+    : TestSuite ("binary-trace-file", UNIT)
+  {
+    AddTestCase (new BinaryTraceFileRoundTripTestCase (), TestCase::QUICK);
+    AddTestCase (new BinaryTraceFileTruncationTestCase (), TestCase::QUICK);
+  }
+} g_binaryTraceFileTestSuite;
@@ -342,6 +342,95 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 //-----------------------------------------------------------------------------
+class BufferAllocatorTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferAllocatorTest ();
+private:
+  uint32_t FindGrownClass (std::vector<Buffer::AllocatorStatistics> const &before);
+  std::vector<Buffer::AllocatorStatistics> GetStatistics (void);
+};
+
+BufferAllocatorTest::BufferAllocatorTest ()
+  : TestCase ("Buffer storage allocator") {
+}
+
+std::vector<Buffer::AllocatorStatistics>
+BufferAllocatorTest::GetStatistics (void)
+{
+  std::vector<Buffer::AllocatorStatistics> statistics;
+  for (uint32_t i = 0; i < Buffer::GetAllocatorSizeClasses (); i++)
+    {
+      statistics.push_back (Buffer::GetAllocatorStatistics (i));
+    }
+  return statistics;
+}
+
+uint32_t
+BufferAllocatorTest::FindGrownClass (std::vector<Buffer::AllocatorStatistics> const &before)
+{
+  uint32_t grown = Buffer::GetAllocatorSizeClasses ();
+  for (uint32_t i = 0; i < Buffer::GetAllocatorSizeClasses (); i++)
+    {
+      if (Buffer::GetAllocatorStatistics (i).inUse == before[i].inUse + 1)
+        {
+          grown = i;
+        }
+    }
+  return grown;
+}
+
+void
+BufferAllocatorTest::DoRun (void)
+{
+  uint32_t nClasses = Buffer::GetAllocatorSizeClasses ();
+  NS_TEST_ASSERT_MSG_EQ (Buffer::GetAllocatorStatistics (nClasses - 1).size, 0, "The last class should be the heap");
+
+  // released storage of a size class is reused
+  std::vector<Buffer::AllocatorStatistics> before = GetStatistics ();
+  uint32_t k;
+  {
+    Buffer buffer;
+    buffer.AddAtStart (5000);
+    k = FindGrownClass (before);
+    NS_TEST_ASSERT_MSG_LT (k, nClasses - 1, "5000 bytes should be served from a size class");
+    NS_TEST_EXPECT_MSG_GT_OR_EQ (Buffer::GetAllocatorStatistics (k).size, 5000, "Size class too small");
+  }
+  Buffer::AllocatorStatistics released = Buffer::GetAllocatorStatistics (k);
+  NS_TEST_EXPECT_MSG_EQ (released.inUse, before[k].inUse, "Storage still in use");
+  NS_TEST_EXPECT_MSG_EQ (released.cached, before[k].cached + 1, "Storage not cached");
+  {
+    Buffer buffer;
+    buffer.AddAtStart (5000);
+    Buffer::AllocatorStatistics reused = Buffer::GetAllocatorStatistics (k);
+    NS_TEST_EXPECT_MSG_EQ (reused.allocated, released.allocated, "Cached storage not reused");
+    NS_TEST_EXPECT_MSG_EQ (reused.cached, released.cached - 1, "Cached storage not reused");
+  }
+
+  // the high water mark follows the buffers in use
+  {
+    std::vector<Buffer> buffers (10);
+    for (uint32_t i = 0; i < buffers.size (); i++)
+      {
+        buffers[i].AddAtStart (5000);
+      }
+    NS_TEST_EXPECT_MSG_GT_OR_EQ (Buffer::GetAllocatorStatistics (k).highWater, before[k].inUse + 10, "Bad high water mark");
+  }
+  NS_TEST_EXPECT_MSG_EQ (Buffer::GetAllocatorStatistics (k).inUse, before[k].inUse, "Storage still in use");
+
+  // storage too large for the size classes is not cached
+  before = GetStatistics ();
+  {
+    Buffer buffer;
+    buffer.AddAtStart (20000);
+    NS_TEST_EXPECT_MSG_EQ (FindGrownClass (before), nClasses - 1, "20000 bytes should be served from the heap");
+  }
+  Buffer::AllocatorStatistics heap = Buffer::GetAllocatorStatistics (nClasses - 1);
+  NS_TEST_EXPECT_MSG_EQ (heap.inUse, before[nClasses - 1].inUse, "Storage still in use");
+  NS_TEST_EXPECT_MSG_EQ (heap.cached, 0, "Heap storage should not be cached");
+  NS_TEST_EXPECT_MSG_EQ (heap.allocated, before[nClasses - 1].allocated + 1, "Bad heap allocation count");
+}
+//-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -352,6 +441,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferAllocatorTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
@@ -0,0 +1,124 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/pcap-file-wrapper.h"
+#include "ns3/trace-helper.h"
+#include "ns3/ethernet-header.h"
+
+using namespace ns3;
+
+/**
+ * The async mode writes the same file as the default mode.
+ */
+class PcapFileWrapperAsyncTestCase : public TestCase
+{
+public:
+  PcapFileWrapperAsyncTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * \param filename the file to write
+   * \param async use the async mode
+   * \param snapLen the snaplen of the file
+   * \returns the content of the file
+   */
+  std::vector<char> WriteFile (std::string filename, bool async, uint32_t snapLen);
+};
+
+PcapFileWrapperAsyncTestCase::PcapFileWrapperAsyncTestCase ()
+  : TestCase ("Write the same records with and without the async mode")
+{
+}
+
+std::vector<char>
+PcapFileWrapperAsyncTestCase::WriteFile (std::string filename, bool async, uint32_t snapLen)
+{
+  Ptr<PcapFileWrapper> file = CreateObject<PcapFileWrapper> ();
+  file->SetAttribute ("Async", BooleanValue (async));
+  // smaller than some records, so that many buffers are queued
+  file->SetAttribute ("BufferSize", UintegerValue (300));
+  file->Open (filename, std::ios::out);
+  file->Init (PcapHelper::DLT_EN10MB, snapLen);
+  NS_TEST_EXPECT_MSG_EQ (file->Fail (), false, "could not open " << filename);
+
+  uint8_t data[1000];
+  for (uint32_t i = 0; i < sizeof (data); i++)
+    {
+      data[i] = i;
+    }
+  EthernetHeader header;
+  header.SetSource (Mac48Address ("00:00:00:00:00:01"));
+  header.SetDestination (Mac48Address ("00:00:00:00:00:02"));
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Time t = MicroSeconds (1234567 * i);
+      uint32_t size = (i * 37) % sizeof (data);
+      Ptr<Packet> p = Create<Packet> (data, size);
+      switch (i % 3)
+        {
+        case 0:
+          file->Write (t, p);
+          break;
+        case 1:
+          header.SetLengthType (size);
+          file->Write (t, header, p);
+          break;
+        case 2:
+          file->Write (t, data, size);
+          break;
+        }
+    }
+  file->Close ();
+  NS_TEST_EXPECT_MSG_EQ (file->Fail (), false, "could not write " << filename);
+
+  std::ifstream in (filename.c_str (), std::ios::binary);
+  return std::vector<char> ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+}
+
+void
+PcapFileWrapperAsyncTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("pcap-file-wrapper-sync.pcap");
+  std::string asyncFilename = CreateTempDirFilename ("pcap-file-wrapper-async.pcap");
+
+  uint32_t snapLens[] = { PcapFile::SNAPLEN_DEFAULT, 64, 10 };
+  for (uint32_t i = 0; i < sizeof (snapLens) / sizeof (snapLens[0]); i++)
+    {
+      std::vector<char> expected = WriteFile (filename, false, snapLens[i]);
+      std::vector<char> actual = WriteFile (asyncFilename, true, snapLens[i]);
+      NS_TEST_EXPECT_MSG_GT (expected.size (), 24, "no records with a snaplen of " << snapLens[i]);
+      NS_TEST_EXPECT_MSG_EQ ((actual == expected), true, "different files with a snaplen of " << snapLens[i]);
+    }
+}
+
+static class PcapFileWrapperTestSuite : public TestSuite
+{
+public:
+  PcapFileWrapperTestSuite ()
+    : TestSuite ("pcap-file-wrapper", UNIT)
+  {
+    AddTestCase (new PcapFileWrapperAsyncTestCase (), TestCase::QUICK);
+  }
+} g_pcapFileWrapperTestSuite;
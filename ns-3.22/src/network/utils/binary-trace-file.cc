@@ -0,0 +1,618 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/core-config.h"
+#include "binary-trace-file.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BinaryTraceFile");
+
+NS_OBJECT_ENSURE_REGISTERED (BinaryTraceFile);
+
+namespace {
+
+/* The file starts with a header of FILE_HEADER_SIZE bytes:
+ *
+ *   0  char[8]  magic "ns3btrc"
+ *   8  uint32   BYTE_ORDER_MARK, to detect a file of another architecture
+ *  12  uint32   FORMAT_VERSION
+ *  16  uint32   size of a record
+ *  20  uint32   MaxItems
+ *  24  uint32   CaptureSize
+ *  28  int32    Time::Unit of the times
+ *
+ * and is followed by the records, RECORD_HEADER_SIZE bytes of:
+ *
+ *   0  int64    timestep
+ *   8  uint64   packet uid
+ *  16  uint32   node
+ *  20  uint32   device
+ *  24  uint32   packet size
+ *  28  uint8    event
+ *  29  uint8    flags
+ *  30  uint16   bytes captured
+ *  32  uint8    items
+ *  33           unused
+ *
+ * then MaxItems items of ITEM_SIZE bytes, and CaptureSize bytes of
+ * headers and trailers.  All the fields are in the byte order of the
+ * host.
+ */
+const char MAGIC[8] = "ns3btrc";
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const uint32_t FORMAT_VERSION = 1;
+const uint32_t FILE_HEADER_SIZE = 32;
+const uint32_t RECORD_HEADER_SIZE = 40;
+const uint32_t ITEM_SIZE = sizeof (BinaryTraceFile::Item);
+
+/* Each thread caches the blocks it used last so that it finds its
+ * block without taking the lock of the file.  A cached block is valid
+ * only while the serial of the file is unchanged.
+ */
+const uint32_t THREAD_CACHE_SIZE = 4;
+
+struct ThreadCacheEntry
+{
+  const void *file;
+  uint32_t serial;
+  void *block;
+};
+
+__thread struct ThreadCacheEntry t_blocks[THREAD_CACHE_SIZE];
+__thread uint32_t t_nextEntry = 0;
+
+uint32_t g_serial = 0;
+
+/* Files may be opened and closed by the threads of several partitions. */
+uint32_t
+NextSerial (void)
+{
+#ifdef NS3_MT_SIMULATOR
+  return __sync_add_and_fetch (&g_serial, 1);
+#else
+  return ++g_serial;
+#endif
+}
+
+} // anonymous namespace
+
+TypeId
+BinaryTraceFile::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BinaryTraceFile")
+    .SetParent<Object> ()
+    .AddConstructor<BinaryTraceFile> ()
+    .AddAttribute ("CaptureSize",
+                   "Number of bytes of headers and trailers kept in each record",
+                   UintegerValue (128),
+                   MakeUintegerAccessor (&BinaryTraceFile::m_captureSize),
+                   MakeUintegerChecker<uint32_t> (0, 0xffff))
+    .AddAttribute ("MaxItems",
+                   "Number of packet metadata items kept in each record",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&BinaryTraceFile::m_maxItems),
+                   MakeUintegerChecker<uint32_t> (0, 0xff))
+    .AddAttribute ("BlockSize",
+                   "Size of the memory block in which each thread stores its records "
+                   "before they are written to the file",
+                   UintegerValue (1 << 20),
+                   MakeUintegerAccessor (&BinaryTraceFile::m_blockSize),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+BinaryTraceFile::BinaryTraceFile ()
+  : m_recordSize (0),
+    m_resolution (Time::GetResolution ()),
+    m_serial (0),
+    m_writing (false),
+    m_fail (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+BinaryTraceFile::~BinaryTraceFile ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+void
+BinaryTraceFile::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+  Object::DoDispose ();
+}
+
+void
+BinaryTraceFile::Open (std::string const &filename, std::ios::openmode mode)
+{
+  NS_LOG_FUNCTION (this << filename << mode);
+  Close ();
+  m_fail = false;
+  m_writing = (mode & std::ios::out) != 0;
+  m_typeNames.clear ();
+  m_typeNames.push_back ("");
+  m_typeIndex.clear ();
+
+  uint8_t header[FILE_HEADER_SIZE];
+  if (m_writing)
+    {
+      m_file.open (filename.c_str (), std::ios::out | std::ios::trunc | std::ios::binary);
+      m_resolution = Time::GetResolution ();
+      m_recordSize = RECORD_HEADER_SIZE + m_maxItems * ITEM_SIZE + m_captureSize;
+      std::memcpy (header, MAGIC, 8);
+      std::memcpy (header + 8, &BYTE_ORDER_MARK, 4);
+      std::memcpy (header + 12, &FORMAT_VERSION, 4);
+      std::memcpy (header + 16, &m_recordSize, 4);
+      std::memcpy (header + 20, &m_maxItems, 4);
+      std::memcpy (header + 24, &m_captureSize, 4);
+      std::memcpy (header + 28, &m_resolution, 4);
+      m_file.write ((const char *)header, FILE_HEADER_SIZE);
+      // the blocks cached by the threads for a previous file are stale
+      m_serial = NextSerial ();
+    }
+  else
+    {
+      m_file.open (filename.c_str (), std::ios::in | std::ios::binary);
+      m_file.read ((char *)header, FILE_HEADER_SIZE);
+      uint32_t byteOrder;
+      uint32_t version;
+      std::memcpy (&byteOrder, header + 8, 4);
+      std::memcpy (&version, header + 12, 4);
+      std::memcpy (&m_recordSize, header + 16, 4);
+      std::memcpy (&m_maxItems, header + 20, 4);
+      std::memcpy (&m_captureSize, header + 24, 4);
+      std::memcpy (&m_resolution, header + 28, 4);
+      if (m_file.fail () || std::memcmp (header, MAGIC, 8) != 0
+          || byteOrder != BYTE_ORDER_MARK || version != FORMAT_VERSION
+          || m_recordSize != RECORD_HEADER_SIZE + m_maxItems * ITEM_SIZE + m_captureSize)
+        {
+          NS_LOG_WARN ("Not a binary trace file of this host: " << filename);
+          m_fail = true;
+        }
+      m_readBuffer.resize (m_recordSize);
+    }
+  if (m_file.fail ())
+    {
+      m_fail = true;
+    }
+}
+
+void
+BinaryTraceFile::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  if (m_writing)
+    {
+      CriticalSection cs (m_mutex);
+      for (std::vector<ThreadBlock *>::iterator i = m_blocks.begin (); i != m_blocks.end (); ++i)
+        {
+          WriteBlock (*i);
+        }
+    }
+  for (std::vector<ThreadBlock *>::iterator i = m_blocks.begin (); i != m_blocks.end (); ++i)
+    {
+      delete *i;
+    }
+  m_blocks.clear ();
+  m_file.close ();
+  m_serial = NextSerial ();
+}
+
+void
+BinaryTraceFile::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_writing || !m_file.is_open ())
+    {
+      return;
+    }
+  // the blocks of the other threads are filled without the lock
+  ThreadBlock *block = GetThreadBlock ();
+  CriticalSection cs (m_mutex);
+  WriteBlock (block);
+  m_file.flush ();
+}
+
+bool
+BinaryTraceFile::Fail (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_fail || m_file.fail ();
+}
+
+int32_t
+BinaryTraceFile::GetResolution (void) const
+{
+  return m_resolution;
+}
+
+uint32_t
+BinaryTraceFile::GetRecordSize (void) const
+{
+  return m_recordSize;
+}
+
+BinaryTraceFile::ThreadBlock *
+BinaryTraceFile::GetThreadBlock (void)
+{
+  for (uint32_t i = 0; i < THREAD_CACHE_SIZE; i++)
+    {
+      if (t_blocks[i].file == this && t_blocks[i].serial == m_serial)
+        {
+          return static_cast<ThreadBlock *> (t_blocks[i].block);
+        }
+    }
+
+  CriticalSection cs (m_mutex);
+  // the entry of this file may have been evicted by other files: the
+  // address of a thread local variable identifies the thread
+  ThreadBlock *block = 0;
+  for (std::vector<ThreadBlock *>::const_iterator i = m_blocks.begin (); i != m_blocks.end (); ++i)
+    {
+      if ((*i)->owner == &t_nextEntry)
+        {
+          block = *i;
+          break;
+        }
+    }
+  if (block == 0)
+    {
+      block = new ThreadBlock ();
+      block->owner = &t_nextEntry;
+      block->data.resize (std::max (m_blockSize, m_recordSize));
+      block->used = 0;
+      block->record.resize (m_recordSize);
+      m_blocks.push_back (block);
+    }
+  struct ThreadCacheEntry &entry = t_blocks[t_nextEntry++ % THREAD_CACHE_SIZE];
+  entry.file = this;
+  entry.serial = m_serial;
+  entry.block = block;
+  return block;
+}
+
+void
+BinaryTraceFile::WriteBlock (ThreadBlock *block)
+{
+  NS_LOG_FUNCTION (this << block->used);
+  m_file.write ((const char *)&block->data[0], block->used);
+  if (m_file.fail ())
+    {
+      m_fail = true;
+    }
+  block->used = 0;
+}
+
+void
+BinaryTraceFile::Append (ThreadBlock *block, uint8_t const *record)
+{
+  if (block->used + m_recordSize > block->data.size ())
+    {
+      CriticalSection cs (m_mutex);
+      WriteBlock (block);
+    }
+  std::memcpy (&block->data[block->used], record, m_recordSize);
+  block->used += m_recordSize;
+}
+
+uint16_t
+BinaryTraceFile::GetTypeIndex (ThreadBlock *block, TypeId tid)
+{
+  std::map<uint16_t, uint16_t>::const_iterator i = block->types.find (tid.GetUid ());
+  if (i != block->types.end ())
+    {
+      return i->second;
+    }
+
+  uint16_t index;
+  {
+    CriticalSection cs (m_mutex);
+    std::map<uint16_t, uint16_t>::const_iterator j = m_typeIndex.find (tid.GetUid ());
+    if (j != m_typeIndex.end ())
+      {
+        index = j->second;
+      }
+    else
+      {
+        index = m_typeNames.size ();
+        m_typeNames.push_back (tid.GetName ());
+        m_typeIndex[tid.GetUid ()] = index;
+      }
+  }
+  block->types[tid.GetUid ()] = index;
+
+  // Each thread defines the types it uses in its own records, so that
+  // a definition is always written before the records which use it.
+  std::string name = tid.GetName ();
+  uint16_t length = std::min<uint32_t> (name.size (), m_captureSize);
+  uint8_t flags = length < name.size () ? BYTES_TRUNCATED : 0;
+  int64_t time = Simulator::Now ().GetTimeStep ();
+  uint64_t uid = index;
+  uint8_t event = TYPE;
+  std::vector<uint8_t> record (m_recordSize, 0);
+  std::memcpy (&record[0], &time, 8);
+  std::memcpy (&record[8], &uid, 8);
+  record[28] = event;
+  record[29] = flags;
+  std::memcpy (&record[30], &length, 2);
+  std::memcpy (&record[RECORD_HEADER_SIZE + m_maxItems * ITEM_SIZE], name.data (), length);
+  Append (block, &record[0]);
+  return index;
+}
+
+void
+BinaryTraceFile::Write (uint8_t event, uint32_t node, uint32_t device, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << event << node << device << p);
+  NS_ASSERT_MSG (m_writing && m_file.is_open (), "BinaryTraceFile::Write(): file not open for writing");
+
+  ThreadBlock *block = GetThreadBlock ();
+  uint8_t *record = &block->record[0];
+  uint8_t *items = record + RECORD_HEADER_SIZE;
+  uint8_t *bytes = items + m_maxItems * ITEM_SIZE;
+  std::memset (record, 0, m_recordSize);
+
+  uint8_t nItems = 0;
+  uint16_t nBytes = 0;
+  uint8_t flags = 0;
+  PacketMetadata::ItemIterator i = p->BeginItem ();
+  while (i.HasNext ())
+    {
+      if (nItems == m_maxItems)
+        {
+          flags |= ITEMS_TRUNCATED;
+          break;
+        }
+      PacketMetadata::Item item = i.Next ();
+      Item out;
+      out.type = 0;
+      out.reserved = 0;
+      out.size = item.currentSize;
+      out.trimmedFromStart = item.currentTrimedFromStart;
+      switch (item.type)
+        {
+        case PacketMetadata::Item::PAYLOAD:
+          out.kind = PAYLOAD;
+          break;
+        case PacketMetadata::Item::HEADER:
+          out.kind = HEADER;
+          break;
+        case PacketMetadata::Item::TRAILER:
+          out.kind = TRAILER;
+          break;
+        }
+      if (item.isFragment)
+        {
+          out.kind |= FRAGMENT;
+        }
+      if (item.type != PacketMetadata::Item::PAYLOAD)
+        {
+          out.type = GetTypeIndex (block, item.tid);
+          // the bytes of whole headers and trailers are kept until
+          // the first one which does not fit
+          if (!item.isFragment && !(flags & BYTES_TRUNCATED))
+            {
+              if (nBytes + item.currentSize <= m_captureSize)
+                {
+                  Buffer::Iterator start = item.current;
+                  if (item.type == PacketMetadata::Item::TRAILER)
+                    {
+                      start.Prev (item.currentSize);
+                    }
+                  start.Read (bytes + nBytes, item.currentSize);
+                  nBytes += item.currentSize;
+                }
+              else
+                {
+                  flags |= BYTES_TRUNCATED;
+                }
+            }
+        }
+      std::memcpy (items + nItems * ITEM_SIZE, &out, ITEM_SIZE);
+      nItems++;
+    }
+
+  int64_t time = Simulator::Now ().GetTimeStep ();
+  uint64_t uid = p->GetUid ();
+  uint32_t size = p->GetSize ();
+  std::memcpy (record, &time, 8);
+  std::memcpy (record + 8, &uid, 8);
+  std::memcpy (record + 16, &node, 4);
+  std::memcpy (record + 20, &device, 4);
+  std::memcpy (record + 24, &size, 4);
+  record[28] = event;
+  record[29] = flags;
+  std::memcpy (record + 30, &nBytes, 2);
+  record[32] = nItems;
+  Append (block, record);
+}
+
+bool
+BinaryTraceFile::Read (Record &record)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_fail || m_writing || !m_file.is_open ())
+    {
+      return false;
+    }
+  m_file.read ((char *)&m_readBuffer[0], m_recordSize);
+  if (m_file.gcount () != (std::streamsize)m_recordSize)
+    {
+      return false;
+    }
+  uint8_t const *buffer = &m_readBuffer[0];
+  std::memcpy (&record.time, buffer, 8);
+  std::memcpy (&record.uid, buffer + 8, 8);
+  std::memcpy (&record.node, buffer + 16, 4);
+  std::memcpy (&record.device, buffer + 20, 4);
+  std::memcpy (&record.size, buffer + 24, 4);
+  record.event = buffer[28];
+  record.flags = buffer[29];
+  uint16_t nBytes;
+  std::memcpy (&nBytes, buffer + 30, 2);
+  uint8_t nItems = std::min<uint32_t> (buffer[32], m_maxItems);
+  nBytes = std::min<uint32_t> (nBytes, m_captureSize);
+
+  record.items.resize (nItems);
+  for (uint8_t i = 0; i < nItems; i++)
+    {
+      std::memcpy (&record.items[i], buffer + RECORD_HEADER_SIZE + i * ITEM_SIZE, ITEM_SIZE);
+    }
+  uint8_t const *bytes = buffer + RECORD_HEADER_SIZE + m_maxItems * ITEM_SIZE;
+  record.bytes.assign (bytes, bytes + nBytes);
+
+  if (record.event == TYPE)
+    {
+      if (record.uid >= m_typeNames.size ())
+        {
+          m_typeNames.resize (record.uid + 1);
+        }
+      m_typeNames[record.uid] = std::string (record.bytes.begin (), record.bytes.end ());
+    }
+  return true;
+}
+
+bool
+BinaryTraceFile::GetItemBytes (Record const &record, uint32_t item, uint32_t &offset) const
+{
+  offset = 0;
+  for (uint32_t i = 0; i < item; i++)
+    {
+      Item const &it = record.items[i];
+      if (it.kind == HEADER || it.kind == TRAILER)
+        {
+          offset += it.size;
+        }
+    }
+  Item const &it = record.items[item];
+  return (it.kind == HEADER || it.kind == TRAILER) && offset + it.size <= record.bytes.size ();
+}
+
+void
+BinaryTraceFile::Deserialize (Record const &record, uint32_t item, Chunk &chunk) const
+{
+  uint32_t offset;
+  bool ok = GetItemBytes (record, item, offset);
+  NS_ASSERT (ok);
+  Item const &it = record.items[item];
+  Buffer buffer;
+  buffer.AddAtStart (it.size);
+  buffer.Begin ().Write (&record.bytes[offset], it.size);
+  if (it.kind == HEADER)
+    {
+      chunk.Deserialize (buffer.Begin ());
+    }
+  else
+    {
+      chunk.Deserialize (buffer.End ());
+    }
+}
+
+void
+BinaryTraceFile::Print (Record const &record, std::ostream &os) const
+{
+  for (uint32_t i = 0; i < record.items.size (); i++)
+    {
+      Item const &item = record.items[i];
+      std::string name = (item.kind & ~FRAGMENT) == PAYLOAD ? "Payload" : GetTypeName (item.type);
+      if (i > 0)
+        {
+          os << " ";
+        }
+      if (item.kind & FRAGMENT)
+        {
+          os << name << " Fragment [" << item.trimmedFromStart << ":"
+             << (item.trimmedFromStart + item.size) << "]";
+        }
+      else if (item.kind == PAYLOAD)
+        {
+          os << "Payload (size=" << item.size << ")";
+        }
+      else
+        {
+          os << name << " (";
+          TypeId tid;
+          uint32_t offset;
+          if (GetItemBytes (record, i, offset)
+              && TypeId::LookupByNameFailSafe (name, &tid) && tid.HasConstructor ())
+            {
+              Callback<ObjectBase *> constructor = tid.GetConstructor ();
+              ObjectBase *instance = constructor ();
+              Chunk *chunk = dynamic_cast<Chunk *> (instance);
+              NS_ASSERT (chunk != 0);
+              Deserialize (record, i, *chunk);
+              chunk->Print (os);
+              delete chunk;
+            }
+          else
+            {
+              os << "...";
+            }
+          os << ")";
+        }
+    }
+  if (record.flags & ITEMS_TRUNCATED)
+    {
+      os << " ...";
+    }
+}
+
+bool
+BinaryTraceFile::PeekChunk (Record const &record, Chunk &chunk) const
+{
+  std::string name = chunk.GetInstanceTypeId ().GetName ();
+  for (uint32_t i = 0; i < record.items.size (); i++)
+    {
+      Item const &item = record.items[i];
+      uint32_t offset;
+      if ((item.kind == HEADER || item.kind == TRAILER)
+          && GetTypeName (item.type) == name
+          && GetItemBytes (record, i, offset))
+        {
+          Deserialize (record, i, chunk);
+          return true;
+        }
+    }
+  return false;
+}
+
+std::string
+BinaryTraceFile::GetTypeName (uint16_t index) const
+{
+  if (index < m_typeNames.size ())
+    {
+      return m_typeNames[index];
+    }
+  return "";
+}
+
+} // namespace ns3
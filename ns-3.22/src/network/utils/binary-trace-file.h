@@ -0,0 +1,287 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BINARY_TRACE_FILE_H
+#define BINARY_TRACE_FILE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <stdint.h>
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/chunk.h"
+#include "ns3/system-mutex.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tracing
+ *
+ * \brief A file of fixed-width binary trace records.
+ *
+ * Formatting every traced packet with Packet::Print, as the ascii
+ * traces do, is expensive.  This file stores instead, for each event,
+ * a record of fixed size which holds the time, node, device, event,
+ * packet uid and size, the layout of the packet metadata and the bytes
+ * of its headers and trailers.  The records are written by each thread
+ * into its own memory block, and a block is written to the file when
+ * it is full, so that the cost of a traced event is a few copies.
+ *
+ * The utils/decode-binary-trace program turns such a file back into
+ * the ascii traces, or into csv or column files: the headers are
+ * deserialized from the recorded bytes as Packet::Print does.
+ *
+ * The same class reads the records back, with Open (filename, std::ios::in).
+ */
+class BinaryTraceFile : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  BinaryTraceFile ();
+  ~BinaryTraceFile ();
+
+  /**
+   * The events of the records: the first four are the characters of
+   * the ascii traces.
+   */
+  enum Event
+  {
+    ENQUEUE = '+',  //!< the packet was queued
+    DEQUEUE = '-',  //!< the packet left the queue
+    DROP = 'd',     //!< the packet was dropped
+    RECEIVE = 'r',  //!< the packet was received
+    TYPE = 'T'      //!< defines the name of a header or trailer type
+  };
+
+  /**
+   * The kind of a metadata item, ored with FRAGMENT for the fragments.
+   */
+  enum ItemKind
+  {
+    PAYLOAD = 0,
+    HEADER = 1,
+    TRAILER = 2,
+    FRAGMENT = 0x80
+  };
+
+  /**
+   * The flags of a record.
+   */
+  enum Flags
+  {
+    ITEMS_TRUNCATED = 1,  //!< the packet had more items than MaxItems
+    BYTES_TRUNCATED = 2   //!< the headers did not fit in CaptureSize
+  };
+
+  /**
+   * A metadata item of a record.
+   */
+  struct Item
+  {
+    uint16_t type;                //!< index of the type name, zero for the payload
+    uint8_t kind;                 //!< an ItemKind
+    uint8_t reserved;             //!< unused
+    uint32_t size;                //!< size of the item
+    uint32_t trimmedFromStart;    //!< start of a fragment
+  };
+
+  /**
+   * A record, as returned by Read.
+   */
+  struct Record
+  {
+    int64_t time;                 //!< timestep of the event, in the resolution of the file
+    uint64_t uid;                 //!< packet uid, or type index for TYPE records
+    uint32_t node;                //!< node id
+    uint32_t device;              //!< device index in the node
+    uint32_t size;                //!< packet size
+    uint8_t event;                //!< an Event
+    uint8_t flags;                //!< Flags
+    std::vector<Item> items;      //!< metadata items
+    std::vector<uint8_t> bytes;   //!< bytes of the headers and trailers, in item order
+  };
+
+  /**
+   * \brief Open a file.
+   *
+   * With std::ios::out, the file is created and its header is written
+   * with the current attributes.  With std::ios::in, the header is read
+   * and the file is ready for Read.
+   *
+   * \param filename the name of the file
+   * \param mode std::ios::out or std::ios::in
+   */
+  void Open (std::string const &filename, std::ios::openmode mode);
+
+  /**
+   * \brief Write the blocks of all threads to the file, and close it.
+   *
+   * No other thread may write records to the file during the call,
+   * e.g. it is called once Simulator::Run has returned.
+   */
+  void Close (void);
+
+  /**
+   * \brief Write the block of the calling thread to the file.
+   *
+   * The blocks of the other threads are written when they are full,
+   * or by Close.
+   */
+  void Flush (void);
+
+  /**
+   * \return true if the file could not be opened, read or written.
+   */
+  bool Fail (void) const;
+
+  /**
+   * \brief Record an event.
+   *
+   * \param event an Event
+   * \param node the id of the node
+   * \param device the index of the device in the node
+   * \param p the packet
+   */
+  void Write (uint8_t event, uint32_t node, uint32_t device, Ptr<const Packet> p);
+
+  /**
+   * \brief Read the next record.
+   *
+   * The TYPE records are returned too, after their name was stored for
+   * GetTypeName.
+   *
+   * \param record the record read
+   * \return false at the end of the file
+   */
+  bool Read (Record &record);
+
+  /**
+   * \brief Print the packet of a record as Packet::Print does.
+   *
+   * The headers and trailers are deserialized from the bytes of the
+   * record with the types of the simulation, so they must be linked to
+   * the program.  A header which is unknown or was not captured is
+   * printed with "..." instead of its fields.
+   *
+   * \param record a record returned by Read
+   * \param os the output stream
+   */
+  void Print (Record const &record, std::ostream &os) const;
+
+  /**
+   * \brief Deserialize a header or trailer of a record.
+   *
+   * \param record a record returned by Read
+   * \param chunk a header or trailer
+   * \return true if the record holds the bytes of a header or trailer
+   * of the type of chunk, which was deserialized into chunk
+   */
+  bool PeekChunk (Record const &record, Chunk &chunk) const;
+
+  /**
+   * \param index the index of a type, as found in Item::type
+   * \return the name of the type, or an empty string if it was not defined yet
+   */
+  std::string GetTypeName (uint16_t index) const;
+
+  /**
+   * \return the resolution of the times of the records, a Time::Unit
+   */
+  int32_t GetResolution (void) const;
+
+  /**
+   * \return the size of a record in the file
+   */
+  uint32_t GetRecordSize (void) const;
+
+private:
+  /**
+   * The records of one thread waiting to be written to the file.
+   */
+  struct ThreadBlock
+  {
+    const void *owner;                      //!< identifies the thread
+    std::vector<uint8_t> data;              //!< the records
+    uint32_t used;                          //!< bytes of data used
+    std::map<uint16_t, uint16_t> types;     //!< type indexes defined in this block stream
+    std::vector<uint8_t> record;            //!< the record being built
+  };
+
+  virtual void DoDispose (void);
+
+  /**
+   * \return the block of the calling thread, created on first use
+   */
+  ThreadBlock *GetThreadBlock (void);
+  /**
+   * \param block the block of the calling thread
+   * \param tid a header or trailer type
+   * \return the index of the type; a TYPE record is added to the block
+   * the first time the thread sees the type
+   */
+  uint16_t GetTypeIndex (ThreadBlock *block, TypeId tid);
+  /**
+   * \param block a block
+   * \param record a record of GetRecordSize bytes
+   */
+  void Append (ThreadBlock *block, uint8_t const *record);
+  /**
+   * \param record a record
+   * \param item the index of an item of the record
+   * \param offset set to the offset of the bytes of the item in the record
+   * \return true if the bytes of the item are in the record
+   */
+  bool GetItemBytes (Record const &record, uint32_t item, uint32_t &offset) const;
+  /**
+   * \param record a record
+   * \param item the index of a header or trailer item whose bytes are in the record
+   * \param chunk the chunk to deserialize
+   */
+  void Deserialize (Record const &record, uint32_t item, Chunk &chunk) const;
+  /**
+   * Write a block to the file and empty it.  The caller holds m_mutex.
+   * \param block the block
+   */
+  void WriteBlock (ThreadBlock *block);
+
+  uint32_t m_captureSize;                   //!< bytes of headers kept in each record
+  uint32_t m_maxItems;                      //!< metadata items kept in each record
+  uint32_t m_blockSize;                     //!< size of the blocks of the threads
+  uint32_t m_recordSize;                    //!< size of a record
+  int32_t m_resolution;                     //!< Time::Unit of the times
+  uint32_t m_serial;                        //!< identifies this open file in the thread caches
+  bool m_writing;                           //!< opened with std::ios::out
+  bool m_fail;                              //!< an error occurred
+  std::fstream m_file;                      //!< the file
+  SystemMutex m_mutex;                      //!< protects the fields below
+  std::vector<ThreadBlock *> m_blocks;      //!< the blocks of all threads
+  std::map<uint16_t, uint16_t> m_typeIndex; //!< TypeId uid to type index
+  std::vector<std::string> m_typeNames;     //!< type names, by index
+  std::vector<uint8_t> m_readBuffer;        //!< buffer of Read
+};
+
+} // namespace ns3
+
+#endif /* BINARY_TRACE_FILE_H */
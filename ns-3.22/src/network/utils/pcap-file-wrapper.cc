@@ -16,16 +16,507 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
 #include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
 #include "ns3/uinteger.h"
 #include "ns3/buffer.h"
 #include "ns3/header.h"
+#include "ns3/simulator.h"
+#include "ns3/core-config.h"
 #include "pcap-file-wrapper.h"
 
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#include "ns3/system-thread.h"
+#endif
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PcapFileWrapper");
 
+/**
+ * A buffer of pcap records.
+ */
+struct PcapBuffer
+{
+  std::vector<uint8_t> data; //!< the records
+  uint32_t used;             //!< bytes of data used
+};
+
+namespace {
+class PcapWriter;
+} // anonymous namespace
+
+/**
+ * The state of a file in async mode.
+ */
+struct PcapAsyncFile
+{
+  int fd;                    //!< the file, opened for appending
+  PcapWriter *writer;        //!< the writer of the buffers
+  PcapBuffer *buffer;        //!< the buffer being filled, or 0
+  uint32_t pending;          //!< buffers waiting for the writer, protected by its lock
+  bool failed;               //!< a write failed, protected by the lock of the writer
+};
+
+namespace {
+
+/* The simulation waits for the writer when this many bytes are queued. */
+const uint64_t MAX_QUEUED_BYTES = 64 << 20;
+/* The released buffers are kept for reuse up to this number. */
+const uint32_t MAX_FREE_BUFFERS = 64;
+#ifdef IOV_MAX
+const int MAX_IOV = IOV_MAX;
+#else
+const int MAX_IOV = 16;
+#endif
+
+/**
+ * \brief Write a few buffers to a file.
+ * \param fd the file
+ * \param iov the buffers, modified by the partial writes
+ * \param count the number of buffers
+ * \returns false if a write failed
+ */
+bool
+WriteAll (int fd, struct iovec *iov, int count)
+{
+  while (count > 0)
+    {
+      ssize_t written = writev (fd, iov, std::min (count, MAX_IOV));
+      if (written < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          return false;
+        }
+      while (count > 0 && (size_t)written >= iov->iov_len)
+        {
+          written -= iov->iov_len;
+          iov++;
+          count--;
+        }
+      if (count > 0)
+        {
+          iov->iov_base = (char *)iov->iov_base + written;
+          iov->iov_len -= written;
+        }
+    }
+  return true;
+}
+
+/**
+ * The writer of the full buffers of all the files in async mode.  With
+ * threads, the buffers are queued for a background thread which
+ * writes the consecutive buffers of a file with a single writev;
+ * otherwise they are written when they are submitted.
+ *
+ * The writer lives while files in async mode are open. Its thread is
+ * started by the first buffer submitted, and joined once the queued
+ * buffers are written, when the simulator is destroyed or when the
+ * writer is, with the last file.
+ */
+class PcapWriter
+{
+public:
+  /**
+   * \returns the writer, created by the first file
+   */
+  static PcapWriter *Acquire (void);
+  /**
+   * \brief Release the writer of a file, deleted with the last file.
+   */
+  static void Release (void);
+  /**
+   * \param size the minimum size of the buffer
+   * \returns an empty buffer
+   */
+  PcapBuffer *Allocate (uint32_t size);
+  /**
+   * \brief Queue a buffer for writing; the writer releases it.
+   * \param file the file
+   * \param buffer the buffer
+   */
+  void Submit (PcapAsyncFile *file, PcapBuffer *buffer);
+  /**
+   * \brief Wait until all the buffers of a file are written.
+   * \param file the file
+   */
+  void Drain (PcapAsyncFile *file);
+  /**
+   * \param file the file
+   * \returns true if a write to the file failed
+   */
+  bool Failed (PcapAsyncFile *file);
+
+private:
+  /** A buffer to write. */
+  struct Job
+  {
+    PcapAsyncFile *file;   //!< the file
+    PcapBuffer *buffer;    //!< the buffer
+    bool ok;               //!< the buffer was written
+  };
+
+  PcapWriter ();
+  ~PcapWriter ();
+  /**
+   * \param a a job
+   * \param b a job
+   * \returns true if the file of a sorts before the file of b
+   */
+  static bool CompareFiles (Job const &a, Job const &b);
+  /**
+   * \brief Write the buffers, grouping those of the same file.
+   * \param jobs the buffers
+   */
+  static void Write (std::vector<Job> &jobs);
+  /**
+   * \brief Account for written buffers and keep them for reuse.
+   * The caller holds the lock.
+   * \param jobs the buffers
+   */
+  void Complete (std::vector<Job> const &jobs);
+#ifdef HAVE_PTHREAD_H
+  /**
+   * \brief The loop of the background thread.
+   */
+  void Run (void);
+  /**
+   * \brief Wait until the queued buffers are written, and join the
+   * thread.
+   */
+  void Stop (void);
+  /**
+   * \brief Stop the thread of the writer, if any, when the simulator
+   * is destroyed.
+   */
+  static void DoStop (void);
+
+  SystemMutex m_mutex;           //!< protects the fields below and the files
+  SystemCondition m_work;        //!< set when jobs are queued or the thread must stop
+  SystemCondition m_done;        //!< set when jobs are complete
+  Ptr<SystemThread> m_thread;    //!< the background thread, or 0
+  bool m_stop;                   //!< the thread stops once the jobs are complete
+#endif
+  std::deque<Job> m_jobs;        //!< the queued buffers
+  uint64_t m_queuedBytes;        //!< bytes queued or being written
+  std::vector<PcapBuffer *> m_free; //!< released buffers
+
+  static PcapWriter *g_writer;   //!< the writer of the open files, or 0
+  static uint32_t g_files;       //!< the open files in async mode
+#ifdef HAVE_PTHREAD_H
+  static SystemMutex g_mutex;    //!< protects g_writer and g_files
+#endif
+};
+
+PcapWriter *PcapWriter::g_writer = 0;
+uint32_t PcapWriter::g_files = 0;
+#ifdef HAVE_PTHREAD_H
+SystemMutex PcapWriter::g_mutex;
+
+/* SystemCondition::TimedWait forgets a wakeup which comes before it
+ * starts: the waiters check their condition again after this delay.
+ */
+const uint64_t WAIT_NS = 1000000;
+#endif
+
+PcapWriter::PcapWriter ()
+  : m_queuedBytes (0)
+{
+#ifdef HAVE_PTHREAD_H
+  m_thread = 0;
+  m_stop = false;
+#endif
+}
+
+PcapWriter::~PcapWriter ()
+{
+#ifdef HAVE_PTHREAD_H
+  Stop ();
+#endif
+  NS_ASSERT (m_jobs.empty ());
+  for (std::vector<PcapBuffer *>::iterator i = m_free.begin (); i != m_free.end (); ++i)
+    {
+      delete *i;
+    }
+}
+
+PcapWriter *
+PcapWriter::Acquire (void)
+{
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (g_mutex);
+#endif
+  if (g_files++ == 0)
+    {
+      g_writer = new PcapWriter ();
+    }
+  return g_writer;
+}
+
+void
+PcapWriter::Release (void)
+{
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (g_mutex);
+#endif
+  NS_ASSERT (g_files > 0);
+  if (--g_files == 0)
+    {
+      delete g_writer;
+      g_writer = 0;
+    }
+}
+
+bool
+PcapWriter::CompareFiles (Job const &a, Job const &b)
+{
+  return a.file < b.file;
+}
+
+PcapBuffer *
+PcapWriter::Allocate (uint32_t size)
+{
+  PcapBuffer *buffer = 0;
+  {
+#ifdef HAVE_PTHREAD_H
+    CriticalSection cs (m_mutex);
+#endif
+    for (std::vector<PcapBuffer *>::iterator i = m_free.begin (); i != m_free.end (); ++i)
+      {
+        if ((*i)->data.size () >= size)
+          {
+            buffer = *i;
+            m_free.erase (i);
+            break;
+          }
+      }
+  }
+  if (buffer == 0)
+    {
+      buffer = new PcapBuffer ();
+      buffer->data.resize (size);
+    }
+  buffer->used = 0;
+  return buffer;
+}
+
+void
+PcapWriter::Write (std::vector<Job> &jobs)
+{
+  std::vector<struct iovec> iov;
+  uint32_t i = 0;
+  while (i < jobs.size ())
+    {
+      uint32_t j = i;
+      iov.clear ();
+      while (j < jobs.size () && jobs[j].file == jobs[i].file)
+        {
+          struct iovec v;
+          v.iov_base = &jobs[j].buffer->data[0];
+          v.iov_len = jobs[j].buffer->used;
+          iov.push_back (v);
+          j++;
+        }
+      bool ok = jobs[i].file->fd >= 0 && WriteAll (jobs[i].file->fd, &iov[0], iov.size ());
+      for (; i < j; i++)
+        {
+          jobs[i].ok = ok;
+        }
+    }
+}
+
+void
+PcapWriter::Complete (std::vector<Job> const &jobs)
+{
+  for (std::vector<Job>::const_iterator i = jobs.begin (); i != jobs.end (); ++i)
+    {
+      i->file->pending--;
+      if (!i->ok)
+        {
+          i->file->failed = true;
+        }
+      m_queuedBytes -= i->buffer->used;
+      if (m_free.size () < MAX_FREE_BUFFERS)
+        {
+          m_free.push_back (i->buffer);
+        }
+      else
+        {
+          delete i->buffer;
+        }
+    }
+}
+
+#ifdef HAVE_PTHREAD_H
+void
+PcapWriter::Run (void)
+{
+  std::vector<Job> jobs;
+  for (;;)
+    {
+      {
+        CriticalSection cs (m_mutex);
+        if (m_jobs.empty () && m_stop)
+          {
+            return;
+          }
+        jobs.assign (m_jobs.begin (), m_jobs.end ());
+        m_jobs.clear ();
+      }
+      if (jobs.empty ())
+        {
+          m_work.TimedWait (WAIT_NS);
+          continue;
+        }
+
+      // the buffers of a file keep their order in the group, so that
+      // the records of the file keep the order of the simulation
+      std::stable_sort (jobs.begin (), jobs.end (), CompareFiles);
+      Write (jobs);
+
+      {
+        CriticalSection cs (m_mutex);
+        Complete (jobs);
+      }
+      m_done.SetCondition (true);
+      m_done.Broadcast ();
+    }
+}
+
+void
+PcapWriter::Stop (void)
+{
+  Ptr<SystemThread> thread;
+  {
+    CriticalSection cs (m_mutex);
+    thread = m_thread;
+    m_stop = true;
+  }
+  if (thread != 0)
+    {
+      m_work.SetCondition (true);
+      m_work.Signal ();
+      thread->Join ();
+    }
+  CriticalSection cs (m_mutex);
+  m_thread = 0;
+  m_stop = false;
+}
+
+void
+PcapWriter::DoStop (void)
+{
+  CriticalSection cs (g_mutex);
+  if (g_writer != 0)
+    {
+      g_writer->Stop ();
+    }
+}
+#endif
+
+void
+PcapWriter::Submit (PcapAsyncFile *file, PcapBuffer *buffer)
+{
+  Job job;
+  job.file = file;
+  job.buffer = buffer;
+  job.ok = true;
+#ifdef HAVE_PTHREAD_H
+  bool started = false;
+  for (;;)
+    {
+      {
+        CriticalSection cs (m_mutex);
+        if (m_thread == 0)
+          {
+            m_thread = Create<SystemThread> (MakeCallback (&PcapWriter::Run, this));
+            m_thread->Start ();
+            started = true;
+          }
+        // a thread being stopped may not see the job
+        if (!m_stop && m_queuedBytes <= MAX_QUEUED_BYTES)
+          {
+            m_jobs.push_back (job);
+            m_queuedBytes += buffer->used;
+            file->pending++;
+            break;
+          }
+      }
+      // wait for the writer to catch up, or to be stopped
+      m_done.TimedWait (WAIT_NS);
+    }
+  m_work.SetCondition (true);
+  m_work.Signal ();
+  if (started)
+    {
+      Simulator::ScheduleDestroy (&PcapWriter::DoStop);
+    }
+#else
+  std::vector<Job> jobs (1, job);
+  m_queuedBytes += buffer->used;
+  file->pending++;
+  Write (jobs);
+  Complete (jobs);
+#endif
+}
+
+void
+PcapWriter::Drain (PcapAsyncFile *file)
+{
+#ifdef HAVE_PTHREAD_H
+  for (;;)
+    {
+      {
+        CriticalSection cs (m_mutex);
+        if (file->pending == 0)
+          {
+            return;
+          }
+      }
+      m_done.TimedWait (WAIT_NS);
+    }
+#endif
+}
+
+bool
+PcapWriter::Failed (PcapAsyncFile *file)
+{
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (m_mutex);
+#endif
+  return file->failed;
+}
+
+/**
+ * \brief Store a 32 bit value in little endian, as PcapFile writes.
+ * \param buffer the destination
+ * \param value the value
+ */
+void
+WriteLe32 (uint8_t *buffer, uint32_t value)
+{
+  buffer[0] = value & 0xff;
+  buffer[1] = (value >> 8) & 0xff;
+  buffer[2] = (value >> 16) & 0xff;
+  buffer[3] = (value >> 24) & 0xff;
+}
+
+} // anonymous namespace
+
 NS_OBJECT_ENSURE_REGISTERED (PcapFileWrapper);
 
 TypeId 
@@ -39,12 +530,25 @@ PcapFileWrapper::GetTypeId (void)
                    UintegerValue (PcapFile::SNAPLEN_DEFAULT),
                    MakeUintegerAccessor (&PcapFileWrapper::m_snapLen),
                    MakeUintegerChecker<uint32_t> (0, PcapFile::SNAPLEN_DEFAULT))
+    .AddAttribute ("Async",
+                   "Write the records from a background thread, through "
+                   "buffers of BufferSize bytes",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PcapFileWrapper::m_async),
+                   MakeBooleanChecker ())
+    .AddAttribute ("BufferSize",
+                   "Size of the buffers of records of the Async mode",
+                   UintegerValue (64 * 1024),
+                   MakeUintegerAccessor (&PcapFileWrapper::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> (1))
   ;
   return tid;
 }
 
 
 PcapFileWrapper::PcapFileWrapper ()
+  : m_mode (std::ios::in),
+    m_asyncFile (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -60,6 +564,10 @@ bool
 PcapFileWrapper::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_asyncFile != 0 && m_asyncFile->writer->Failed (m_asyncFile))
+    {
+      return true;
+    }
   return m_file.Fail ();
 }
 bool 
@@ -79,6 +587,28 @@ void
 PcapFileWrapper::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_asyncFile != 0)
+    {
+      PcapWriter *writer = m_asyncFile->writer;
+      if (m_asyncFile->buffer != 0)
+        {
+          writer->Submit (m_asyncFile, m_asyncFile->buffer);
+        }
+      writer->Drain (m_asyncFile);
+      if (m_asyncFile->failed)
+        {
+          NS_LOG_WARN ("Unable to write the records of " << m_filename);
+        }
+      if (m_asyncFile->fd >= 0)
+        {
+          close (m_asyncFile->fd);
+        }
+      delete m_asyncFile;
+      m_asyncFile = 0;
+      PcapWriter::Release ();
+      // the stream was closed by Init
+      return;
+    }
   m_file.Close ();
 }
 
@@ -86,6 +616,12 @@ void
 PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
 {
   NS_LOG_FUNCTION (this << filename << mode);
+  if (m_asyncFile != 0)
+    {
+      Close ();
+    }
+  m_filename = filename;
+  m_mode = mode;
   m_file.Open (filename, mode);
 }
 
@@ -106,12 +642,64 @@ PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrec
     {
       m_file.Init (dataLinkType, m_snapLen, tzCorrection);
     } 
+
+  if (m_async && (m_mode & std::ios::out) && !m_file.Fail () && m_asyncFile == 0)
+    {
+      // The file header is flushed by closing the stream: the records
+      // are then appended with the descriptor of the writer.
+      m_file.Close ();
+      m_asyncFile = new PcapAsyncFile ();
+      m_asyncFile->fd = open (m_filename.c_str (), O_WRONLY | O_APPEND);
+      m_asyncFile->writer = PcapWriter::Acquire ();
+      m_asyncFile->buffer = 0;
+      m_asyncFile->pending = 0;
+      m_asyncFile->failed = m_asyncFile->fd < 0;
+    }
+}
+
+uint8_t *
+PcapFileWrapper::Reserve (uint32_t size)
+{
+  PcapBuffer *buffer = m_asyncFile->buffer;
+  if (buffer != 0 && buffer->used + size > buffer->data.size ())
+    {
+      m_asyncFile->writer->Submit (m_asyncFile, buffer);
+      buffer = 0;
+    }
+  if (buffer == 0)
+    {
+      buffer = m_asyncFile->writer->Allocate (std::max (m_bufferSize, size));
+      m_asyncFile->buffer = buffer;
+    }
+  uint8_t *start = &buffer->data[buffer->used];
+  buffer->used += size;
+  return start;
+}
+
+std::pair<uint8_t *, uint32_t>
+PcapFileWrapper::ReserveRecord (Time t, uint32_t totalLen)
+{
+  uint64_t current = t.GetMicroSeconds ();
+  uint32_t inclLen = std::min (totalLen, m_file.GetSnapLen ());
+  uint8_t *start = Reserve (16 + inclLen);
+  WriteLe32 (start, current / 1000000);
+  WriteLe32 (start + 4, current % 1000000);
+  WriteLe32 (start + 8, inclLen);
+  WriteLe32 (start + 12, totalLen);
+  return std::make_pair (start + 16, inclLen);
 }
 
 void
 PcapFileWrapper::Write (Time t, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << p);
+  if (m_asyncFile != 0)
+    {
+      // only the bytes kept by the snaplen are copied
+      std::pair<uint8_t *, uint32_t> data = ReserveRecord (t, p->GetSize ());
+      p->CopyData (data.first, data.second);
+      return;
+    }
   uint64_t current = t.GetMicroSeconds ();
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
@@ -123,6 +711,18 @@ void
 PcapFileWrapper::Write (Time t, Header &header, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << &header << p);
+  if (m_asyncFile != 0)
+    {
+      uint32_t headerSize = header.GetSerializedSize ();
+      std::pair<uint8_t *, uint32_t> data = ReserveRecord (t, headerSize + p->GetSize ());
+      Buffer headerBuffer;
+      headerBuffer.AddAtStart (headerSize);
+      header.Serialize (headerBuffer.Begin ());
+      uint32_t toCopy = std::min (headerSize, data.second);
+      headerBuffer.CopyData (data.first, toCopy);
+      p->CopyData (data.first + toCopy, data.second - toCopy);
+      return;
+    }
   uint64_t current = t.GetMicroSeconds ();
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
@@ -134,6 +734,12 @@ void
 PcapFileWrapper::Write (Time t, uint8_t const *buffer, uint32_t length)
 {
   NS_LOG_FUNCTION (this << t << &buffer << length);
+  if (m_asyncFile != 0)
+    {
+      std::pair<uint8_t *, uint32_t> data = ReserveRecord (t, length);
+      std::memcpy (data.first, buffer, data.second);
+      return;
+    }
   uint64_t current = t.GetMicroSeconds ();
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
@@ -30,11 +30,20 @@
 
 namespace ns3 {
 
+struct PcapAsyncFile;
+
 /**
  * A class that wraps a PcapFile as an ns3::Object and provides a higher-layer
  * ns-3 interface to the low-level public methods of PcapFile.  Users are
  * encouraged to use this object instead of class ns3::PcapFile in ns-3
  * public APIs.
+ *
+ * When the "Async" attribute is set, the records of a file opened for
+ * writing are serialized, truncated to the snaplen, into buffers of
+ * "BufferSize" bytes.  The full buffers are written with writev by a
+ * background thread shared by all the files, so that the simulation
+ * does not wait for the disk.  The records are in the file once Close
+ * returns.
  */
 class PcapFileWrapper : public Object
 {
@@ -213,8 +222,27 @@ public:
   uint32_t GetDataLinkType (void);
 
 private:
+  /**
+   * \brief Get room for a record in the buffer of the async mode.
+   * \param size the size of the record
+   * \returns the start of the record
+   */
+  uint8_t *Reserve (uint32_t size);
+  /**
+   * \brief Write a record header in the buffer of the async mode.
+   * \param t the timestamp
+   * \param totalLen the size of the packet
+   * \returns the start of the packet data, and its size truncated to the snaplen
+   */
+  std::pair<uint8_t *, uint32_t> ReserveRecord (Time t, uint32_t totalLen);
+
   PcapFile m_file; //!< Pcap file
   uint32_t m_snapLen; //!< max length of saved packets
+  bool m_async; //!< write the records from the background thread
+  uint32_t m_bufferSize; //!< size of the buffers of the async mode
+  std::string m_filename; //!< name of the file
+  std::ios::openmode m_mode; //!< mode of the file
+  PcapAsyncFile *m_asyncFile; //!< state of the file in async mode, or 0
 };
 
 } // namespace ns3
@@ -30,9 +30,19 @@
  * when dealing with a large number of nodes.
  *
  * Currently, the ns-3 model of nix-vector routing supports IPv4 p2p links 
- * as well as CSMA links.  It does not (yet) provide support for 
- * efficient adaptation to link failures.  It simply flushes all nix-vector 
- * routing caches. Finally, IPv6 is not supported.
+ * as well as CSMA links.  When an interface goes down, only the 
+ * nix-vectors whose path crosses its channel are flushed, along with the 
+ * Ipv4 routes; any other change flushes all nix-vector routing caches. 
+ * Finally, IPv6 is not supported.
+ *
+ * The caches of a node hold every destination it has used, unless the 
+ * MaxCacheEntries attribute bounds them, in which case the least recently 
+ * used destinations are flushed first.  Instead of building the 
+ * nix-vectors on demand, Ipv4NixVectorRouting::PrecomputeNixVectors can 
+ * fill the caches for all the destinations, or for a traffic matrix, 
+ * before the simulation starts.  It searches a snapshot of the adjacency 
+ * of the nodes from several threads (see the NixVectorRoutingThreadCount 
+ * global value).
  *
  * \section api API and Usage
  *
@@ -20,11 +20,19 @@
 
 #include <queue>
 #include <iomanip>
+#include <algorithm>
 
 #include "ns3/log.h"
 #include "ns3/abort.h"
 #include "ns3/names.h"
+#include "ns3/uinteger.h"
+#include "ns3/global-value.h"
 #include "ns3/ipv4-list-routing.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include <unistd.h>
+#endif /* HAVE_PTHREAD_H */
 
 #include "ipv4-nix-vector-routing.h"
 
@@ -35,6 +43,15 @@ NS_LOG_COMPONENT_DEFINE ("Ipv4NixVectorRouting");
 NS_OBJECT_ENSURE_REGISTERED (Ipv4NixVectorRouting);
 
 bool Ipv4NixVectorRouting::g_isCacheDirty = false;
+std::vector<uint32_t> Ipv4NixVectorRouting::g_downChannels;
+
+/// The number of threads which run the searches of PrecomputeNixVectors
+static GlobalValue g_nixVectorRoutingThreadCount ("NixVectorRoutingThreadCount",
+                                                  "The number of threads which compute the nix-vectors "
+                                                  "of Ipv4NixVectorRouting::PrecomputeNixVectors, or zero "
+                                                  "to use one thread per online processor.",
+                                                  UintegerValue (0),
+                                                  MakeUintegerChecker<uint32_t> ());
 
 TypeId 
 Ipv4NixVectorRouting::GetTypeId (void)
@@ -42,12 +59,20 @@ Ipv4NixVectorRouting::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::Ipv4NixVectorRouting")
     .SetParent<Ipv4RoutingProtocol> ()
     .AddConstructor<Ipv4NixVectorRouting> ()
+    .AddAttribute ("MaxCacheEntries",
+                   "The maximum number of destinations in the caches of the node, "
+                   "beyond which the least recently used ones are flushed, or zero "
+                   "for no limit.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4NixVectorRouting::m_maxCacheEntries),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
 
 Ipv4NixVectorRouting::Ipv4NixVectorRouting ()
-  : m_totalNeighbors (0)
+  : m_maxCacheEntries (0),
+    m_totalNeighbors (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -111,6 +136,19 @@ Ipv4NixVectorRouting::FlushNixCache (void) const
 {
   NS_LOG_FUNCTION_NOARGS ();
   m_nixCache.clear ();
+  for (std::map<Ipv4Address, struct CacheEntry>::iterator i = m_cacheEntries.begin (); i != m_cacheEntries.end (); )
+    {
+      i->second.channels.clear ();
+      if (m_ipv4RouteCache.find (i->first) == m_ipv4RouteCache.end ())
+        {
+          m_lru.erase (i->second.lru);
+          m_cacheEntries.erase (i++);
+        }
+      else
+        {
+          i++;
+        }
+    }
 }
 
 void
@@ -118,10 +156,103 @@ Ipv4NixVectorRouting::FlushIpv4RouteCache (void) const
 {
   NS_LOG_FUNCTION_NOARGS ();
   m_ipv4RouteCache.clear ();
+  for (std::map<Ipv4Address, struct CacheEntry>::iterator i = m_cacheEntries.begin (); i != m_cacheEntries.end (); )
+    {
+      if (m_nixCache.find (i->first) == m_nixCache.end ())
+        {
+          m_lru.erase (i->second.lru);
+          m_cacheEntries.erase (i++);
+        }
+      else
+        {
+          i++;
+        }
+    }
+}
+
+void
+Ipv4NixVectorRouting::TouchCache (Ipv4Address address)
+{
+  NS_LOG_FUNCTION (this << address);
+  std::map<Ipv4Address, struct CacheEntry>::iterator i = m_cacheEntries.find (address);
+  if (i != m_cacheEntries.end ())
+    {
+      m_lru.splice (m_lru.begin (), m_lru, i->second.lru);
+    }
+  else
+    {
+      m_lru.push_front (address);
+      m_cacheEntries[address].lru = m_lru.begin ();
+    }
+  while (m_maxCacheEntries != 0 && m_cacheEntries.size () > m_maxCacheEntries)
+    {
+      NS_LOG_LOGIC ("Evicting " << m_lru.back () << " from the caches");
+      EvictCache (m_lru.back ());
+    }
+}
+
+void
+Ipv4NixVectorRouting::EvictCache (Ipv4Address address) const
+{
+  NS_LOG_FUNCTION (this << address);
+  std::map<Ipv4Address, struct CacheEntry>::iterator i = m_cacheEntries.find (address);
+  if (i == m_cacheEntries.end ())
+    {
+      return;
+    }
+  m_lru.erase (i->second.lru);
+  m_cacheEntries.erase (i);
+  m_nixCache.erase (address);
+  m_ipv4RouteCache.erase (address);
+}
+
+void
+Ipv4NixVectorRouting::InsertNixVector (Ipv4Address address, Ptr<NixVector> nixVector, std::vector<uint32_t> const &channels)
+{
+  NS_LOG_FUNCTION (this << address << nixVector);
+  m_nixCache[address] = nixVector;
+  TouchCache (address);
+  std::map<Ipv4Address, struct CacheEntry>::iterator i = m_cacheEntries.find (address);
+  if (i != m_cacheEntries.end ())
+    {
+      i->second.channels = channels;
+    }
+}
+
+void
+Ipv4NixVectorRouting::InvalidateChannels (std::vector<uint32_t> const &channels) const
+{
+  NS_LOG_FUNCTION (this << channels.size ());
+  // The Ipv4 routes are cheap to build again from the nix-vectors, and
+  // those of the transit nodes do not record which path they belong to.
+  m_ipv4RouteCache.clear ();
+  for (std::map<Ipv4Address, struct CacheEntry>::iterator i = m_cacheEntries.begin (); i != m_cacheEntries.end (); )
+    {
+      NixMap_t::iterator nix = m_nixCache.find (i->first);
+      bool crosses = false;
+      for (uint32_t j = 0; j < i->second.channels.size () && !crosses; j++)
+        {
+          crosses = std::find (channels.begin (), channels.end (), i->second.channels[j]) != channels.end ();
+        }
+      if (nix == m_nixCache.end () || crosses)
+        {
+          NS_LOG_LOGIC ("Flushing the nix-vector to " << i->first);
+          if (nix != m_nixCache.end ())
+            {
+              m_nixCache.erase (nix);
+            }
+          m_lru.erase (i->second.lru);
+          m_cacheEntries.erase (i++);
+        }
+      else
+        {
+          i++;
+        }
+    }
 }
 
 Ptr<NixVector>
-Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetDevice> oif)
+Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetDevice> oif, std::vector<uint32_t> &channels)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
@@ -153,7 +284,7 @@ Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetD
 
       BFS (NodeList::GetNNodes (), source, destNode, parentVector, oif);
 
-      if (BuildNixVector (parentVector, source->GetId (), destNode->GetId (), nixVector))
+      if (BuildNixVector (parentVector, source->GetId (), destNode->GetId (), nixVector, channels))
         {
           return nixVector;
         }
@@ -176,6 +307,7 @@ Ipv4NixVectorRouting::GetNixVectorInCache (Ipv4Address address)
   if (iter != m_nixCache.end ())
     {
       NS_LOG_LOGIC ("Found Nix-vector in cache.");
+      TouchCache (address);
       return iter->second;
     }
 
@@ -194,6 +326,7 @@ Ipv4NixVectorRouting::GetIpv4RouteInCache (Ipv4Address address)
   if (iter != m_ipv4RouteCache.end ())
     {
       NS_LOG_LOGIC ("Found Ipv4Route in cache.");
+      TouchCache (address);
       return iter->second;
     }
 
@@ -229,7 +362,8 @@ Ipv4NixVectorRouting::BuildNixVectorLocal (Ptr<NixVector> nixVector)
 }
 
 bool
-Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector)
+Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector,
+                                      std::vector<uint32_t> & channels)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
@@ -248,6 +382,8 @@ Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVec
   uint32_t numberOfDevices = parentNode->GetNDevices ();
   uint32_t destId = 0;
   uint32_t totalNeighbors = 0;
+  Ptr<Channel> localChannel;
+  Ptr<Channel> remoteChannel;
 
   // scan through the net devices on the parent node
   // and then look at the nodes adjacent to them
@@ -285,6 +421,8 @@ Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVec
           if (remoteNode->GetId () == dest)
             {
               destId = totalNeighbors + offset;
+              localChannel = channel;
+              remoteChannel = (*iter)->GetChannel ();
             }
           offset += 1;
         }
@@ -294,10 +432,18 @@ Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVec
   NS_LOG_LOGIC ("Adding Nix: " << destId << " with " 
                                << nixVector->BitCount (totalNeighbors) << " bits, for node " << parentNode->GetId ());
   nixVector->AddNeighborIndex (destId, nixVector->BitCount (totalNeighbors));
+  if (localChannel)
+    {
+      channels.push_back (localChannel->GetId ());
+      if (remoteChannel != localChannel)
+        {
+          channels.push_back (remoteChannel->GetId ());
+        }
+    }
 
   // recurse through parent vector, grabbing the path 
   // and building the nix vector
-  BuildNixVector (parentVector, source, (parentVector.at (dest))->GetId (), nixVector);
+  BuildNixVector (parentVector, source, (parentVector.at (dest))->GetId (), nixVector, channels);
   return true;
 }
 
@@ -506,10 +652,11 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
       NS_LOG_LOGIC ("Nix-vector not in cache, build: ");
       // Build the nix-vector, given this node and the
       // dest IP address
-      nixVectorInCache = GetNixVector (m_node, header.GetDestination (), oif);
+      std::vector<uint32_t> channels;
+      nixVectorInCache = GetNixVector (m_node, header.GetDestination (), oif, channels);
 
       // cache it
-      m_nixCache.insert (NixMap_t::value_type (header.GetDestination (), nixVectorInCache));
+      InsertNixVector (header.GetDestination (), nixVectorInCache, channels);
     }
 
   // path exists
@@ -588,6 +735,7 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
 
           // add rtentry to cache
           m_ipv4RouteCache.insert (Ipv4RouteMap_t::value_type (header.GetDestination (), rtentry));
+          TouchCache (header.GetDestination ());
         }
 
       NS_LOG_LOGIC ("Nix-vector contents: " << *nixVectorInCache << " : Remaining bits: " << nixVectorForPacket->GetRemainingBits ());
@@ -655,6 +803,7 @@ Ipv4NixVectorRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
 
       // add rtentry to cache
       m_ipv4RouteCache.insert (Ipv4RouteMap_t::value_type (header.GetDestination (), rtentry));
+      TouchCache (header.GetDestination ());
     }
 
   NS_LOG_LOGIC ("At Node " << m_node->GetId () << ", Extracting " << numberOfBits <<
@@ -724,7 +873,16 @@ Ipv4NixVectorRouting::NotifyInterfaceUp (uint32_t i)
 void
 Ipv4NixVectorRouting::NotifyInterfaceDown (uint32_t i)
 {
-  g_isCacheDirty = true;
+  // only the paths which cross the channel of the interface change
+  Ptr<Channel> channel = m_ipv4->GetNetDevice (i)->GetChannel ();
+  if (channel)
+    {
+      g_downChannels.push_back (channel->GetId ());
+    }
+  else
+    {
+      g_isCacheDirty = true;
+    }
 }
 void
 Ipv4NixVectorRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
@@ -892,6 +1050,329 @@ Ipv4NixVectorRouting::CheckCacheStateAndFlush (void) const
     {
       FlushGlobalNixRoutingCache ();
       g_isCacheDirty = false;
+      g_downChannels.clear ();
+    }
+  else if (!g_downChannels.empty ())
+    {
+      std::vector<uint32_t> channels;
+      channels.swap (g_downChannels);
+      for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+        {
+          Ptr<Ipv4NixVectorRouting> rp = (*i)->GetObject<Ipv4NixVectorRouting> ();
+          if (rp)
+            {
+              rp->InvalidateChannels (channels);
+            }
+        }
+    }
+}
+
+bool
+Ipv4NixVectorRouting::NixHop::operator< (struct NixHop const &o) const
+{
+  return node < o.node;
+}
+
+void
+Ipv4NixVectorRouting::BuildNixGraph (NixGraph &graph)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nNodes = NodeList::GetNNodes ();
+  graph.edgeOffsets.assign (1, 0);
+  graph.edges.clear ();
+  graph.hopOffsets.assign (1, 0);
+  graph.hops.clear ();
+  graph.totalNeighbors.assign (nNodes, 0);
+  for (uint32_t n = 0; n < nNodes; n++)
+    {
+      Ptr<Node> node = NodeList::GetNode (n);
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      uint32_t firstHop = graph.hops.size ();
+      for (uint32_t i = 0; i < node->GetNDevices (); i++)
+        {
+          Ptr<NetDevice> device = node->GetDevice (i);
+          Ptr<Channel> channel = device->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          NetDeviceContainer netDeviceContainer;
+          GetAdjacentNetDevices (device, channel, netDeviceContainer);
+
+          // the neighbors which BFS visits
+          bool up = device->IsLinkUp ();
+          if (up && ipv4)
+            {
+              int32_t interfaceIndex = ipv4->GetInterfaceForDevice (device);
+              up = interfaceIndex != -1 && ipv4->IsUp (interfaceIndex);
+            }
+          if (up)
+            {
+              for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
+                {
+                  graph.edges.push_back ((*iter)->GetNode ()->GetId ());
+                }
+            }
+
+          // the neighbors which BuildNixVector counts
+          if (device->IsBridge ())
+            {
+              continue;
+            }
+          for (uint32_t j = 0; j < netDeviceContainer.GetN (); j++)
+            {
+              struct NixHop hop;
+              hop.node = netDeviceContainer.Get (j)->GetNode ()->GetId ();
+              hop.index = graph.totalNeighbors[n] + j;
+              hop.localChannel = channel->GetId ();
+              hop.remoteChannel = netDeviceContainer.Get (j)->GetChannel ()->GetId ();
+              graph.hops.push_back (hop);
+            }
+          graph.totalNeighbors[n] += netDeviceContainer.GetN ();
+        }
+      graph.edgeOffsets.push_back (graph.edges.size ());
+
+      // sort the neighbors by id, keeping the last index of each like
+      // BuildNixVector does
+      std::vector<struct NixHop> hops (graph.hops.begin () + firstHop, graph.hops.end ());
+      graph.hops.resize (firstHop);
+      std::map<uint32_t, uint32_t> last;
+      for (uint32_t j = 0; j < hops.size (); j++)
+        {
+          last[hops[j].node] = j;
+        }
+      for (std::map<uint32_t, uint32_t>::const_iterator j = last.begin (); j != last.end (); j++)
+        {
+          graph.hops.push_back (hops[j->second]);
+        }
+      graph.hopOffsets.push_back (graph.hops.size ());
+    }
+}
+
+void
+Ipv4NixVectorRouting::RunNixBatch (NixBatch *batch)
+{
+  NixGraph const &graph = *batch->graph;
+  uint32_t nNodes = graph.totalNeighbors.size ();
+  uint32_t const none = 0xffffffff;
+  std::vector<uint32_t> parents;
+  std::vector<uint32_t> queue;
+  for (uint32_t j = batch->first; j < batch->end; j += batch->stride)
+    {
+      NixJob &job = (*batch->jobs)[j];
+
+      // the same search as BFS, without an output interface and to
+      // all the nodes
+      parents.assign (nNodes, none);
+      queue.clear ();
+      parents[job.source] = job.source;
+      queue.push_back (job.source);
+      for (uint32_t head = 0; head < queue.size (); head++)
+        {
+          uint32_t current = queue[head];
+          for (uint32_t e = graph.edgeOffsets[current]; e < graph.edgeOffsets[current + 1]; e++)
+            {
+              if (parents[graph.edges[e]] == none)
+                {
+                  parents[graph.edges[e]] = current;
+                  queue.push_back (graph.edges[e]);
+                }
+            }
+        }
+
+      job.nixVectors.assign (job.destinations.size (), 0);
+      job.channels.assign (job.destinations.size (), std::vector<uint32_t> ());
+      for (uint32_t d = 0; d < job.destinations.size (); d++)
+        {
+          uint32_t node = job.destinations[d].second;
+          if (node == job.source || parents[node] == none)
+            {
+              continue;
+            }
+          Ptr<NixVector> nixVector = Create<NixVector> ();
+          while (node != job.source)
+            {
+              uint32_t parent = parents[node];
+              struct NixHop key;
+              key.node = node;
+              std::vector<struct NixHop>::const_iterator begin = graph.hops.begin () + graph.hopOffsets[parent];
+              std::vector<struct NixHop>::const_iterator end = graph.hops.begin () + graph.hopOffsets[parent + 1];
+              std::vector<struct NixHop>::const_iterator hop = std::lower_bound (begin, end, key);
+              uint32_t index = 0;
+              if (hop != end && hop->node == node)
+                {
+                  index = hop->index;
+                  job.channels[d].push_back (hop->localChannel);
+                  if (hop->remoteChannel != hop->localChannel)
+                    {
+                      job.channels[d].push_back (hop->remoteChannel);
+                    }
+                }
+              nixVector->AddNeighborIndex (index, nixVector->BitCount (graph.totalNeighbors[parent]));
+              node = parent;
+            }
+          job.nixVectors[d] = nixVector;
+        }
+    }
+}
+
+void
+Ipv4NixVectorRouting::PrecomputeNixVectors (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  TrafficMatrix traffic;
+  std::vector<Ipv4Address> destinations;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+      if (ipv4 == 0)
+        {
+          continue;
+        }
+      for (uint32_t j = 0; j < ipv4->GetNInterfaces (); j++)
+        {
+          for (uint32_t k = 0; k < ipv4->GetNAddresses (j); k++)
+            {
+              Ipv4Address address = ipv4->GetAddress (j, k).GetLocal ();
+              if (!address.IsEqual (Ipv4Address::GetLoopback ()))
+                {
+                  destinations.push_back (address);
+                }
+            }
+        }
+    }
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      if ((*i)->GetObject<Ipv4NixVectorRouting> () == 0)
+        {
+          continue;
+        }
+      for (uint32_t j = 0; j < destinations.size (); j++)
+        {
+          traffic.push_back (std::make_pair (*i, destinations[j]));
+        }
+    }
+  PrecomputeNixVectors (traffic);
+}
+
+void
+Ipv4NixVectorRouting::PrecomputeNixVectors (TrafficMatrix const &traffic)
+{
+  NS_LOG_FUNCTION (traffic.size ());
+  if (traffic.empty ())
+    {
+      return;
+    }
+  Ptr<Ipv4NixVectorRouting> first = traffic.front ().first->GetObject<Ipv4NixVectorRouting> ();
+  NS_ASSERT_MSG (first, "Node " << traffic.front ().first->GetId () << " does not use nix-vector routing");
+  // apply the pending topology changes, which would otherwise flush
+  // the new nix-vectors
+  first->CheckCacheStateAndFlush ();
+
+  // the node of each destination, the first one which has the address
+  // like GetNodeByIp
+  std::map<Ipv4Address, uint32_t> nodeOfAddress;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+      if (ipv4 == 0)
+        {
+          continue;
+        }
+      for (uint32_t j = 0; j < ipv4->GetNInterfaces (); j++)
+        {
+          for (uint32_t k = 0; k < ipv4->GetNAddresses (j); k++)
+            {
+              nodeOfAddress.insert (std::make_pair (ipv4->GetAddress (j, k).GetLocal (), (*i)->GetId ()));
+            }
+        }
+    }
+
+  // one job per source
+  std::map<uint32_t, uint32_t> jobOfNode;
+  std::vector<NixJob> jobs;
+  for (TrafficMatrix::const_iterator i = traffic.begin (); i != traffic.end (); i++)
+    {
+      std::map<Ipv4Address, uint32_t>::const_iterator node = nodeOfAddress.find (i->second);
+      if (node == nodeOfAddress.end ())
+        {
+          NS_LOG_LOGIC ("No node has the address " << i->second);
+          continue;
+        }
+      uint32_t source = i->first->GetId ();
+      std::map<uint32_t, uint32_t>::iterator job = jobOfNode.find (source);
+      if (job == jobOfNode.end ())
+        {
+          NS_ASSERT_MSG (i->first->GetObject<Ipv4NixVectorRouting> (), "Node " << source << " does not use nix-vector routing");
+          job = jobOfNode.insert (std::make_pair (source, jobs.size ())).first;
+          jobs.push_back (NixJob ());
+          jobs.back ().source = source;
+        }
+      jobs[job->second].destinations.push_back (*node);
+    }
+
+  NixGraph graph;
+  first->BuildNixGraph (graph);
+
+  UintegerValue threadCount;
+  g_nixVectorRoutingThreadCount.GetValue (threadCount);
+  uint32_t threads = threadCount.Get ();
+#ifdef HAVE_PTHREAD_H
+  if (threads == 0)
+    {
+      long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+      threads = cpus > 0 ? cpus : 1;
+    }
+#else
+  threads = 1;
+#endif
+  // the jobs run in batches, so that the nix-vectors waiting to be
+  // cached never take much more memory than the caches of a few nodes
+  uint32_t batchSize = 64 * threads;
+  for (uint32_t begin = 0; begin < jobs.size (); begin += batchSize)
+    {
+      uint32_t end = std::min<uint32_t> (begin + batchSize, jobs.size ());
+      uint32_t workers = std::min<uint32_t> (threads, end - begin);
+      std::vector<NixBatch> batches (workers);
+      for (uint32_t i = 0; i < workers; i++)
+        {
+          batches[i].graph = &graph;
+          batches[i].jobs = &jobs;
+          batches[i].first = begin + i;
+          batches[i].end = end;
+          batches[i].stride = workers;
+        }
+#ifdef HAVE_PTHREAD_H
+      std::vector<Ptr<SystemThread> > running;
+      for (uint32_t i = 1; i < workers; i++)
+        {
+          Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (&Ipv4NixVectorRouting::RunNixBatch, &batches[i]));
+          thread->Start ();
+          running.push_back (thread);
+        }
+#endif /* HAVE_PTHREAD_H */
+      RunNixBatch (&batches[0]);
+#ifdef HAVE_PTHREAD_H
+      for (std::vector<Ptr<SystemThread> >::iterator i = running.begin (); i != running.end (); i++)
+        {
+          (*i)->Join ();
+        }
+#endif /* HAVE_PTHREAD_H */
+
+      for (uint32_t i = begin; i < end; i++)
+        {
+          NixJob &job = jobs[i];
+          Ptr<Ipv4NixVectorRouting> rp = NodeList::GetNode (job.source)->GetObject<Ipv4NixVectorRouting> ();
+          for (uint32_t d = 0; d < job.destinations.size (); d++)
+            {
+              if (job.nixVectors[d])
+                {
+                  rp->InsertNixVector (job.destinations[d].first, job.nixVectors[d], job.channels[d]);
+                }
+            }
+          // release the memory of the batch
+          job = NixJob ();
+        }
     }
 }
 
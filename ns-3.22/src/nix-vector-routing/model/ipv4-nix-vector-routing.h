@@ -21,7 +21,10 @@
 #ifndef IPV4_NIX_VECTOR_ROUTING_H
 #define IPV4_NIX_VECTOR_ROUTING_H
 
+#include <list>
 #include <map>
+#include <utility>
+#include <vector>
 
 #include "ns3/channel.h"
 #include "ns3/node-container.h"
@@ -80,7 +83,126 @@ public:
    */
   void FlushGlobalNixRoutingCache (void) const;
 
+  /**
+   * \brief Sources and destinations for which to compute nix-vectors
+   */
+  typedef std::vector<std::pair<Ptr<Node>, Ipv4Address> > TrafficMatrix;
+
+  /**
+   * \brief Fill the nix-vector caches of all the nodes for all the
+   * destinations
+   *
+   * The destinations are all the addresses of the nodes, except the
+   * loopback addresses. See PrecomputeNixVectors (TrafficMatrix const &).
+   */
+  static void PrecomputeNixVectors (void);
+
+  /**
+   * \brief Fill the nix-vector caches of some nodes for some destinations
+   *
+   * The nix-vectors are those which the nodes would build on demand,
+   * without an output interface. The breadth first searches run on a
+   * snapshot of the adjacency of the nodes, from the number of threads
+   * given by the NixVectorRoutingThreadCount global value. The caches
+   * must be filled again after a topology change, as they would be
+   * on demand.
+   *
+   * \param traffic the nodes, which must use nix-vector routing, with
+   * the destinations to reach from each
+   */
+  static void PrecomputeNixVectors (TrafficMatrix const &traffic);
+
 private:
+  /// A neighbor of a node, as counted in the nix-vectors
+  struct NixHop
+  {
+    uint32_t node;          //!< the id of the neighbor
+    uint32_t index;         //!< the neighbor index of the neighbor
+    uint32_t localChannel;  //!< the id of the channel of the local device
+    uint32_t remoteChannel; //!< the id of the channel of the device of the neighbor
+    /**
+     * \param o the other neighbor
+     * \returns whether this neighbor has a lower id
+     */
+    bool operator< (struct NixHop const &o) const;
+  };
+
+  /// A snapshot of the adjacency of the nodes, indexed by node id
+  struct NixGraph
+  {
+    std::vector<uint32_t> edgeOffsets;    //!< where the neighbors of each node start in edges
+    std::vector<uint32_t> edges;          //!< the neighbors reached through the devices which are up, in search order
+    std::vector<uint32_t> hopOffsets;     //!< where the neighbors of each node start in hops
+    std::vector<struct NixHop> hops;      //!< the neighbor index of each neighbor, by neighbor id
+    std::vector<uint32_t> totalNeighbors; //!< the number of neighbors of each node in the nix-vectors
+  };
+
+  /// The nix-vectors to compute from one node
+  struct NixJob
+  {
+    uint32_t source;                                       //!< the id of the node
+    std::vector<std::pair<Ipv4Address, uint32_t> > destinations; //!< the destinations, with the id of their node
+    std::vector<Ptr<NixVector> > nixVectors;               //!< the nix-vector of each destination, 0 if none
+    std::vector<std::vector<uint32_t> > channels;          //!< the channels crossed to each destination
+  };
+
+  /// The jobs run by one thread
+  struct NixBatch
+  {
+    NixGraph const *graph;      //!< the adjacency of the nodes
+    std::vector<NixJob> *jobs;  //!< all the jobs
+    uint32_t first;             //!< the first job of the thread
+    uint32_t end;               //!< the end of the jobs of the thread
+    uint32_t stride;            //!< the distance between the jobs of the thread
+  };
+
+  /// The state of a cached destination
+  struct CacheEntry
+  {
+    std::list<Ipv4Address>::iterator lru; //!< the position of the destination in m_lru
+    std::vector<uint32_t> channels;       //!< the ids of the channels crossed by the nix-vector
+  };
+
+  /**
+   * \brief Build a snapshot of the adjacency of the nodes
+   * \param graph the snapshot to fill
+   */
+  void BuildNixGraph (NixGraph &graph);
+
+  /**
+   * \brief Run the jobs of a thread
+   * \param batch the jobs
+   */
+  static void RunNixBatch (NixBatch *batch);
+
+  /**
+   * \brief Mark a destination as the most recently used one, and
+   * evict the least recently used destinations beyond MaxCacheEntries
+   * \param address the destination
+   */
+  void TouchCache (Ipv4Address address);
+
+  /**
+   * \brief Forget a destination
+   * \param address the destination
+   */
+  void EvictCache (Ipv4Address address) const;
+
+  /**
+   * \brief Cache a nix-vector
+   * \param address the destination
+   * \param nixVector the nix-vector, 0 if there is no path
+   * \param channels the ids of the channels which the nix-vector crosses
+   */
+  void InsertNixVector (Ipv4Address address, Ptr<NixVector> nixVector, std::vector<uint32_t> const &channels);
+
+  /**
+   * \brief Flush the nix-vectors which cross some channels, and all the
+   * Ipv4 routes
+   * \param channels the ids of the channels
+   */
+  void InvalidateChannels (std::vector<uint32_t> const &channels) const;
+
 
   /* flushes the cache which stores nix-vector based on
    * destination IP */
@@ -98,7 +220,7 @@ private:
   /*  takes in the source node and dest IP and calls GetNodeByIp,
    *  BFS, accounting for any output interface specified, and finally
    *  BuildNixVector to return the built nix-vector */
-  Ptr<NixVector> GetNixVector (Ptr<Node>, Ipv4Address, Ptr<NetDevice>);
+  Ptr<NixVector> GetNixVector (Ptr<Node>, Ipv4Address, Ptr<NetDevice>, std::vector<uint32_t> &);
 
   /* checks the cache based on dest IP for the nix-vector */
   Ptr<NixVector> GetNixVectorInCache (Ipv4Address);
@@ -114,8 +236,10 @@ private:
    * corresponding to the given Ipv4Address */
   Ptr<Node> GetNodeByIp (Ipv4Address);
 
-  /* Recurses the parent vector, created by BFS and actually builds the nixvector */
-  bool BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector);
+  /* Recurses the parent vector, created by BFS and actually builds the nixvector,
+   * adding the ids of the channels which it crosses to channels */
+  bool BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector,
+                       std::vector<uint32_t> & channels);
 
   /* special variation of BuildNixVector for when a node is sending to itself */
   bool BuildNixVectorLocal (Ptr<NixVector> nixVector);
@@ -171,12 +295,27 @@ private:
    */
   static bool g_isCacheDirty;
 
+  /* 
+   * Channels of the interfaces which went down since the caches were
+   * last checked: only the nix-vectors which cross them are flushed.
+   */
+  static std::vector<uint32_t> g_downChannels;
+
   /* Cache stores nix-vectors based on destination ip */
   mutable NixMap_t m_nixCache;
 
   /* Cache stores Ipv4Routes based on destination ip */
   mutable Ipv4RouteMap_t m_ipv4RouteCache;
 
+  /* Destinations in either cache, the most recently used first */
+  mutable std::list<Ipv4Address> m_lru;
+
+  /* State of the destinations in either cache */
+  mutable std::map<Ipv4Address, struct CacheEntry> m_cacheEntries;
+
+  /* Maximum number of destinations in the caches, 0 for no limit */
+  uint32_t m_maxCacheEntries;
+
   Ptr<Ipv4> m_ipv4;
   Ptr<Node> m_node;
 
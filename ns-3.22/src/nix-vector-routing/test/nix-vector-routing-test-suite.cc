@@ -0,0 +1,346 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/uinteger.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-list-routing-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-nix-vector-helper.h"
+#include "ns3/ipv4-nix-vector-routing.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4.h"
+#include "ns3/output-stream-wrapper.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * Build the test topology: a line 0-1-2-3, a branch 1-4, and a channel
+ * shared by 3, 4 and 5, each link being a subnet of its own.
+ *
+ * \param nodes the nodes to create
+ */
+void
+BuildTopology (NodeContainer &nodes)
+{
+  nodes.Create (6);
+  Ipv4StaticRoutingHelper staticRouting;
+  Ipv4NixVectorHelper nixRouting;
+  Ipv4ListRoutingHelper list;
+  list.Add (staticRouting, 0);
+  list.Add (nixRouting, 10);
+  InternetStackHelper stack;
+  stack.SetRoutingHelper (list);
+  stack.Install (nodes);
+
+  SimpleNetDeviceHelper devices;
+  Ipv4AddressHelper addresses;
+  addresses.SetBase ("10.1.1.0", "255.255.255.0");
+  uint32_t links[][3] = { { 0, 1, 6 }, { 1, 2, 6 }, { 2, 3, 6 }, { 1, 4, 6 }, { 3, 4, 5 } };
+  for (uint32_t i = 0; i < sizeof (links) / sizeof (links[0]); i++)
+    {
+      NodeContainer link;
+      for (uint32_t j = 0; j < 3 && links[i][j] < nodes.GetN (); j++)
+        {
+          link.Add (nodes.Get (links[i][j]));
+        }
+      addresses.Assign (devices.Install (link));
+      addresses.NewNetwork ();
+    }
+}
+
+/**
+ * \param node a node
+ * \returns the addresses of the other nodes, except the loopback ones
+ */
+std::vector<Ipv4Address>
+GetDestinations (Ptr<Node> node)
+{
+  std::vector<Ipv4Address> destinations;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      if (*i == node)
+        {
+          continue;
+        }
+      Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+      for (uint32_t j = 0; j < ipv4->GetNInterfaces (); j++)
+        {
+          for (uint32_t k = 0; k < ipv4->GetNAddresses (j); k++)
+            {
+              Ipv4Address address = ipv4->GetAddress (j, k).GetLocal ();
+              if (!address.IsEqual (Ipv4Address::GetLoopback ()))
+                {
+                  destinations.push_back (address);
+                }
+            }
+        }
+    }
+  return destinations;
+}
+
+/**
+ * Build the nix-vector of a node to a destination as RouteOutput does
+ * for locally originated packets.
+ *
+ * \param node the node
+ * \param destination the destination
+ * \returns whether there is a route
+ */
+bool
+RouteOutput (Ptr<Node> node, Ipv4Address destination)
+{
+  Ptr<Ipv4RoutingProtocol> routing = node->GetObject<Ipv4NixVectorRouting> ();
+  Ipv4Header header;
+  header.SetDestination (destination);
+  Socket::SocketErrno error;
+  return routing->RouteOutput (Create<Packet> (), header, 0, error) != 0;
+}
+
+/**
+ * \param node a node
+ * \returns the nix-vector cache of the node, as printed in its routing
+ * table
+ */
+std::string
+GetNixCache (Ptr<Node> node)
+{
+  Ptr<Ipv4RoutingProtocol> routing = node->GetObject<Ipv4NixVectorRouting> ();
+  std::ostringstream os;
+  routing->PrintRoutingTable (Create<OutputStreamWrapper> (&os));
+  std::string table = os.str ();
+  return table.substr (0, table.find ("Ipv4RouteCache:"));
+}
+
+/**
+ * \param node a node
+ * \returns the destinations in the nix-vector cache of the node
+ */
+std::vector<std::string>
+GetCachedDestinations (Ptr<Node> node)
+{
+  std::istringstream is (GetNixCache (node));
+  std::vector<std::string> destinations;
+  std::string line;
+  while (std::getline (is, line))
+    {
+      if (line.find ("10.") == 0)
+        {
+          destinations.push_back (line.substr (0, line.find (' ')));
+        }
+    }
+  return destinations;
+}
+
+} // anonymous namespace
+
+/**
+ * Check that PrecomputeNixVectors fills the caches with the nix-vectors
+ * which the nodes build on demand, whatever the number of threads.
+ */
+class NixVectorPrecomputeTestCase : public TestCase
+{
+public:
+  /**
+   * \param threads the value of NixVectorRoutingThreadCount
+   */
+  NixVectorPrecomputeTestCase (uint32_t threads);
+  virtual void DoRun (void);
+
+private:
+  uint32_t m_threads;
+};
+
+NixVectorPrecomputeTestCase::NixVectorPrecomputeTestCase (uint32_t threads)
+  : TestCase ("Check that the precomputed nix-vectors are those built on demand"),
+    m_threads (threads)
+{
+}
+
+void
+NixVectorPrecomputeTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  BuildTopology (nodes);
+
+  std::vector<std::string> onDemand;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      std::vector<Ipv4Address> destinations = GetDestinations (nodes.Get (i));
+      for (uint32_t j = 0; j < destinations.size (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (RouteOutput (nodes.Get (i), destinations[j]), true,
+                                 "No route from node " << i << " to " << destinations[j]);
+        }
+      onDemand.push_back (GetNixCache (nodes.Get (i)));
+    }
+
+  nodes.Get (0)->GetObject<Ipv4NixVectorRouting> ()->FlushGlobalNixRoutingCache ();
+  Config::SetGlobal ("NixVectorRoutingThreadCount", UintegerValue (m_threads));
+  Ipv4NixVectorRouting::PrecomputeNixVectors ();
+  Config::SetGlobal ("NixVectorRoutingThreadCount", UintegerValue (0));
+
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (GetNixCache (nodes.Get (i)), onDemand[i],
+                             "Wrong precomputed nix-vectors for node " << i);
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Check that the caches of a node hold at most MaxCacheEntries
+ * destinations, and evict the least recently used one.
+ */
+class NixVectorCacheLimitTestCase : public TestCase
+{
+public:
+  NixVectorCacheLimitTestCase ();
+  virtual void DoRun (void);
+};
+
+NixVectorCacheLimitTestCase::NixVectorCacheLimitTestCase ()
+  : TestCase ("Check that the nix-vector caches are bounded and evict the least recently used destination")
+{
+}
+
+void
+NixVectorCacheLimitTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  BuildTopology (nodes);
+  Ptr<Node> node = nodes.Get (0);
+  node->GetObject<Ipv4NixVectorRouting> ()->SetAttribute ("MaxCacheEntries", UintegerValue (2));
+
+  // 10.1.1.2, 10.1.2.2 and 10.1.3.2 are on nodes 1, 2 and 3
+  RouteOutput (node, Ipv4Address ("10.1.1.2"));
+  RouteOutput (node, Ipv4Address ("10.1.2.2"));
+  std::vector<std::string> cached = GetCachedDestinations (node);
+  NS_TEST_ASSERT_MSG_EQ (cached.size (), 2, "Wrong number of cached destinations");
+
+  // 10.1.1.2 is now used more recently than 10.1.2.2
+  RouteOutput (node, Ipv4Address ("10.1.1.2"));
+  RouteOutput (node, Ipv4Address ("10.1.3.2"));
+  cached = GetCachedDestinations (node);
+  NS_TEST_ASSERT_MSG_EQ (cached.size (), 2, "The cache grew beyond MaxCacheEntries");
+  NS_TEST_EXPECT_MSG_EQ (cached[0], "10.1.1.2", "The most recently used destination was evicted");
+  NS_TEST_EXPECT_MSG_EQ (cached[1], "10.1.3.2", "The new destination was not cached");
+
+  // a destination evicted from the caches is built again on demand
+  NS_TEST_EXPECT_MSG_EQ (RouteOutput (node, Ipv4Address ("10.1.2.2")), true, "No route to an evicted destination");
+  cached = GetCachedDestinations (node);
+  NS_TEST_ASSERT_MSG_EQ (cached.size (), 2, "The cache grew beyond MaxCacheEntries");
+  NS_TEST_EXPECT_MSG_EQ (cached[0], "10.1.2.2", "The destination was not cached again");
+  NS_TEST_EXPECT_MSG_EQ (cached[1], "10.1.3.2", "The least recently used destination was not evicted");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Check that when an interface goes down, a node only flushes the
+ * nix-vectors which cross the channel of that interface.
+ */
+class NixVectorInterfaceDownTestCase : public TestCase
+{
+public:
+  /**
+   * \param precompute whether to fill the caches with
+   * PrecomputeNixVectors, or on demand
+   */
+  NixVectorInterfaceDownTestCase (bool precompute);
+  virtual void DoRun (void);
+
+private:
+  bool m_precompute;
+};
+
+NixVectorInterfaceDownTestCase::NixVectorInterfaceDownTestCase (bool precompute)
+  : TestCase ("Check that an interface going down only flushes the nix-vectors which cross its channel"),
+    m_precompute (precompute)
+{
+}
+
+void
+NixVectorInterfaceDownTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  BuildTopology (nodes);
+  Ptr<Node> node = nodes.Get (0);
+  std::vector<Ipv4Address> destinations = GetDestinations (node);
+  if (m_precompute)
+    {
+      Ipv4NixVectorRouting::PrecomputeNixVectors ();
+    }
+  else
+    {
+      for (uint32_t i = 0; i < destinations.size (); i++)
+        {
+          RouteOutput (node, destinations[i]);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (GetCachedDestinations (node).size (), destinations.size (), "Not all the destinations are cached");
+
+  // Take down the interface of node 2 on the link 1-2 (10.1.2.0/24):
+  // the paths from node 0 to the nodes 2 and 3 cross it, and the paths
+  // to the nodes 1, 4 and 5 do not.
+  Ptr<Ipv4> ipv4 = nodes.Get (2)->GetObject<Ipv4> ();
+  ipv4->SetDown (ipv4->GetInterfaceForAddress (Ipv4Address ("10.1.2.2")));
+
+  std::vector<std::string> cached = GetCachedDestinations (node);
+  std::vector<std::string> expected;
+  expected.push_back ("10.1.1.2");  // node 1
+  expected.push_back ("10.1.2.1");  // node 1
+  expected.push_back ("10.1.4.1");  // node 1
+  expected.push_back ("10.1.4.2");  // node 4
+  expected.push_back ("10.1.5.2");  // node 4
+  expected.push_back ("10.1.5.3");  // node 5
+  NS_TEST_ASSERT_MSG_EQ (cached.size (), expected.size (), "Wrong number of nix-vectors left");
+  for (uint32_t i = 0; i < expected.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (cached[i], expected[i], "Wrong nix-vector left");
+    }
+
+  Simulator::Destroy ();
+}
+
+class NixVectorRoutingTestSuite : public TestSuite
+{
+public:
+  NixVectorRoutingTestSuite ()
+    : TestSuite ("nix-vector-routing", UNIT)
+  {
+    AddTestCase (new NixVectorPrecomputeTestCase (1), TestCase::QUICK);
+    AddTestCase (new NixVectorPrecomputeTestCase (4), TestCase::QUICK);
+    AddTestCase (new NixVectorCacheLimitTestCase (), TestCase::QUICK);
+    AddTestCase (new NixVectorInterfaceDownTestCase (false), TestCase::QUICK);
+    AddTestCase (new NixVectorInterfaceDownTestCase (true), TestCase::QUICK);
+  }
+} g_nixVectorRoutingTestSuite;
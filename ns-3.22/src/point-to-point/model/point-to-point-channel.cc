@@ -22,6 +22,7 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/core-config.h"
 
 namespace ns3 {
 
@@ -96,9 +97,17 @@ PointToPointChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
+#ifdef NS3_MT_SIMULATOR
+  // The receiver may run in another thread, while the sender still uses
+  // the packet for its PhyTxEnd trace: it strips its headers from its own
+  // copy, which only shares the buffers.
+  Ptr<Packet> rx = p->Copy ();
+#else
+  Ptr<Packet> rx = p;
+#endif
   Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
-                                  m_link[wire].m_dst, p);
+                                  m_link[wire].m_dst, rx);
 
   // Call the tx anim callback on the net device
   m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
@@ -355,9 +355,13 @@ PointToPointNetDevice::Receive (Ptr<Packet> packet)
 
       //
       // Trace sinks will expect complete packets, not packets without some of the
-      // headers.
+      // headers, so keep a copy when there are trace sinks to see it.
       //
-      Ptr<Packet> originalPacket = packet->Copy ();
+      Ptr<Packet> originalPacket;
+      if (!m_macRxTrace.IsEmpty () || !m_macPromiscRxTrace.IsEmpty ())
+        {
+          originalPacket = packet->Copy ();
+        }
 
       //
       // Strip off the point-to-point protocol header and forward this packet
@@ -1,8 +1,17 @@
 #include "ns3/test.h"
+#include "ns3/core-config.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/ppp-header.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/node-container.h"
+#include "ns3/data-rate.h"
+#include "ns3/uinteger.h"
+
+#include <vector>
 
 using namespace ns3;
 
@@ -73,6 +82,205 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+#ifdef NS3_MT_SIMULATOR
+/**
+ * \brief Test class for the PointToPoint model on the multithreaded
+ * simulator
+ *
+ * Pairs of nodes in different partitions exchange packets while the
+ * senders keep modifying the copies of the packets they sent, which
+ * share their buffers and tags: the receivers must get the packets as
+ * they were sent.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send a packet, and modify a copy of it
+   *
+   * \param device NetDevice to send from
+   * \param n the number of the packet
+   */
+  void Send (Ptr<PointToPointNetDevice> device, uint32_t n);
+
+  /**
+   * \brief Check a received packet
+   *
+   * \param device the receiving NetDevice
+   * \param packet the received packet
+   * \param protocol the protocol of the packet
+   * \param from the sender address
+   * \returns true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Check the payload and the tags of a packet
+   *
+   * \param packet the packet to check
+   * \param n the number of the packet
+   * \returns true if the packet holds the payload and tags of packet n
+   */
+  static bool IsIntact (Ptr<const Packet> packet, uint32_t n);
+
+  static const uint32_t PAYLOAD_SIZE = 600; //!< payload size of the packets
+
+  Ptr<MultithreadedSimulatorImpl> m_impl; //!< the simulator
+  std::vector<uint32_t> m_received; //!< packets received by each node
+  std::vector<uint32_t> m_crossed;  //!< packets of another partition received by each node
+  std::vector<uint32_t> m_errors;   //!< packets modified, by node
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest ()
+  : TestCase ("PointToPoint across the partitions of the multithreaded simulator")
+{
+}
+
+bool
+PointToPointMultithreadedTest::IsIntact (Ptr<const Packet> packet, uint32_t n)
+{
+  if (packet->GetSize () != PAYLOAD_SIZE)
+    {
+      return false;
+    }
+  uint8_t payload[PAYLOAD_SIZE];
+  packet->CopyData (payload, PAYLOAD_SIZE);
+  for (uint32_t i = 0; i < PAYLOAD_SIZE; i++)
+    {
+      if (payload[i] != static_cast<uint8_t> (n + i))
+        {
+          return false;
+        }
+    }
+  FlowIdTag tag;
+  if (!packet->PeekPacketTag (tag) || tag.GetFlowId () != n)
+    {
+      return false;
+    }
+  ByteTagIterator i = packet->GetByteTagIterator ();
+  if (!i.HasNext ())
+    {
+      return false;
+    }
+  ByteTagIterator::Item item = i.Next ();
+  item.GetTag (tag);
+  return tag.GetFlowId () == n && !i.HasNext ();
+}
+
+void
+PointToPointMultithreadedTest::Send (Ptr<PointToPointNetDevice> device, uint32_t n)
+{
+  uint8_t payload[PAYLOAD_SIZE];
+  for (uint32_t i = 0; i < PAYLOAD_SIZE; i++)
+    {
+      payload[i] = n + i;
+    }
+  Ptr<Packet> p = Create<Packet> (payload, PAYLOAD_SIZE);
+  p->AddPacketTag (FlowIdTag (n));
+  p->AddByteTag (FlowIdTag (n));
+  Ptr<Packet> copy = p->Copy ();
+  device->Send (p, device->GetBroadcast (), 0x800);
+
+  // The copy shares the buffer and the tags of the packet sent.
+  PppHeader header;
+  header.SetProtocol (0x0021);
+  copy->AddHeader (header);
+  copy->AddByteTag (FlowIdTag (n + 1));
+  FlowIdTag tag;
+  copy->RemovePacketTag (tag);
+  copy->AddPacketTag (FlowIdTag (n + 1));
+  copy->RemoveHeader (header);
+  copy->AddAtEnd (Create<Packet> (PAYLOAD_SIZE));
+}
+
+bool
+PointToPointMultithreadedTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                        uint16_t protocol, const Address &from)
+{
+  uint32_t node = device->GetNode ()->GetId ();
+  FlowIdTag tag;
+  packet->PeekPacketTag (tag);
+  m_received[node]++;
+  if (m_impl->GetPartition (tag.GetFlowId () / 1000) != m_impl->GetPartition (node))
+    {
+      m_crossed[node]++;
+    }
+  if (!IsIntact (packet, tag.GetFlowId ()))
+    {
+      m_errors[node]++;
+    }
+  return true;
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  Simulator::Destroy ();
+  m_impl = CreateObject<MultithreadedSimulatorImpl> ();
+  m_impl->SetAttribute ("ThreadCount", UintegerValue (2));
+  Simulator::SetImplementation (m_impl);
+
+  // The nodes are assigned to the partitions in the order of their ids:
+  // node i is connected to node i + pairs, in the other partition.
+  uint32_t pairs = 4;
+  uint32_t packets = 200;
+  NodeContainer nodes;
+  nodes.Create (2 * pairs);
+  std::vector<Ptr<PointToPointNetDevice> > devices (2 * pairs);
+  for (uint32_t i = 0; i < pairs; i++)
+    {
+      Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MilliSeconds (1)));
+      for (uint32_t j = i; j < 2 * pairs; j += pairs)
+        {
+          Ptr<PointToPointNetDevice> device = CreateObject<PointToPointNetDevice> ();
+          device->SetAttribute ("DataRate", DataRateValue (DataRate ("1Gbps")));
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetQueue (CreateObject<DropTailQueue> ());
+          device->Attach (channel);
+          // the node sets the receive callback of its devices
+          nodes.Get (j)->AddDevice (device);
+          device->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::Receive, this));
+          devices[j] = device;
+        }
+    }
+  m_received.assign (2 * pairs, 0);
+  m_crossed.assign (2 * pairs, 0);
+  m_errors.assign (2 * pairs, 0);
+
+  // The packets of node i are numbered from 1000 * i.
+  for (uint32_t i = 0; i < 2 * pairs; i++)
+    {
+      for (uint32_t n = 0; n < packets; n++)
+        {
+          Simulator::ScheduleWithContext (i, MicroSeconds (10 * n), &PointToPointMultithreadedTest::Send,
+                                          this, devices[i], 1000 * i + n);
+        }
+    }
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_impl->GetThreadCount (), 2, "Wrong number of partitions");
+  for (uint32_t i = 0; i < 2 * pairs; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_received[i], packets, "Wrong number of packets received by node " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_crossed[i], packets, "Packets received by node " << i << " from its own partition");
+      NS_TEST_EXPECT_MSG_EQ (m_errors[i], 0, "Packets received modified by node " << i);
+    }
+  Simulator::Destroy ();
+  m_impl = 0;
+}
+#endif /* NS3_MT_SIMULATOR */
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -89,6 +297,9 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+#ifdef NS3_MT_SIMULATOR
+  AddTestCase (new PointToPointMultithreadedTest, TestCase::QUICK);
+#endif
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
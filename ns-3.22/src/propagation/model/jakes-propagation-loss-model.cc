@@ -20,6 +20,8 @@
 
 #include "jakes-propagation-loss-model.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/log.h"
 
 namespace ns3
@@ -40,12 +42,64 @@ JakesPropagationLossModel::JakesPropagationLossModel()
 JakesPropagationLossModel::~JakesPropagationLossModel()
 {}
 
+void
+JakesPropagationLossModel::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_INFO ("cache hits=" << m_propagationCache.GetHits () <<
+               ", misses=" << m_propagationCache.GetMisses () <<
+               ", paths=" << m_propagationCache.GetSize ());
+  // the fading processes hold a reference to this model
+  m_propagationCache.Clear ();
+  PropagationLossModel::DoDispose ();
+}
+
+void
+JakesPropagationLossModel::SetCacheSize (uint32_t cacheSize)
+{
+  NS_LOG_FUNCTION (this << cacheSize);
+  m_propagationCache.SetMaxSize (cacheSize);
+}
+
+uint32_t
+JakesPropagationLossModel::GetCacheSize () const
+{
+  return m_propagationCache.GetMaxSize ();
+}
+
+void
+JakesPropagationLossModel::SetInvalidateOnCourseChange (bool invalidate)
+{
+  NS_LOG_FUNCTION (this << invalidate);
+  m_propagationCache.SetInvalidateOnCourseChange (invalidate);
+}
+
+bool
+JakesPropagationLossModel::GetInvalidateOnCourseChange () const
+{
+  return m_propagationCache.GetInvalidateOnCourseChange ();
+}
+
 TypeId
 JakesPropagationLossModel::GetTypeId ()
 {
   static TypeId tid = TypeId ("ns3::JakesPropagationLossModel")
     .SetParent<PropagationLossModel> ()
     .AddConstructor<JakesPropagationLossModel> ()
+    .AddAttribute ("CacheSize",
+                   "The maximum number of paths whose fading process is kept, "
+                   "the least recently used being removed first; 0 for no maximum.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&JakesPropagationLossModel::SetCacheSize,
+                                         &JakesPropagationLossModel::GetCacheSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("InvalidateOnCourseChange",
+                   "Whether to remove the fading processes of the paths of a node "
+                   "when it changes course, so that they are drawn again.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&JakesPropagationLossModel::SetInvalidateOnCourseChange,
+                                         &JakesPropagationLossModel::GetInvalidateOnCourseChange),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -64,6 +64,26 @@ private:
                         Ptr<MobilityModel> a,
                         Ptr<MobilityModel> b) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual void DoDispose ();
+
+  /**
+   * \param cacheSize the maximum number of paths in the cache, 0 for no maximum
+   */
+  void SetCacheSize (uint32_t cacheSize);
+  /**
+   * \return the maximum number of paths in the cache, 0 for no maximum
+   */
+  uint32_t GetCacheSize () const;
+  /**
+   * \param invalidate whether to remove the paths of a node from the
+   * cache when it changes course
+   */
+  void SetInvalidateOnCourseChange (bool invalidate);
+  /**
+   * \return whether the paths of a node are removed from the cache when
+   * it changes course
+   */
+  bool GetInvalidateOnCourseChange () const;
 
   /**
    * Get the underlying RNG stream
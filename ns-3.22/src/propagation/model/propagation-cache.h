@@ -21,7 +21,10 @@
 #define PROPAGATION_CACHE_H_
 
 #include "ns3/mobility-model.h"
+#include "ns3/callback.h"
+#include <list>
 #include <map>
+#include <set>
 
 namespace ns3
 {
@@ -30,13 +33,63 @@ namespace ns3
  * \brief Constructs a cache of objects, where each object is responsible for a single propagation path loss calculations.
  * Propagation path a-->b and b-->a is the same thing. Propagation path is identified by
  * a couple of MobilityModels and a spectrum model UID
+ *
+ * The cache can be bounded: when it holds more paths than its maximum
+ * size, the path least recently returned by GetPathData or added is
+ * removed.  It can also remove the paths of a mobility model whenever
+ * that model notifies a course change, so that the objects of the paths
+ * whose geometry changed are created again.
  */
 template<class T>
 class PropagationCache
 {
 public:
-  PropagationCache () {};
-  ~PropagationCache () {};
+  PropagationCache ()
+    : m_maxSize (0),
+      m_invalidateOnCourseChange (false),
+      m_hits (0),
+      m_misses (0)
+  {};
+  ~PropagationCache ()
+  {
+    Clear ();
+  };
+
+  /**
+   * \param maxSize the maximum number of paths, or zero for no maximum
+   *
+   * The least recently used paths beyond the maximum are removed.
+   */
+  void SetMaxSize (uint32_t maxSize)
+  {
+    m_maxSize = maxSize;
+    Evict ();
+  };
+  /**
+   * \return the maximum number of paths, or zero for no maximum
+   */
+  uint32_t GetMaxSize (void) const
+  {
+    return m_maxSize;
+  };
+  /**
+   * \param invalidate whether to remove the paths of a mobility model
+   * when it notifies a course change
+   *
+   * This only applies to the paths added afterwards.
+   */
+  void SetInvalidateOnCourseChange (bool invalidate)
+  {
+    m_invalidateOnCourseChange = invalidate;
+  };
+  /**
+   * \return whether the paths of a mobility model are removed when it
+   * notifies a course change
+   */
+  bool GetInvalidateOnCourseChange (void) const
+  {
+    return m_invalidateOnCourseChange;
+  };
 
   /**
    * Get the model associated with the path
@@ -51,9 +104,13 @@ public:
     typename PathCache::iterator it = m_pathCache.find (key);
     if (it == m_pathCache.end ())
       {
+        m_misses++;
         return 0;
       }
-    return it->second;
+    m_hits++;
+    // move the path to the front of the usage list
+    m_paths.splice (m_paths.begin (), m_paths, it->second);
+    return it->second->second;
   };
 
   /**
@@ -67,9 +124,67 @@ public:
   {
     PropagationPathIdentifier key = PropagationPathIdentifier (a, b, modelUid);
     NS_ASSERT (m_pathCache.find (key) == m_pathCache.end ());
-    m_pathCache.insert (std::make_pair (key, data)); 
+    m_paths.push_front (std::make_pair (key, data));
+    m_pathCache.insert (std::make_pair (key, m_paths.begin ()));
+    if (m_invalidateOnCourseChange)
+      {
+        Watch (key, a);
+        Watch (key, b);
+      }
+    Evict ();
   };
+
+  /**
+   * Remove all the paths.
+   */
+  void Clear (void)
+  {
+    for (typename MobilityPaths::iterator i = m_mobilityPaths.begin (); i != m_mobilityPaths.end (); ++i)
+      {
+        Unwatch (i->second.mobility);
+      }
+    m_mobilityPaths.clear ();
+    m_pathCache.clear ();
+    m_paths.clear ();
+  };
+
+  /**
+   * \return the number of paths in the cache
+   */
+  uint32_t GetSize (void) const
+  {
+    return m_pathCache.size ();
+  };
+  /**
+   * \return the number of calls to GetPathData which found their path
+   */
+  uint64_t GetHits (void) const
+  {
+    return m_hits;
+  };
+  /**
+   * \return the number of calls to GetPathData which did not find their path
+   */
+  uint64_t GetMisses (void) const
+  {
+    return m_misses;
+  };
+
 private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  PropagationCache (const PropagationCache &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  PropagationCache & operator = (const PropagationCache &);
+
   /// Each path is identified by
   struct PropagationPathIdentifier
   {
@@ -104,10 +219,126 @@ private:
     }
   };
 
-  /// Typedef: PropagationPathIdentifier, Ptr<T>
-  typedef std::map<PropagationPathIdentifier, Ptr<T> > PathCache;
-private:
-  PathCache m_pathCache; //!< Path cache
+  /// the paths, the most recently used first
+  typedef std::list<std::pair<PropagationPathIdentifier, Ptr<T> > > PathList;
+  /// Typedef: PropagationPathIdentifier, position of the path in the usage list
+  typedef std::map<PropagationPathIdentifier, typename PathList::iterator> PathCache;
+  /// the paths of a mobility model watched for course changes
+  struct WatchedMobility
+  {
+    Ptr<MobilityModel> mobility;                 //!< the mobility model
+    std::set<PropagationPathIdentifier> paths;   //!< its paths in the cache
+  };
+  /// Typedef: mobility model, its paths
+  typedef std::map<const MobilityModel *, WatchedMobility> MobilityPaths;
+
+  /**
+   * Remove the least recently used paths beyond the maximum size.
+   */
+  void Evict (void)
+  {
+    while (m_maxSize != 0 && m_pathCache.size () > m_maxSize)
+      {
+        Remove (m_paths.back ().first);
+      }
+  };
+  /**
+   * Remove a path.
+   * \param key the path
+   */
+  void Remove (PropagationPathIdentifier key)
+  {
+    Erase (key);
+    Forget (key, key.m_srcMobility);
+    Forget (key, key.m_dstMobility);
+  };
+  /**
+   * Remove a path from the cache and the usage list only.
+   * \param key the path
+   */
+  void Erase (const PropagationPathIdentifier &key)
+  {
+    typename PathCache::iterator it = m_pathCache.find (key);
+    NS_ASSERT (it != m_pathCache.end ());
+    m_paths.erase (it->second);
+    m_pathCache.erase (it);
+  };
+  /**
+   * Remove the path from the paths of a mobility model watched for
+   * course changes, and stop watching the model when it has no path.
+   * \param key the path
+   * \param mobility one of the mobility models of the path
+   */
+  void Forget (const PropagationPathIdentifier &key, Ptr<const MobilityModel> mobility)
+  {
+    typename MobilityPaths::iterator i = m_mobilityPaths.find (PeekPointer (mobility));
+    if (i == m_mobilityPaths.end ())
+      {
+        return;
+      }
+    i->second.paths.erase (key);
+    if (i->second.paths.empty ())
+      {
+        Unwatch (i->second.mobility);
+        m_mobilityPaths.erase (i);
+      }
+  };
+  /**
+   * Add the path to the paths of a mobility model watched for course
+   * changes, and start watching the model if needed.
+   * \param key the path
+   * \param mobility one of the mobility models of the path
+   */
+  void Watch (const PropagationPathIdentifier &key, Ptr<const MobilityModel> mobility)
+  {
+    WatchedMobility &watched = m_mobilityPaths[PeekPointer (mobility)];
+    if (watched.mobility == 0)
+      {
+        watched.mobility = ConstCast<MobilityModel> (mobility);
+        watched.mobility->TraceConnectWithoutContext ("CourseChange", MakeCallback (&PropagationCache<T>::CourseChanged, this));
+      }
+    watched.paths.insert (key);
+  };
+  /**
+   * \param mobility a mobility model whose course changes are watched
+   */
+  void Unwatch (Ptr<MobilityModel> mobility)
+  {
+    mobility->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&PropagationCache<T>::CourseChanged, this));
+  };
+  /**
+   * Remove the paths of a mobility model which changed course.
+   * \param mobility the mobility model
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility)
+  {
+    typename MobilityPaths::iterator i = m_mobilityPaths.find (PeekPointer (mobility));
+    if (i == m_mobilityPaths.end ())
+      {
+        return;
+      }
+    // the model cannot be disconnected while it notifies: it stays
+    // watched, without paths, until one of its next paths is removed.
+    std::set<PropagationPathIdentifier> paths;
+    paths.swap (i->second.paths);
+    for (typename std::set<PropagationPathIdentifier>::const_iterator j = paths.begin (); j != paths.end (); ++j)
+      {
+        Erase (*j);
+        Ptr<const MobilityModel> other = j->m_srcMobility == mobility ? j->m_dstMobility : j->m_srcMobility;
+        if (other != mobility)
+          {
+            Forget (*j, other);
+          }
+      }
+  };
+
+  PathList m_paths;                  //!< Paths, most recently used first
+  PathCache m_pathCache;             //!< Path cache
+  MobilityPaths m_mobilityPaths;     //!< Paths of the mobility models watched
+  uint32_t m_maxSize;                //!< Maximum number of paths, 0 for no maximum
+  bool m_invalidateOnCourseChange;   //!< Whether to watch the course changes
+  uint64_t m_hits;                   //!< Number of paths found
+  uint64_t m_misses;                 //!< Number of paths not found
 };
 } // namespace ns3
 
@@ -29,6 +29,7 @@
 #include "ns3/string.h"
 #include "ns3/pointer.h"
 #include <cmath>
+#include <limits>
 
 namespace ns3 {
 
@@ -81,6 +82,41 @@ PropagationLossModel::CalcRxPower (double txPowerDbm,
   return self;
 }
 
+void
+PropagationLossModel::CalcRxPowerBatch (double txPowerDbm,
+                                        Ptr<MobilityModel> a,
+                                        std::vector<Ptr<MobilityModel> > const &b,
+                                        std::vector<double> &rxPowerDbm) const
+{
+  NS_LOG_FUNCTION (this << txPowerDbm << a << b.size ());
+  Vector position = a->GetPosition ();
+  std::vector<double> distances;
+  distances.reserve (b.size ());
+  for (std::vector<Ptr<MobilityModel> >::const_iterator i = b.begin (); i != b.end (); ++i)
+    {
+      distances.push_back (CalculateDistance (position, (*i)->GetPosition ()));
+    }
+  rxPowerDbm.assign (b.size (), txPowerDbm);
+  // each model sees the destinations in the same order as with
+  // CalcRxPower, so that the random models draw the same values.
+  for (const PropagationLossModel *model = this; model != 0; model = PeekPointer (model->m_next))
+    {
+      model->DoCalcRxPowerBatch (a, b, distances, rxPowerDbm);
+    }
+}
+
+void
+PropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                          std::vector<Ptr<MobilityModel> > const &b,
+                                          std::vector<double> const &distances,
+                                          std::vector<double> &rxPowerDbm) const
+{
+  for (std::size_t i = 0; i < b.size (); i++)
+    {
+      rxPowerDbm[i] = DoCalcRxPower (rxPowerDbm[i], a, b[i]);
+    }
+}
+
 int64_t
 PropagationLossModel::AssignStreams (int64_t stream)
 {
@@ -93,6 +129,34 @@ PropagationLossModel::AssignStreams (int64_t stream)
   return (currentStream - stream);
 }
 
+double
+PropagationLossModel::GetRange (double txPowerDbm, double rxPowerDbm) const
+{
+  if (m_next == 0)
+    {
+      return DoGetRange (txPowerDbm, rxPowerDbm);
+    }
+  // The models before the last one must bound their power too: the others
+  // may be random, and the channels would change the values they draw by
+  // skipping the nodes beyond the range.
+  const PropagationLossModel *last = this;
+  for (; last->m_next != 0; last = PeekPointer (last->m_next))
+    {
+      if (last->DoGetRange (txPowerDbm, rxPowerDbm) == std::numeric_limits<double>::infinity ())
+        {
+          return std::numeric_limits<double>::infinity ();
+        }
+    }
+  // the power given to the last model is not bounded
+  return last->DoGetRange (std::numeric_limits<double>::infinity (), rxPowerDbm);
+}
+
+double
+PropagationLossModel::DoGetRange (double txPowerDbm, double rxPowerDbm) const
+{
+  return std::numeric_limits<double>::infinity ();
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (RandomPropagationLossModel);
@@ -222,6 +286,44 @@ double
 FriisPropagationLossModel::DoCalcRxPower (double txPowerDbm,
                                           Ptr<MobilityModel> a,
                                           Ptr<MobilityModel> b) const
+{
+  return CalcRxPowerAt (txPowerDbm, a->GetDistanceFrom (b));
+}
+
+void
+FriisPropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                               std::vector<Ptr<MobilityModel> > const &b,
+                                               std::vector<double> const &distances,
+                                               std::vector<double> &rxPowerDbm) const
+{
+  // the loss of CalcRxPowerAt, as 10 log10 (16 pi^2 L / lambda^2) + 20 log10 (d)
+  double constantDb = 10 * std::log10 (16 * M_PI * M_PI * m_systemLoss / (m_lambda * m_lambda));
+  double farField = 3 * m_lambda;
+  uint32_t nearField = 0;
+  for (std::size_t i = 0; i < distances.size (); i++)
+    {
+      double distance = distances[i];
+      if (distance < farField)
+        {
+          nearField++;
+        }
+      if (distance <= 0)
+        {
+          rxPowerDbm[i] -= m_minLoss;
+          continue;
+        }
+      rxPowerDbm[i] -= std::max (constantDb + 20 * std::log10 (distance), m_minLoss);
+    }
+  if (nearField > 0)
+    {
+      NS_LOG_WARN (nearField << " distances not within the far field region => inaccurate propagation loss values");
+    }
+  NS_LOG_DEBUG (distances.size () << " distances, loss at 1m=" << constantDb << "dB");
+}
+
+double
+FriisPropagationLossModel::CalcRxPowerAt (double txPowerDbm,
+                                          double distance) const
 {
   /*
    * Friis free space equation:
@@ -252,7 +354,6 @@ FriisPropagationLossModel::DoCalcRxPower (double txPowerDbm,
    * L: system loss (unit-less)
    * lambda: wavelength (m)
    */
-  double distance = a->GetDistanceFrom (b);
   if (distance < 3*m_lambda)
     {
       NS_LOG_WARN ("distance not within the far field region => inaccurate propagation loss value");
@@ -274,6 +375,17 @@ FriisPropagationLossModel::DoAssignStreams (int64_t stream)
   return 0;
 }
 
+double
+FriisPropagationLossModel::DoGetRange (double txPowerDbm, double rxPowerDbm) const
+{
+  // the distance beyond which the loss without m_minLoss exceeds
+  // txPowerDbm - rxPowerDbm:
+  //
+  //   txPowerDbm - rxPowerDbm = 20 log10 (4 * pi * d / lambda) + 10 log10 (L)
+  double lossDb = txPowerDbm - rxPowerDbm - 10 * std::log10 (m_systemLoss);
+  return m_lambda / (4 * M_PI) * std::pow (10.0, lossDb / 20);
+}
+
 // ------------------------------------------------------------------------- //
 // -- Two-Ray Ground Model ported from NS-2 -- tomhewer@mac.com -- Nov09 //
 
@@ -371,6 +483,47 @@ double
 TwoRayGroundPropagationLossModel::DoCalcRxPower (double txPowerDbm,
                                                  Ptr<MobilityModel> a,
                                                  Ptr<MobilityModel> b) const
+{
+  return CalcRxPowerAt (txPowerDbm, a->GetDistanceFrom (b),
+                        a->GetPosition ().z, b->GetPosition ().z);
+}
+
+void
+TwoRayGroundPropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                                      std::vector<Ptr<MobilityModel> > const &b,
+                                                      std::vector<double> const &distances,
+                                                      std::vector<double> &rxPowerDbm) const
+{
+  // the terms of CalcRxPowerAt which do not depend on the receiver
+  double txAntHeight = a->GetPosition ().z + m_heightAboveZ;
+  double crossoverPerHeight = 4 * M_PI * txAntHeight / m_lambda;
+  double friisDb = 10 * std::log10 (m_lambda * m_lambda / (16 * M_PI * M_PI * m_systemLoss));
+  double systemLossDb = 10 * std::log10 (m_systemLoss);
+  for (std::size_t i = 0; i < distances.size (); i++)
+    {
+      double distance = distances[i];
+      if (distance <= m_minDistance)
+        {
+          continue;
+        }
+      double rxAntHeight = b[i]->GetPosition ().z + m_heightAboveZ;
+      if (distance <= crossoverPerHeight * rxAntHeight)
+        {
+          rxPowerDbm[i] += friisDb - 20 * std::log10 (distance);
+        }
+      else
+        {
+          rxPowerDbm[i] += 20 * std::log10 (txAntHeight * rxAntHeight) - 40 * std::log10 (distance) - systemLossDb;
+        }
+    }
+  NS_LOG_DEBUG (distances.size () << " distances, tx antenna height=" << txAntHeight << "m");
+}
+
+double
+TwoRayGroundPropagationLossModel::CalcRxPowerAt (double txPowerDbm,
+                                                 double distance,
+                                                 double txZ,
+                                                 double rxZ) const
 {
   /*
    * Two-Ray Ground equation:
@@ -398,15 +551,14 @@ TwoRayGroundPropagationLossModel::DoCalcRxPower (double txPowerDbm,
    * rx = tx + 10 log10 (-----------------------)
    *                      (d * d * d * d) * L
    */
-  double distance = a->GetDistanceFrom (b);
   if (distance <= m_minDistance)
     {
       return txPowerDbm;
     }
 
   // Set the height of the Tx and Rx antennae
-  double txAntHeight = a->GetPosition ().z + m_heightAboveZ;
-  double rxAntHeight = b->GetPosition ().z + m_heightAboveZ;
+  double txAntHeight = txZ + m_heightAboveZ;
+  double rxAntHeight = rxZ + m_heightAboveZ;
 
   // Calculate a crossover distance, under which we use Friis
   /*
@@ -447,6 +599,16 @@ TwoRayGroundPropagationLossModel::DoAssignStreams (int64_t stream)
   return 0;
 }
 
+double
+TwoRayGroundPropagationLossModel::DoGetRange (double txPowerDbm, double rxPowerDbm) const
+{
+  // Beyond the crossover distance, the two-ray loss is larger than the
+  // Friis loss, so that the range of the Friis model bounds both, as
+  // long as the antennas are above the ground.
+  double lossDb = txPowerDbm - rxPowerDbm - 10 * std::log10 (m_systemLoss);
+  return std::max (m_minDistance, m_lambda / (4 * M_PI) * std::pow (10.0, lossDb / 20));
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (LogDistancePropagationLossModel);
@@ -503,7 +665,32 @@ LogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
                                                 Ptr<MobilityModel> a,
                                                 Ptr<MobilityModel> b) const
 {
-  double distance = a->GetDistanceFrom (b);
+  return CalcRxPowerAt (txPowerDbm, a->GetDistanceFrom (b));
+}
+
+void
+LogDistancePropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                                     std::vector<Ptr<MobilityModel> > const &b,
+                                                     std::vector<double> const &distances,
+                                                     std::vector<double> &rxPowerDbm) const
+{
+  double exponentDb = 10 * m_exponent;
+  double referenceLog = std::log10 (m_referenceDistance);
+  for (std::size_t i = 0; i < distances.size (); i++)
+    {
+      double distance = distances[i];
+      if (distance > m_referenceDistance)
+        {
+          rxPowerDbm[i] -= m_referenceLoss + exponentDb * (std::log10 (distance) - referenceLog);
+        }
+    }
+  NS_LOG_DEBUG (distances.size () << " distances, reference-attenuation=" << -m_referenceLoss << "dB");
+}
+
+double
+LogDistancePropagationLossModel::CalcRxPowerAt (double txPowerDbm,
+                                                double distance) const
+{
   if (distance <= m_referenceDistance)
     {
       return txPowerDbm;
@@ -535,6 +722,17 @@ LogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
   return 0;
 }
 
+double
+LogDistancePropagationLossModel::DoGetRange (double txPowerDbm, double rxPowerDbm) const
+{
+  if (m_exponent <= 0)
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  double pathLossDb = txPowerDbm - rxPowerDbm - m_referenceLoss;
+  return m_referenceDistance * std::max (1.0, std::pow (10.0, pathLossDb / (10 * m_exponent)));
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (ThreeLogDistancePropagationLossModel);
@@ -594,7 +792,47 @@ ThreeLogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
                                                      Ptr<MobilityModel> a,
                                                      Ptr<MobilityModel> b) const
 {
-  double distance = a->GetDistanceFrom (b);
+  return CalcRxPowerAt (txPowerDbm, a->GetDistanceFrom (b));
+}
+
+void
+ThreeLogDistancePropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                                          std::vector<Ptr<MobilityModel> > const &b,
+                                                          std::vector<double> const &distances,
+                                                          std::vector<double> &rxPowerDbm) const
+{
+  // the losses at the beginnings of the middle and far fields
+  double loss1 = m_referenceLoss + 10 * m_exponent0 * std::log10 (m_distance1 / m_distance0);
+  double loss2 = loss1 + 10 * m_exponent1 * std::log10 (m_distance2 / m_distance1);
+  for (std::size_t i = 0; i < distances.size (); i++)
+    {
+      double distance = distances[i];
+      NS_ASSERT (distance >= 0);
+      if (distance < m_distance0)
+        {
+          continue;
+        }
+      else if (distance < m_distance1)
+        {
+          rxPowerDbm[i] -= m_referenceLoss + 10 * m_exponent0 * std::log10 (distance / m_distance0);
+        }
+      else if (distance < m_distance2)
+        {
+          rxPowerDbm[i] -= loss1 + 10 * m_exponent1 * std::log10 (distance / m_distance1);
+        }
+      else
+        {
+          rxPowerDbm[i] -= loss2 + 10 * m_exponent2 * std::log10 (distance / m_distance2);
+        }
+    }
+  NS_LOG_DEBUG (distances.size () << " distances, attenuation at " << m_distance1 << "m=" << loss1
+                << "dB, at " << m_distance2 << "m=" << loss2 << "dB");
+}
+
+double
+ThreeLogDistancePropagationLossModel::CalcRxPowerAt (double txPowerDbm,
+                                                     double distance) const
+{
   NS_ASSERT (distance >= 0);
 
   // See doxygen comments for the formula and explanation
@@ -636,6 +874,37 @@ ThreeLogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
   return 0;
 }
 
+double
+ThreeLogDistancePropagationLossModel::DoGetRange (double txPowerDbm, double rxPowerDbm) const
+{
+  if (m_exponent0 < 0 || m_exponent1 < 0 || m_exponent2 < 0)
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  // the loss grows with the distance: find the field in which it
+  // reaches txPowerDbm - rxPowerDbm.
+  double pathLossDb = txPowerDbm - rxPowerDbm;
+  double pathLoss1 = m_referenceLoss + 10 * m_exponent0 * std::log10 (m_distance1 / m_distance0);
+  double pathLoss2 = pathLoss1 + 10 * m_exponent1 * std::log10 (m_distance2 / m_distance1);
+  if (pathLossDb < m_referenceLoss)
+    {
+      return m_distance0;
+    }
+  else if (pathLossDb < pathLoss1)
+    {
+      return m_distance0 * std::pow (10.0, (pathLossDb - m_referenceLoss) / (10 * m_exponent0));
+    }
+  else if (pathLossDb < pathLoss2)
+    {
+      return m_distance1 * std::pow (10.0, (pathLossDb - pathLoss1) / (10 * m_exponent1));
+    }
+  else if (m_exponent2 > 0)
+    {
+      return m_distance2 * std::pow (10.0, (pathLossDb - pathLoss2) / (10 * m_exponent2));
+    }
+  return std::numeric_limits<double>::infinity ();
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (NakagamiPropagationLossModel);
@@ -694,10 +963,50 @@ double
 NakagamiPropagationLossModel::DoCalcRxPower (double txPowerDbm,
                                              Ptr<MobilityModel> a,
                                              Ptr<MobilityModel> b) const
+{
+  return CalcRxPowerAt (txPowerDbm, a->GetDistanceFrom (b));
+}
+
+void
+NakagamiPropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                                  std::vector<Ptr<MobilityModel> > const &b,
+                                                  std::vector<double> const &distances,
+                                                  std::vector<double> &rxPowerDbm) const
+{
+  // the m of each distance field, and whether it selects the Erlang
+  // distribution, as in CalcRxPowerAt
+  double m[3] = { m_m0, m_m1, m_m2 };
+  bool erlang[3];
+  for (uint32_t j = 0; j < 3; j++)
+    {
+      erlang[j] = static_cast<unsigned int> (std::floor (m[j])) == m[j];
+    }
+  for (std::size_t i = 0; i < distances.size (); i++)
+    {
+      double distance = distances[i];
+      NS_ASSERT (distance >= 0);
+      uint32_t field = distance < m_distance1 ? 0 : (distance < m_distance2 ? 1 : 2);
+      double powerW = std::pow (10, (rxPowerDbm[i] - 30) / 10);
+      double resultPowerW;
+      if (erlang[field])
+        {
+          resultPowerW = m_erlangRandomVariable->GetValue (static_cast<unsigned int> (m[field]), powerW / m[field]);
+        }
+      else
+        {
+          resultPowerW = m_gammaRandomVariable->GetValue (m[field], powerW / m[field]);
+        }
+      rxPowerDbm[i] = 10 * std::log10 (resultPowerW) + 30;
+    }
+  NS_LOG_DEBUG ("Nakagami " << distances.size () << " distances");
+}
+
+double
+NakagamiPropagationLossModel::CalcRxPowerAt (double txPowerDbm,
+                                             double distance) const
 {
   // select m parameter
 
-  double distance = a->GetDistanceFrom (b);
   NS_ASSERT (distance >= 0);
 
   double m;
@@ -796,6 +1105,12 @@ FixedRssLossModel::DoAssignStreams (int64_t stream)
   return 0;
 }
 
+double
+FixedRssLossModel::DoGetRange (double txPowerDbm, double rxPowerDbm) const
+{
+  return m_rss < rxPowerDbm ? 0 : std::numeric_limits<double>::infinity ();
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (MatrixPropagationLossModel);
@@ -903,7 +1218,25 @@ RangePropagationLossModel::DoCalcRxPower (double txPowerDbm,
                                           Ptr<MobilityModel> a,
                                           Ptr<MobilityModel> b) const
 {
-  double distance = a->GetDistanceFrom (b);
+  return CalcRxPowerAt (txPowerDbm, a->GetDistanceFrom (b));
+}
+
+void
+RangePropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                               std::vector<Ptr<MobilityModel> > const &b,
+                                               std::vector<double> const &distances,
+                                               std::vector<double> &rxPowerDbm) const
+{
+  for (std::size_t i = 0; i < distances.size (); i++)
+    {
+      rxPowerDbm[i] = CalcRxPowerAt (rxPowerDbm[i], distances[i]);
+    }
+}
+
+double
+RangePropagationLossModel::CalcRxPowerAt (double txPowerDbm,
+                                          double distance) const
+{
   if (distance <= m_range)
     {
       return txPowerDbm;
@@ -920,6 +1253,12 @@ RangePropagationLossModel::DoAssignStreams (int64_t stream)
   return 0;
 }
 
+double
+RangePropagationLossModel::DoGetRange (double txPowerDbm, double rxPowerDbm) const
+{
+  return rxPowerDbm > -1000 ? m_range : std::numeric_limits<double>::infinity ();
+}
+
 // ------------------------------------------------------------------------- //
 
 } // namespace ns3
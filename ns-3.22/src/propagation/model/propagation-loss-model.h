@@ -28,6 +28,7 @@
 #include "ns3/object.h"
 #include "ns3/random-variable-stream.h"
 #include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -93,6 +94,45 @@ public:
                       Ptr<MobilityModel> a,
                       Ptr<MobilityModel> b) const;
 
+  /**
+   * Returns the Rx Power at many destinations, taking into account all
+   * the PropagationLossModel(s) chained to the current one.
+   *
+   * The result is the same as calling CalcRxPower for each destination
+   * in turn, but the distances are computed once for the whole chain,
+   * and the models compute the powers of all the destinations in one
+   * call, so that the channels call this once per transmission.
+   *
+   * \param txPowerDbm current transmission power (in dBm)
+   * \param a the mobility model of the source
+   * \param b the mobility models of the destinations
+   * \param rxPowerDbm the reception powers at the destinations (in dBm),
+   *        resized to the number of destinations
+   */
+  void CalcRxPowerBatch (double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         std::vector<Ptr<MobilityModel> > const &b,
+                         std::vector<double> &rxPowerDbm) const;
+
+  /**
+   * Returns a distance beyond which CalcRxPower returns less than
+   * rxPowerDbm, so that the channels need not compute the power
+   * received by the nodes which are further away.
+   *
+   * The models which cannot bound their received power, such as the
+   * random ones, return infinity.  A chain of models is bounded by its
+   * last model, when that model bounds the received power whatever the
+   * power given to it, as RangePropagationLossModel does, and when the
+   * other models of the chain bound their received power too.  A chain
+   * with a random model is thus never bounded, so that the channels do
+   * not change the values it draws by skipping the far nodes.
+   *
+   * \param txPowerDbm the transmission power (in dBm)
+   * \param rxPowerDbm a reception power (in dBm)
+   * \returns a distance (in meters), or infinity
+   */
+  double GetRange (double txPowerDbm, double rxPowerDbm) const;
+
   /**
    * If this loss model uses objects of type RandomVariableStream,
    * set the stream numbers to the integers starting with the offset
@@ -134,12 +174,38 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const = 0;
 
+  /**
+   * Updates the Rx Power at many destinations, taking into account only
+   * the particular PropagationLossModel.  The default implementation
+   * calls DoCalcRxPower for each destination in turn.
+   *
+   * \param a the mobility model of the source
+   * \param b the mobility models of the destinations
+   * \param distances the distances from the source to the destinations
+   * \param rxPowerDbm the powers given to this model, replaced by the
+   *        powers after its propagation loss (in dBm)
+   */
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   std::vector<Ptr<MobilityModel> > const &b,
+                                   std::vector<double> const &distances,
+                                   std::vector<double> &rxPowerDbm) const;
+
   /**
    * Subclasses must implement this; those not using random variables
    * can return zero
    */
   virtual int64_t DoAssignStreams (int64_t stream) = 0;
 
+  /**
+   * Returns a distance beyond which DoCalcRxPower returns less than
+   * rxPowerDbm.  The default implementation returns infinity.
+   *
+   * \param txPowerDbm the transmission power (in dBm)
+   * \param rxPowerDbm a reception power (in dBm)
+   * \returns a distance (in meters), or infinity
+   */
+  virtual double DoGetRange (double txPowerDbm, double rxPowerDbm) const;
+
   Ptr<PropagationLossModel> m_next; //!< Next propagation loss model in the list
 };
 
@@ -321,7 +387,18 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   std::vector<Ptr<MobilityModel> > const &b,
+                                   std::vector<double> const &distances,
+                                   std::vector<double> &rxPowerDbm) const;
+  /**
+   * \param txPowerDbm the transmission power (in dBm)
+   * \param distance the distance between the source and the destination
+   * \returns the reception power (in dBm)
+   */
+  double CalcRxPowerAt (double txPowerDbm, double distance) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual double DoGetRange (double txPowerDbm, double rxPowerDbm) const;
 
   /**
    * Transforms a Dbm value to Watt
@@ -441,7 +518,20 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   std::vector<Ptr<MobilityModel> > const &b,
+                                   std::vector<double> const &distances,
+                                   std::vector<double> &rxPowerDbm) const;
+  /**
+   * \param txPowerDbm the transmission power (in dBm)
+   * \param distance the distance between the source and the destination
+   * \param txZ the height of the source
+   * \param rxZ the height of the destination
+   * \returns the reception power (in dBm)
+   */
+  double CalcRxPowerAt (double txPowerDbm, double distance, double txZ, double rxZ) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual double DoGetRange (double txPowerDbm, double rxPowerDbm) const;
 
   /**
    * Transforms a Dbm value to Watt
@@ -529,7 +619,18 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   std::vector<Ptr<MobilityModel> > const &b,
+                                   std::vector<double> const &distances,
+                                   std::vector<double> &rxPowerDbm) const;
+  /**
+   * \param txPowerDbm the transmission power (in dBm)
+   * \param distance the distance between the source and the destination
+   * \returns the reception power (in dBm)
+   */
+  double CalcRxPowerAt (double txPowerDbm, double distance) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual double DoGetRange (double txPowerDbm, double rxPowerDbm) const;
 
   /**
    *  Creates a default reference loss model
@@ -612,7 +713,18 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   std::vector<Ptr<MobilityModel> > const &b,
+                                   std::vector<double> const &distances,
+                                   std::vector<double> &rxPowerDbm) const;
+  /**
+   * \param txPowerDbm the transmission power (in dBm)
+   * \param distance the distance between the source and the destination
+   * \returns the reception power (in dBm)
+   */
+  double CalcRxPowerAt (double txPowerDbm, double distance) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual double DoGetRange (double txPowerDbm, double rxPowerDbm) const;
 
   double m_distance0; //!< Beginning of the first (near) distance field
   double m_distance1; //!< Beginning of the second (middle) distance field.
@@ -676,6 +788,16 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   std::vector<Ptr<MobilityModel> > const &b,
+                                   std::vector<double> const &distances,
+                                   std::vector<double> &rxPowerDbm) const;
+  /**
+   * \param txPowerDbm the transmission power (in dBm)
+   * \param distance the distance between the source and the destination
+   * \returns the reception power (in dBm)
+   */
+  double CalcRxPowerAt (double txPowerDbm, double distance) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 
   double m_distance1; //!< Distance1
@@ -740,6 +862,7 @@ private:
                                 Ptr<MobilityModel> b) const;
 
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual double DoGetRange (double txPowerDbm, double rxPowerDbm) const;
   double m_rss; //!< the received signal strength
 };
 
@@ -844,7 +967,18 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   std::vector<Ptr<MobilityModel> > const &b,
+                                   std::vector<double> const &distances,
+                                   std::vector<double> &rxPowerDbm) const;
+  /**
+   * \param txPowerDbm the transmission power (in dBm)
+   * \param distance the distance between the source and the destination
+   * \returns the reception power (in dBm)
+   */
+  double CalcRxPowerAt (double txPowerDbm, double distance) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual double DoGetRange (double txPowerDbm, double rxPowerDbm) const;
 private:
   double m_range; //!< Maximum Transmission Range (meters)
 };
@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/object.h"
+#include "ns3/boolean.h"
+#include "ns3/propagation-cache.h"
+#include "ns3/jakes-propagation-loss-model.h"
+#include "ns3/constant-position-mobility-model.h"
+
+using namespace ns3;
+
+/**
+ * The least recently used paths are removed first, and the paths are
+ * the same in both directions.
+ */
+class PropagationCacheLruTestCase : public TestCase
+{
+public:
+  PropagationCacheLruTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+PropagationCacheLruTestCase::PropagationCacheLruTestCase ()
+  : TestCase ("Remove the least recently used paths")
+{
+}
+
+void
+PropagationCacheLruTestCase::DoRun (void)
+{
+  std::vector<Ptr<MobilityModel> > m;
+  std::vector<Ptr<Object> > data;
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      m.push_back (CreateObject<ConstantPositionMobilityModel> ());
+      data.push_back (CreateObject<Object> ());
+    }
+
+  PropagationCache<Object> cache;
+  cache.SetMaxSize (3);
+  cache.AddPathData (data[0], m[0], m[1], 0);
+  cache.AddPathData (data[1], m[0], m[2], 0);
+  cache.AddPathData (data[2], m[1], m[2], 0);
+  NS_TEST_EXPECT_MSG_EQ (cache.GetPathData (m[1], m[0], 0), data[0], "the path is not symmetrical");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetPathData (m[0], m[1], 1), 0, "the model uid is not part of the path");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 3, "wrong number of paths");
+
+  // the path of m[0] and m[2] is now the least recently used
+  cache.AddPathData (data[3], m[3], m[4], 0);
+  NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 3, "the cache is not bounded");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetPathData (m[0], m[2], 0), 0, "the least recently used path is kept");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetPathData (m[0], m[1], 0), data[0], "a recently used path is removed");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetPathData (m[1], m[2], 0), data[2], "a recently added path is removed");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetPathData (m[4], m[3], 0), data[3], "the added path is removed");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetHits (), 4, "wrong number of hits");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetMisses (), 2, "wrong number of misses");
+
+  cache.SetMaxSize (1);
+  NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 1, "the cache is not shrunk");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetPathData (m[3], m[4], 0), data[3], "the most recently used path is removed");
+  cache.SetMaxSize (0);
+  cache.AddPathData (data[4], m[2], m[4], 0);
+  NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 2, "the cache is still bounded");
+}
+
+/**
+ * The paths of a mobility model are removed when it changes course.
+ */
+class PropagationCacheCourseChangeTestCase : public TestCase
+{
+public:
+  PropagationCacheCourseChangeTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+PropagationCacheCourseChangeTestCase::PropagationCacheCourseChangeTestCase ()
+  : TestCase ("Remove the paths of the models which change course")
+{
+}
+
+void
+PropagationCacheCourseChangeTestCase::DoRun (void)
+{
+  std::vector<Ptr<MobilityModel> > m;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      m.push_back (CreateObject<ConstantPositionMobilityModel> ());
+    }
+  Ptr<Object> data = CreateObject<Object> ();
+
+  {
+    PropagationCache<Object> cache;
+    cache.SetInvalidateOnCourseChange (true);
+    NS_TEST_EXPECT_MSG_EQ (cache.GetInvalidateOnCourseChange (), true, "the setting is lost");
+    cache.AddPathData (data, m[0], m[1], 0);
+    cache.AddPathData (data, m[0], m[2], 0);
+    cache.AddPathData (data, m[0], m[2], 1);
+    cache.AddPathData (data, m[2], m[3], 0);
+    cache.AddPathData (data, m[3], m[3], 0);
+
+    m[0]->SetPosition (Vector (1, 0, 0));
+    NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 2, "the paths of the model are kept");
+    NS_TEST_EXPECT_MSG_EQ (cache.GetPathData (m[2], m[3], 0), data, "another path is removed");
+    m[3]->SetPosition (Vector (1, 0, 0));
+    NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 0, "the paths of the model are kept");
+
+    // the cache stops watching the models of the paths removed
+    cache.SetMaxSize (1);
+    cache.AddPathData (data, m[0], m[1], 0);
+    cache.AddPathData (data, m[2], m[3], 0);
+    m[2]->SetPosition (Vector (2, 0, 0));
+    NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 0, "the path is kept");
+    cache.AddPathData (data, m[1], m[2], 0);
+    m[0]->SetPosition (Vector (2, 0, 0));
+    NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 1, "the path is removed");
+  }
+  // the cache destroyed stops watching the models
+  m[1]->SetPosition (Vector (3, 0, 0));
+
+  // the attribute of the model which uses the cache can be read back
+  Ptr<JakesPropagationLossModel> jakes = CreateObject<JakesPropagationLossModel> ();
+  jakes->SetAttribute ("InvalidateOnCourseChange", BooleanValue (true));
+  BooleanValue invalidate (false);
+  jakes->GetAttribute ("InvalidateOnCourseChange", invalidate);
+  NS_TEST_EXPECT_MSG_EQ (invalidate.Get (), true, "wrong InvalidateOnCourseChange");
+}
+
+static class PropagationCacheTestSuite : public TestSuite
+{
+public:
+  PropagationCacheTestSuite ()
+    : TestSuite ("propagation-cache", UNIT)
+  {
+    AddTestCase (new PropagationCacheLruTestCase (), TestCase::QUICK);
+    AddTestCase (new PropagationCacheCourseChangeTestCase (), TestCase::QUICK);
+  }
+} g_propagationCacheTestSuite;
@@ -24,6 +24,9 @@
 #include "ns3/propagation-loss-model.h"
 #include "ns3/constant-position-mobility-model.h"
 #include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include <limits>
+#include <vector>
 
 using namespace ns3;
 
@@ -436,6 +439,185 @@ RangePropagationLossModelTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class GetRangeTestCase : public TestCase
+{
+public:
+  GetRangeTestCase ();
+  virtual ~GetRangeTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check that the received power is below rxPowerDbm beyond the range,
+   * and, if tight, that it is not just before the range.
+   */
+  void CheckRange (Ptr<PropagationLossModel> lossModel, double txPowerDbm, double rxPowerDbm, bool tight);
+};
+
+GetRangeTestCase::GetRangeTestCase ()
+  : TestCase ("Check the ranges returned by GetRange")
+{
+}
+
+GetRangeTestCase::~GetRangeTestCase ()
+{
+}
+
+void
+GetRangeTestCase::CheckRange (Ptr<PropagationLossModel> lossModel, double txPowerDbm, double rxPowerDbm, bool tight)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0,0,0));
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  double range = lossModel->GetRange (txPowerDbm, rxPowerDbm);
+  NS_TEST_ASSERT_MSG_LT (range, 1e9, "no range for " << rxPowerDbm << " dBm");
+  double factors[] = { 1.001, 1.5, 10 };
+  for (uint32_t i = 0; i < sizeof (factors) / sizeof (factors[0]); i++)
+    {
+      b->SetPosition (Vector (range * factors[i], 0, 1));
+      NS_TEST_EXPECT_MSG_LT (lossModel->CalcRxPower (txPowerDbm, a, b), rxPowerDbm,
+                             "received power too high beyond " << range << "m");
+    }
+  if (tight)
+    {
+      b->SetPosition (Vector (range * 0.999, 0, 0));
+      NS_TEST_EXPECT_MSG_GT_OR_EQ (lossModel->CalcRxPower (txPowerDbm, a, b), rxPowerDbm,
+                                   "range " << range << "m too large");
+    }
+}
+
+void
+GetRangeTestCase::DoRun (void)
+{
+  double thresholds[] = { -60, -80, -96, -110 };
+  for (uint32_t i = 0; i < sizeof (thresholds) / sizeof (thresholds[0]); i++)
+    {
+      CheckRange (CreateObject<FriisPropagationLossModel> (), 16, thresholds[i], true);
+      CheckRange (CreateObject<TwoRayGroundPropagationLossModel> (), 16, thresholds[i], false);
+      CheckRange (CreateObject<LogDistancePropagationLossModel> (), 16, thresholds[i], true);
+      CheckRange (CreateObject<ThreeLogDistancePropagationLossModel> (), 16, thresholds[i], true);
+      CheckRange (CreateObject<RangePropagationLossModel> (), 16, thresholds[i], false);
+    }
+
+  // the random models, the chains whose last model can raise the power,
+  // and the chains with a random model are not bounded
+  Ptr<PropagationLossModel> logDistance = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<PropagationLossModel> nakagami = CreateObject<NakagamiPropagationLossModel> ();
+  NS_TEST_EXPECT_MSG_EQ (nakagami->GetRange (16, -96), std::numeric_limits<double>::infinity (),
+                         "the Nakagami model is bounded");
+  logDistance->SetNext (nakagami);
+  NS_TEST_EXPECT_MSG_EQ (logDistance->GetRange (16, -96), std::numeric_limits<double>::infinity (),
+                         "a chain ending with a Nakagami model is bounded");
+  nakagami->SetNext (CreateObject<RangePropagationLossModel> ());
+  NS_TEST_EXPECT_MSG_EQ (logDistance->GetRange (16, -96), std::numeric_limits<double>::infinity (),
+                         "a chain with a Nakagami model is bounded");
+  logDistance->SetNext (CreateObject<RangePropagationLossModel> ());
+  CheckRange (logDistance, 16, -96, false);
+  Simulator::Destroy ();
+}
+
+class CalcRxPowerBatchTestCase : public TestCase
+{
+public:
+  CalcRxPowerBatchTestCase ();
+  virtual ~CalcRxPowerBatchTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param kind the index of a model, or of a chain of models
+   * \returns the model, or the first model of the chain, 0 past the last one
+   */
+  Ptr<PropagationLossModel> CreateModel (uint32_t kind) const;
+};
+
+CalcRxPowerBatchTestCase::CalcRxPowerBatchTestCase ()
+  : TestCase ("Check that CalcRxPowerBatch returns the powers of CalcRxPower")
+{
+}
+
+CalcRxPowerBatchTestCase::~CalcRxPowerBatchTestCase ()
+{
+}
+
+Ptr<PropagationLossModel>
+CalcRxPowerBatchTestCase::CreateModel (uint32_t kind) const
+{
+  Ptr<PropagationLossModel> model;
+  switch (kind)
+    {
+    case 0:
+      return CreateObject<FriisPropagationLossModel> ();
+    case 1:
+      return CreateObject<TwoRayGroundPropagationLossModel> ();
+    case 2:
+      return CreateObject<LogDistancePropagationLossModel> ();
+    case 3:
+      return CreateObject<ThreeLogDistancePropagationLossModel> ();
+    case 4:
+      return CreateObject<NakagamiPropagationLossModel> ();
+    case 5:
+      return CreateObject<RangePropagationLossModel> ();
+    case 6:
+      // a model without its own batch computation
+      return CreateObject<RandomPropagationLossModel> ();
+    case 7:
+      model = CreateObject<LogDistancePropagationLossModel> ();
+      model->SetNext (CreateObject<NakagamiPropagationLossModel> ());
+      model->GetNext ()->SetNext (CreateObject<RandomPropagationLossModel> ());
+      model->GetNext ()->GetNext ()->SetNext (CreateObject<RangePropagationLossModel> ());
+      return model;
+    default:
+      return 0;
+    }
+}
+
+void
+CalcRxPowerBatchTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (10, 20, 1.5));
+  std::vector<Ptr<MobilityModel> > b;
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (random->GetValue (-500, 500), random->GetValue (-500, 500),
+                                     random->GetValue (0, 5)));
+      b.push_back (mobility);
+    }
+  // a receiver at the position of the source
+  b.push_back (a);
+
+  for (uint32_t kind = 0; CreateModel (kind) != 0; kind++)
+    {
+      Ptr<PropagationLossModel> batchModel = CreateModel (kind);
+      Ptr<PropagationLossModel> model = CreateModel (kind);
+      batchModel->AssignStreams (7);
+      model->AssignStreams (7);
+      for (uint32_t k = 0; k < 3; k++)
+        {
+          std::vector<double> rxPowerDbm;
+          batchModel->CalcRxPowerBatch (16, a, b, rxPowerDbm);
+          NS_TEST_ASSERT_MSG_EQ (rxPowerDbm.size (), b.size (), "wrong number of powers");
+          for (uint32_t i = 0; i < b.size (); i++)
+            {
+              // the batches compute the same formulas, rearranged; the
+              // macro evaluates its limit more than once, and it must draw
+              // the random variables of the model only once
+              double expected = model->CalcRxPower (16, a, b[i]);
+              NS_TEST_EXPECT_MSG_EQ_TOL (rxPowerDbm[i], expected, 1e-9,
+                                         "model " << kind << ", receiver " << i);
+            }
+        }
+    }
+  std::vector<double> rxPowerDbm (3, 0);
+  CreateModel (0)->CalcRxPowerBatch (16, a, std::vector<Ptr<MobilityModel> > (), rxPowerDbm);
+  NS_TEST_EXPECT_MSG_EQ (rxPowerDbm.size (), 0, "powers without receivers");
+  Simulator::Destroy ();
+}
+
 class PropagationLossModelsTestSuite : public TestSuite
 {
 public:
@@ -450,6 +632,8 @@ PropagationLossModelsTestSuite::PropagationLossModelsTestSuite ()
   AddTestCase (new LogDistancePropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new MatrixPropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new RangePropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new GetRangeTestCase, TestCase::QUICK);
+  AddTestCase (new CalcRxPowerBatchTestCase, TestCase::QUICK);
 }
 
 static PropagationLossModelsTestSuite propagationLossModelsTestSuite;
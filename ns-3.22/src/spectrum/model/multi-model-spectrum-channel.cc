@@ -33,8 +33,11 @@
 #include <ns3/propagation-loss-model.h>
 #include <ns3/propagation-delay-model.h>
 #include <ns3/antenna-model.h>
+#include <ns3/isotropic-antenna-model.h>
 #include <ns3/angles.h>
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <utility>
 #include "multi-model-spectrum-channel.h"
 
@@ -75,7 +78,18 @@ RxSpectrumModelInfo::RxSpectrumModelInfo (Ptr<const SpectrumModel> rxSpectrumMod
 }
 
 
+/**
+ * \param antenna an antenna, or 0
+ * \return true if the antenna may change the received power
+ */
+static bool
+HasGain (Ptr<AntennaModel> antenna)
+{
+  return antenna != 0 && DynamicCast<IsotropicAntennaModel> (antenna) == 0;
+}
+
 MultiModelSpectrumChannel::MultiModelSpectrumChannel ()
+  : m_nIndexed (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -89,6 +103,10 @@ MultiModelSpectrumChannel::DoDispose ()
   m_spectrumPropagationLoss = 0;
   m_txSpectrumModelInfoMap.clear ();
   m_rxSpectrumModelInfoMap.clear ();
+  m_grid.Clear ();
+  m_phys.clear ();
+  m_unindexed.clear ();
+  m_nIndexed = 0;
   SpectrumChannel::DoDispose ();
 }
 
@@ -112,6 +130,16 @@ MultiModelSpectrumChannel::GetTypeId (void)
                    DoubleValue (1.0e9),
                    MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxLossDb),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("SpatialIndexCellSize",
+                   "If not zero, the size, in meters, of the cells of a grid "
+                   "which indexes the positions of the receivers, so that the "
+                   "receivers beyond the range of the PropagationLossModel for "
+                   "MaxLossDb are not looked at, and do not fire the PathLoss "
+                   "trace.  The grid assumes that the mobility models notify "
+                   "a course change whenever their velocity changes.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&MultiModelSpectrumChannel::m_cellSize),
+                   MakeDoubleChecker<double> (0))
     .AddTraceSource ("PathLoss",
                      "This trace is fired whenever a new path loss value "
                      "is calculated. The first and second parameters "
@@ -150,6 +178,7 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
   // we need to scan for all rxSpectrumModel values since we don't
   // know which spectrum model the phy had when it was previously added
   // (it's probably different than the current one)
+  bool found = false;
   for (RxSpectrumModelInfoMap_t::iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
        rxInfoIterator !=  m_rxSpectrumModelInfoMap.end ();
        ++rxInfoIterator)
@@ -159,11 +188,16 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
         {
           rxInfoIterator->second.m_rxPhySet.erase (phyIt);
           --m_numDevices;
+          found = true;
           break; // there should be at most one entry
         }       
     }
 
   ++m_numDevices;
+  if (!found)
+    {
+      m_phys.push_back (phy);
+    }
 
   RxSpectrumModelInfoMap_t::iterator rxInfoIterator = m_rxSpectrumModelInfoMap.find (rxSpectrumModelUid);
 
@@ -265,108 +299,224 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
   NS_LOG_LOGIC ("converter map size: " << txInfoIteratorerator->second.m_spectrumConverterMap.size ());
   NS_LOG_LOGIC ("converter map first element: " << txInfoIteratorerator->second.m_spectrumConverterMap.begin ()->first);
 
-  for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
-       rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
-       ++rxInfoIterator)
+  // the receivers other than the transmitter, and the transmitted
+  // power spectral density in their SpectrumModel.
+  std::vector<Ptr<SpectrumPhy> > receivers;
+  std::vector<Ptr<SpectrumValue> > convertedTxPowerSpectrums;
+  if (m_cellSize > 0 && txMobility && !HasGain (txParams->txAntenna))
     {
-      SpectrumModelUid_t rxSpectrumModelUid = rxInfoIterator->second.m_rxSpectrumModel->GetUid ();
-      NS_LOG_LOGIC (" rxSpectrumModelUids " << rxSpectrumModelUid);
-
-      Ptr <SpectrumValue> convertedTxPowerSpectrum;
-      if (txSpectrumModelUid == rxSpectrumModelUid)
+      // the receivers near enough to receive the signal with a loss
+      // below m_maxLossDb, and those which are not in the grid.
+      UpdateGrid ();
+      std::vector<uint32_t> candidates;
+      double range = std::numeric_limits<double>::infinity ();
+      if (m_propagationLoss)
         {
-          NS_LOG_LOGIC ("no spectrum conversion needed");
-          convertedTxPowerSpectrum = txParams->psd;
+          range = m_propagationLoss->GetRange (0, -m_maxLossDb);
         }
-      else
+      m_grid.Lookup (txMobility->GetPosition (), range, candidates);
+      candidates.insert (candidates.end (), m_unindexed.begin (), m_unindexed.end ());
+      NS_LOG_LOGIC ("range " << range << " m, " << candidates.size () << " receivers");
+
+      // sorted as m_rxSpectrumModelInfoMap and its sets are, so that the
+      // receptions are scheduled in the same order as without the grid.
+      std::vector<std::pair<SpectrumModelUid_t, Ptr<SpectrumPhy> > > sorted;
+      sorted.reserve (candidates.size ());
+      for (std::vector<uint32_t>::const_iterator i = candidates.begin (); i != candidates.end (); ++i)
         {
-          NS_LOG_LOGIC (" converting txPowerSpectrum SpectrumModelUids" << txSpectrumModelUid << " --> " << rxSpectrumModelUid);
-          SpectrumConverterMap_t::const_iterator rxConverterIterator = txInfoIteratorerator->second.m_spectrumConverterMap.find (rxSpectrumModelUid);
-          NS_ASSERT (rxConverterIterator != txInfoIteratorerator->second.m_spectrumConverterMap.end ());
-          convertedTxPowerSpectrum = rxConverterIterator->second.Convert (txParams->psd);
+          Ptr<SpectrumPhy> receiver = m_phys[*i];
+          if (receiver != txParams->txPhy)
+            {
+              sorted.push_back (std::make_pair (receiver->GetRxSpectrumModel ()->GetUid (), receiver));
+            }
         }
+      std::sort (sorted.begin (), sorted.end ());
 
-
-      for (std::set<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxInfoIterator->second.m_rxPhySet.begin ();
-           rxPhyIterator != rxInfoIterator->second.m_rxPhySet.end ();
-           ++rxPhyIterator)
+      Ptr<SpectrumValue> convertedTxPowerSpectrum;
+      for (uint32_t i = 0; i < sorted.size (); i++)
         {
-          NS_ASSERT_MSG ((*rxPhyIterator)->GetRxSpectrumModel ()->GetUid () == rxSpectrumModelUid,
-                         "SpectrumModel change was not notified to MultiModelSpectrumChannel (i.e., AddRx should be called again after model is changed)");
-
-          if ((*rxPhyIterator) != txParams->txPhy)
+          if (i == 0 || sorted[i].first != sorted[i - 1].first)
             {
-              NS_LOG_LOGIC (" copying signal parameters " << txParams);
-              Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
-              rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
-              Time delay = MicroSeconds (0);
+              convertedTxPowerSpectrum = ConvertTxPowerSpectrum (txInfoIteratorerator, txParams, sorted[i].first);
+            }
+          receivers.push_back (sorted[i].second);
+          convertedTxPowerSpectrums.push_back (convertedTxPowerSpectrum);
+        }
+    }
+  else
+    {
+      for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
+           rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
+           ++rxInfoIterator)
+        {
+          SpectrumModelUid_t rxSpectrumModelUid = rxInfoIterator->second.m_rxSpectrumModel->GetUid ();
+          NS_LOG_LOGIC (" rxSpectrumModelUids " << rxSpectrumModelUid);
 
-              Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
+          Ptr <SpectrumValue> convertedTxPowerSpectrum = ConvertTxPowerSpectrum (txInfoIteratorerator, txParams, rxSpectrumModelUid);
 
-              if (txMobility && receiverMobility)
+          for (std::set<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxInfoIterator->second.m_rxPhySet.begin ();
+               rxPhyIterator != rxInfoIterator->second.m_rxPhySet.end ();
+               ++rxPhyIterator)
+            {
+              NS_ASSERT_MSG ((*rxPhyIterator)->GetRxSpectrumModel ()->GetUid () == rxSpectrumModelUid,
+                             "SpectrumModel change was not notified to MultiModelSpectrumChannel (i.e., AddRx should be called again after model is changed)");
+              if (*rxPhyIterator == txParams->txPhy)
                 {
-                  double pathLossDb = 0;
-                  if (rxParams->txAntenna != 0)
-                    {
-                      Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
-                      double txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
-                      NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-                      pathLossDb -= txAntennaGain;
-                    }
-                  Ptr<AntennaModel> rxAntenna = (*rxPhyIterator)->GetRxAntenna ();
-                  if (rxAntenna != 0)
-                    {
-                      Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
-                      double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
-                      NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-                      pathLossDb -= rxAntennaGain;
-                    }
-                  if (m_propagationLoss)
-                    {
-                      double propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
-                      NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-                      pathLossDb -= propagationGainDb;
-                    }                    
-                  NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");    
-                  m_pathLossTrace (txParams->txPhy, *rxPhyIterator, pathLossDb);
-                  if ( pathLossDb > m_maxLossDb)
-                    {
-                      // beyond range
-                      continue;
-                    }
-                  double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-                  *(rxParams->psd) *= pathGainLinear;              
-
-                  if (m_spectrumPropagationLoss)
-                    {
-                      rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
-                    }
-
-                  if (m_propagationDelay)
-                    {
-                      delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
-                    }
+                  continue;
                 }
+              receivers.push_back (*rxPhyIterator);
+              convertedTxPowerSpectrums.push_back (convertedTxPowerSpectrum);
+            }
+        }
+    }
 
-              Ptr<NetDevice> netDev = (*rxPhyIterator)->GetDevice ();
-              if (netDev)
-                {
-                  // the receiver has a NetDevice, so we expect that it is attached to a Node
-                  uint32_t dstNode =  netDev->GetNode ()->GetId ();
-                  Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
-                                                  rxParams, *rxPhyIterator);
-                }
-              else
-                {
-                  // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
-                  Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
-                                       rxParams, *rxPhyIterator);
-                }
+  // the propagation gains of all the receivers with a mobility model,
+  // computed at once.
+  std::vector<double> propagationGainsDb (receivers.size (), 0);
+  if (m_propagationLoss && txMobility)
+    {
+      std::vector<uint32_t> mobile;
+      std::vector<Ptr<MobilityModel> > receiverMobilities;
+      for (uint32_t k = 0; k < receivers.size (); k++)
+        {
+          Ptr<MobilityModel> receiverMobility = receivers[k]->GetMobility ();
+          if (receiverMobility)
+            {
+              mobile.push_back (k);
+              receiverMobilities.push_back (receiverMobility);
             }
         }
+      std::vector<double> gainsDb;
+      m_propagationLoss->CalcRxPowerBatch (0, txMobility, receiverMobilities, gainsDb);
+      for (uint32_t k = 0; k < mobile.size (); k++)
+        {
+          propagationGainsDb[mobile[k]] = gainsDb[k];
+        }
+    }
 
+  for (uint32_t k = 0; k < receivers.size (); k++)
+    {
+      Propagate (txParams, convertedTxPowerSpectrums[k], receivers[k], propagationGainsDb[k]);
     }
+}
 
+Ptr<SpectrumValue>
+MultiModelSpectrumChannel::ConvertTxPowerSpectrum (TxSpectrumModelInfoMap_t::const_iterator txInfoIterator,
+                                                   Ptr<SpectrumSignalParameters> txParams,
+                                                   SpectrumModelUid_t rxSpectrumModelUid) const
+{
+  SpectrumModelUid_t txSpectrumModelUid = txParams->psd->GetSpectrumModelUid ();
+  if (txSpectrumModelUid == rxSpectrumModelUid)
+    {
+      NS_LOG_LOGIC ("no spectrum conversion needed");
+      return txParams->psd;
+    }
+  NS_LOG_LOGIC (" converting txPowerSpectrum SpectrumModelUids" << txSpectrumModelUid << " --> " << rxSpectrumModelUid);
+  SpectrumConverterMap_t::const_iterator rxConverterIterator = txInfoIterator->second.m_spectrumConverterMap.find (rxSpectrumModelUid);
+  NS_ASSERT (rxConverterIterator != txInfoIterator->second.m_spectrumConverterMap.end ());
+  return rxConverterIterator->second.Convert (txParams->psd);
+}
+
+void
+MultiModelSpectrumChannel::Propagate (Ptr<SpectrumSignalParameters> txParams, Ptr<SpectrumValue> convertedTxPowerSpectrum,
+                                      Ptr<SpectrumPhy> receiver, double propagationGainDb)
+{
+  Ptr<MobilityModel> txMobility = txParams->txPhy->GetMobility ();
+
+  NS_LOG_LOGIC (" copying signal parameters " << txParams);
+  Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
+  rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
+  Time delay = MicroSeconds (0);
+
+  Ptr<MobilityModel> receiverMobility = receiver->GetMobility ();
+
+  if (txMobility && receiverMobility)
+    {
+      double pathLossDb = 0;
+      if (rxParams->txAntenna != 0)
+        {
+          Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
+          double txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
+          NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
+          pathLossDb -= txAntennaGain;
+        }
+      Ptr<AntennaModel> rxAntenna = receiver->GetRxAntenna ();
+      if (rxAntenna != 0)
+        {
+          Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
+          double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
+          NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
+          pathLossDb -= rxAntennaGain;
+        }
+      if (m_propagationLoss)
+        {
+          NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
+          pathLossDb -= propagationGainDb;
+        }                    
+      NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");    
+      m_pathLossTrace (txParams->txPhy, receiver, pathLossDb);
+      if ( pathLossDb > m_maxLossDb)
+        {
+          // beyond range
+          return;
+        }
+      double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+      *(rxParams->psd) *= pathGainLinear;              
+
+      if (m_spectrumPropagationLoss)
+        {
+          rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
+        }
+
+      if (m_propagationDelay)
+        {
+          delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
+        }
+    }
+
+  Ptr<NetDevice> netDev = receiver->GetDevice ();
+  if (netDev)
+    {
+      // the receiver has a NetDevice, so we expect that it is attached to a Node
+      uint32_t dstNode =  netDev->GetNode ()->GetId ();
+      Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
+                                      rxParams, receiver);
+    }
+  else
+    {
+      // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
+      Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
+                           rxParams, receiver);
+    }
+}
+
+void
+MultiModelSpectrumChannel::UpdateGrid (void)
+{
+  if (m_grid.GetCellSize () != m_cellSize)
+    {
+      m_grid.SetCellSize (m_cellSize);
+      m_nIndexed = 0;
+      m_unindexed.clear ();
+    }
+  for (; m_nIndexed < m_phys.size (); m_nIndexed++)
+    {
+      m_unindexed.push_back (m_nIndexed);
+    }
+  std::vector<uint32_t> unindexed;
+  for (std::vector<uint32_t>::const_iterator i = m_unindexed.begin (); i != m_unindexed.end (); ++i)
+    {
+      Ptr<MobilityModel> mobility = m_phys[*i]->GetMobility ();
+      if (mobility != 0 && !HasGain (m_phys[*i]->GetRxAntenna ()))
+        {
+          m_grid.Add (*i, mobility);
+        }
+      else
+        {
+          unindexed.push_back (*i);
+        }
+    }
+  m_unindexed.swap (unindexed);
 }
 
 void
@@ -27,8 +27,10 @@
 #include <ns3/spectrum-channel.h>
 #include <ns3/spectrum-propagation-loss-model.h>
 #include <ns3/propagation-delay-model.h>
+#include <ns3/mobility-grid.h>
 #include <map>
 #include <set>
+#include <vector>
 
 namespace ns3 {
 
@@ -82,6 +84,13 @@ typedef std::map<SpectrumModelUid_t, RxSpectrumModelInfo> RxSpectrumModelInfoMap
  * for this to work is that, after the SpectrumPhy switched its
  * SpectrumModel,  MultiModelSpectrumChannel::AddRx () is
  * called again passing the pointer to that SpectrumPhy.
+ *
+ * With the SpatialIndexCellSize attribute, the channel keeps the
+ * positions of the receivers in a MobilityGrid, and only looks at the
+ * receivers within the range which PropagationLossModel::GetRange
+ * returns for MaxLossDb.  The transmissions with a TX antenna, and the
+ * receivers with an RX antenna, other than an IsotropicAntennaModel,
+ * are not culled, since the gains of the antennas are not bounded.
  */
 class MultiModelSpectrumChannel : public SpectrumChannel
 {
@@ -132,6 +141,35 @@ private:
    */
   virtual void StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver);
 
+  /**
+   * @param txInfoIterator the entry of the TX SpectrumModel
+   * @param txParams the parameters of the transmission
+   * @param rxSpectrumModelUid the uid of an RX SpectrumModel
+   *
+   * @return the transmitted power spectral density in the RX SpectrumModel
+   */
+  Ptr<SpectrumValue> ConvertTxPowerSpectrum (TxSpectrumModelInfoMap_t::const_iterator txInfoIterator,
+                                             Ptr<SpectrumSignalParameters> txParams,
+                                             SpectrumModelUid_t rxSpectrumModelUid) const;
+
+  /**
+   * used internally to propagate a transmission to a receiver
+   *
+   * @param txParams the parameters of the transmission
+   * @param convertedTxPowerSpectrum the transmitted power spectral density in the RX SpectrumModel
+   * @param receiver the receiver
+   * @param propagationGainDb the gain of the PropagationLossModel from
+   * the transmitter to the receiver, if both have a mobility model
+   */
+  void Propagate (Ptr<SpectrumSignalParameters> txParams, Ptr<SpectrumValue> convertedTxPowerSpectrum,
+                  Ptr<SpectrumPhy> receiver, double propagationGainDb);
+
+  /**
+   * Add to the grid the receivers added since the last call, and those
+   * which had no mobility model or had an RX antenna then.
+   */
+  void UpdateGrid (void);
+
 
 
   /**
@@ -173,6 +211,31 @@ private:
 
   double m_maxLossDb;
 
+  /**
+   * the size of the cells of the grid, or zero
+   */
+  double m_cellSize;
+
+  /**
+   * the positions of the receivers, which are indexed in m_phys
+   */
+  MobilityGrid m_grid;
+
+  /**
+   * the receivers, in the order they were first added
+   */
+  std::vector<Ptr<SpectrumPhy> > m_phys;
+
+  /**
+   * the number of receivers looked at by UpdateGrid
+   */
+  uint32_t m_nIndexed;
+
+  /**
+   * the receivers which are not in the grid, in increasing order
+   */
+  std::vector<uint32_t> m_unindexed;
+
   TracedCallback<Ptr<SpectrumPhy>, Ptr<SpectrumPhy>, double > m_pathLossTrace;
 };
 
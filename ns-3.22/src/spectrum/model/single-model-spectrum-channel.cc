@@ -33,6 +33,7 @@
 #include <ns3/propagation-delay-model.h>
 #include <ns3/antenna-model.h>
 #include <ns3/angles.h>
+#include <vector>
 
 
 #include "single-model-spectrum-channel.h"
@@ -133,6 +134,25 @@ SingleModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
   Ptr<MobilityModel> senderMobility = txParams->txPhy->GetMobility ();
 
+  // the propagation gains of all the receivers, computed at once
+  std::vector<Ptr<MobilityModel> > receiverMobilities;
+  std::vector<double> propagationGainsDb;
+  if (m_propagationLoss && senderMobility)
+    {
+      for (PhyList::const_iterator rxPhyIterator = m_phyList.begin ();
+           rxPhyIterator != m_phyList.end ();
+           ++rxPhyIterator)
+        {
+          Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
+          if ((*rxPhyIterator) != txParams->txPhy && receiverMobility)
+            {
+              receiverMobilities.push_back (receiverMobility);
+            }
+        }
+      m_propagationLoss->CalcRxPowerBatch (0, senderMobility, receiverMobilities, propagationGainsDb);
+    }
+  std::vector<double>::const_iterator propagationGainDb = propagationGainsDb.begin ();
+
   for (PhyList::const_iterator rxPhyIterator = m_phyList.begin ();
        rxPhyIterator != m_phyList.end ();
        ++rxPhyIterator)
@@ -165,9 +185,10 @@ SingleModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
                 }
               if (m_propagationLoss)
                 {
-                  double propagationGainDb = m_propagationLoss->CalcRxPower (0, senderMobility, receiverMobility);
-                  NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-                  pathLossDb -= propagationGainDb;
+                  NS_ASSERT (propagationGainDb != propagationGainsDb.end ());
+                  NS_LOG_LOGIC ("propagationGainDb = " << *propagationGainDb << " dB");
+                  pathLossDb -= *propagationGainDb;
+                  ++propagationGainDb;
                 }                    
               NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");    
               m_pathLossTrace (txParams->txPhy, *rxPhyIterator, pathLossDb);
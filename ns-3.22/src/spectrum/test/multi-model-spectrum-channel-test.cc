@@ -0,0 +1,260 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/double.h>
+#include <ns3/net-device.h>
+#include <ns3/spectrum-phy.h>
+#include <ns3/spectrum-value.h>
+#include <ns3/spectrum-signal-parameters.h>
+#include <ns3/spectrum-model-ism2400MHz-res1MHz.h>
+#include <ns3/multi-model-spectrum-channel.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/propagation-delay-model.h>
+#include <ns3/constant-position-mobility-model.h>
+#include <ns3/constant-velocity-mobility-model.h>
+#include <ns3/cosine-antenna-model.h>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+/// a reception seen by a GridTestSpectrumPhy
+struct RxEvent
+{
+  int64_t time;   //!< the time of the reception, in time steps
+  uint32_t phy;   //!< the index of the receiver
+  double power;   //!< the power received, in W
+  Time duration;  //!< the duration of the signal
+};
+
+/**
+ * A SpectrumPhy which logs the signals given to it by the channel.
+ */
+class GridTestSpectrumPhy : public SpectrumPhy
+{
+public:
+  GridTestSpectrumPhy ()
+    : m_index (0),
+      m_log (0)
+  {
+  }
+  void Setup (uint32_t index, Ptr<const SpectrumModel> model, Ptr<AntennaModel> antenna,
+              std::vector<RxEvent> *log)
+  {
+    m_index = index;
+    m_model = model;
+    m_antenna = antenna;
+    m_log = log;
+  }
+  virtual void SetDevice (Ptr<NetDevice> d)
+  {
+  }
+  virtual Ptr<NetDevice> GetDevice ()
+  {
+    return 0;
+  }
+  virtual void SetMobility (Ptr<MobilityModel> m)
+  {
+    m_mobility = m;
+  }
+  virtual Ptr<MobilityModel> GetMobility ()
+  {
+    return m_mobility;
+  }
+  virtual void SetChannel (Ptr<SpectrumChannel> c)
+  {
+  }
+  virtual Ptr<const SpectrumModel> GetRxSpectrumModel () const
+  {
+    return m_model;
+  }
+  virtual Ptr<AntennaModel> GetRxAntenna ()
+  {
+    return m_antenna;
+  }
+  virtual void StartRx (Ptr<SpectrumSignalParameters> params)
+  {
+    RxEvent event;
+    event.time = Simulator::Now ().GetTimeStep ();
+    event.phy = m_index;
+    event.power = Integral (*params->psd);
+    event.duration = params->duration;
+    m_log->push_back (event);
+  }
+protected:
+  virtual void DoDispose (void)
+  {
+    m_model = 0;
+    m_antenna = 0;
+    m_mobility = 0;
+    SpectrumPhy::DoDispose ();
+  }
+private:
+  uint32_t m_index;
+  Ptr<const SpectrumModel> m_model;
+  Ptr<AntennaModel> m_antenna;
+  Ptr<MobilityModel> m_mobility;
+  std::vector<RxEvent> *m_log;
+};
+
+} // anonymous namespace
+
+/**
+ * Make sure that the spatial index of MultiModelSpectrumChannel gives
+ * the same signals to the same receivers, in the same order, as a scan
+ * of all of them.  The receivers are attached to a channel with the
+ * index and to one without, since the order of the receptions at the
+ * same time depends on the addresses of the receivers.
+ */
+class MultiModelSpectrumChannelGridTestCase : public TestCase
+{
+public:
+  MultiModelSpectrumChannelGridTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \param cellSize the SpatialIndexCellSize of the channel
+   * \return a new channel
+   */
+  static Ptr<MultiModelSpectrumChannel> CreateChannel (double cellSize);
+};
+
+MultiModelSpectrumChannelGridTestCase::MultiModelSpectrumChannelGridTestCase ()
+  : TestCase ("Check that the spatial index of MultiModelSpectrumChannel does not change the receptions")
+{
+}
+
+Ptr<MultiModelSpectrumChannel>
+MultiModelSpectrumChannelGridTestCase::CreateChannel (double cellSize)
+{
+  Ptr<MultiModelSpectrumChannel> channel = CreateObject<MultiModelSpectrumChannel> ();
+  channel->AddPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetAttribute ("MaxLossDb", DoubleValue (90));
+  channel->SetAttribute ("SpatialIndexCellSize", DoubleValue (cellSize));
+  return channel;
+}
+
+void
+MultiModelSpectrumChannelGridTestCase::DoRun (void)
+{
+  Ptr<MultiModelSpectrumChannel> scan = CreateChannel (0);
+  Ptr<MultiModelSpectrumChannel> grid = CreateChannel (15);
+  std::vector<RxEvent> log;
+
+  // a second spectrum model, which the signals are converted to
+  std::vector<double> freqs;
+  for (uint32_t i = 0; i < 16; i++)
+    {
+      freqs.push_back (2.4e9 + 5e6 * i);
+    }
+  Ptr<SpectrumModel> other = Create<SpectrumModel> (freqs);
+
+  // a 9 x 9 grid of receivers 10 m apart, many at the same distance of
+  // the transmitters, so that the order of their receptions matters
+  const uint32_t side = 9;
+  std::vector<Ptr<GridTestSpectrumPhy> > phys;
+  for (uint32_t i = 0; i < side * side + 2; i++)
+    {
+      Ptr<GridTestSpectrumPhy> phy = CreateObject<GridTestSpectrumPhy> ();
+      Ptr<AntennaModel> antenna;
+      if (i == 7)
+        {
+          // the receivers with a directional antenna are not culled
+          antenna = CreateObject<CosineAntennaModel> ();
+        }
+      phy->Setup (i, i % 3 == 0 ? other : SpectrumModelIsm2400MhzRes1Mhz, antenna, &log);
+      if (i < side * side)
+        {
+          Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+          mobility->SetPosition (Vector (10.0 * (i % side), 10.0 * (i / side), 0.0));
+          phy->SetMobility (mobility);
+        }
+      else if (i == side * side)
+        {
+          // a receiver which comes near the others at 20 m/s
+          Ptr<ConstantVelocityMobilityModel> mobility = CreateObject<ConstantVelocityMobilityModel> ();
+          mobility->SetPosition (Vector (-100.0, 40.0, 0.0));
+          mobility->SetVelocity (Vector (20.0, 0.0, 0.0));
+          phy->SetMobility (mobility);
+        }
+      // and the last one has no mobility model
+      scan->AddRx (phy);
+      grid->AddRx (phy);
+      phys.push_back (phy);
+    }
+
+  // the center, a corner, a transmission with a directional antenna, and
+  // the center again once the moving receiver is near; the signals of the
+  // channel with the index last twice as long.
+  uint32_t senders[] = { 40, 0, 40, 40 };
+  for (uint32_t i = 0; i < sizeof (senders) / sizeof (senders[0]); i++)
+    {
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          Ptr<SpectrumSignalParameters> params = Create<SpectrumSignalParameters> ();
+          params->duration = MilliSeconds (1 + j);
+          params->txPhy = phys[senders[i]];
+          params->psd = Create<SpectrumValue> (SpectrumModelIsm2400MhzRes1Mhz);
+          *params->psd = 1e-9;
+          if (i == 2)
+            {
+              params->txAntenna = CreateObject<CosineAntennaModel> ();
+            }
+          Simulator::Schedule (Seconds (1.0 + 2 * i), &MultiModelSpectrumChannel::StartTx,
+                               j == 0 ? scan : grid, params);
+        }
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::vector<RxEvent> expected;
+  std::vector<RxEvent> indexed;
+  for (uint32_t i = 0; i < log.size (); i++)
+    {
+      (log[i].duration == MilliSeconds (1) ? expected : indexed).push_back (log[i]);
+    }
+  log.swap (indexed);
+  NS_TEST_ASSERT_MSG_GT (expected.size (), 0, "no receptions");
+  NS_TEST_ASSERT_MSG_EQ (log.size (), expected.size (), "the grid changed the number of receptions");
+  for (uint32_t i = 0; i < log.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (log[i].time, expected[i].time, "wrong time of reception " << i);
+      NS_TEST_EXPECT_MSG_EQ (log[i].phy, expected[i].phy, "wrong receiver of reception " << i);
+      NS_TEST_EXPECT_MSG_EQ_TOL (log[i].power, expected[i].power, expected[i].power * 1e-12,
+                                 "wrong power of reception " << i);
+    }
+}
+
+class MultiModelSpectrumChannelTestSuite : public TestSuite
+{
+public:
+  MultiModelSpectrumChannelTestSuite ();
+};
+
+MultiModelSpectrumChannelTestSuite::MultiModelSpectrumChannelTestSuite ()
+  : TestSuite ("multi-model-spectrum-channel", UNIT)
+{
+  AddTestCase (new MultiModelSpectrumChannelGridTestCase, TestCase::QUICK);
+}
+
+static MultiModelSpectrumChannelTestSuite g_multiModelSpectrumChannelTestSuite;
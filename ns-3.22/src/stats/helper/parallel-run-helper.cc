@@ -0,0 +1,556 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "parallel-run-helper.h"
+#include "ns3/data-calculator.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/nstime.h"
+#include "ns3/fatal-error.h"
+#include "ns3/log.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <sstream>
+#include <vector>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ParallelRunHelper");
+
+namespace {
+
+/*
+ * The results of a run are sent as a sequence of records, each of which
+ * starts with a one-byte tag:
+ *  'L' the labels of the DataCollector
+ *  'M' a metadata key and value
+ *  'S' a statistical summary
+ *  'i', 'u', 'd', 's', 't' a singleton of type int, uint32_t, double,
+ *      std::string or Time
+ *  'E' the end of the results
+ * Strings are sent as their length followed by their bytes, and numbers
+ * in the representation of the host, which the workers share.
+ */
+
+void
+PutString (std::string &buffer, const std::string &s)
+{
+  uint32_t size = s.size ();
+  buffer.append (reinterpret_cast<const char *> (&size), sizeof (size));
+  buffer.append (s);
+}
+
+template <typename T>
+void
+Put (std::string &buffer, T value)
+{
+  buffer.append (reinterpret_cast<const char *> (&value), sizeof (value));
+}
+
+class Decoder
+{
+public:
+  Decoder (const std::string &buffer)
+    : m_buffer (buffer),
+      m_offset (0),
+      m_ok (true)
+  {}
+  bool IsOk (void) const { return m_ok; }
+  bool IsEnd (void) const { return m_offset >= m_buffer.size (); }
+  std::string GetString (void)
+  {
+    uint32_t size = Get<uint32_t> ();
+    if (!m_ok || m_buffer.size () - m_offset < size)
+      {
+        m_ok = false;
+        return "";
+      }
+    std::string s = m_buffer.substr (m_offset, size);
+    m_offset += size;
+    return s;
+  }
+  template <typename T>
+  T Get (void)
+  {
+    T value = T ();
+    if (!m_ok || m_buffer.size () - m_offset < sizeof (T))
+      {
+        m_ok = false;
+        return value;
+      }
+    std::memcpy (&value, m_buffer.data () + m_offset, sizeof (T));
+    m_offset += sizeof (T);
+    return value;
+  }
+private:
+  const std::string &m_buffer;
+  std::string::size_type m_offset;
+  bool m_ok;
+};
+
+/* Encode the output of the calculators of a worker. */
+class EncoderCallback : public DataOutputCallback
+{
+public:
+  EncoderCallback (std::string &buffer)
+    : m_buffer (buffer)
+  {}
+  virtual void OutputStatistic (std::string key, std::string variable,
+                                const StatisticalSummary *statSum)
+  {
+    Put<char> (m_buffer, 'S');
+    PutString (m_buffer, key);
+    PutString (m_buffer, variable);
+    Put<int64_t> (m_buffer, statSum->getCount ());
+    Put<double> (m_buffer, statSum->getSum ());
+    Put<double> (m_buffer, statSum->getSqrSum ());
+    Put<double> (m_buffer, statSum->getMin ());
+    Put<double> (m_buffer, statSum->getMax ());
+    Put<double> (m_buffer, statSum->getMean ());
+    Put<double> (m_buffer, statSum->getStddev ());
+    Put<double> (m_buffer, statSum->getVariance ());
+  }
+  virtual void OutputSingleton (std::string key, std::string variable, int val)
+  {
+    Start ('i', key, variable);
+    Put<int32_t> (m_buffer, val);
+  }
+  virtual void OutputSingleton (std::string key, std::string variable, uint32_t val)
+  {
+    Start ('u', key, variable);
+    Put<uint32_t> (m_buffer, val);
+  }
+  virtual void OutputSingleton (std::string key, std::string variable, double val)
+  {
+    Start ('d', key, variable);
+    Put<double> (m_buffer, val);
+  }
+  virtual void OutputSingleton (std::string key, std::string variable, std::string val)
+  {
+    Start ('s', key, variable);
+    PutString (m_buffer, val);
+  }
+  virtual void OutputSingleton (std::string key, std::string variable, Time val)
+  {
+    Start ('t', key, variable);
+    Put<int64_t> (m_buffer, val.GetTimeStep ());
+  }
+private:
+  void Start (char tag, const std::string &key, const std::string &variable)
+  {
+    Put<char> (m_buffer, tag);
+    PutString (m_buffer, key);
+    PutString (m_buffer, variable);
+  }
+  std::string &m_buffer;
+};
+
+/* A statistical summary received from a worker. */
+class StoredSummary : public StatisticalSummary
+{
+public:
+  virtual long getCount () const { return count; }
+  virtual double getSum () const { return sum; }
+  virtual double getSqrSum () const { return sqrSum; }
+  virtual double getMin () const { return min; }
+  virtual double getMax () const { return max; }
+  virtual double getMean () const { return mean; }
+  virtual double getStddev () const { return stddev; }
+  virtual double getVariance () const { return variance; }
+
+  long count;
+  double sum;
+  double sqrSum;
+  double min;
+  double max;
+  double mean;
+  double stddev;
+  double variance;
+};
+
+/* Output again, in the calling process, what the calculators of a
+   worker output. */
+class ReplayCalculator : public DataCalculator
+{
+public:
+  struct Item
+  {
+    char tag;
+    std::string key;
+    std::string variable;
+    StoredSummary summary;
+    int64_t integer;
+    double real;
+    std::string string;
+  };
+
+  void Add (const Item &item)
+  {
+    m_items.push_back (item);
+  }
+  virtual void Output (DataOutputCallback &callback) const
+  {
+    for (std::list<Item>::const_iterator i = m_items.begin (); i != m_items.end (); i++)
+      {
+        switch (i->tag)
+          {
+          case 'S':
+            callback.OutputStatistic (i->key, i->variable, &i->summary);
+            break;
+          case 'i':
+            callback.OutputSingleton (i->key, i->variable, (int)i->integer);
+            break;
+          case 'u':
+            callback.OutputSingleton (i->key, i->variable, (uint32_t)i->integer);
+            break;
+          case 'd':
+            callback.OutputSingleton (i->key, i->variable, i->real);
+            break;
+          case 's':
+            callback.OutputSingleton (i->key, i->variable, i->string);
+            break;
+          case 't':
+            callback.OutputSingleton (i->key, i->variable, TimeStep (i->integer));
+            break;
+          }
+      }
+  }
+private:
+  std::list<Item> m_items;
+};
+
+/* \returns the DataCollector encoded in buffer, or zero if the buffer
+   is truncated or corrupted. */
+Ptr<DataCollector>
+Decode (const std::string &buffer)
+{
+  Ptr<DataCollector> data = CreateObject<DataCollector> ();
+  Ptr<ReplayCalculator> calculator = CreateObject<ReplayCalculator> ();
+  data->AddDataCalculator (calculator);
+  Decoder decoder (buffer);
+  while (decoder.IsOk () && !decoder.IsEnd ())
+    {
+      char tag = decoder.Get<char> ();
+      if (tag == 'E')
+        {
+          return decoder.IsOk () && decoder.IsEnd () ? data : 0;
+        }
+      else if (tag == 'L')
+        {
+          std::string experiment = decoder.GetString ();
+          std::string strategy = decoder.GetString ();
+          std::string input = decoder.GetString ();
+          std::string run = decoder.GetString ();
+          std::string description = decoder.GetString ();
+          data->DescribeRun (experiment, strategy, input, run, description);
+        }
+      else if (tag == 'M')
+        {
+          std::string key = decoder.GetString ();
+          std::string value = decoder.GetString ();
+          data->AddMetadata (key, value);
+        }
+      else
+        {
+          ReplayCalculator::Item item;
+          item.tag = tag;
+          item.key = decoder.GetString ();
+          item.variable = decoder.GetString ();
+          item.integer = 0;
+          item.real = 0;
+          switch (tag)
+            {
+            case 'S':
+              item.summary.count = decoder.Get<int64_t> ();
+              item.summary.sum = decoder.Get<double> ();
+              item.summary.sqrSum = decoder.Get<double> ();
+              item.summary.min = decoder.Get<double> ();
+              item.summary.max = decoder.Get<double> ();
+              item.summary.mean = decoder.Get<double> ();
+              item.summary.stddev = decoder.Get<double> ();
+              item.summary.variance = decoder.Get<double> ();
+              break;
+            case 'i':
+              item.integer = decoder.Get<int32_t> ();
+              break;
+            case 'u':
+              item.integer = decoder.Get<uint32_t> ();
+              break;
+            case 'd':
+              item.real = decoder.Get<double> ();
+              break;
+            case 's':
+              item.string = decoder.GetString ();
+              break;
+            case 't':
+              item.integer = decoder.Get<int64_t> ();
+              break;
+            default:
+              return 0;
+            }
+          calculator->Add (item);
+        }
+    }
+  return 0;
+}
+
+/* A process which executes a run. */
+struct Worker
+{
+  pid_t pid;
+  int fd;
+  uint64_t run;
+  // the results received so far
+  std::string buffer;
+};
+
+} // anonymous namespace
+
+ParallelRunHelper::ParallelRunHelper ()
+  : m_maxProcesses (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ParallelRunHelper::~ParallelRunHelper ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ParallelRunHelper::SetMaxProcesses (uint32_t maxProcesses)
+{
+  NS_LOG_FUNCTION (this << maxProcesses);
+  m_maxProcesses = maxProcesses;
+}
+
+void
+ParallelRunHelper::SetOutput (Ptr<DataOutputInterface> output)
+{
+  NS_LOG_FUNCTION (this << output);
+  m_output = output;
+}
+
+void
+ParallelRunHelper::DescribeRuns (std::string experiment,
+                                 std::string strategy,
+                                 std::string input,
+                                 std::string description)
+{
+  NS_LOG_FUNCTION (this << experiment << strategy << input << description);
+  m_experiment = experiment;
+  m_strategy = strategy;
+  m_input = input;
+  m_description = description;
+}
+
+void
+ParallelRunHelper::DoWorker (RunCallback run, uint64_t runNumber, int fd)
+{
+  NS_LOG_FUNCTION (this << runNumber << fd);
+  RngSeedManager::SetRun (runNumber);
+  RandomVariableStream::ReseedAll ();
+
+  Ptr<DataCollector> data = CreateObject<DataCollector> ();
+  std::ostringstream label;
+  label << runNumber;
+  data->DescribeRun (m_experiment, m_strategy, m_input, label.str (), m_description);
+  run (runNumber, data);
+
+  std::string buffer;
+  Put<char> (buffer, 'L');
+  PutString (buffer, data->GetExperimentLabel ());
+  PutString (buffer, data->GetStrategyLabel ());
+  PutString (buffer, data->GetInputLabel ());
+  PutString (buffer, data->GetRunLabel ());
+  PutString (buffer, data->GetDescription ());
+  for (MetadataList::iterator i = data->MetadataBegin (); i != data->MetadataEnd (); i++)
+    {
+      Put<char> (buffer, 'M');
+      PutString (buffer, i->first);
+      PutString (buffer, i->second);
+    }
+  EncoderCallback callback (buffer);
+  for (DataCalculatorList::iterator i = data->DataCalculatorBegin (); i != data->DataCalculatorEnd (); i++)
+    {
+      (*i)->Output (callback);
+    }
+  Put<char> (buffer, 'E');
+
+  std::string::size_type written = 0;
+  while (written < buffer.size ())
+    {
+      ssize_t n = write (fd, buffer.data () + written, buffer.size () - written);
+      if (n < 0 && errno == EINTR)
+        {
+          continue;
+        }
+      if (n <= 0)
+        {
+          _exit (1);
+        }
+      written += n;
+    }
+  close (fd);
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::fflush (0);
+  // skip the destructors of the static objects, which belong to the
+  // calling process
+  _exit (0);
+}
+
+uint32_t
+ParallelRunHelper::Run (RunCallback run, uint64_t firstRun, uint32_t runs)
+{
+  NS_LOG_FUNCTION (this << firstRun << runs);
+  uint32_t maxProcesses = m_maxProcesses;
+  if (maxProcesses == 0)
+    {
+      long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+      maxProcesses = cpus > 0 ? cpus : 1;
+    }
+
+  std::list<Worker> workers;
+  uint32_t started = 0;
+  uint32_t failed = 0;
+
+  // do not let the workers print what is still buffered
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::fflush (0);
+
+  while (started < runs || !workers.empty ())
+    {
+      while (started < runs && workers.size () < maxProcesses)
+        {
+          uint64_t runNumber = firstRun + started;
+          int fds[2];
+          if (pipe (fds) < 0)
+            {
+              NS_FATAL_ERROR ("Could not create a pipe: " << std::strerror (errno));
+            }
+          pid_t pid = fork ();
+          if (pid < 0)
+            {
+              NS_FATAL_ERROR ("Could not fork: " << std::strerror (errno));
+            }
+          if (pid == 0)
+            {
+              close (fds[0]);
+              for (std::list<Worker>::iterator i = workers.begin (); i != workers.end (); i++)
+                {
+                  close (i->fd);
+                }
+              DoWorker (run, runNumber, fds[1]);
+            }
+          close (fds[1]);
+          NS_LOG_LOGIC ("run " << runNumber << " in process " << pid);
+          Worker worker;
+          worker.pid = pid;
+          worker.fd = fds[0];
+          worker.run = runNumber;
+          workers.push_back (worker);
+          started++;
+        }
+
+      std::vector<struct pollfd> fds;
+      for (std::list<Worker>::iterator i = workers.begin (); i != workers.end (); i++)
+        {
+          struct pollfd fd;
+          fd.fd = i->fd;
+          fd.events = POLLIN;
+          fd.revents = 0;
+          fds.push_back (fd);
+        }
+      if (poll (&fds[0], fds.size (), -1) < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          NS_FATAL_ERROR ("Could not poll the workers: " << std::strerror (errno));
+        }
+
+      std::vector<struct pollfd>::const_iterator fd = fds.begin ();
+      for (std::list<Worker>::iterator i = workers.begin (); i != workers.end (); fd++)
+        {
+          if (fd->revents == 0)
+            {
+              i++;
+              continue;
+            }
+          char chunk[4096];
+          ssize_t n = read (i->fd, chunk, sizeof (chunk));
+          if (n > 0)
+            {
+              i->buffer.append (chunk, n);
+              i++;
+              continue;
+            }
+          if (n < 0 && errno == EINTR)
+            {
+              i++;
+              continue;
+            }
+          // end of the results, or error
+          close (i->fd);
+          int status = 0;
+          pid_t pid;
+          do
+            {
+              pid = waitpid (i->pid, &status, 0);
+            }
+          while (pid < 0 && errno == EINTR);
+          Ptr<DataCollector> data;
+          if (pid < 0)
+            {
+              NS_LOG_WARN ("could not wait for run " << i->run << ": " << std::strerror (errno));
+            }
+          else if (WIFEXITED (status) && WEXITSTATUS (status) == 0)
+            {
+              data = Decode (i->buffer);
+            }
+          if (data == 0)
+            {
+              NS_LOG_WARN ("run " << i->run << " failed");
+              failed++;
+            }
+          else
+            {
+              if (m_output != 0)
+                {
+                  m_output->Output (*data);
+                }
+              data->Dispose ();
+            }
+          i = workers.erase (i);
+        }
+    }
+  return failed;
+}
+
+} // namespace ns3
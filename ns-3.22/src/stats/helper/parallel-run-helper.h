@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PARALLEL_RUN_HELPER_H
+#define PARALLEL_RUN_HELPER_H
+
+#include <stdint.h>
+#include <string>
+#include "ns3/callback.h"
+#include "ns3/ptr.h"
+#include "ns3/data-collector.h"
+#include "ns3/data-output-interface.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup stats
+ * \brief Run independent replications of a simulation in parallel
+ * processes.
+ *
+ * The simulation program builds its scenario once, and then asks the
+ * helper to execute a range of run numbers. For each run, the helper
+ * forks a worker process which shares the memory of the scenario with
+ * the other workers through copy-on-write, sets the run number with
+ * RngSeedManager::SetRun, reseeds the random variables which already
+ * exist with RandomVariableStream::ReseedAll, and calls the run
+ * callback with a DataCollector to fill. The worker then sends the
+ * content of the DataCollector back through a pipe, and the calling
+ * process feeds it to the DataOutputInterface given to SetOutput, for
+ * example a SqliteDataOutput, so that a single process writes all the
+ * results.
+ *
+ * \code
+ *   static void
+ *   DoRun (uint64_t run, Ptr<DataCollector> data)
+ *   {
+ *     Ptr<CounterCalculator<> > received = CreateObject<CounterCalculator<> > ();
+ *     received->SetKey ("received");
+ *     data->AddDataCalculator (received);
+ *     ... connect received to some trace source ...
+ *     Simulator::Stop (Seconds (600));
+ *     Simulator::Run ();
+ *     Simulator::Destroy ();
+ *   }
+ *
+ *   ... build the scenario ...
+ *   ParallelRunHelper helper;
+ *   helper.DescribeRuns ("pvr", "nodes=50", "links=100");
+ *   helper.SetOutput (CreateObject<SqliteDataOutput> ());
+ *   uint32_t failed = helper.Run (MakeCallback (&DoRun), 1, 100);
+ * \endcode
+ *
+ * The scenario must not be running when Run is called, and the
+ * simulator implementation must not use threads, since the workers
+ * contain only the calling thread.
+ */
+class ParallelRunHelper
+{
+public:
+  /**
+   * The function which executes one run in a worker: it is given the
+   * run number and the DataCollector to fill.
+   */
+  typedef Callback<void, uint64_t, Ptr<DataCollector> > RunCallback;
+
+  ParallelRunHelper ();
+  ~ParallelRunHelper ();
+
+  /**
+   * \param maxProcesses the largest number of workers which may run at
+   *        the same time. Zero, the default, means one per processor.
+   */
+  void SetMaxProcesses (uint32_t maxProcesses);
+  /**
+   * \param output where the results of each run are written.
+   */
+  void SetOutput (Ptr<DataOutputInterface> output);
+  /**
+   * \param experiment the experiment label of every run.
+   * \param strategy the strategy label of every run.
+   * \param input the input label of every run.
+   * \param description the description of every run.
+   *
+   * The run label of each DataCollector is the run number, unless
+   * the run callback changes it.
+   */
+  void DescribeRuns (std::string experiment,
+                     std::string strategy,
+                     std::string input,
+                     std::string description = "");
+
+  /**
+   * \param run the function which executes one run.
+   * \param firstRun the run number of the first run.
+   * \param runs the number of runs to execute.
+   * \returns the number of runs which failed, that is, whose worker
+   *          crashed or exited before sending its results.
+   */
+  uint32_t Run (RunCallback run, uint64_t firstRun, uint32_t runs);
+
+private:
+  /* Body of the workers: never returns. */
+  void DoWorker (RunCallback run, uint64_t runNumber, int fd);
+
+  uint32_t m_maxProcesses;
+  Ptr<DataOutputInterface> m_output;
+  std::string m_experiment;
+  std::string m_strategy;
+  std::string m_input;
+  std::string m_description;
+};
+
+} // namespace ns3
+
+#endif /* PARALLEL_RUN_HELPER_H */
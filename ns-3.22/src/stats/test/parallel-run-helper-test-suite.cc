@@ -0,0 +1,243 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/parallel-run-helper.h"
+#include "ns3/basic-data-calculators.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/simulator.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+// Record everything the runs output, by run label.
+class RecordingDataOutput : public DataOutputInterface
+{
+public:
+  struct Result
+  {
+    uint32_t count;
+    double sum;
+    std::string metadata;
+  };
+
+  virtual void Output (DataCollector &dc)
+  {
+    Result &result = m_results[dc.GetRunLabel ()];
+    result.count = 0;
+    result.sum = 0;
+    for (MetadataList::iterator i = dc.MetadataBegin (); i != dc.MetadataEnd (); i++)
+      {
+        result.metadata = i->second;
+      }
+    Callback callback (result);
+    for (DataCalculatorList::iterator i = dc.DataCalculatorBegin (); i != dc.DataCalculatorEnd (); i++)
+      {
+        (*i)->Output (callback);
+      }
+  }
+
+  std::map<std::string, Result> m_results;
+
+private:
+  class Callback : public DataOutputCallback
+  {
+  public:
+    Callback (Result &result) : m_result (result) {}
+    virtual void OutputStatistic (std::string key, std::string variable, const StatisticalSummary *statSum)
+    {
+      m_result.count = statSum->getCount ();
+      m_result.sum = statSum->getSum ();
+    }
+    virtual void OutputSingleton (std::string key, std::string variable, int val) {}
+    virtual void OutputSingleton (std::string key, std::string variable, uint32_t val) {}
+    virtual void OutputSingleton (std::string key, std::string variable, double val) {}
+    virtual void OutputSingleton (std::string key, std::string variable, std::string val) {}
+    virtual void OutputSingleton (std::string key, std::string variable, Time val) {}
+  private:
+    Result &m_result;
+  };
+};
+
+class ParallelRunHelperTestCase : public TestCase
+{
+public:
+  ParallelRunHelperTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Draw (Ptr<MinMaxAvgTotalCalculator<double> > calculator);
+  void DoOneRun (uint64_t run, Ptr<DataCollector> data);
+  std::vector<double> DrawReseeded (void);
+
+  // created before the runs, like the random variables of a topology
+  Ptr<UniformRandomVariable> m_random;
+};
+
+ParallelRunHelperTestCase::ParallelRunHelperTestCase ()
+  : TestCase ("Check that each run gets its own random numbers and results")
+{
+}
+
+void
+ParallelRunHelperTestCase::Draw (Ptr<MinMaxAvgTotalCalculator<double> > calculator)
+{
+  calculator->Update (m_random->GetValue ());
+}
+
+void
+ParallelRunHelperTestCase::DoOneRun (uint64_t run, Ptr<DataCollector> data)
+{
+  Ptr<MinMaxAvgTotalCalculator<double> > calculator = CreateObject<MinMaxAvgTotalCalculator<double> > ();
+  calculator->SetKey ("draws");
+  data->AddDataCalculator (calculator);
+  data->AddMetadata ("run", (uint32_t)run);
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::Schedule (Seconds (i), &ParallelRunHelperTestCase::Draw, this, calculator);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  if (run == 13)
+    {
+      // a run which crashes
+      std::abort ();
+    }
+}
+
+/*
+ * Draw what the workers should have drawn, and two values of a normal
+ * variable which must not survive a reseed. This runs in a child
+ * process, so that reseeding the random variables does not change the
+ * numbers the other test suites draw.
+ */
+std::vector<double>
+ParallelRunHelperTestCase::DrawReseeded (void)
+{
+  std::vector<double> values;
+  int fds[2];
+  if (pipe (fds) != 0)
+    {
+      return values;
+    }
+  pid_t pid = fork ();
+  if (pid == 0)
+    {
+      close (fds[0]);
+      for (uint64_t run = 10; run < 15; run++)
+        {
+          RngSeedManager::SetRun (run);
+          RandomVariableStream::ReseedAll ();
+          double sum = 0;
+          for (uint32_t i = 0; i < 10; i++)
+            {
+              sum += m_random->GetValue ();
+            }
+          values.push_back (sum);
+        }
+      // The first value draws two normal values, and keeps the second.
+      Ptr<NormalRandomVariable> normal = CreateObject<NormalRandomVariable> ();
+      normal->GetValue ();
+      for (uint32_t i = 0; i < 2; i++)
+        {
+          RandomVariableStream::ReseedAll ();
+          values.push_back (normal->GetValue ());
+        }
+      std::size_t size = values.size () * sizeof (double);
+      _exit (write (fds[1], &values[0], size) == (ssize_t)size ? 0 : 1);
+    }
+  close (fds[1]);
+  if (pid > 0)
+    {
+      double value;
+      while (read (fds[0], &value, sizeof (value)) == sizeof (value))
+        {
+          values.push_back (value);
+        }
+      while (waitpid (pid, 0, 0) < 0 && errno == EINTR)
+        {
+        }
+    }
+  close (fds[0]);
+  return values;
+}
+
+void
+ParallelRunHelperTestCase::DoRun (void)
+{
+  uint64_t oldRun = RngSeedManager::GetRun ();
+  m_random = CreateObject<UniformRandomVariable> ();
+
+  Ptr<RecordingDataOutput> output = CreateObject<RecordingDataOutput> ();
+  ParallelRunHelper helper;
+  helper.SetMaxProcesses (3);
+  helper.SetOutput (output);
+  uint32_t failed = helper.Run (MakeCallback (&ParallelRunHelperTestCase::DoOneRun, this), 10, 5);
+
+  NS_TEST_EXPECT_MSG_EQ (failed, 1, "Run 13 should have failed");
+  NS_TEST_ASSERT_MSG_EQ (output->m_results.size (), 4, "Bad number of results");
+  NS_TEST_EXPECT_MSG_EQ (RngSeedManager::GetRun (), oldRun, "The run number of the calling process changed");
+
+  // each worker should draw what this process draws with the same run
+  // number and a reseeded variable
+  std::vector<double> values = DrawReseeded ();
+  NS_TEST_ASSERT_MSG_EQ (values.size (), 7, "Could not draw the expected values");
+  for (uint64_t run = 10; run < 15; run++)
+    {
+      if (run == 13)
+        {
+          continue;
+        }
+      double sum = values[run - 10];
+      std::ostringstream label;
+      label << run;
+      RecordingDataOutput::Result &result = output->m_results[label.str ()];
+      NS_TEST_EXPECT_MSG_EQ_TOL (result.sum, sum, 1e-9, "Bad results for run " << run);
+      NS_TEST_EXPECT_MSG_EQ (result.count, 10, "Bad count for run " << run);
+      NS_TEST_EXPECT_MSG_EQ (result.metadata, label.str (), "Bad metadata for run " << run);
+    }
+  NS_TEST_EXPECT_MSG_NE (output->m_results["10"].sum, output->m_results["11"].sum,
+                         "Runs 10 and 11 drew the same numbers");
+  NS_TEST_EXPECT_MSG_EQ (values[5], values[6], "A normal value drawn before the reseed was returned");
+
+  m_random = 0;
+}
+
+class ParallelRunHelperTestSuite : public TestSuite
+{
+public:
+  ParallelRunHelperTestSuite ();
+};
+
+ParallelRunHelperTestSuite::ParallelRunHelperTestSuite ()
+  : TestSuite ("parallel-run-helper", UNIT)
+{
+  AddTestCase (new ParallelRunHelperTestCase, TestCase::QUICK);
+}
+
+static ParallelRunHelperTestSuite parallelRunHelperTestSuite;
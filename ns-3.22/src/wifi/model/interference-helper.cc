@@ -22,7 +22,7 @@
 #include "error-rate-model.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
-#include <algorithm>
+#include <utility>
 
 namespace ns3 {
 
@@ -124,6 +124,8 @@ InterferenceHelper::NiChange::operator < (const InterferenceHelper::NiChange& o)
 InterferenceHelper::InterferenceHelper ()
   : m_errorRateModel (0),
     m_firstPower (0.0),
+    m_pastEnd (m_niChanges.end ()),
+    m_pastPower (0.0),
     m_rxing (false)
 {
 }
@@ -179,17 +181,19 @@ Time
 InterferenceHelper::GetEnergyDuration (double energyW)
 {
   Time now = Simulator::Now ();
-  double noiseInterferenceW = 0.0;
+  // the changes in the past are summed once, since the changes added
+  // later cannot be earlier than now.
+  while (m_pastEnd != m_niChanges.end () && m_pastEnd->first < now)
+    {
+      m_pastPower += m_pastEnd->second;
+      m_pastEnd++;
+    }
+  double noiseInterferenceW = m_pastPower;
   Time end = now;
-  noiseInterferenceW = m_firstPower;
-  for (NiChanges::const_iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
+  for (NiChangeTimeline::const_iterator i = m_pastEnd; i != m_niChanges.end (); i++)
     {
-      noiseInterferenceW += i->GetDelta ();
-      end = i->GetTime ();
-      if (end < now)
-        {
-          continue;
-        }
+      noiseInterferenceW += i->second;
+      end = i->first;
       if (noiseInterferenceW < energyW)
         {
           break;
@@ -204,20 +208,13 @@ InterferenceHelper::AppendEvent (Ptr<InterferenceHelper::Event> event)
   Time now = Simulator::Now ();
   if (!m_rxing)
     {
-      NiChanges::iterator nowIterator = GetPosition (now);
-      for (NiChanges::iterator i = m_niChanges.begin (); i != nowIterator; i++)
-        {
-          m_firstPower += i->GetDelta ();
-        }
-      m_niChanges.erase (m_niChanges.begin (), nowIterator);
-      m_niChanges.insert (m_niChanges.begin (), NiChange (event->GetStartTime (), event->GetRxPowerW ()));
-    }
-  else
-    {
-      AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetRxPowerW ()));
+      // no event is received: the changes which already happened are
+      // only needed for their sum, and the start of this event is the
+      // first change of the timeline.
+      CollectNiChanges (now);
     }
+  AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetRxPowerW ()));
   AddNiChangeEvent (NiChange (event->GetEndTime (), -event->GetRxPowerW ()));
-
 }
 
 
@@ -236,21 +233,13 @@ InterferenceHelper::CalculateSnr (double signal, double noiseInterference, WifiM
 }
 
 double
-InterferenceHelper::CalculateNoiseInterferenceW (Ptr<InterferenceHelper::Event> event, NiChanges *ni) const
+InterferenceHelper::CalculateNoiseInterferenceW (Ptr<InterferenceHelper::Event> event) const
 {
-  double noiseInterference = m_firstPower;
   NS_ASSERT (m_rxing);
-  for (NiChanges::const_iterator i = m_niChanges.begin () + 1; i != m_niChanges.end (); i++)
-    {
-      if ((event->GetEndTime () == i->GetTime ()) && event->GetRxPowerW () == -i->GetDelta ())
-        {
-          break;
-        }
-      ni->push_back (*i);
-    }
-  ni->insert (ni->begin (), NiChange (event->GetStartTime (), noiseInterference));
-  ni->push_back (NiChange (event->GetEndTime (), 0));
-  return noiseInterference;
+  NS_ASSERT (!m_niChanges.empty ());
+  // the first change is the start of the event received
+  NS_ASSERT (m_niChanges.begin ()->first == event->GetStartTime ());
+  return m_firstPower;
 }
 
 double
@@ -267,11 +256,14 @@ InterferenceHelper::CalculateChunkSuccessRate (double snir, Time duration, WifiM
 }
 
 double
-InterferenceHelper::CalculatePer (Ptr<const InterferenceHelper::Event> event, NiChanges *ni) const
+InterferenceHelper::CalculatePer (Ptr<const InterferenceHelper::Event> event, double noiseInterferenceW) const
 {
   double psr = 1.0; /* Packet Success Rate */
-  NiChanges::iterator j = ni->begin ();
-  Time previous = (*j).GetTime ();
+  // the changes after the start of the event, which is the first one,
+  // up to its end, which ends the last chunk
+  NiChangeTimeline::const_iterator j = m_niChanges.begin ();
+  NiChangeTimeline::const_iterator last = m_niChanges.lower_bound (event->GetEndTime ());
+  Time previous = event->GetStartTime ();
   WifiMode payloadMode = event->GetPayloadMode ();
   WifiPreamble preamble = event->GetPreambleType ();
  WifiMode MfHeaderMode ;
@@ -281,16 +273,18 @@ InterferenceHelper::CalculatePer (Ptr<const InterferenceHelper::Event> event, Ni
 
    }
   WifiMode headerMode = WifiPhy::GetPlcpHeaderMode (payloadMode, preamble);
-  Time plcpHeaderStart = (*j).GetTime () + WifiPhy::GetPlcpPreambleDuration (payloadMode, preamble); //packet start time+ preamble
+  Time plcpHeaderStart = previous + WifiPhy::GetPlcpPreambleDuration (payloadMode, preamble); //packet start time+ preamble
   Time plcpHsigHeaderStart = plcpHeaderStart + WifiPhy::GetPlcpHeaderDuration (payloadMode, preamble);//packet start time+ preamble+L SIG
   Time plcpHtTrainingSymbolsStart = plcpHsigHeaderStart + WifiPhy::GetPlcpHtSigHeaderDuration (payloadMode, preamble);//packet start time+ preamble+L SIG+HT SIG
   Time plcpPayloadStart =plcpHtTrainingSymbolsStart + WifiPhy::GetPlcpHtTrainingSymbolDuration (preamble,event->GetTxVector()); //packet start time+ preamble+L SIG+HT SIG+Training
-  double noiseInterferenceW = (*j).GetDelta ();
   double powerW = event->GetRxPowerW ();
-    j++;
-  while (ni->end () != j)
+  if (j != last)
     {
-      Time current = (*j).GetTime ();
+      j++;
+    }
+  while (true)
+    {
+      Time current = j == last ? event->GetEndTime () : j->first;
       NS_ASSERT (current >= previous);
       //Case 1: Both prev and curr point to the payload
       if (previous >= plcpPayloadStart)
@@ -528,8 +522,12 @@ InterferenceHelper::CalculatePer (Ptr<const InterferenceHelper::Event> event, Ni
             }
         }
 
-      noiseInterferenceW += (*j).GetDelta ();
-      previous = (*j).GetTime ();
+      if (j == last)
+        {
+          break;
+        }
+      noiseInterferenceW += j->second;
+      previous = j->first;
       j++;
     }
 
@@ -541,8 +539,7 @@ InterferenceHelper::CalculatePer (Ptr<const InterferenceHelper::Event> event, Ni
 struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculateSnrPer (Ptr<InterferenceHelper::Event> event)
 {
-  NiChanges ni;
-  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
+  double noiseInterferenceW = CalculateNoiseInterferenceW (event);
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
                              event->GetPayloadMode ());
@@ -550,7 +547,7 @@ InterferenceHelper::CalculateSnrPer (Ptr<InterferenceHelper::Event> event)
   /* calculate the SNIR at the start of the packet and accumulate
    * all SNIR changes in the snir vector.
    */
-  double per = CalculatePer (event, &ni);
+  double per = CalculatePer (event, noiseInterferenceW);
 
   struct SnrPer snrPer;
   snrPer.snr = snr;
@@ -564,17 +561,36 @@ InterferenceHelper::EraseEvents (void)
   m_niChanges.clear ();
   m_rxing = false;
   m_firstPower = 0.0;
+  m_pastEnd = m_niChanges.end ();
+  m_pastPower = 0.0;
 }
-InterferenceHelper::NiChanges::iterator
+InterferenceHelper::NiChangeTimeline::iterator
 InterferenceHelper::GetPosition (Time moment)
 {
-  return std::upper_bound (m_niChanges.begin (), m_niChanges.end (), NiChange (moment, 0));
-
+  return m_niChanges.upper_bound (moment);
 }
 void
 InterferenceHelper::AddNiChangeEvent (NiChange change)
 {
-  m_niChanges.insert (GetPosition (change.GetTime ()), change);
+  // a multimap inserts a value at the end of the range of its key
+  NiChangeTimeline::iterator i = m_niChanges.insert (std::make_pair (change.GetTime (), change.GetDelta ()));
+  // the changes before m_pastEnd are earlier than now
+  if (m_pastEnd == m_niChanges.end () || change.GetTime () < m_pastEnd->first)
+    {
+      m_pastEnd = i;
+    }
+}
+void
+InterferenceHelper::CollectNiChanges (Time moment)
+{
+  NiChangeTimeline::iterator end = GetPosition (moment);
+  for (NiChangeTimeline::const_iterator i = m_niChanges.begin (); i != end; i++)
+    {
+      m_firstPower += i->second;
+    }
+  m_niChanges.erase (m_niChanges.begin (), end);
+  m_pastEnd = m_niChanges.begin ();
+  m_pastPower = m_firstPower;
 }
 void
 InterferenceHelper::NotifyRxStart ()
@@ -585,5 +601,7 @@ void
 InterferenceHelper::NotifyRxEnd ()
 {
   m_rxing = false;
+  // the changes were kept for the reception only
+  CollectNiChanges (Simulator::Now ());
 }
 } // namespace ns3
@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <vector>
 #include <list>
+#include <map>
 #include "wifi-mode.h"
 #include "wifi-preamble.h"
 #include "wifi-phy-standard.h"
@@ -239,9 +240,10 @@ private:
     double m_delta;
   };
   /**
-   * typedef for a vector of NiChanges
+   * typedef for the power changes of the medium ordered by time; the
+   * changes of the same time are kept in the order they were added.
    */
-  typedef std::vector <NiChange> NiChanges;
+  typedef std::multimap<Time, double> NiChangeTimeline;
   /**
    * typedef for a list of Events
    */
@@ -256,13 +258,13 @@ private:
    */
   void AppendEvent (Ptr<Event> event);
   /**
-   * Calculate noise and interference power in W.
+   * Calculate noise and interference power in W at the start of the
+   * event received, which is the first change of the timeline.
    *
    * \param event
-   * \param ni
    * \return noise and interference power
    */
-  double CalculateNoiseInterferenceW (Ptr<Event> event, NiChanges *ni) const;
+  double CalculateNoiseInterferenceW (Ptr<Event> event) const;
   /**
    * Calculate SNR (linear ratio) from the given signal power and noise+interference power.
    * (Mode is not currently used)
@@ -285,28 +287,42 @@ private:
   double CalculateChunkSuccessRate (double snir, Time duration, WifiMode mode) const;
   /**
    * Calculate the error rate of the given packet. The packet can be divided into
-   * multiple chunks (e.g. due to interference from other transmissions).
+   * multiple chunks (e.g. due to interference from other transmissions), which
+   * are read from the changes of the timeline before the end of the packet.
    *
    * \param event
-   * \param ni
+   * \param noiseInterferenceW the noise and interference power at the start of the packet
    * \return the error rate of the packet
    */
-  double CalculatePer (Ptr<const Event> event, NiChanges *ni) const;
+  double CalculatePer (Ptr<const Event> event, double noiseInterferenceW) const;
 
   double m_noiseFigure; /**< noise figure (linear) */
   Ptr<ErrorRateModel> m_errorRateModel;
   /// Experimental: needed for energy duration calculation
-  NiChanges m_niChanges;
+  NiChangeTimeline m_niChanges;
+  /// the sum of the power changes removed from m_niChanges
   double m_firstPower;
+  /// the first change of m_niChanges not summed in m_pastPower
+  NiChangeTimeline::iterator m_pastEnd;
+  /// m_firstPower and the sum of the changes before m_pastEnd
+  double m_pastPower;
   bool m_rxing;
   /// Returns an iterator to the first nichange, which is later than moment
-  NiChanges::iterator GetPosition (Time moment);
+  NiChangeTimeline::iterator GetPosition (Time moment);
   /**
-   * Add NiChange to the list at the appropriate position.
+   * Add NiChange to the timeline after the changes of the same time,
+   * which cannot be earlier than the current time.
    *
    * \param change
    */
   void AddNiChangeEvent (NiChange change);
+  /**
+   * Add the power changes up to the given moment to m_firstPower and
+   * remove them from the timeline.
+   *
+   * \param moment the time of the last change to remove
+   */
+  void CollectNiChanges (Time moment);
 };
 
 } // namespace ns3
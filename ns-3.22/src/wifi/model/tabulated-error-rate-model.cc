@@ -0,0 +1,359 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include "tabulated-error-rate-model.h"
+#include "nist-error-rate-model.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/object-factory.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TabulatedErrorRateModel");
+
+NS_OBJECT_ENSURE_REGISTERED (TabulatedErrorRateModel);
+
+/// the number of bit counts of the tables: 0, 1, 2, 4, ... 2^20 bits
+static const uint32_t TABULATED_N_BUCKETS = 22;
+/// the logarithm stored for a success rate of zero
+static const double TABULATED_MIN_LOG_SUCCESS = -1000.0;
+
+TypeId
+TabulatedErrorRateModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TabulatedErrorRateModel")
+    .SetParent<ErrorRateModel> ()
+    .AddConstructor<TabulatedErrorRateModel> ()
+    .AddAttribute ("ErrorRateModel",
+                   "The error rate model which computes the tables; "
+                   "a NistErrorRateModel if not set.",
+                   PointerValue (),
+                   MakePointerAccessor (&TabulatedErrorRateModel::SetErrorRateModel,
+                                        &TabulatedErrorRateModel::GetErrorRateModel),
+                   MakePointerChecker<ErrorRateModel> ())
+    .AddAttribute ("MinSnr",
+                   "The lowest SNR of the tables, in dB.",
+                   DoubleValue (-10.0),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_minSnrDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxSnr",
+                   "The highest SNR of the tables, in dB.",
+                   DoubleValue (40.0),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_maxSnrDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("SnrStep",
+                   "The SNR step of the tables, in dB.",
+                   DoubleValue (0.05),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_snrStepDb),
+                   MakeDoubleChecker<double> (0.001))
+    .AddAttribute ("TableFile",
+                   "A file written by TabulatedErrorRateModel::Save from which "
+                   "the tables are loaded; none if empty.",
+                   StringValue (""),
+                   MakeStringAccessor (&TabulatedErrorRateModel::SetTableFile),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+TabulatedErrorRateModel::TabulatedErrorRateModel ()
+  : m_minSnrDb (-10.0),
+    m_maxSnrDb (40.0),
+    m_snrStepDb (0.05)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TabulatedErrorRateModel::~TabulatedErrorRateModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TabulatedErrorRateModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_model = 0;
+  m_tables.clear ();
+  ErrorRateModel::DoDispose ();
+}
+
+void
+TabulatedErrorRateModel::SetErrorRateModel (Ptr<ErrorRateModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  m_model = model;
+  m_tables.clear ();
+}
+
+Ptr<ErrorRateModel>
+TabulatedErrorRateModel::GetErrorRateModel (void) const
+{
+  return m_model;
+}
+
+void
+TabulatedErrorRateModel::SetTableFile (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  if (!filename.empty ())
+    {
+      Load (filename);
+    }
+}
+
+uint32_t
+TabulatedErrorRateModel::GetBucketBits (uint32_t bucket)
+{
+  return bucket == 0 ? 0 : 1U << (bucket - 1);
+}
+
+std::map<std::string, Ptr<const TabulatedErrorRateModel::Table> > &
+TabulatedErrorRateModel::GetSharedTables (void)
+{
+  static std::map<std::string, Ptr<const Table> > tables;
+  return tables;
+}
+
+std::string
+TabulatedErrorRateModel::GetModelKey (Ptr<const ErrorRateModel> model)
+{
+  std::ostringstream key;
+  TypeId tid = model->GetInstanceTypeId ();
+  key << tid.GetName ();
+  do
+    {
+      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
+        {
+          struct TypeId::AttributeInformation info = tid.GetAttribute (i);
+          if ((info.flags & TypeId::ATTR_GET) && info.accessor->HasGetter ())
+            {
+              Ptr<AttributeValue> value = info.checker->Create ();
+              model->GetAttribute (info.name, *value);
+              key << " " << info.name << "=" << value->SerializeToString (info.checker);
+            }
+        }
+      tid = tid.GetParent ();
+    }
+  while (tid != ObjectBase::GetTypeId ());
+  return key.str ();
+}
+
+void
+TabulatedErrorRateModel::SetTable (Ptr<const Table> table) const
+{
+  WifiMode mode = table->mode;
+  if (mode.GetUid () >= m_tables.size ())
+    {
+      m_tables.resize (mode.GetUid () + 1);
+    }
+  m_tables[mode.GetUid ()] = table;
+}
+
+void
+TabulatedErrorRateModel::Build (WifiMode mode) const
+{
+  NS_LOG_FUNCTION (this << mode);
+  if (mode.GetUid () < m_tables.size () && m_tables[mode.GetUid ()] != 0)
+    {
+      return;
+    }
+  if (m_model == 0)
+    {
+      m_model = CreateObject<NistErrorRateModel> ();
+    }
+  NS_ABORT_MSG_UNLESS (m_maxSnrDb > m_minSnrDb, "MaxSnr must be greater than MinSnr");
+  // the interpolation needs two rows
+  uint32_t nSnrs = static_cast<uint32_t> (std::floor ((m_maxSnrDb - m_minSnrDb) / m_snrStepDb)) + 1;
+  nSnrs = std::max<uint32_t> (nSnrs, 2);
+
+  std::ostringstream key;
+  key.precision (std::numeric_limits<double>::digits10 + 2);
+  key << GetModelKey (m_model) << " " << m_minSnrDb << " " << m_snrStepDb << " " << nSnrs
+      << " " << mode.GetUid ();
+  std::map<std::string, Ptr<const Table> > &shared = GetSharedTables ();
+  std::map<std::string, Ptr<const Table> >::const_iterator found = shared.find (key.str ());
+  if (found != shared.end ())
+    {
+      NS_LOG_DEBUG ("shared table of " << mode);
+      SetTable (found->second);
+      return;
+    }
+
+  Ptr<Table> table = Create<Table> ();
+  table->mode = mode;
+  table->minSnrDb = m_minSnrDb;
+  table->snrStepDb = m_snrStepDb;
+  table->nSnrs = nSnrs;
+  table->nBuckets = TABULATED_N_BUCKETS;
+  table->logSuccess.reserve (table->nSnrs * table->nBuckets);
+  for (uint32_t i = 0; i < table->nSnrs; i++)
+    {
+      double snr = std::pow (10.0, (table->minSnrDb + i * table->snrStepDb) / 10.0);
+      for (uint32_t k = 0; k < table->nBuckets; k++)
+        {
+          double success = m_model->GetChunkSuccessRate (mode, snr, GetBucketBits (k));
+          table->logSuccess.push_back (success > 0 ? std::max (std::log (success), TABULATED_MIN_LOG_SUCCESS)
+                                       : TABULATED_MIN_LOG_SUCCESS);
+        }
+    }
+  NS_LOG_DEBUG ("table of " << mode << ": " << table->nSnrs << " snrs from " << table->minSnrDb << "dB");
+  shared[key.str ()] = table;
+  SetTable (table);
+}
+
+const TabulatedErrorRateModel::Table &
+TabulatedErrorRateModel::GetTable (WifiMode mode) const
+{
+  if (mode.GetUid () >= m_tables.size () || m_tables[mode.GetUid ()] == 0)
+    {
+      Build (mode);
+    }
+  return *m_tables[mode.GetUid ()];
+}
+
+double
+TabulatedErrorRateModel::GetChunkSuccessRate (WifiMode mode, double snr, uint32_t nbits) const
+{
+  NS_LOG_FUNCTION (this << mode << snr << nbits);
+  const Table &table = GetTable (mode);
+  double x = (10.0 * std::log10 (snr) - table.minSnrDb) / table.snrStepDb;
+  // beyond the grid; the NaN of a negative SNR is not below zero
+  if (!(x >= 0) || x > table.nSnrs - 1 || nbits > GetBucketBits (table.nBuckets - 1))
+    {
+      return m_model->GetChunkSuccessRate (mode, snr, nbits);
+    }
+  uint32_t i = std::min (static_cast<uint32_t> (x), table.nSnrs - 2);
+  double snrWeight = x - i;
+
+  // the last bit count which is not larger than nbits
+  uint32_t k = 0;
+  while (k + 2 < table.nBuckets && GetBucketBits (k + 1) <= nbits)
+    {
+      k++;
+    }
+  double bitsWeight = static_cast<double> (nbits - GetBucketBits (k)) / (GetBucketBits (k + 1) - GetBucketBits (k));
+
+  const double *row = &table.logSuccess[i * table.nBuckets + k];
+  const double *next = row + table.nBuckets;
+  // the logarithm is linear in the number of bits, while the rate is
+  // smoother than its logarithm along the SNR when it nears zero.
+  double low = std::exp (row[0] + bitsWeight * (row[1] - row[0]));
+  double high = std::exp (next[0] + bitsWeight * (next[1] - next[0]));
+  return low + snrWeight * (high - low);
+}
+
+void
+TabulatedErrorRateModel::Load (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  std::ifstream is (filename.c_str ());
+  if (!is.good ())
+    {
+      NS_FATAL_ERROR ("Could not open " << filename);
+    }
+  // a line with the type of the model which computed the tables, then
+  // for each table, a line with the mode, the first SNR, the SNR step,
+  // the number of rows and of bit counts, followed by the rows.
+  std::string keyword;
+  std::string name;
+  TypeId tid;
+  if (!(is >> keyword >> name) || keyword != "ErrorRateModel" || !TypeId::LookupByNameFailSafe (name, &tid))
+    {
+      NS_FATAL_ERROR ("Unknown error rate model " << name << " in " << filename);
+    }
+  while (is >> name)
+    {
+      Ptr<Table> table = Create<Table> ();
+      table->mode = WifiMode (name);
+      is >> table->minSnrDb >> table->snrStepDb >> table->nSnrs >> table->nBuckets;
+      if (!is || table->nSnrs < 2 || table->nBuckets < 2 || table->nBuckets > 32 || !(table->snrStepDb > 0))
+        {
+          NS_FATAL_ERROR ("Malformed table of " << name << " in " << filename);
+        }
+      table->logSuccess.resize (table->nSnrs * table->nBuckets);
+      for (std::vector<double>::iterator j = table->logSuccess.begin (); j != table->logSuccess.end (); ++j)
+        {
+          is >> *j;
+        }
+      if (!is)
+        {
+          NS_FATAL_ERROR ("Truncated table of " << name << " in " << filename);
+        }
+      NS_LOG_DEBUG ("loaded table of " << table->mode << ": " << table->nSnrs << " snrs from " << table->minSnrDb << "dB");
+      SetTable (table);
+    }
+  if (m_model == 0)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (tid);
+      m_model = factory.Create<ErrorRateModel> ();
+    }
+  else if (m_model->GetInstanceTypeId () != tid)
+    {
+      NS_LOG_WARN ("the tables of " << filename << " were computed by " << tid.GetName ()
+                   << ", not by " << m_model->GetInstanceTypeId ().GetName ());
+    }
+}
+
+void
+TabulatedErrorRateModel::Save (std::string filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+  std::ofstream os (filename.c_str ());
+  if (!os.good ())
+    {
+      NS_FATAL_ERROR ("Could not open " << filename);
+    }
+  os.precision (std::numeric_limits<double>::digits10 + 2);
+  TypeId tid = m_model == 0 ? NistErrorRateModel::GetTypeId () : m_model->GetInstanceTypeId ();
+  os << "ErrorRateModel " << tid.GetName () << std::endl;
+  for (uint32_t uid = 0; uid < m_tables.size (); uid++)
+    {
+      if (m_tables[uid] == 0)
+        {
+          continue;
+        }
+      const Table &table = *m_tables[uid];
+      os << table.mode.GetUniqueName () << " " << table.minSnrDb << " " << table.snrStepDb
+         << " " << table.nSnrs << " " << table.nBuckets << std::endl;
+      for (uint32_t i = 0; i < table.nSnrs; i++)
+        {
+          for (uint32_t k = 0; k < table.nBuckets; k++)
+            {
+              os << (k == 0 ? "" : " ") << table.logSuccess[i * table.nBuckets + k];
+            }
+          os << std::endl;
+        }
+    }
+  if (!os.good ())
+    {
+      NS_FATAL_ERROR ("Could not write " << filename);
+    }
+}
+
+} // namespace ns3
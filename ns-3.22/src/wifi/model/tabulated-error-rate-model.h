@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef TABULATED_ERROR_RATE_MODEL_H
+#define TABULATED_ERROR_RATE_MODEL_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "ns3/simple-ref-count.h"
+#include "wifi-mode.h"
+#include "error-rate-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * An error rate model which looks up the chunk success rates in tables
+ * instead of computing them.
+ *
+ * The table of a mode holds the logarithm of the chunk success rate
+ * given by another error rate model, NistErrorRateModel by default, for
+ * a grid of SNRs in dB and for chunks of 0, 1, 2, 4, ... 2^20 bits.  The
+ * logarithm is interpolated linearly along the number of bits, which is
+ * exact for all the models of this module, since their success rate is
+ * the success rate of a bit to the power of the number of bits.  The
+ * rate is then interpolated linearly along the SNR: with the default
+ * grid, the rates of NistErrorRateModel and YansErrorRateModel are
+ * within 0.002 of theirs, except for chunks of a few bits where the
+ * error probability of a bit nears one.  The SNRs outside the grid and
+ * the larger chunks are given to the other model.
+ *
+ * The table of a mode is computed the first time the mode is used,
+ * unless it was loaded from the file given by the TableFile attribute,
+ * which Save writes.  The tables computed are shared by all the
+ * instances whose model has the same type and attribute values, and
+ * whose tables have the same grid, so that the Wi-Fi devices of a
+ * simulation compute each table once.
+ */
+class TabulatedErrorRateModel : public ErrorRateModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  TabulatedErrorRateModel ();
+  virtual ~TabulatedErrorRateModel ();
+
+  virtual double GetChunkSuccessRate (WifiMode mode, double snr, uint32_t nbits) const;
+
+  /**
+   * \param model the model which computes the tables
+   *
+   * The tables computed or loaded before are dropped.
+   */
+  void SetErrorRateModel (Ptr<ErrorRateModel> model);
+  /**
+   * \return the model which computes the tables
+   */
+  Ptr<ErrorRateModel> GetErrorRateModel (void) const;
+
+  /**
+   * Compute the table of a mode, if it was neither computed nor loaded.
+   * The table has at least two rows: if the step is larger than the
+   * range of the SNRs, it extends past MaxSnr.
+   *
+   * \param mode the Wi-Fi mode
+   */
+  void Build (WifiMode mode) const;
+  /**
+   * Load the tables written by Save.  The tables of the other modes are
+   * computed when they are used.  If the ErrorRateModel attribute is not
+   * set, a model of the type which computed the tables is created, to
+   * compute the other tables and the rates beyond them.
+   *
+   * \param filename the name of the file
+   */
+  void Load (std::string filename);
+  /**
+   * Write the tables computed or loaded to a file.
+   *
+   * \param filename the name of the file
+   */
+  void Save (std::string filename) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /// the chunk success rates of a mode
+  struct Table : public SimpleRefCount<Table>
+  {
+    WifiMode mode;                   //!< the mode
+    double minSnrDb;                 //!< the SNR of the first row, in dB
+    double snrStepDb;                //!< the SNR step between the rows, in dB
+    uint32_t nSnrs;                  //!< the number of rows
+    uint32_t nBuckets;               //!< the number of bit counts of a row
+    std::vector<double> logSuccess;  //!< the logarithm of the rates, row by row
+  };
+
+  /**
+   * \param bucket the index of a bit count
+   * \return the bit count
+   */
+  static uint32_t GetBucketBits (uint32_t bucket);
+  /**
+   * \return the tables computed by all the instances, by model, grid
+   * and mode, which are kept until the end of the program
+   */
+  static std::map<std::string, Ptr<const Table> > & GetSharedTables (void);
+  /**
+   * \param model an error rate model
+   * \return the type and the attribute values of the model
+   */
+  static std::string GetModelKey (Ptr<const ErrorRateModel> model);
+  /**
+   * \param filename the file to load the tables from, if not empty
+   */
+  void SetTableFile (std::string filename);
+  /**
+   * \param mode the Wi-Fi mode
+   * \return the table of the mode, computed if needed
+   */
+  const Table & GetTable (WifiMode mode) const;
+  /**
+   * \param table the table of a mode, computed or loaded
+   */
+  void SetTable (Ptr<const Table> table) const;
+
+  mutable Ptr<ErrorRateModel> m_model;  //!< the model which computes the tables
+  double m_minSnrDb;                    //!< the lowest SNR of the tables
+  double m_maxSnrDb;                    //!< the highest SNR of the tables
+  double m_snrStepDb;                   //!< the SNR step of the tables
+  mutable std::vector<Ptr<const Table> > m_tables;  //!< the tables, by mode uid
+};
+
+} // namespace ns3
+
+#endif /* TABULATED_ERROR_RATE_MODEL_H */
@@ -17,6 +17,7 @@
  *
  * Author: Mathieu Lacage, <mathieu.lacage@sophia.inria.fr>
  */
+#include <algorithm>
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/mobility-model.h"
@@ -24,6 +25,7 @@
 #include "ns3/node.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/double.h"
 #include "ns3/object-factory.h"
 #include "yans-wifi-channel.h"
 #include "yans-wifi-phy.h"
@@ -50,11 +52,31 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("ReceptionThreshold",
+                   "The power, in dBm, below which the signals are not delivered "
+                   "to the receivers, not even as interference.  The default "
+                   "value delivers all the signals.",
+                   DoubleValue (-1.0e9),
+                   MakeDoubleAccessor (&YansWifiChannel::m_receptionThreshold),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("SpatialIndexCellSize",
+                   "If not zero, the size, in meters, of the cells of a grid "
+                   "which indexes the positions of the receivers, so that the "
+                   "receivers beyond the range of the PropagationLossModel for "
+                   "the ReceptionThreshold are not looked at.  The grid "
+                   "assumes that the mobility models notify a course change "
+                   "whenever their velocity changes.  It is not used with a "
+                   "PropagationDelayModel other than the constant speed one, "
+                   "which may draw a random delay for every receiver.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_cellSize),
+                   MakeDoubleChecker<double> (0))
   ;
   return tid;
 }
 
 YansWifiChannel::YansWifiChannel ()
+  : m_nIndexed (0)
 {
 }
 YansWifiChannel::~YansWifiChannel ()
@@ -80,52 +102,129 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
 {
   Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
   NS_ASSERT (senderMobility != 0);
-  uint32_t j = 0;
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
+  // the receivers share a single copy of the packet: they only
+  // copy it again when they deliver it to their MAC.
+  Ptr<Transmission> transmission = Create<Transmission> ();
+  transmission->packet = packet->Copy ();
+  transmission->txVector = txVector;
+  transmission->preamble = preamble;
+  transmission->packetType = packetType;
+  transmission->duration = duration;
+  std::vector<uint32_t> candidates;
+  // the delay is drawn for every receiver, even those below the
+  // threshold: the grid would change the values of a random delay model.
+  if (m_cellSize > 0 && DynamicCast<ConstantSpeedPropagationDelayModel> (m_delay) != 0)
     {
-      if (sender != (*i))
+      // the receivers near enough to receive the signal above the
+      // threshold, and those whose position is not known.
+      UpdateGrid ();
+      double range = m_loss->GetRange (txPowerDbm, m_receptionThreshold);
+      m_grid.Lookup (senderMobility->GetPosition (), range, candidates);
+      std::size_t indexed = candidates.size ();
+      candidates.insert (candidates.end (), m_unindexed.begin (), m_unindexed.end ());
+      std::inplace_merge (candidates.begin (), candidates.begin () + indexed, candidates.end ());
+      NS_LOG_DEBUG ("range=" << range << "m, receivers=" << candidates.size ());
+    }
+  else
+    {
+      candidates.reserve (m_phyList.size ());
+      for (uint32_t j = 0; j < m_phyList.size (); j++)
+        {
+          candidates.push_back (j);
+        }
+    }
+
+  std::vector<uint32_t> receivers;
+  std::vector<Ptr<MobilityModel> > receiverMobilities;
+  receivers.reserve (candidates.size ());
+  receiverMobilities.reserve (candidates.size ());
+  for (std::vector<uint32_t>::const_iterator i = candidates.begin (); i != candidates.end (); ++i)
+    {
+      Ptr<YansWifiPhy> receiver = m_phyList[*i];
+      // For now don't account for inter channel interference
+      if (receiver == sender || receiver->GetChannelNumber () != sender->GetChannelNumber ())
+        {
+          continue;
+        }
+      receivers.push_back (*i);
+      receiverMobilities.push_back (receiver->GetMobility ()->GetObject<MobilityModel> ());
+    }
+  std::vector<double> rxPowersDbm;
+  m_loss->CalcRxPowerBatch (txPowerDbm, senderMobility, receiverMobilities, rxPowersDbm);
+  for (uint32_t k = 0; k < receivers.size (); k++)
+    {
+      SendTo (receivers[k], senderMobility, receiverMobilities[k], txPowerDbm, rxPowersDbm[k], transmission);
+    }
+}
+
+void
+YansWifiChannel::SendTo (uint32_t j, Ptr<MobilityModel> senderMobility, Ptr<MobilityModel> receiverMobility,
+                         double txPowerDbm, double rxPowerDbm, Ptr<const Transmission> transmission) const
+{
+  Ptr<YansWifiPhy> receiver = m_phyList[j];
+  Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+  NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
+  if (rxPowerDbm < m_receptionThreshold)
+    {
+      return;
+    }
+  Ptr<Object> dstNetDevice = receiver->GetDevice ();
+  uint32_t dstNode;
+  if (dstNetDevice == 0)
+    {
+      dstNode = 0xffffffff;
+    }
+  else
+    {
+      dstNode = dstNetDevice->GetObject<NetDevice> ()->GetNode ()->GetId ();
+    }
+
+  Simulator::ScheduleWithContext (dstNode,
+                                  delay, &YansWifiChannel::Receive, this,
+                                  j, transmission, rxPowerDbm);
+}
+
+void
+YansWifiChannel::UpdateGrid (void) const
+{
+  if (m_grid.GetCellSize () != m_cellSize)
+    {
+      m_grid.SetCellSize (m_cellSize);
+      m_nIndexed = 0;
+      m_unindexed.clear ();
+    }
+  for (; m_nIndexed < m_phyList.size (); m_nIndexed++)
+    {
+      m_unindexed.push_back (m_nIndexed);
+    }
+  std::vector<uint32_t> unindexed;
+  for (std::vector<uint32_t>::const_iterator i = m_unindexed.begin (); i != m_unindexed.end (); ++i)
+    {
+      Ptr<Object> object = m_phyList[*i]->GetMobility ();
+      Ptr<MobilityModel> mobility;
+      if (object != 0)
+        {
+          mobility = object->GetObject<MobilityModel> ();
+        }
+      if (mobility != 0)
+        {
+          m_grid.Add (*i, mobility);
+        }
+      else
         {
-          // For now don't account for inter channel interference
-          if ((*i)->GetChannelNumber () != sender->GetChannelNumber ())
-            {
-              continue;
-            }
-
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
-          NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          Ptr<Packet> copy = packet->Copy ();
-          Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice ();
-          uint32_t dstNode;
-          if (dstNetDevice == 0)
-            {
-              dstNode = 0xffffffff;
-            }
-          else
-            {
-              dstNode = dstNetDevice->GetObject<NetDevice> ()->GetNode ()->GetId ();
-            }
-
-          double *atts = new double[3];
-          *atts = rxPowerDbm;
-          *(atts+1)= packetType;
-          *(atts+2)= duration.GetNanoSeconds();
-
-          Simulator::ScheduleWithContext (dstNode,
-                                          delay, &YansWifiChannel::Receive, this,
-                                          j, copy, atts, txVector, preamble);
+          unindexed.push_back (*i);
         }
     }
+  m_unindexed.swap (unindexed);
 }
 
 void
-YansWifiChannel::Receive (uint32_t i, Ptr<Packet> packet, double *atts,
-                          WifiTxVector txVector, WifiPreamble preamble) const
+YansWifiChannel::Receive (uint32_t i, Ptr<const Transmission> transmission, double rxPowerDbm) const
 {
-  m_phyList[i]->StartReceivePacket (packet, *atts, txVector, preamble,*(atts+1), NanoSeconds(*(atts+2)));
-  delete[] atts;
+  m_phyList[i]->StartReceivePacket (transmission->packet, rxPowerDbm, transmission->txVector,
+                                    transmission->preamble, transmission->packetType,
+                                    transmission->duration);
 }
 
 uint32_t
@@ -28,12 +28,15 @@
 #include "wifi-preamble.h"
 #include "wifi-tx-vector.h"
 #include "ns3/nstime.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/mobility-grid.h"
 
 namespace ns3 {
 
 class NetDevice;
 class PropagationLossModel;
 class PropagationDelayModel;
+class MobilityModel;
 class YansWifiPhy;
 
 /**
@@ -47,6 +50,13 @@ class YansWifiPhy;
  * class and contains a ns3::PropagationLossModel and a ns3::PropagationDelayModel.
  * By default, no propagation models are set so, it is the caller's responsability
  * to set them before using the channel.
+ *
+ * The signals received with a power below the ReceptionThreshold
+ * attribute are not delivered.  With the SpatialIndexCellSize
+ * attribute, the channel keeps the positions of the receivers in a
+ * MobilityGrid, and only computes the received power of the receivers
+ * within the range which PropagationLossModel::GetRange returns for
+ * that threshold.
  */
 class YansWifiChannel : public WifiChannel
 {
@@ -111,24 +121,57 @@ private:
    * A vector of pointers to YansWifiPhy.
    */
   typedef std::vector<Ptr<YansWifiPhy> > PhyList;
+  /**
+   * The attributes of a transmission which are the same for all the
+   * receivers. A single instance, holding a single read-only copy of
+   * the packet, is shared by the Receive events of a transmission.
+   */
+  struct Transmission : public SimpleRefCount<Transmission>
+  {
+    Ptr<const Packet> packet; //!< the packet being sent
+    WifiTxVector txVector;    //!< the TXVECTOR of the packet
+    WifiPreamble preamble;    //!< the type of preamble being used to send the packet
+    uint8_t packetType;       //!< the type of packet, used for A-MPDU
+    Time duration;            //!< the transmission duration of the packet
+  };
   /**
    * This method is scheduled by Send for each associated YansWifiPhy.
    * The method then calls the corresponding YansWifiPhy that the first
    * bit of the packet has arrived.
    *
    * \param i index of the corresponding YansWifiPhy in the PHY list
-   * \param packet the packet being sent
-   * \param atts a vector containing the received power in dBm and the packet type
-   * \param txVector the TXVECTOR of the packet
-   * \param preamble the type of preamble being used to send the packet
+   * \param transmission the transmission being received
+   * \param rxPowerDbm the received power in dBm
+   */
+  void Receive (uint32_t i, Ptr<const Transmission> transmission, double rxPowerDbm) const;
+  /**
+   * Schedule the reception of a transmission by a YansWifiPhy, if it
+   * receives it above the reception threshold.
+   *
+   * \param i index of the receiving YansWifiPhy in the PHY list
+   * \param senderMobility the mobility model of the sender
+   * \param receiverMobility the mobility model of the receiver
+   * \param txPowerDbm the tx power associated to the packet
+   * \param rxPowerDbm the power received by the receiver
+   * \param transmission the transmission
+   */
+  void SendTo (uint32_t i, Ptr<MobilityModel> senderMobility, Ptr<MobilityModel> receiverMobility,
+               double txPowerDbm, double rxPowerDbm, Ptr<const Transmission> transmission) const;
+  /**
+   * Add to the grid the PHYs added to the channel since the last call,
+   * and those which had no mobility model then.
    */
-  void Receive (uint32_t i, Ptr<Packet> packet, double *atts,
-                WifiTxVector txVector, WifiPreamble preamble) const;
+  void UpdateGrid (void) const;
 
 
   PhyList m_phyList; //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss; //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay; //!< Propagation delay model
+  double m_receptionThreshold; //!< the power below which the signals are not delivered (dBm)
+  double m_cellSize; //!< the size of the cells of the grid, or zero
+  mutable MobilityGrid m_grid; //!< the positions of the PHYs
+  mutable uint32_t m_nIndexed; //!< the number of PHYs looked at by UpdateGrid
+  mutable std::vector<uint32_t> m_unindexed; //!< the PHYs without mobility model, in increasing order
 };
 
 } // namespace ns3
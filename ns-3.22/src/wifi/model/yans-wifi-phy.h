@@ -102,6 +102,9 @@ public:
   /**
    * Starting receiving the packet (i.e. the first bit of the preamble has arrived).
    *
+   * The packet may be shared by all the receivers of a transmission:
+   * it is copied only if it is delivered to the MAC.
+   *
    * \param packet the arriving packet
    * \param rxPowerDbm the receive power in dBm
    * \param txVector the TXVECTOR of the arriving packet
@@ -109,7 +112,7 @@ public:
    * \param packetType The type of the received packet (values: 0 not an A-MPDU, 1 corresponds to any packets in an A-MPDU except the last one, 2 is the last packet in an A-MPDU) 
    * \param rxDuration the duration needed for the reception of the arriving packet
    */
-  void StartReceivePacket (Ptr<Packet> packet,
+  void StartReceivePacket (Ptr<const Packet> packet,
                            double rxPowerDbm,
                            WifiTxVector txVector,
                            WifiPreamble preamble,
@@ -464,7 +467,7 @@ private:
    * \param packet the packet that the last bit has arrived
    * \param event the corresponding event of the first time the packet arrives
    */
-  void EndReceive (Ptr<Packet> packet, Ptr<InterferenceHelper::Event> event);
+  void EndReceive (Ptr<const Packet> packet, Ptr<InterferenceHelper::Event> event);
 
 private:
   virtual void DoInitialize (void);
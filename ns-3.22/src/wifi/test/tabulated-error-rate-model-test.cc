@@ -0,0 +1,272 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/tabulated-error-rate-model.h"
+#include "ns3/nist-error-rate-model.h"
+#include "ns3/yans-error-rate-model.h"
+#include "ns3/wifi-phy.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TabulatedErrorRateModelTest");
+
+namespace {
+
+std::vector<WifiMode>
+GetModes (void)
+{
+  std::vector<WifiMode> modes;
+  modes.push_back (WifiPhy::GetDsssRate1Mbps ());
+  modes.push_back (WifiPhy::GetDsssRate2Mbps ());
+  modes.push_back (WifiPhy::GetDsssRate5_5Mbps ());
+  modes.push_back (WifiPhy::GetDsssRate11Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate6Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate9Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate12Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate18Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate24Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate36Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate48Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate54Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate65MbpsBW20MHz ());
+  return modes;
+}
+
+/**
+ * A NistErrorRateModel which counts the rates computed.
+ */
+class CountingErrorRateModel : public NistErrorRateModel
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::TabulatedErrorRateModelTest::CountingErrorRateModel")
+      .SetParent<NistErrorRateModel> ()
+      .AddConstructor<CountingErrorRateModel> ()
+    ;
+    return tid;
+  }
+  CountingErrorRateModel ()
+    : m_count (0)
+  {
+  }
+  virtual double GetChunkSuccessRate (WifiMode mode, double snr, uint32_t nbits) const
+  {
+    m_count++;
+    return NistErrorRateModel::GetChunkSuccessRate (mode, snr, nbits);
+  }
+  mutable uint32_t m_count; //!< the number of rates computed
+};
+
+} // anonymous namespace
+
+/**
+ * The chunk success rates of the tables are close to those of the model
+ * which computed them.
+ */
+class TabulatedErrorRateModelAccuracyTest : public TestCase
+{
+public:
+  TabulatedErrorRateModelAccuracyTest ();
+private:
+  virtual void DoRun (void);
+  /**
+   * \param model the model which computes the tables
+   */
+  void Check (Ptr<ErrorRateModel> model);
+};
+
+TabulatedErrorRateModelAccuracyTest::TabulatedErrorRateModelAccuracyTest ()
+  : TestCase ("Compare the tabulated chunk success rates to the Nist and Yans models")
+{
+}
+
+void
+TabulatedErrorRateModelAccuracyTest::Check (Ptr<ErrorRateModel> model)
+{
+  Ptr<TabulatedErrorRateModel> tabulated = CreateObject<TabulatedErrorRateModel> ();
+  tabulated->SetAttribute ("ErrorRateModel", PointerValue (model));
+  std::vector<WifiMode> modes = GetModes ();
+  // chunks of a few bits are less accurate where the error probability
+  // of a bit reaches one, since the models clamp it.
+  uint32_t nbits[] = { 0, 24, 100, 192, 1000, 8 * 1500, 50000, 2000000 };
+  double maxError = 0;
+  for (std::vector<WifiMode>::const_iterator mode = modes.begin (); mode != modes.end (); ++mode)
+    {
+      // off the grid of the tables, and beyond it
+      for (double snrDb = -15.013; snrDb < 45; snrDb += 0.0737)
+        {
+          if (mode->GetDataRate () > 2000000 && mode->GetModulationClass () == WIFI_MOD_CLASS_DSSS
+              && (std::fabs (snrDb - 10) < 0.1 || std::fabs (snrDb + 10) < 0.1))
+            {
+              // the CCK models without GSL jump at WLAN_SIR_PERFECT
+              // and WLAN_SIR_IMPOSSIBLE
+              continue;
+            }
+          double snr = std::pow (10.0, snrDb / 10.0);
+          for (uint32_t i = 0; i < sizeof (nbits) / sizeof (nbits[0]); i++)
+            {
+              double expected = model->GetChunkSuccessRate (*mode, snr, nbits[i]);
+              double actual = tabulated->GetChunkSuccessRate (*mode, snr, nbits[i]);
+              maxError = std::max (maxError, std::fabs (actual - expected));
+              NS_TEST_ASSERT_MSG_EQ_TOL (actual, expected, 2e-3,
+                                         *mode << " at " << snrDb << "dB with " << nbits[i] << " bits");
+            }
+        }
+    }
+  NS_LOG_INFO ("largest error " << maxError);
+}
+
+void
+TabulatedErrorRateModelAccuracyTest::DoRun (void)
+{
+  Check (CreateObject<NistErrorRateModel> ());
+  Check (CreateObject<YansErrorRateModel> ());
+}
+
+/**
+ * The tables loaded from a file give the rates of the tables saved.
+ */
+class TabulatedErrorRateModelFileTest : public TestCase
+{
+public:
+  TabulatedErrorRateModelFileTest ();
+private:
+  virtual void DoRun (void);
+};
+
+TabulatedErrorRateModelFileTest::TabulatedErrorRateModelFileTest ()
+  : TestCase ("Save and load the tables")
+{
+}
+
+void
+TabulatedErrorRateModelFileTest::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("tabulated-error-rate-model.txt");
+  Ptr<TabulatedErrorRateModel> saved = CreateObject<TabulatedErrorRateModel> ();
+  saved->SetAttribute ("ErrorRateModel", PointerValue (CreateObject<YansErrorRateModel> ()));
+  saved->SetAttribute ("SnrStep", DoubleValue (0.5));
+  std::vector<WifiMode> modes = GetModes ();
+  for (std::vector<WifiMode>::const_iterator mode = modes.begin (); mode != modes.end (); ++mode)
+    {
+      saved->Build (*mode);
+    }
+  saved->Save (filename);
+
+  // the grid of the file, not that of the attributes, is used
+  Ptr<TabulatedErrorRateModel> loaded = CreateObject<TabulatedErrorRateModel> ();
+  loaded->SetAttribute ("SnrStep", DoubleValue (2));
+  loaded->SetAttribute ("TableFile", StringValue (filename));
+  for (std::vector<WifiMode>::const_iterator mode = modes.begin (); mode != modes.end (); ++mode)
+    {
+      for (double snrDb = -12; snrDb < 42; snrDb += 0.3)
+        {
+          double snr = std::pow (10.0, snrDb / 10.0);
+          NS_TEST_EXPECT_MSG_EQ_TOL (loaded->GetChunkSuccessRate (*mode, snr, 1000),
+                                     saved->GetChunkSuccessRate (*mode, snr, 1000), 1e-12,
+                                     *mode << " at " << snrDb << "dB");
+          // the chunks beyond the tables are given to the model which
+          // computed them
+          NS_TEST_EXPECT_MSG_EQ_TOL (loaded->GetChunkSuccessRate (*mode, snr, 2000000),
+                                     saved->GetChunkSuccessRate (*mode, snr, 2000000), 1e-12,
+                                     *mode << " at " << snrDb << "dB with 2000000 bits");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (loaded->GetErrorRateModel ()->GetInstanceTypeId (), YansErrorRateModel::GetTypeId (),
+                         "the tables were computed by another model");
+}
+
+/**
+ * The tables have at least two rows, and the tables computed are
+ * shared by the instances with the same model and grid.
+ */
+class TabulatedErrorRateModelGridTest : public TestCase
+{
+public:
+  TabulatedErrorRateModelGridTest ();
+private:
+  virtual void DoRun (void);
+};
+
+TabulatedErrorRateModelGridTest::TabulatedErrorRateModelGridTest ()
+  : TestCase ("Build the tables of small and shared grids")
+{
+}
+
+void
+TabulatedErrorRateModelGridTest::DoRun (void)
+{
+  WifiMode mode = WifiPhy::GetOfdmRate6Mbps ();
+  Ptr<NistErrorRateModel> nist = CreateObject<NistErrorRateModel> ();
+
+  // a step larger than the range of the SNRs
+  Ptr<TabulatedErrorRateModel> small = CreateObject<TabulatedErrorRateModel> ();
+  small->SetAttribute ("MinSnr", DoubleValue (2));
+  small->SetAttribute ("MaxSnr", DoubleValue (2.5));
+  small->SetAttribute ("SnrStep", DoubleValue (1));
+  double low = nist->GetChunkSuccessRate (mode, std::pow (10.0, 0.2), 128);
+  double high = nist->GetChunkSuccessRate (mode, std::pow (10.0, 0.3), 128);
+  NS_TEST_EXPECT_MSG_EQ_TOL (small->GetChunkSuccessRate (mode, std::pow (10.0, 0.2), 128), low, 1e-12,
+                             "wrong rate at 2dB");
+  // the table extends to 3dB, past MaxSnr, and interpolates between its two rows
+  NS_TEST_EXPECT_MSG_EQ_TOL (small->GetChunkSuccessRate (mode, std::pow (10.0, 0.25), 128),
+                             (low + high) / 2, 1e-12, "wrong rate at 2.5dB");
+
+  Ptr<CountingErrorRateModel> counting = CreateObject<CountingErrorRateModel> ();
+  Ptr<TabulatedErrorRateModel> first = CreateObject<TabulatedErrorRateModel> ();
+  first->SetAttribute ("ErrorRateModel", PointerValue (counting));
+  first->Build (mode);
+  NS_TEST_ASSERT_MSG_GT (counting->m_count, 0, "the table was not computed");
+
+  // another model of the same type and attributes
+  Ptr<CountingErrorRateModel> other = CreateObject<CountingErrorRateModel> ();
+  Ptr<TabulatedErrorRateModel> second = CreateObject<TabulatedErrorRateModel> ();
+  second->SetAttribute ("ErrorRateModel", PointerValue (other));
+  second->Build (mode);
+  NS_TEST_EXPECT_MSG_EQ (other->m_count, 0, "the table was computed again");
+  NS_TEST_EXPECT_MSG_EQ (second->GetChunkSuccessRate (mode, 2, 1000), first->GetChunkSuccessRate (mode, 2, 1000),
+                         "the shared table differs");
+
+  // another grid
+  Ptr<TabulatedErrorRateModel> third = CreateObject<TabulatedErrorRateModel> ();
+  third->SetAttribute ("ErrorRateModel", PointerValue (other));
+  third->SetAttribute ("SnrStep", DoubleValue (0.1));
+  third->Build (mode);
+  NS_TEST_EXPECT_MSG_GT (other->m_count, 0, "the table of another grid was shared");
+}
+
+static class TabulatedErrorRateModelTestSuite : public TestSuite
+{
+public:
+  TabulatedErrorRateModelTestSuite ()
+    : TestSuite ("wifi-tabulated-error-rate-model", UNIT)
+  {
+    AddTestCase (new TabulatedErrorRateModelAccuracyTest (), TestCase::QUICK);
+    AddTestCase (new TabulatedErrorRateModelFileTest (), TestCase::QUICK);
+    AddTestCase (new TabulatedErrorRateModelGridTest (), TestCase::QUICK);
+  }
+} g_tabulatedErrorRateModelTestSuite;
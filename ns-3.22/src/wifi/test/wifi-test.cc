@@ -24,12 +24,14 @@
 #include "ns3/yans-wifi-channel.h"
 #include "ns3/adhoc-wifi-mac.h"
 #include "ns3/yans-wifi-phy.h"
+#include "ns3/interference-helper.h"
 #include "ns3/arf-wifi-manager.h"
 #include "ns3/propagation-delay-model.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/error-rate-model.h"
 #include "ns3/yans-error-rate-model.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
 #include "ns3/node.h"
 #include "ns3/simulator.h"
 #include "ns3/test.h"
@@ -41,6 +43,7 @@
 #include "ns3/edca-txop-n.h"
 #include "ns3/config.h"
 #include "ns3/boolean.h"
+#include "ns3/double.h"
 
 using namespace ns3;
 
@@ -322,6 +325,143 @@ InterferenceHelperSequenceTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+//-----------------------------------------------------------------------------
+/**
+ * Check the noise and interference power tracked by the InterferenceHelper
+ * across many signals which overlap or follow each other.
+ */
+class InterferenceHelperTimelineTest : public TestCase
+{
+public:
+  InterferenceHelperTimelineTest ();
+
+  virtual void DoRun (void);
+private:
+  /**
+   * \param interference the helper of the receiver
+   * \param rxPowerW the power of the signal
+   * \param duration the duration of the signal
+   * \param receive whether the receiver starts receiving the signal
+   */
+  void AddSignal (InterferenceHelper *interference, double rxPowerW, Time duration, bool receive);
+  /**
+   * \param interference the helper of the receiver
+   * \param energyW the threshold
+   * \param expected the expected time above the threshold
+   */
+  void CheckEnergyDuration (InterferenceHelper *interference, double energyW, Time expected);
+  /**
+   * \param interference the helper of the receiver
+   */
+  void EndReceive (InterferenceHelper *interference);
+
+  Ptr<InterferenceHelper::Event> m_event;    //!< the signal received
+  std::vector<double> m_pers;                //!< the packet error rates of the signals received
+};
+
+InterferenceHelperTimelineTest::InterferenceHelperTimelineTest ()
+  : TestCase ("InterferenceHelperTimeline")
+{
+}
+
+void
+InterferenceHelperTimelineTest::AddSignal (InterferenceHelper *interference, double rxPowerW, Time duration, bool receive)
+{
+  WifiMode mode = WifiPhy::GetOfdmRate6Mbps ();
+  Ptr<InterferenceHelper::Event> event = interference->Add (1000, mode, WIFI_PREAMBLE_LONG, duration, rxPowerW,
+                                                             WifiTxVector (mode, 0, 0, false, 1, 0, false));
+  if (receive)
+    {
+      m_event = event;
+      interference->NotifyRxStart ();
+    }
+}
+
+void
+InterferenceHelperTimelineTest::CheckEnergyDuration (InterferenceHelper *interference, double energyW, Time expected)
+{
+  NS_TEST_EXPECT_MSG_EQ (interference->GetEnergyDuration (energyW), expected,
+                         "wrong energy duration above " << energyW << "W at " << Simulator::Now ());
+}
+
+void
+InterferenceHelperTimelineTest::EndReceive (InterferenceHelper *interference)
+{
+  struct InterferenceHelper::SnrPer snrPer = interference->CalculateSnrPer (m_event);
+  interference->NotifyRxEnd ();
+  // the SNR is the one at the start of the signal, without interference
+  double noiseW = 1.3803e-23 * 290.0 * m_event->GetPayloadMode ().GetBandwidth ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (snrPer.snr, m_event->GetRxPowerW () / noiseW, 1e-6 * snrPer.snr,
+                             "the SNR includes the interference");
+  m_pers.push_back (snrPer.per);
+}
+
+void
+InterferenceHelperTimelineTest::DoRun (void)
+{
+  InterferenceHelper interference;
+  interference.SetNoiseFigure (1.0);
+  interference.SetErrorRateModel (CreateObject<YansErrorRateModel> ());
+  Time start = Seconds (1.0);
+
+  // two overlapping signals
+  Simulator::Schedule (start, &InterferenceHelperTimelineTest::AddSignal, this,
+                       &interference, 1e-9, MilliSeconds (1), false);
+  Simulator::Schedule (start, &InterferenceHelperTimelineTest::CheckEnergyDuration, this,
+                       &interference, 0.5e-9, MilliSeconds (1));
+  Simulator::Schedule (start + MicroSeconds (500), &InterferenceHelperTimelineTest::AddSignal, this,
+                       &interference, 2e-9, MilliSeconds (1), false);
+  Simulator::Schedule (start + MicroSeconds (500), &InterferenceHelperTimelineTest::CheckEnergyDuration, this,
+                       &interference, 2.5e-9, MicroSeconds (500));
+  Simulator::Schedule (start + MicroSeconds (500), &InterferenceHelperTimelineTest::CheckEnergyDuration, this,
+                       &interference, 1.5e-9, MilliSeconds (1));
+  Simulator::Schedule (start + MicroSeconds (1200), &InterferenceHelperTimelineTest::CheckEnergyDuration, this,
+                       &interference, 1.5e-9, MicroSeconds (300));
+  Simulator::Schedule (start + MicroSeconds (1600), &InterferenceHelperTimelineTest::CheckEnergyDuration, this,
+                       &interference, 0.0, MicroSeconds (0));
+
+  // many short signals, each starting when the previous one ends
+  start = Seconds (2.0);
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      Simulator::Schedule (start + MicroSeconds (10 * i), &InterferenceHelperTimelineTest::AddSignal, this,
+                           &interference, 1e-9 * (1 + i % 3), MicroSeconds (10), false);
+      Simulator::Schedule (start + MicroSeconds (10 * i), &InterferenceHelperTimelineTest::CheckEnergyDuration, this,
+                           &interference, 0.5e-9, MicroSeconds (10));
+    }
+
+  // the same signal received alone, and with interference during its
+  // payload, which starts after the 20us of the preamble and header
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      start = Seconds (3.0 + k);
+      double interferenceW = k == 0 ? 0.0 : 5e-9;
+      Simulator::Schedule (start, &InterferenceHelperTimelineTest::AddSignal, this,
+                           &interference, 1e-8, MilliSeconds (1), true);
+      if (interferenceW > 0)
+        {
+          Simulator::Schedule (start + MicroSeconds (100), &InterferenceHelperTimelineTest::AddSignal, this,
+                               &interference, interferenceW, MicroSeconds (100), false);
+          Simulator::Schedule (start + MicroSeconds (100), &InterferenceHelperTimelineTest::AddSignal, this,
+                               &interference, interferenceW, MicroSeconds (100), false);
+          // while the signal is received
+          Simulator::Schedule (start + MicroSeconds (150), &InterferenceHelperTimelineTest::CheckEnergyDuration, this,
+                               &interference, 1.5e-8, MicroSeconds (50));
+          Simulator::Schedule (start + MicroSeconds (500), &InterferenceHelperTimelineTest::CheckEnergyDuration, this,
+                               &interference, 0.5e-8, MicroSeconds (500));
+        }
+      Simulator::Schedule (start + MilliSeconds (1), &InterferenceHelperTimelineTest::EndReceive, this,
+                           &interference);
+    }
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_pers.size (), 2, "the signals were not received");
+  NS_TEST_EXPECT_MSG_LT (m_pers[0], m_pers[1], "the interference does not increase the packet error rate");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_pers[1], 0.064658278273175385, 1e-12, "the packet error rate changed");
+}
+
 //-----------------------------------------------------------------------------
 /**
  * Make sure that when multiple broadcast packets are queued on the same
@@ -476,6 +616,227 @@ Bug555TestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_secondTransmissionTime, expectedSecondTransmissionTime, "The second transmission time not correct!");
 }
 
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that the receivers of a broadcast, which share the packet
+ * sent on the channel, each get their own packet.
+ */
+class YansWifiChannelBroadcastTest : public TestCase
+{
+public:
+  YansWifiChannelBroadcastTest ();
+
+  virtual void DoRun (void);
+private:
+  Ptr<YansWifiPhy> CreatePhy (Vector pos, Ptr<YansWifiChannel> channel);
+  void Receive (Ptr<Packet> p, double snr, WifiMode mode, enum WifiPreamble preamble);
+
+  std::vector<Ptr<Packet> > m_received;
+};
+
+YansWifiChannelBroadcastTest::YansWifiChannelBroadcastTest ()
+  : TestCase ("Check that the receivers of a broadcast get independent packets")
+{
+}
+
+void
+YansWifiChannelBroadcastTest::Receive (Ptr<Packet> p, double snr, WifiMode mode, enum WifiPreamble preamble)
+{
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 1000, "Packet modified by another receiver");
+  p->RemoveAtStart (100);
+  m_received.push_back (p);
+}
+
+Ptr<YansWifiPhy>
+YansWifiChannelBroadcastTest::CreatePhy (Vector pos, Ptr<YansWifiChannel> channel)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (pos);
+  node->AggregateObject (mobility);
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->SetErrorRateModel (CreateObject<YansErrorRateModel> ());
+  phy->SetChannel (channel);
+  phy->SetMobility (node);
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  phy->SetReceiveOkCallback (MakeCallback (&YansWifiChannelBroadcastTest::Receive, this));
+  return phy;
+}
+
+void
+YansWifiChannelBroadcastTest::DoRun (void)
+{
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+
+  Ptr<YansWifiPhy> sender = CreatePhy (Vector (0.0, 0.0, 0.0), channel);
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      CreatePhy (Vector (1.0 + i, 0.0, 0.0), channel);
+    }
+
+  Ptr<Packet> p = Create<Packet> (1000);
+  WifiTxVector txVector (WifiPhy::GetOfdmRate6Mbps (), 0, 0, false, 1, 0, false);
+  Simulator::Schedule (Seconds (1.0), &YansWifiPhy::SendPacket, sender, p, txVector, WIFI_PREAMBLE_LONG, 0);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), 3, "Every receiver should get the packet");
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 1000, "Sent packet modified by a receiver");
+  for (uint32_t i = 0; i < m_received.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_received[i]->GetUid (), p->GetUid (), "Bad packet received");
+      NS_TEST_EXPECT_MSG_EQ (m_received[i]->GetSize (), 900, "Packet modified by another receiver");
+      NS_TEST_EXPECT_MSG_NE (m_received[i], p, "Receiver got the sent packet");
+      for (uint32_t j = 0; j < i; j++)
+        {
+          NS_TEST_EXPECT_MSG_NE (m_received[i], m_received[j], "Receivers got the same packet");
+        }
+    }
+  m_received.clear ();
+}
+
+/**
+ * Make sure that the spatial index of the channel delivers the packets
+ * to the same receivers as a scan of all of them.
+ */
+class YansWifiChannelGridTest : public TestCase
+{
+public:
+  YansWifiChannelGridTest ();
+
+  virtual void DoRun (void);
+private:
+  /// counts the packets received by a phy
+  struct Counter
+  {
+    uint32_t received; //!< the packets received
+    int64_t times;     //!< the sum of the reception times, in ns
+    void Receive (Ptr<Packet> p, double snr, WifiMode mode, enum WifiPreamble preamble)
+    {
+      received++;
+      times += Simulator::Now ().GetNanoSeconds ();
+    }
+  };
+  /**
+   * \param cellSize the SpatialIndexCellSize of the channel
+   * \param randomDelay use a RandomPropagationDelayModel
+   * \return the packets received by each phy, then the sums of their
+   * reception times
+   */
+  std::vector<int64_t> Run (double cellSize, bool randomDelay);
+  Ptr<YansWifiPhy> CreatePhy (Ptr<MobilityModel> mobility, Ptr<YansWifiChannel> channel, Counter *counter);
+};
+
+YansWifiChannelGridTest::YansWifiChannelGridTest ()
+  : TestCase ("Check that the spatial index of YansWifiChannel does not change the receptions")
+{
+}
+
+Ptr<YansWifiPhy>
+YansWifiChannelGridTest::CreatePhy (Ptr<MobilityModel> mobility, Ptr<YansWifiChannel> channel, Counter *counter)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  node->AggregateObject (mobility);
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->SetErrorRateModel (CreateObject<YansErrorRateModel> ());
+  phy->SetChannel (channel);
+  phy->SetMobility (node);
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  counter->received = 0;
+  counter->times = 0;
+  phy->SetReceiveOkCallback (MakeCallback (&Counter::Receive, counter));
+  // the same streams in all the runs
+  phy->AssignStreams (channel->GetNDevices ());
+  return phy;
+}
+
+std::vector<int64_t>
+YansWifiChannelGridTest::Run (double cellSize, bool randomDelay)
+{
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  if (randomDelay)
+    {
+      Ptr<RandomPropagationDelayModel> delay = CreateObject<RandomPropagationDelayModel> ();
+      delay->AssignStreams (1000);
+      channel->SetPropagationDelayModel (delay);
+    }
+  else
+    {
+      channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+    }
+  channel->SetPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+  channel->SetAttribute ("ReceptionThreshold", DoubleValue (-96));
+  channel->SetAttribute ("SpatialIndexCellSize", DoubleValue (cellSize));
+
+  const uint32_t side = 10;
+  Counter counters[side * side + 1];
+  std::vector<Ptr<YansWifiPhy> > phys;
+  for (uint32_t i = 0; i < side * side; i++)
+    {
+      Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (40.0 * (i % side), 40.0 * (i / side), 0.0));
+      phys.push_back (CreatePhy (mobility, channel, &counters[i]));
+    }
+  // a phy which comes near the first one at 100 m/s
+  Ptr<ConstantVelocityMobilityModel> moving = CreateObject<ConstantVelocityMobilityModel> ();
+  moving->SetPosition (Vector (-1000.0, 0.0, 0.0));
+  moving->SetVelocity (Vector (100.0, 0.0, 0.0));
+  phys.push_back (CreatePhy (moving, channel, &counters[side * side]));
+
+  WifiTxVector txVector (WifiPhy::GetOfdmRate6Mbps (), 0, 0, false, 1, 0, false);
+  uint32_t senders[] = { 0, 45, 99, 0, 0 };
+  for (uint32_t i = 0; i < sizeof (senders) / sizeof (senders[0]); i++)
+    {
+      Simulator::Schedule (Seconds (1.0 + 2 * i), &YansWifiPhy::SendPacket, phys[senders[i]],
+                           Create<Packet> (1000), txVector, WIFI_PREAMBLE_LONG, 0);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::vector<int64_t> received;
+  for (uint32_t i = 0; i < side * side + 1; i++)
+    {
+      received.push_back (counters[i].received);
+    }
+  for (uint32_t i = 0; i < side * side + 1; i++)
+    {
+      received.push_back (counters[i].times);
+    }
+  return received;
+}
+
+void
+YansWifiChannelGridTest::DoRun (void)
+{
+  // the grid must not change the delays drawn by a random model either
+  for (uint32_t randomDelay = 0; randomDelay < 2; randomDelay++)
+    {
+      std::vector<int64_t> expected = Run (0, randomDelay);
+      uint32_t phys = expected.size () / 2;
+      int64_t total = 0;
+      for (uint32_t i = 0; i < phys; i++)
+        {
+          total += expected[i];
+        }
+      NS_TEST_ASSERT_MSG_GT (total, 10, "too few receptions");
+      NS_TEST_ASSERT_MSG_LT (total, 4 * (phys - 1), "too many receptions");
+      NS_TEST_ASSERT_MSG_GT (expected[phys - 1], 0, "the moving phy received nothing");
+
+      double cellSizes[] = { 10, 75, 1000 };
+      for (uint32_t i = 0; i < sizeof (cellSizes) / sizeof (cellSizes[0]); i++)
+        {
+          std::vector<int64_t> received = Run (cellSizes[i], randomDelay);
+          for (uint32_t j = 0; j < phys; j++)
+            {
+              NS_TEST_EXPECT_MSG_EQ (received[j], expected[j], "wrong receptions of phy " << j << " with cells of " << cellSizes[i] << "m");
+              NS_TEST_EXPECT_MSG_EQ (received[phys + j], expected[phys + j], "wrong reception times of phy " << j << " with cells of " << cellSizes[i] << "m");
+            }
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 class WifiTestSuite : public TestSuite
 {
@@ -489,7 +850,10 @@ WifiTestSuite::WifiTestSuite ()
   AddTestCase (new WifiTest, TestCase::QUICK);
   AddTestCase (new QosUtilsIsOldPacketTest, TestCase::QUICK);
   AddTestCase (new InterferenceHelperSequenceTest, TestCase::QUICK); // Bug 991
+  AddTestCase (new InterferenceHelperTimelineTest, TestCase::QUICK);
   AddTestCase (new Bug555TestCase, TestCase::QUICK); // Bug 555
+  AddTestCase (new YansWifiChannelBroadcastTest, TestCase::QUICK);
+  AddTestCase (new YansWifiChannelGridTest, TestCase::QUICK);
 }
 
 static WifiTestSuite g_wifiTestSuite;
@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+
+using namespace ns3;
+
+// Measure the forwarding rate of a router with many point-to-point
+// interfaces: each host sends UDP packets through the router to the
+// host of the next interface.
+
+static uint32_t g_received = 0;
+
+static void
+Receive (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+      g_received++;
+    }
+}
+
+static void
+Send (Ptr<Socket> socket, uint32_t size, uint32_t left, Time interval)
+{
+  socket->Send (Create<Packet> (size));
+  if (left > 1)
+    {
+      Simulator::Schedule (interval, &Send, socket, size, left - 1, interval);
+    }
+}
+
+static uint32_t g_traced = 0;
+
+static void
+RxTrace (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  g_traced++;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nInterfaces = 64;
+  uint32_t nPackets = 1000;
+  uint32_t size = 512;
+  bool trace = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the IPv4 forwarding of a router with many\n"
+             "point-to-point interfaces.");
+  cmd.AddValue ("interfaces", "number of interfaces of the router", nInterfaces);
+  cmd.AddValue ("packets", "number of packets sent by each host", nPackets);
+  cmd.AddValue ("size", "size of the UDP payload", size);
+  cmd.AddValue ("trace", "connect a sink to the Rx trace of the router", trace);
+  cmd.Parse (argc, argv);
+
+  NodeContainer router;
+  router.Create (1);
+  NodeContainer hosts;
+  hosts.Create (nInterfaces);
+  InternetStackHelper internet;
+  internet.Install (router);
+  internet.Install (hosts);
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("100Gbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("1us"));
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.255.255.252");
+  std::vector<Ipv4Address> hostAddresses;
+  for (uint32_t i = 0; i < nInterfaces; i++)
+    {
+      NetDeviceContainer devices = p2p.Install (router.Get (0), hosts.Get (i));
+      Ipv4InterfaceContainer interfaces = address.Assign (devices);
+      hostAddresses.push_back (interfaces.GetAddress (1));
+      address.NewNetwork ();
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  if (trace)
+    {
+      router.Get (0)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("Rx", MakeCallback (&RxTrace));
+    }
+
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Time interval = MicroSeconds (10);
+  for (uint32_t i = 0; i < nInterfaces; i++)
+    {
+      Ptr<Socket> sink = Socket::CreateSocket (hosts.Get (i), tid);
+      sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+      sink->SetRecvCallback (MakeCallback (&Receive));
+
+      Ptr<Socket> source = Socket::CreateSocket (hosts.Get (i), tid);
+      source->Connect (InetSocketAddress (hostAddresses[(i + 1) % nInterfaces], 9));
+      // spread the hosts over the interval, so that the queues stay short
+      Simulator::Schedule (Seconds (1) + interval * i / nInterfaces, &Send, source, size, nPackets, interval);
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t ms = clock.End ();
+
+  std::cout << nInterfaces << " interfaces, " << nInterfaces * nPackets << " packets sent, "
+            << g_received << " received" << std::endl;
+  std::cout << ms << " ms, " << g_received * 1000.0 / std::max<int64_t> (ms, 1)
+            << " packets forwarded/s" << std::endl;
+  if (trace)
+    {
+      std::cout << g_traced << " packets seen by the Rx trace of the router" << std::endl;
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
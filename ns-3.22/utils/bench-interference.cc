@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/interference-helper.h"
+
+using namespace ns3;
+
+// Measure the InterferenceHelper of a receiver which receives long
+// signals back to back, while short signals arrive during each of them
+// and are dropped, as YansWifiPhy does: each of them is added and the
+// energy duration is asked for.
+
+static uint32_t g_received = 0;
+
+static void
+AddSignal (InterferenceHelper *interference, Time duration, double rxPowerW)
+{
+  WifiMode mode = WifiPhy::GetOfdmRate6Mbps ();
+  interference->Add (1000, mode, WIFI_PREAMBLE_LONG, duration, rxPowerW,
+                     WifiTxVector (mode, 0, 0, false, 1, 0, false));
+  // the CCA threshold of YansWifiPhy, -62dBm
+  interference->GetEnergyDuration (6.3e-10);
+}
+
+static void
+EndReceive (InterferenceHelper *interference, Ptr<InterferenceHelper::Event> event)
+{
+  interference->CalculateSnrPer (event);
+  interference->NotifyRxEnd ();
+  g_received++;
+}
+
+static void
+StartReceive (InterferenceHelper *interference, Time duration)
+{
+  WifiMode mode = WifiPhy::GetOfdmRate6Mbps ();
+  Ptr<InterferenceHelper::Event> event = interference->Add (1000, mode, WIFI_PREAMBLE_LONG, duration, 1e-8,
+                                                             WifiTxVector (mode, 0, 0, false, 1, 0, false));
+  interference->NotifyRxStart ();
+  Simulator::Schedule (duration, &EndReceive, interference, event);
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nReceptions = 100;
+  uint32_t nSignals = 1000;
+  Time duration = MilliSeconds (10);
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the InterferenceHelper of a receiver with many\n"
+             "signals dropped during its receptions.");
+  cmd.AddValue ("receptions", "number of signals received", nReceptions);
+  cmd.AddValue ("signals", "number of signals dropped during each reception", nSignals);
+  cmd.AddValue ("duration", "duration of the signals received", duration);
+  cmd.Parse (argc, argv);
+
+  InterferenceHelper interference;
+  interference.SetNoiseFigure (5.0);
+  interference.SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 0; i < nReceptions; i++)
+    {
+      // a receiver cannot start a reception before the end of the last one
+      Time start = Seconds (1) + (duration + MicroSeconds (10)) * i;
+      Simulator::Schedule (start, &StartReceive, &interference, duration);
+      for (uint32_t j = 0; j < nSignals; j++)
+        {
+          Time offset = NanoSeconds (random->GetInteger (1, duration.GetNanoSeconds () - 1));
+          Simulator::Schedule (start + offset, &AddSignal, &interference,
+                               MicroSeconds (random->GetInteger (20, 200)), 1e-12 * random->GetValue (1, 100));
+        }
+    }
+  std::cout << nReceptions << " receptions of " << duration.GetMicroSeconds () << "us, "
+            << nSignals << " signals dropped during each" << std::endl;
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t ms = clock.End ();
+  std::cout << "  " << g_received << " receptions in " << ms << " ms, "
+            << nReceptions * nSignals * 1000.0 / std::max<int64_t> (ms, 1) << " signals/s" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+
+using namespace ns3;
+
+// Compare Object::GetObject, which caches its lookups in the aggregate
+// array, with a scan of the aggregates and of the parents of their
+// TypeIds, as it did before, on the aggregates of a node with an
+// internet stack and a mobility model.
+
+static Ptr<Object>
+ScanAggregates (Ptr<Object> object, TypeId tid)
+{
+  Object::AggregateIterator i = object->GetAggregateIterator ();
+  while (i.HasNext ())
+    {
+      Ptr<const Object> current = i.Next ();
+      TypeId cur = current->GetInstanceTypeId ();
+      while (cur != tid && cur != Object::GetTypeId ())
+        {
+          cur = cur.GetParent ();
+        }
+      if (cur == tid)
+        {
+          return ConstCast<Object> (current);
+        }
+    }
+  return 0;
+}
+
+static void
+Report (std::string name, uint32_t lookups, int64_t ms)
+{
+  std::cout << "  " << name << ": " << ms << " ms, "
+            << lookups * 1000.0 / std::max<int64_t> (ms, 1) << " lookups/s" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nLookups = 1000000;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark Object::GetObject on the aggregates of a node\n"
+             "against a scan of the aggregates.");
+  cmd.AddValue ("lookups", "number of lookups of each type", nLookups);
+  cmd.Parse (argc, argv);
+
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  node->AggregateObject (CreateObject<ConstantPositionMobilityModel> ());
+
+  // the types looked up per packet by the stacks and the channels, and
+  // one which is not aggregated
+  std::vector<TypeId> tids;
+  tids.push_back (Ipv4::GetTypeId ());
+  tids.push_back (Ipv4L3Protocol::GetTypeId ());
+  tids.push_back (MobilityModel::GetTypeId ());
+  tids.push_back (UdpL4Protocol::GetTypeId ());
+  tids.push_back (TcpL4Protocol::GetTypeId ());
+  tids.push_back (Ipv6::GetTypeId ());
+  tids.push_back (ArpL3Protocol::GetTypeId ());
+  tids.push_back (PacketSocketFactory::GetTypeId ());
+
+  uint32_t aggregates = 0;
+  for (Object::AggregateIterator i = node->GetAggregateIterator (); i.HasNext (); i.Next ())
+    {
+      aggregates++;
+    }
+  std::cout << aggregates << " aggregates, " << tids.size () << " types, "
+            << nLookups << " lookups of each type" << std::endl;
+
+  SystemWallClockMs clock;
+  for (uint32_t t = 0; t < tids.size (); t++)
+    {
+      std::cout << tids[t].GetName () << std::endl;
+      uint32_t found = 0;
+      clock.Start ();
+      for (uint32_t i = 0; i < nLookups; i++)
+        {
+          if (node->GetObject<Object> (tids[t]) != 0)
+            {
+              found++;
+            }
+        }
+      Report ("GetObject", nLookups, clock.End ());
+      uint32_t scanFound = 0;
+      clock.Start ();
+      for (uint32_t i = 0; i < nLookups; i++)
+        {
+          if (ScanAggregates (node, tids[t]) != 0)
+            {
+              scanFound++;
+            }
+        }
+      Report ("scan", nLookups, clock.End ());
+      if (found != scanFound)
+        {
+          std::cout << "  GetObject found " << found << " objects, the scan " << scanFound << std::endl;
+        }
+    }
+
+  // the typed lookups, which try a dynamic_cast of the first aggregate first
+  std::cout << "GetObject<Ipv4>, GetObject<MobilityModel>, GetObject<Node>" << std::endl;
+  clock.Start ();
+  for (uint32_t i = 0; i < nLookups; i++)
+    {
+      node->GetObject<Ipv4> ();
+      node->GetObject<MobilityModel> ();
+      node->GetObject<Node> ();
+    }
+  Report ("GetObject<T>", 3 * nLookups, clock.End ());
+
+  Simulator::Destroy ();
+  return 0;
+}
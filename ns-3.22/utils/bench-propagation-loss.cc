@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+
+using namespace ns3;
+
+// Compare PropagationLossModel::CalcRxPowerBatch with a call of
+// CalcRxPower per receiver, for the models with their own batch
+// computation, on receivers spread around a transmitter.
+
+static void
+Report (std::string name, uint32_t powers, int64_t ms)
+{
+  std::cout << "  " << name << ": " << ms << " ms, "
+            << powers * 1000.0 / std::max<int64_t> (ms, 1) << " powers/s" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nReceivers = 1000;
+  uint32_t nBatches = 2000;
+  double side = 1000;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark PropagationLossModel::CalcRxPowerBatch against\n"
+             "a call of CalcRxPower per receiver.");
+  cmd.AddValue ("receivers", "number of receivers of each batch", nReceivers);
+  cmd.AddValue ("batches", "number of batches", nBatches);
+  cmd.AddValue ("side", "side of the square of the receivers, in m", side);
+  cmd.Parse (argc, argv);
+
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0, 0, 1.5));
+  std::vector<Ptr<MobilityModel> > b;
+  for (uint32_t i = 0; i < nReceivers; i++)
+    {
+      Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (random->GetValue (-side / 2, side / 2),
+                                     random->GetValue (-side / 2, side / 2),
+                                     random->GetValue (1, 2)));
+      b.push_back (mobility);
+    }
+
+  std::vector<Ptr<PropagationLossModel> > models;
+  models.push_back (CreateObject<FriisPropagationLossModel> ());
+  models.push_back (CreateObject<TwoRayGroundPropagationLossModel> ());
+  models.push_back (CreateObject<LogDistancePropagationLossModel> ());
+  models.push_back (CreateObject<ThreeLogDistancePropagationLossModel> ());
+  models.push_back (CreateObject<NakagamiPropagationLossModel> ());
+
+  std::cout << nReceivers << " receivers, " << nBatches << " batches" << std::endl;
+
+  SystemWallClockMs clock;
+  std::vector<double> rxPowerDbm;
+  for (uint32_t m = 0; m < models.size (); m++)
+    {
+      std::cout << models[m]->GetInstanceTypeId ().GetName () << std::endl;
+      double sum = 0;
+      clock.Start ();
+      for (uint32_t k = 0; k < nBatches; k++)
+        {
+          for (uint32_t i = 0; i < nReceivers; i++)
+            {
+              sum += models[m]->CalcRxPower (16, a, b[i]);
+            }
+        }
+      Report ("CalcRxPower", nBatches * nReceivers, clock.End ());
+      clock.Start ();
+      for (uint32_t k = 0; k < nBatches; k++)
+        {
+          models[m]->CalcRxPowerBatch (16, a, b, rxPowerDbm);
+          sum -= rxPowerDbm[k % nReceivers];
+        }
+      Report ("CalcRxPowerBatch", nBatches * nReceivers, clock.End ());
+      // keep the loops from being optimized away
+      if (sum == 0)
+        {
+          std::cout << "  no power" << std::endl;
+        }
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,195 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+
+using namespace ns3;
+
+// Compare the unicast lookups of the routing protocols, which use a
+// prefix trie, with a scan of their list of routes, as they did before.
+
+static Ptr<Ipv4Route>
+MakeRoute (Ptr<Ipv4> ipv4, Ipv4RoutingTableEntry *route)
+{
+  Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
+  rtentry->SetDestination (route->GetDest ());
+  rtentry->SetSource (ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
+  rtentry->SetGateway (route->GetGateway ());
+  rtentry->SetOutputDevice (ipv4->GetNetDevice (route->GetInterface ()));
+  return rtentry;
+}
+
+// the first matching route, like Ipv4GlobalRouting
+static Ptr<Ipv4Route>
+ScanFirst (Ptr<Ipv4> ipv4, std::vector<Ipv4RoutingTableEntry *> const &routes, Ipv4Address dest)
+{
+  for (uint32_t i = 0; i < routes.size (); i++)
+    {
+      if (routes[i]->GetDestNetworkMask ().IsMatch (dest, routes[i]->GetDestNetwork ()))
+        {
+          return MakeRoute (ipv4, routes[i]);
+        }
+    }
+  return 0;
+}
+
+// the longest matching prefix, like Ipv4StaticRouting
+static Ptr<Ipv4Route>
+ScanLongest (Ptr<Ipv4> ipv4, std::vector<Ipv4RoutingTableEntry *> const &routes, Ipv4Address dest)
+{
+  Ipv4RoutingTableEntry *best = 0;
+  uint16_t longest = 0;
+  for (uint32_t i = 0; i < routes.size (); i++)
+    {
+      Ipv4Mask mask = routes[i]->GetDestNetworkMask ();
+      if (mask.IsMatch (dest, routes[i]->GetDestNetwork ())
+          && (best == 0 || mask.GetPrefixLength () >= longest))
+        {
+          best = routes[i];
+          longest = mask.GetPrefixLength ();
+        }
+    }
+  return best == 0 ? 0 : MakeRoute (ipv4, best);
+}
+
+typedef Ptr<Ipv4Route> (*ScanFunction)(Ptr<Ipv4>, std::vector<Ipv4RoutingTableEntry *> const &, Ipv4Address);
+
+static void
+RunBench (std::string name, Ptr<Ipv4> ipv4, Ptr<Ipv4RoutingProtocol> protocol,
+          std::vector<Ipv4RoutingTableEntry *> const &routes, ScanFunction scan,
+          std::vector<Ipv4Address> const &dests)
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  Ipv4Header header;
+  Socket::SocketErrno sockerr;
+  uint32_t found = 0;
+  SystemWallClockMs clock;
+
+  clock.Start ();
+  for (uint32_t i = 0; i < dests.size (); i++)
+    {
+      header.SetDestination (dests[i]);
+      if (protocol->RouteOutput (packet, header, 0, sockerr) != 0)
+        {
+          found++;
+        }
+    }
+  int64_t trieMs = clock.End ();
+
+  uint32_t scanFound = 0;
+  clock.Start ();
+  for (uint32_t i = 0; i < dests.size (); i++)
+    {
+      if (scan (ipv4, routes, dests[i]) != 0)
+        {
+          scanFound++;
+        }
+    }
+  int64_t scanMs = clock.End ();
+
+  std::cout << name << ": " << routes.size () << " routes, "
+            << dests.size () << " lookups, " << found << " found" << std::endl;
+  std::cout << "  trie: " << trieMs << " ms, "
+            << dests.size () * 1000.0 / std::max<int64_t> (trieMs, 1) << " lookups/s" << std::endl;
+  std::cout << "  list: " << scanMs << " ms, "
+            << dests.size () * 1000.0 / std::max<int64_t> (scanMs, 1) << " lookups/s" << std::endl;
+  if (found != scanFound)
+    {
+      std::cout << "  the list found " << scanFound << " routes" << std::endl;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nRoutes = 2000;
+  uint32_t nLookups = 100000;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the unicast route lookups of Ipv4GlobalRouting\n"
+             "and Ipv4StaticRouting against a scan of their routes.");
+  cmd.AddValue ("routes", "number of network routes", nRoutes);
+  cmd.AddValue ("lookups", "number of lookups", nLookups);
+  cmd.Parse (argc, argv);
+
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (Ipv4ListRoutingHelper ());
+  internet.Install (node);
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  node->AddDevice (device);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (device);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address ("192.168.0.1"), Ipv4Mask ("255.255.255.0")));
+  ipv4->SetUp (interface);
+
+  Ptr<Ipv4GlobalRouting> global = CreateObject<Ipv4GlobalRouting> ();
+  global->SetIpv4 (ipv4);
+  Ptr<Ipv4StaticRouting> staticRouting = CreateObject<Ipv4StaticRouting> ();
+  staticRouting->SetIpv4 (ipv4);
+
+  // prefixes of 16 to 30 bits in 10.0.0.0/8, and destinations inside them
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  Ipv4Address gateway ("192.168.0.2");
+  std::vector<Ipv4Address> networks;
+  for (uint32_t i = 0; i < nRoutes; i++)
+    {
+      uint32_t length = random->GetInteger (16, 30);
+      Ipv4Mask mask (~((1U << (32 - length)) - 1));
+      Ipv4Address network = Ipv4Address (0x0a000000 | random->GetInteger (0, 0xffffff)).CombineMask (mask);
+      global->AddNetworkRouteTo (network, mask, gateway, interface);
+      staticRouting->AddNetworkRouteTo (network, mask, gateway, interface);
+      networks.push_back (network);
+    }
+  std::vector<Ipv4Address> dests;
+  for (uint32_t i = 0; i < nLookups; i++)
+    {
+      uint32_t network = networks[random->GetInteger (0, networks.size () - 1)].Get ();
+      dests.push_back (Ipv4Address (network | random->GetInteger (0, 3)));
+    }
+
+  std::vector<Ipv4RoutingTableEntry *> globalRoutes;
+  for (uint32_t i = 0; i < global->GetNRoutes (); i++)
+    {
+      globalRoutes.push_back (global->GetRoute (i));
+    }
+  std::vector<Ipv4RoutingTableEntry *> staticRoutes;
+  std::vector<Ipv4RoutingTableEntry> staticEntries;
+  for (uint32_t i = 0; i < staticRouting->GetNRoutes (); i++)
+    {
+      staticEntries.push_back (staticRouting->GetRoute (i));
+    }
+  for (uint32_t i = 0; i < staticEntries.size (); i++)
+    {
+      staticRoutes.push_back (&staticEntries[i]);
+    }
+
+  RunBench ("Ipv4GlobalRouting", ipv4, global, globalRoutes, &ScanFirst, dests);
+  RunBench ("Ipv4StaticRouting", ipv4, staticRouting, staticRoutes, &ScanLongest, dests);
+
+  global->Dispose ();
+  staticRouting->Dispose ();
+  Simulator::Destroy ();
+  return 0;
+}
@@ -52,6 +52,11 @@ public:
   {
     m_rand = stream;
   }
+
+  void SetScheduler (ObjectFactory factory)
+  {
+    m_factory = factory;
+  }
     
   void SetPopulation (const uint32_t population)
   {
@@ -68,6 +73,7 @@ private:
   void Cb (void);
   
   Ptr<RandomVariableStream> m_rand;
+  ObjectFactory m_factory;
   uint32_t m_population;
   uint32_t m_total;
   uint32_t m_count;
@@ -80,6 +86,10 @@ Bench::RunBench (void)
   double init, simu;
 
   DEB ("initializing");
+  // Simulator::Destroy at the end of the previous run discarded the
+  // scheduler, and the event count must start over.
+  Simulator::SetScheduler (m_factory);
+  m_count = 0;
 
   time.Start ();
   for (uint32_t i = 0; i < m_population; ++i)
@@ -125,17 +135,48 @@ Bench::Cb (void)
 
 
 Ptr<RandomVariableStream>
-GetRandomStream (std::string filename)
+GetRandomStream (std::string filename, std::string dist)
 {
   Ptr<RandomVariableStream> stream = 0;
   
-  if (filename == "")
+  if (filename == "" && dist == "exp")
     {
       LOGME ("using default exponential distribution");
       Ptr<ExponentialRandomVariable> erv = CreateObject<ExponentialRandomVariable> ();
       erv->SetAttribute ("Mean", DoubleValue (100));
       stream = erv;
     }
+  else if (filename == "" && dist == "uniform")
+    {
+      LOGME ("using uniform distribution");
+      Ptr<UniformRandomVariable> urv = CreateObject<UniformRandomVariable> ();
+      urv->SetAttribute ("Min", DoubleValue (0));
+      urv->SetAttribute ("Max", DoubleValue (200));
+      stream = urv;
+    }
+  else if (filename == "" && dist == "bimodal")
+    {
+      // 90% of short delays (packet events), 10% of long timers
+      LOGME ("using bimodal distribution");
+      Ptr<EmpiricalRandomVariable> erv = CreateObject<EmpiricalRandomVariable> ();
+      erv->CDF (0, 0.0);
+      erv->CDF (200, 0.9);
+      erv->CDF (1000000, 0.9);
+      erv->CDF (10000000, 1.0);
+      stream = erv;
+    }
+  else if (filename == "" && dist == "pareto")
+    {
+      LOGME ("using heavy-tailed pareto distribution");
+      Ptr<ParetoRandomVariable> prv = CreateObject<ParetoRandomVariable> ();
+      prv->SetAttribute ("Mean", DoubleValue (100));
+      prv->SetAttribute ("Shape", DoubleValue (1.2));
+      stream = prv;
+    }
+  else if (filename == "")
+    {
+      NS_FATAL_ERROR ("unknown distribution " << dist);
+    }
   else
     {
       std::istream *input; 
@@ -182,8 +223,11 @@ GetRandomStream (std::string filename)
 int main (int argc, char *argv[])
 {
 
+  bool schedAll  = false;
   bool schedCal  = false;
+  bool schedDary = false;
   bool schedHeap = false;
+  bool schedLadder = false;
   bool schedList = false;
   bool schedMap  = true;
 
@@ -191,20 +235,26 @@ int main (int argc, char *argv[])
   uint32_t total = 1000000;
   uint32_t runs  =       1;
   std::string filename = "";
+  std::string dist = "exp";
   
   CommandLine cmd;
   cmd.Usage ("Benchmark the simulator scheduler.\n"
              "\n"
              "Event intervals are taken from one of:\n"
              "  an exponential distribution, with mean 100 ns,\n"
+             "  the distribution given by the --dist argument,\n"
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
              "In the case of either --file form, the input is expected\n"
              "to be ascii, giving the relative event times in ns.");
+  cmd.AddValue ("all",   "compare all the schedulers",    schedAll);
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
+  cmd.AddValue ("dary",  "use DaryHeapScheduler",         schedDary);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
+  cmd.AddValue ("dist",  "event interval distribution: exp, uniform, bimodal or pareto", dist);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
@@ -215,58 +265,82 @@ int main (int argc, char *argv[])
   g_me = cmd.GetName () + ": ";
   g_fwidth += 6;  // 5 extra chars in '2.000002e+07 ': . e+0 _
 
-  ObjectFactory factory ("ns3::MapScheduler");
-  if (schedCal)  { factory.SetTypeId ("ns3::CalendarScheduler"); }
-  if (schedHeap) { factory.SetTypeId ("ns3::HeapScheduler");     }
-  if (schedList) { factory.SetTypeId ("ns3::ListScheduler");     }  
-  Simulator::SetScheduler (factory);
+  std::vector<std::string> schedulers;
+  if (schedAll)
+    {
+      schedulers.push_back ("ns3::MapScheduler");
+      schedulers.push_back ("ns3::ListScheduler");
+      schedulers.push_back ("ns3::HeapScheduler");
+      schedulers.push_back ("ns3::DaryHeapScheduler");
+      schedulers.push_back ("ns3::CalendarScheduler");
+      schedulers.push_back ("ns3::LadderScheduler");
+    }
+  else
+    {
+      std::string scheduler = "ns3::MapScheduler";
+      if (schedCal)    { scheduler = "ns3::CalendarScheduler"; }
+      if (schedDary)   { scheduler = "ns3::DaryHeapScheduler"; }
+      if (schedHeap)   { scheduler = "ns3::HeapScheduler";     }
+      if (schedLadder) { scheduler = "ns3::LadderScheduler";   }
+      if (schedList)   { scheduler = "ns3::ListScheduler";     }
+      schedulers.push_back (scheduler);
+    }
 
   LOGME (std::setprecision (g_fwidth - 6));
   DEB ("debugging is ON");
 
-  LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
   LOGME ("population: " << pop);
   LOGME ("total events: " << total);
   LOGME ("runs: " << runs);
   
   Bench *bench = new Bench (pop, total);
-  bench->SetRandomStream (GetRandomStream (filename));
+  bench->SetRandomStream (GetRandomStream (filename, dist));
 
-  // table header
-  LOG ("");
-  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
-       std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
-       std::left << std::setw (3 * g_fwidth) << "Simulation:");
-  LOG (std::left << std::setw (g_fwidth) << "" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
-  LOG (std::setfill ('-') <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<
-       std::setfill (' ')
-       );
-       
-  // prime
-  DEB ("priming");
-  std::cout << std::left << std::setw (g_fwidth) << "(prime)";
-  bench->RunBench ();
-
-  bench->SetPopulation (pop);
-  bench->SetTotal (total);
-  for (uint32_t i = 0; i < runs; i++)
+  for (std::vector<std::string>::const_iterator s = schedulers.begin ();
+       s != schedulers.end (); ++s)
     {
-      std::cout << std::setw (g_fwidth) << i;
-      
+      ObjectFactory factory (*s);
+      bench->SetScheduler (factory);
+
+      LOG ("");
+      LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
+
+      // table header
+      LOG ("");
+      LOG (std::left << std::setw (g_fwidth) << "Run #" <<
+           std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
+           std::left << std::setw (3 * g_fwidth) << "Simulation:");
+      LOG (std::left << std::setw (g_fwidth) << "" <<
+           std::left << std::setw (g_fwidth) << "Time (s)" <<
+           std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+           std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
+           std::left << std::setw (g_fwidth) << "Time (s)" <<
+           std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+           std::left << std::setw (g_fwidth) << "Per (s/ev)" );
+      LOG (std::setfill ('-') <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::setfill (' ')
+           );
+
+      // prime
+      DEB ("priming");
+      std::cout << std::left << std::setw (g_fwidth) << "(prime)";
       bench->RunBench ();
+
+      bench->SetPopulation (pop);
+      bench->SetTotal (total);
+      for (uint32_t i = 0; i < runs; i++)
+        {
+          std::cout << std::setw (g_fwidth) << i;
+
+          bench->RunBench ();
+        }
     }
 
   LOG ("");
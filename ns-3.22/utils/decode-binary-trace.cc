@@ -0,0 +1,274 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+
+using namespace ns3;
+
+// Decode a file written by BinaryTraceHelper into
+//  - ascii: the lines of the ascii traces of the devices, on the
+//    standard output or in one <output>-<node>-<device>.tr file per
+//    device as AsciiTraceHelperForDevice::EnableAsciiAll (prefix) does;
+//  - csv: one line per event with the fields of the IPv4, UDP and TCP
+//    headers, on the standard output or in <output>.csv;
+//  - columns: one file <output>.<column> per column, holding the
+//    values of the column in binary, and a <output>.schema file which
+//    describes the columns.
+//
+// The program links all the modules so that all the headers can be
+// printed.
+
+namespace {
+
+/**
+ * The fields of the IPv4, UDP and TCP headers of a record.
+ */
+struct Fields
+{
+  uint32_t source;
+  uint32_t destination;
+  uint8_t protocol;
+  uint8_t ttl;
+  uint16_t sourcePort;
+  uint16_t destinationPort;
+  uint32_t sequence;
+  uint32_t ack;
+  uint8_t flags;
+};
+
+Fields
+GetFields (Ptr<BinaryTraceFile> file, BinaryTraceFile::Record const &record)
+{
+  Fields fields;
+  std::memset (&fields, 0, sizeof (fields));
+  Ipv4Header ipv4;
+  if (file->PeekChunk (record, ipv4))
+    {
+      fields.source = ipv4.GetSource ().Get ();
+      fields.destination = ipv4.GetDestination ().Get ();
+      fields.protocol = ipv4.GetProtocol ();
+      fields.ttl = ipv4.GetTtl ();
+    }
+  UdpHeader udp;
+  TcpHeader tcp;
+  if (file->PeekChunk (record, udp))
+    {
+      fields.sourcePort = udp.GetSourcePort ();
+      fields.destinationPort = udp.GetDestinationPort ();
+    }
+  else if (file->PeekChunk (record, tcp))
+    {
+      fields.sourcePort = tcp.GetSourcePort ();
+      fields.destinationPort = tcp.GetDestinationPort ();
+      fields.sequence = tcp.GetSequenceNumber ().GetValue ();
+      fields.ack = tcp.GetAckNumber ().GetValue ();
+      fields.flags = tcp.GetFlags ();
+    }
+  return fields;
+}
+
+std::string
+GetHeaders (Ptr<BinaryTraceFile> file, BinaryTraceFile::Record const &record)
+{
+  std::ostringstream oss;
+  for (uint32_t i = 0; i < record.items.size (); i++)
+    {
+      if ((record.items[i].kind & ~BinaryTraceFile::FRAGMENT) != BinaryTraceFile::PAYLOAD)
+        {
+          oss << (oss.tellp () > 0 ? "/" : "") << file->GetTypeName (record.items[i].type);
+        }
+    }
+  return oss.str ();
+}
+
+/**
+ * The column files of the columns format.
+ */
+class Columns
+{
+public:
+  Columns (std::string prefix, int32_t resolution)
+    : m_prefix (prefix),
+      m_resolution (resolution),
+      m_rows (0)
+  {
+  }
+  ~Columns ()
+  {
+    std::ofstream schema ((m_prefix + ".schema").c_str ());
+    schema << "# column type file; " << m_rows << " rows in the byte order of the host" << std::endl;
+    schema << "# the times are timesteps of the Time::Unit " << m_resolution << std::endl;
+    for (uint32_t i = 0; i < m_names.size (); i++)
+      {
+        schema << m_names[i] << " " << m_types[i] << " " << m_prefix << "." << m_names[i] << std::endl;
+        delete m_files[i];
+      }
+  }
+  template <typename T>
+  void Add (uint32_t column, std::string name, std::string type, T value)
+  {
+    if (column == m_files.size ())
+      {
+        m_names.push_back (name);
+        m_types.push_back (type);
+        m_files.push_back (new std::ofstream ((m_prefix + "." + name).c_str (), std::ios::binary));
+      }
+    m_files[column]->write ((const char *)&value, sizeof (value));
+  }
+  void EndRow (void)
+  {
+    m_rows++;
+  }
+private:
+  std::string m_prefix;
+  int32_t m_resolution;
+  std::vector<std::string> m_names;
+  std::vector<std::string> m_types;
+  std::vector<std::ofstream *> m_files;
+  uint64_t m_rows;
+};
+
+} // anonymous namespace
+
+int main (int argc, char *argv[])
+{
+  std::string input;
+  std::string format = "ascii";
+  std::string output;
+
+  CommandLine cmd;
+  cmd.Usage ("Decode a binary trace file written by BinaryTraceHelper.");
+  cmd.AddValue ("input", "the binary trace file", input);
+  cmd.AddValue ("format", "ascii, csv or columns", format);
+  cmd.AddValue ("output", "prefix of the output files; the standard output if empty, "
+                "except for the columns format", output);
+  cmd.Parse (argc, argv);
+
+  if (format != "ascii" && format != "csv" && format != "columns")
+    {
+      std::cerr << "unknown format " << format << std::endl;
+      return 1;
+    }
+  if (format == "columns" && output == "")
+    {
+      output = input;
+    }
+
+  Ptr<BinaryTraceFile> file = CreateObject<BinaryTraceFile> ();
+  file->Open (input, std::ios::in);
+  if (file->Fail ())
+    {
+      std::cerr << "cannot read " << input << std::endl;
+      return 1;
+    }
+  if (file->GetResolution () != Time::GetResolution ())
+    {
+      Time::SetResolution (Time::Unit (file->GetResolution ()));
+    }
+
+  std::ofstream single;
+  std::ostream *os = &std::cout;
+  if (output != "" && format == "csv")
+    {
+      single.open ((output + ".csv").c_str ());
+      os = &single;
+    }
+  std::map<std::pair<uint32_t, uint32_t>, std::ofstream *> devices;
+  Columns *columns = format == "columns" ? new Columns (output, file->GetResolution ()) : 0;
+
+  if (format == "csv")
+    {
+      *os << "time,node,device,event,uid,size,headers,source,destination,"
+          << "protocol,ttl,source_port,destination_port,sequence,ack,tcp_flags" << std::endl;
+    }
+
+  BinaryTraceFile::Record record;
+  while (file->Read (record))
+    {
+      if (record.event == BinaryTraceFile::TYPE)
+        {
+          continue;
+        }
+      double seconds = Time (record.time).GetSeconds ();
+      if (format == "ascii")
+        {
+          if (output != "")
+            {
+              std::pair<uint32_t, uint32_t> key (record.node, record.device);
+              std::map<std::pair<uint32_t, uint32_t>, std::ofstream *>::iterator i = devices.find (key);
+              if (i == devices.end ())
+                {
+                  std::ostringstream oss;
+                  oss << output << "-" << record.node << "-" << record.device << ".tr";
+                  i = devices.insert (std::make_pair (key, new std::ofstream (oss.str ().c_str ()))).first;
+                }
+              os = i->second;
+            }
+          *os << record.event << " " << seconds << " ";
+          file->Print (record, *os);
+          *os << std::endl;
+        }
+      else if (format == "csv")
+        {
+          Fields fields = GetFields (file, record);
+          *os << seconds << "," << record.node << "," << record.device << ","
+              << record.event << "," << record.uid << "," << record.size << ","
+              << GetHeaders (file, record) << ","
+              << Ipv4Address (fields.source) << "," << Ipv4Address (fields.destination) << ","
+              << (uint32_t)fields.protocol << "," << (uint32_t)fields.ttl << ","
+              << fields.sourcePort << "," << fields.destinationPort << ","
+              << fields.sequence << "," << fields.ack << "," << (uint32_t)fields.flags << std::endl;
+        }
+      else
+        {
+          Fields fields = GetFields (file, record);
+          columns->Add (0, "time", "int64", record.time);
+          columns->Add (1, "node", "uint32", record.node);
+          columns->Add (2, "device", "uint32", record.device);
+          columns->Add (3, "event", "uint8", record.event);
+          columns->Add (4, "uid", "uint64", record.uid);
+          columns->Add (5, "size", "uint32", record.size);
+          columns->Add (6, "source", "uint32", fields.source);
+          columns->Add (7, "destination", "uint32", fields.destination);
+          columns->Add (8, "protocol", "uint8", fields.protocol);
+          columns->Add (9, "ttl", "uint8", fields.ttl);
+          columns->Add (10, "source_port", "uint16", fields.sourcePort);
+          columns->Add (11, "destination_port", "uint16", fields.destinationPort);
+          columns->Add (12, "sequence", "uint32", fields.sequence);
+          columns->Add (13, "ack", "uint32", fields.ack);
+          columns->Add (14, "tcp_flags", "uint8", fields.flags);
+          columns->EndRow ();
+        }
+    }
+
+  for (std::map<std::pair<uint32_t, uint32_t>, std::ofstream *>::iterator i = devices.begin (); i != devices.end (); ++i)
+    {
+      delete i->second;
+    }
+  delete columns;
+  file->Close ();
+  return 0;
+}